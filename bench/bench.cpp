@@ -0,0 +1,455 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+// Throughput benchmarks, not part of the test suite
+// Build with optimizations, e.g. -DCMAKE_BUILD_TYPE=Release
+// Pass a name filter as the first argument to run only matching benchmarks
+
+#include <eseed/math/noise.hpp>
+#include <eseed/math/random.hpp>
+#include <eseed/math/decomp.hpp>
+#include <eseed/math/solve.hpp>
+#include <eseed/math/batch.hpp>
+#include <eseed/math/hierarchy.hpp>
+#include <eseed/math/snapshot.hpp>
+#include <eseed/math/broadphase.hpp>
+#include <eseed/math/predicates.hpp>
+#include <eseed/math/integrate.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+const char* filter = nullptr;
+
+// Keeps results alive so the optimizer cannot drop the work
+volatile float sink;
+
+// Run fn() until at least 0.25 s have passed and print items per second
+// fn processes items items per call
+template <typename F>
+void bench(const char* name, std::size_t items, F&& fn) {
+    if (filter && !std::strstr(name, filter)) return;
+    using Clock = std::chrono::steady_clock;
+    fn();
+    std::size_t calls = 0;
+    const Clock::time_point start = Clock::now();
+    double seconds = 0;
+    do {
+        fn();
+        calls++;
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (seconds < 0.25);
+    std::printf("%-40s %12.3f M items/s\n", name, (double)items * (double)calls / seconds * 1e-6);
+}
+
+std::vector<esdm::Vec3<float>> randomPoints(std::size_t count, float range) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> coord(-range, range);
+    std::vector<esdm::Vec3<float>> out(count);
+    for (esdm::Vec3<float>& p : out) p = { coord(rng), coord(rng), coord(rng) };
+    return out;
+}
+
+// -- NOISE -- //
+
+template <esdm::NoiseKind K>
+void benchNoise(const char* scalarName, const char* name8, const char* name16) {
+    const std::size_t n = 1 << 16;
+    const esdm::NoiseTable table(1);
+    const std::vector<esdm::Vec3<float>> points = randomPoints(n, 100);
+    const esdm::VecSoA<3, float> soa{ std::span<const esdm::Vec3<float>>(points) };
+    std::vector<float> out(n);
+
+    bench(scalarName, n, [&] {
+        for (std::size_t i = 0; i < n; i++) out[i] = esdm::noise<K>(table, points[i]);
+        sink = out[n - 1];
+    });
+    bench(name8, n, [&] {
+        esdm::noise<K, 8>(table, soa.view(), std::span<float>(out));
+        sink = out[n - 1];
+    });
+    bench(name16, n, [&] {
+        esdm::noise<K, 16>(table, soa.view(), std::span<float>(out));
+        sink = out[n - 1];
+    });
+}
+
+void benchNoise() {
+    benchNoise<esdm::NoiseKind::Perlin>("perlin3 scalar", "perlin3 soa x8", "perlin3 soa x16");
+    benchNoise<esdm::NoiseKind::Simplex>("simplex3 scalar", "simplex3 soa x8", "simplex3 soa x16");
+    benchNoise<esdm::NoiseKind::Value>("value3 scalar", "value3 soa x8", "value3 soa x16");
+}
+
+// -- RANDOM -- //
+
+template <typename Dist>
+void benchRandom(const char* scalarName, const char* batchName, const Dist& dist) {
+    const std::size_t n = 1 << 16;
+    const esdm::Philox rng(1);
+    std::vector<typename Dist::Result> out(n);
+
+    bench(scalarName, n, [&] {
+        for (std::size_t i = 0; i < n; i++) out[i] = esdm::sample(rng, dist, i);
+        sink = out[n - 1][0];
+    });
+    bench(batchName, n, [&] {
+        esdm::generate(rng, dist, std::span<typename Dist::Result>(out));
+        sink = out[n - 1][0];
+    });
+}
+
+void benchRandom() {
+    benchRandom("uniform3 scalar", "uniform3 batch", esdm::Uniform<3, float>());
+    benchRandom("normal3 scalar", "normal3 batch", esdm::Normal<3, float>());
+    benchRandom("sphere scalar", "sphere batch", esdm::UnitSphere<float>());
+}
+
+// -- DECOMPOSITIONS -- //
+
+void benchDecomp() {
+    const std::size_t n = 1 << 14;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> coord(-1, 1);
+    std::vector<esdm::Mat3<float>> mats(n);
+    for (esdm::Mat3<float>& m : mats)
+        for (std::size_t i = 0; i < 3; i++)
+            for (std::size_t j = 0; j < 3; j++) m[i][j] = coord(rng);
+    std::vector<esdm::Svd3<float>> out(n);
+
+    bench("svd3 scalar", n, [&] {
+        for (std::size_t i = 0; i < n; i++) out[i] = esdm::svd(mats[i]);
+        sink = out[n - 1].sigma[0];
+    });
+    bench("svd3 batch x8", n, [&] {
+        esdm::svd<8>(std::span<const esdm::Mat3<float>>(mats), std::span<esdm::Svd3<float>>(out));
+        sink = out[n - 1].sigma[0];
+    });
+    bench("svd3 batch x16", n, [&] {
+        esdm::svd<16>(std::span<const esdm::Mat3<float>>(mats), std::span<esdm::Svd3<float>>(out));
+        sink = out[n - 1].sigma[0];
+    });
+}
+
+// -- DETERMINANT -- //
+
+template <std::size_t N>
+void benchDet(const char* luName, const char* scalarName, const char* aosName, const char* soaName) {
+    const std::size_t n = 1 << 16;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> coord(-1, 1);
+    std::vector<esdm::Mat<N, N, float>> mats(n);
+    esdm::VecSoA<N * N, float> soa;
+    soa.resize(n);
+    for (std::size_t k = 0; k < n; k++)
+        for (std::size_t i = 0; i < N; i++)
+            for (std::size_t j = 0; j < N; j++) soa.component(i * N + j)[k] = mats[k][i][j] = coord(rng);
+    std::vector<float> out(n);
+
+    bench(luName, n, [&] {
+        for (std::size_t k = 0; k < n; k++) {
+            const esdm::LU<N, float> f = esdm::lu(mats[k]);
+            float d = f.parity;
+            for (std::size_t i = 0; i < N; i++) d *= f.lu[i][i];
+            out[k] = d;
+        }
+        sink = out[n - 1];
+    });
+    bench(scalarName, n, [&] {
+        for (std::size_t k = 0; k < n; k++) out[k] = esdm::det(mats[k]);
+        sink = out[n - 1];
+    });
+    bench(aosName, n, [&] {
+        esdm::det(std::span<const esdm::Mat<N, N, float>>(mats), std::span<float>(out));
+        sink = out[n - 1];
+    });
+    bench(soaName, n, [&] {
+        esdm::det<N>(soa.view(), std::span<float>(out));
+        sink = out[n - 1];
+    });
+}
+
+void benchDet() {
+    benchDet<3>("det3 lu", "det3 scalar", "det3 batch", "det3 soa");
+    benchDet<4>("det4 lu", "det4 scalar", "det4 batch", "det4 soa");
+}
+
+// -- HIERARCHY -- //
+
+void benchHierarchy() {
+    // Wide and shallow like a typical scene, every node's parent is among the
+    // previous few thousand
+    const std::size_t n = 300000;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> coord(-1, 1);
+    std::vector<std::size_t> parents(n);
+    std::vector<esdm::Mat4<float>> locals(n);
+    std::vector<esdm::Mat4<float>> worlds(n);
+    esdm::Hierarchy<float> h;
+    h.reserve(n);
+    for (std::size_t i = 0; i < n; i++) {
+        parents[i] = i == 0 ? esdm::Hierarchy<float>::none : std::uniform_int_distribution<std::size_t>(i > 4096 ? i - 4096 : 0, i - 1)(rng);
+        locals[i] = esdm::matrot(esdm::Vec3<float>(0, 0, 1), coord(rng)) * esdm::mattrans(esdm::Vec3<float>(coord(rng), coord(rng), coord(rng)));
+        h.add(parents[i], locals[i]);
+    }
+    h.update();
+
+    bench("hierarchy mat4 products", n, [&] {
+        worlds[0] = locals[0];
+        for (std::size_t i = 1; i < n; i++) worlds[i] = locals[i] * worlds[parents[i]];
+        sink = worlds[n - 1][3][0];
+    });
+    bench("hierarchy update all", n, [&] {
+        h.setLocal(0, locals[0]);
+        h.update();
+        sink = h.getWorld(n - 1)[3][0];
+    });
+    // Reported per node in the hierarchy, not per node recomputed
+    bench("hierarchy update 1%", n, [&] {
+        for (std::size_t i = n - n / 100; i < n; i++) h.setLocal(i, locals[i]);
+        h.update();
+        sink = h.getWorld(n - 1)[3][0];
+    });
+}
+
+// -- SNAPSHOT -- //
+
+void benchSnapshot() {
+    // Positions moving a little every tick against the previous tick
+    const std::size_t n = 1 << 14;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> move(-0.05f, 0.05f);
+    const std::vector<esdm::Vec3<float>> before = randomPoints(n, 1000);
+    std::vector<esdm::Vec3<float>> after(n);
+    for (std::size_t i = 0; i < n; i++) after[i] = before[i] + esdm::Vec3<float>(move(rng), move(rng), move(rng));
+
+    const esdm::SnapshotCodec<3, float> codec(esdm::Vec3<float>(-1024, -1024, -1024), esdm::Vec3<float>(1024, 1024, 1024), 20);
+    std::vector<esdm::Vec3<std::uint32_t>> baseline(n);
+    std::vector<esdm::Vec3<std::uint32_t>> codes(n);
+    codec.quantize(std::span<const esdm::Vec3<float>>(before), std::span<esdm::Vec3<std::uint32_t>>(baseline));
+    esdm::SnapshotWriter writer;
+
+    bench("snapshot quantize vec3", n, [&] {
+        codec.quantize(std::span<const esdm::Vec3<float>>(after), std::span<esdm::Vec3<std::uint32_t>>(codes));
+        sink = (float)codes[n - 1][0];
+    });
+    std::vector<esdm::Vec3<float>> values(n);
+    bench("snapshot dequantize vec3", n, [&] {
+        codec.dequantize(std::span<const esdm::Vec3<std::uint32_t>>(codes), std::span<esdm::Vec3<float>>(values));
+        sink = values[n - 1][0];
+    });
+
+    bench("snapshot encode vec3", n, [&] {
+        writer.clear();
+        writer.write(codec, std::span<const esdm::Vec3<float>>(after), std::span<const esdm::Vec3<std::uint32_t>>(baseline), std::span<esdm::Vec3<std::uint32_t>>(codes));
+        sink = (float)writer.size();
+    });
+    bench("snapshot decode vec3", n, [&] {
+        esdm::SnapshotReader reader(writer.data());
+        reader.read(codec, std::span<const esdm::Vec3<std::uint32_t>>(baseline), std::span<esdm::Vec3<std::uint32_t>>(codes), std::span<esdm::Vec3<float>>(values));
+        sink = values[n - 1][0];
+    });
+    if (!filter || std::strstr("snapshot size", filter)) std::printf("%-40s %12.3f bytes per entity\n", "snapshot size", (double)writer.size() / (double)n);
+}
+
+// -- BROADPHASE -- //
+
+void benchBroadphase() {
+    // Bodies of mixed sizes drifting over a wide and flat world and bouncing
+    // off its walls, like a game level
+    const std::size_t n = 100000;
+    const esdm::Vec3<float> world(500, 20, 500);
+    const float dt = 1.f / 60.f;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> coord(-1, 1);
+    std::uniform_real_distribution<float> speed(-5, 5);
+    std::lognormal_distribution<float> size(0.f, 0.5f);
+    std::vector<esdm::Vec3<float>> position(n);
+    std::vector<esdm::Vec3<float>> velocity(n);
+    std::vector<esdm::Vec3<float>> extent(n);
+    for (std::size_t i = 0; i < n; i++) {
+        position[i] = { coord(rng) * world[0], coord(rng) * world[1], coord(rng) * world[2] };
+        velocity[i] = { speed(rng), speed(rng), speed(rng) };
+        extent[i] = { size(rng), size(rng), size(rng) };
+    }
+    std::vector<esdm::AABB3<float>> bounds(n);
+    auto step = [&] {
+        for (std::size_t i = 0; i < n; i++) {
+            position[i] = position[i] + velocity[i] * dt;
+            for (std::size_t c = 0; c < 3; c++)
+                if (position[i][c] < -world[c] || position[i][c] > world[c]) velocity[i][c] = -velocity[i][c];
+            bounds[i] = { position[i] - extent[i], position[i] + extent[i] };
+        }
+    };
+    step();
+
+    esdm::SweepAndPrune<float> sap;
+    sap.update(bounds);
+    bench("sap frame incremental", n, [&] {
+        step();
+        sap.update(bounds);
+        sink = (float)sap.pairs().size();
+    });
+    bench("sap frame full sort", n, [&] {
+        step();
+        sap.setAxis(0);
+        sap.update(bounds);
+        sink = (float)sap.pairs().size();
+    });
+    if (!filter || std::strstr("sap pairs", filter)) std::printf("%-40s %12.3f per body\n", "sap pairs", (double)sap.pairs().size() / (double)n);
+}
+
+// -- PREDICATES -- //
+
+void benchPredicates() {
+    // Triangles and circle tests on random points, as in meshing, and on
+    // points a few ulps from a line, where almost every call needs the exact
+    // fallback
+    const std::size_t n = 1 << 16;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> coord(0, 1);
+    std::uniform_int_distribution<int> ulps(-4, 4);
+    std::vector<esdm::Vec3<double>> random3(n + 3);
+    for (esdm::Vec3<double>& p : random3) p = { coord(rng), coord(rng), coord(rng) };
+    std::vector<esdm::Vec2<double>> random2(n + 3);
+    for (std::size_t i = 0; i < n + 3; i++) random2[i] = { random3[i][0], random3[i][1] };
+    std::vector<esdm::Vec2<double>> line(n + 3);
+    for (esdm::Vec2<double>& p : line) {
+        const double t = coord(rng);
+        p = { t, t + std::ldexp((double)ulps(rng), -53) };
+    }
+
+    auto share = [&](const char* name, auto&& certain) {
+        if (filter && !std::strstr(name, filter)) return;
+        std::size_t hits = 0;
+        for (std::size_t i = 0; i < n; i++) hits += certain(i);
+        std::printf("%-40s %12.3f %%\n", name, 100.0 * (double)hits / (double)n);
+    };
+    double det;
+    share("orient2d filter share random", [&](std::size_t i) { return esdm::detail::orient2dFilter(random2[i], random2[i + 1], random2[i + 2], det); });
+    share("orient3d filter share random", [&](std::size_t i) { return esdm::detail::orient3dFilter(random3[i], random3[i + 1], random3[i + 2], random3[i + 3], det); });
+    share("incircle filter share random", [&](std::size_t i) { return esdm::detail::incircleFilter(random2[i], random2[i + 1], random2[i + 2], random2[i + 3], det); });
+    share("orient2d filter share near line", [&](std::size_t i) { return esdm::detail::orient2dFilter(line[i], line[i + 1], line[i + 2], det); });
+
+    bench("orient2d naive", n, [&] {
+        double sum = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            const esdm::Vec2<double>& a = random2[i];
+            const esdm::Vec2<double>& b = random2[i + 1];
+            const esdm::Vec2<double>& c = random2[i + 2];
+            sum += (a[0] - c[0]) * (b[1] - c[1]) - (a[1] - c[1]) * (b[0] - c[0]) > 0;
+        }
+        sink = (float)sum;
+    });
+    bench("orient2d random", n, [&] {
+        double sum = 0;
+        for (std::size_t i = 0; i < n; i++) sum += esdm::orient2d(random2[i], random2[i + 1], random2[i + 2]) > 0;
+        sink = (float)sum;
+    });
+    bench("orient3d random", n, [&] {
+        double sum = 0;
+        for (std::size_t i = 0; i < n; i++) sum += esdm::orient3d(random3[i], random3[i + 1], random3[i + 2], random3[i + 3]) > 0;
+        sink = (float)sum;
+    });
+    bench("incircle random", n, [&] {
+        double sum = 0;
+        for (std::size_t i = 0; i < n; i++) sum += esdm::incircle(random2[i], random2[i + 1], random2[i + 2], random2[i + 3]) > 0;
+        sink = (float)sum;
+    });
+    bench("orient2d near line", n, [&] {
+        double sum = 0;
+        for (std::size_t i = 0; i < n; i++) sum += esdm::orient2d(line[i], line[i + 1], line[i + 2]) > 0;
+        sink = (float)sum;
+    });
+}
+
+// -- INTEGRATION -- //
+
+void benchIntegrate() {
+    // A million particles per step, against the usual loop over arrays of
+    // vectors
+    const std::size_t n = 1 << 20;
+    const std::vector<esdm::Vec3<float>> start = randomPoints(n, 10);
+    const std::vector<esdm::Vec3<float>> speeds = randomPoints(n, 1);
+    const esdm::ParticleStep<float> step{ 1.f / 60.f, { 0.f, -9.8f, 0.f }, 0.1f };
+
+    std::vector<esdm::Vec3<float>> position = start;
+    std::vector<esdm::Vec3<float>> velocity = speeds;
+    std::vector<esdm::Vec3<float>> force(n);
+    std::vector<float> inverseMass(n, 1.f);
+    bench("particles aos loop", n, [&] {
+        esdm::parallelFor(n, 1 << 14, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                const esdm::Vec3<float> a = force[i] * inverseMass[i] + step.gravity - velocity[i] * step.damping;
+                velocity[i] = velocity[i] + a * step.dt;
+                position[i] = position[i] + velocity[i] * step.dt;
+            }
+        });
+        sink = position[n - 1][0];
+    });
+
+    esdm::Particles<float> particles;
+    particles.resize(n);
+    for (std::size_t i = 0; i < n; i++) {
+        particles.position.set(i, start[i]);
+        particles.velocity.set(i, speeds[i]);
+    }
+    auto run = [&](const char* name, esdm::Integrator method) {
+        bench(name, n, [&] {
+            esdm::integrate(particles, method, step);
+            sink = particles.position.component(0)[n - 1];
+        });
+    };
+    run("particles euler", esdm::Integrator::Euler);
+    run("particles semi-implicit euler", esdm::Integrator::SemiImplicitEuler);
+    run("particles verlet", esdm::Integrator::Verlet);
+    run("particles rk4", esdm::Integrator::RK4);
+    bench("particles rk4 spring field", n, [&] {
+        esdm::integrate(particles, esdm::Integrator::RK4, step, [](std::size_t, std::size_t m, const float* const* x, const float* const*, float* const* a) {
+            for (std::size_t c = 0; c < 3; c++) for (std::size_t i = 0; i < m; i++) a[c][i] -= 4.f * x[c][i];
+        });
+        sink = particles.position.component(0)[n - 1];
+    });
+    const esdm::AABB3<float> box{ { -10.f, -10.f, -10.f }, { 10.f, 10.f, 10.f } };
+    bench("particles box constraint", n, [&] {
+        esdm::constrainBox(particles, box, 0.5f);
+        sink = particles.position.component(0)[n - 1];
+    });
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) filter = argv[1];
+    benchNoise();
+    benchRandom();
+    benchDecomp();
+    benchDet();
+    benchHierarchy();
+    benchSnapshot();
+    benchBroadphase();
+    benchPredicates();
+    benchIntegrate();
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,245 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vecops.hpp"
+#include "matops.hpp"
+#include "soa.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+
+#include <span>
+
+namespace esd::math {
+
+namespace detail {
+
+// Elements per parallel task
+constexpr std::size_t batchGrain = std::size_t(1) << 14;
+
+// Elements staged on the stack at a time
+// Small enough to stay in L1, large enough for the loops to vectorize
+constexpr std::size_t batchBlock = 64;
+
+// Squared lengths of m elements given as L component arrays
+template <std::size_t L, typename T>
+inline void lengthSqBlock(const T* const* in, T* out, std::size_t m) {
+    for (std::size_t i = 0; i < m; i++) out[i] = T(0);
+    for (std::size_t c = 0; c < L; c++)
+        for (std::size_t i = 0; i < m; i++) out[i] += in[c][i] * in[c][i];
+}
+
+// Normalize m elements given as L component arrays, in and out may alias
+template <bool Fast, std::size_t L, typename T>
+inline void normalizeBlock(const T* const* in, T* const* out, std::size_t m) {
+    T scale[batchBlock];
+    lengthSqBlock<L>(in, scale, m);
+    if constexpr (Fast && std::is_same_v<T, float>) rsqrtApprox(scale, scale, m);
+    else for (std::size_t i = 0; i < m; i++) scale[i] = rsqrt(scale[i]);
+    for (std::size_t c = 0; c < L; c++)
+        for (std::size_t i = 0; i < m; i++) out[c][i] = in[c][i] * scale[i];
+}
+
+// Determinants of m matrices given as N * N component arrays, entry (i, j)
+// in array i * N + j
+template <std::size_t N, typename T>
+inline void detBlock(const T* const* in, T* out, std::size_t m) {
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < m; w++) out[w] = detClosed<N, T>([&](std::size_t i, std::size_t j) { return in[i * N + j][w]; });
+}
+
+// Inverses of m matrices given as component arrays, in and out may alias
+template <std::size_t N, typename T>
+inline void inverseBlock(const T* const* in, T* const* out, std::size_t m) {
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < m; w++) {
+        T adj[N * N];
+        const T d = adjugateClosed<N, T>([&](std::size_t i, std::size_t j) { return in[i * N + j][w]; },
+            [&](std::size_t i, std::size_t j, T v) { adj[i * N + j] = v; });
+        const T inv = T(1) / d;
+        for (std::size_t k = 0; k < N * N; k++) out[k][w] = adj[k] * inv;
+    }
+}
+
+// Run block(in, out, m) over an array of vectors, staging each block as
+// component arrays
+template <std::size_t L, typename T, typename Block>
+inline void forEachBlockAoS(std::span<const Vec<L, T>> in, std::span<Vec<L, T>> out, Block block) {
+    parallelFor(in.size(), batchGrain, [&](std::size_t begin, std::size_t end) {
+        T staged[L][batchBlock];
+        const T* inPtrs[L];
+        T* outPtrs[L];
+        for (std::size_t c = 0; c < L; c++) inPtrs[c] = outPtrs[c] = staged[c];
+
+        for (std::size_t b = begin; b < end; b += batchBlock) {
+            std::size_t m = std::min(batchBlock, end - b);
+            for (std::size_t i = 0; i < m; i++)
+                for (std::size_t c = 0; c < L; c++) staged[c][i] = in[b + i][c];
+            block(inPtrs, outPtrs, m);
+            for (std::size_t i = 0; i < m; i++)
+                for (std::size_t c = 0; c < L; c++) out[b + i][c] = staged[c][i];
+        }
+    });
+}
+
+// Run block(in, out, m) over component arrays
+template <std::size_t L, typename T, typename Block>
+inline void forEachBlockSoA(VecSoASpan<L, const T> in, VecSoASpan<L, T> out, Block block) {
+    parallelFor(in.size(), batchGrain, [&](std::size_t begin, std::size_t end) {
+        const T* inPtrs[L];
+        T* outPtrs[L];
+        for (std::size_t b = begin; b < end; b += batchBlock) {
+            std::size_t m = std::min(batchBlock, end - b);
+            for (std::size_t c = 0; c < L; c++) {
+                inPtrs[c] = in.component(c).data() + b;
+                outPtrs[c] = out.component(c).data() + b;
+            }
+            block(inPtrs, outPtrs, m);
+        }
+    });
+}
+
+}
+
+// Batch functions split large inputs across the thread pool
+// Output spans must be at least as long as the input, and may be the input
+
+// -- LENGTH -- //
+
+// Squared length of every vector
+template <std::size_t L, AnyFloat T>
+void lengthSq(std::span<const Vec<L, T>> in, std::span<T> out) {
+    parallelFor(in.size(), detail::batchGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = lengthSq(in[i]);
+    });
+}
+
+template <std::size_t L, typename U, AnyFloat T = std::remove_const_t<U>>
+void lengthSq(VecSoASpan<L, U> in, std::span<T> out) {
+    parallelFor(in.size(), detail::batchGrain, [&](std::size_t begin, std::size_t end) {
+        const T* ptrs[L];
+        for (std::size_t c = 0; c < L; c++) ptrs[c] = in.component(c).data() + begin;
+        detail::lengthSqBlock<L>(ptrs, out.data() + begin, end - begin);
+    });
+}
+
+// Length of every vector
+template <std::size_t L, AnyFloat T>
+void length(std::span<const Vec<L, T>> in, std::span<T> out) {
+    parallelFor(in.size(), detail::batchGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = length(in[i]);
+    });
+}
+
+template <std::size_t L, typename U, AnyFloat T = std::remove_const_t<U>>
+void length(VecSoASpan<L, U> in, std::span<T> out) {
+    lengthSq(in, out);
+    parallelFor(in.size(), detail::batchGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = sqrt(out[i]);
+    });
+}
+
+// -- NORMALIZATION -- //
+
+// Normalize every vector, same results as the single vector normalize
+template <std::size_t L, AnyFloat T>
+void normalize(std::span<const Vec<L, T>> in, std::span<Vec<L, T>> out) {
+    detail::forEachBlockAoS(in, out, detail::normalizeBlock<false, L, T>);
+}
+
+template <std::size_t L, AnyFloat T>
+void normalize(std::span<Vec<L, T>> v) {
+    normalize(std::span<const Vec<L, T>>(v), v);
+}
+
+template <std::size_t L, typename U, AnyFloat T = std::remove_const_t<U>>
+void normalize(VecSoASpan<L, U> in, VecSoASpan<L, T> out) {
+    detail::forEachBlockSoA<L, T>(in, out, detail::normalizeBlock<false, L, T>);
+}
+
+template <std::size_t L, AnyFloat T>
+void normalize(VecSoASpan<L, T> v) {
+    normalize(VecSoASpan<L, const T>(v), v);
+}
+
+// Approximately normalize every vector, same results and error bound as the
+// single vector fastNormalize
+template <std::size_t L, AnyFloat T>
+void fastNormalize(std::span<const Vec<L, T>> in, std::span<Vec<L, T>> out) {
+    detail::forEachBlockAoS(in, out, detail::normalizeBlock<true, L, T>);
+}
+
+template <std::size_t L, AnyFloat T>
+void fastNormalize(std::span<Vec<L, T>> v) {
+    fastNormalize(std::span<const Vec<L, T>>(v), v);
+}
+
+template <std::size_t L, typename U, AnyFloat T = std::remove_const_t<U>>
+void fastNormalize(VecSoASpan<L, U> in, VecSoASpan<L, T> out) {
+    detail::forEachBlockSoA<L, T>(in, out, detail::normalizeBlock<true, L, T>);
+}
+
+template <std::size_t L, AnyFloat T>
+void fastNormalize(VecSoASpan<L, T> v) {
+    fastNormalize(VecSoASpan<L, const T>(v), v);
+}
+
+// -- MATRICES -- //
+
+// Closed forms of det and inverse for sizes up to 4
+// Component arrays are evaluated one entry at a time across a block of
+// matrices, which vectorizes
+// Matrices in component arrays are a VecSoASpan<N * N, T> with entry (i, j)
+// in component i * N + j, and N has to be given, e.g. det<3>(soa, out)
+
+// Determinant of every matrix
+template <std::size_t N, AnyFloat T> requires (N <= 4)
+void det(std::span<const Mat<N, N, T>> in, std::span<T> out) {
+    parallelFor(in.size(), detail::batchGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = det(in[i]);
+    });
+}
+
+template <std::size_t N, typename U, AnyFloat T = std::remove_const_t<U>> requires (N <= 4)
+void det(VecSoASpan<N * N, U> in, std::span<T> out) {
+    parallelFor(in.size(), detail::batchGrain, [&](std::size_t begin, std::size_t end) {
+        const T* ptrs[N * N];
+        for (std::size_t c = 0; c < N * N; c++) ptrs[c] = in.component(c).data() + begin;
+        detail::detBlock<N>(ptrs, out.data() + begin, end - begin);
+    });
+}
+
+// Inverse of every matrix, singular matrices give infinite or NaN entries
+template <std::size_t N, AnyFloat T> requires (N <= 4)
+void inverse(std::span<const Mat<N, N, T>> in, std::span<Mat<N, N, T>> out) {
+    parallelFor(in.size(), detail::batchGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = inverse(in[i]);
+    });
+}
+
+template <std::size_t N, typename U, AnyFloat T = std::remove_const_t<U>> requires (N <= 4)
+void inverse(VecSoASpan<N * N, U> in, VecSoASpan<N * N, T> out) {
+    detail::forEachBlockSoA<N * N, T>(in, out, detail::inverseBlock<N, T>);
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -0,0 +1,386 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vecops.hpp"
+#include "mat.hpp"
+
+#include <cstdint>
+
+namespace esd::math {
+
+// Forward declarations for shorthand aliases
+template <std::size_t L, typename T>
+struct AABB;
+
+template <std::size_t L, typename T>
+struct Sphere;
+
+template <std::size_t L, typename T>
+struct Ray;
+
+// Shorthand aliases
+
+template <typename T>
+using AABB2 = AABB<2, T>;
+
+template <typename T>
+using AABB3 = AABB<3, T>;
+
+template <typename T>
+using Sphere2 = Sphere<2, T>;
+
+template <typename T>
+using Sphere3 = Sphere<3, T>;
+
+template <typename T>
+using Ray2 = Ray<2, T>;
+
+template <typename T>
+using Ray3 = Ray<3, T>;
+
+// Axis-aligned bounding box, min and max corners are inclusive
+template <std::size_t L, typename T>
+struct AABB {
+    Vec<L, T> min;
+    Vec<L, T> max;
+};
+
+// Ball of points within radius of center, the surface included
+template <std::size_t L, typename T>
+struct Sphere {
+    Vec<L, T> center;
+    T radius;
+};
+
+// Half line from origin along direction, which need not be unit length
+// Distances along the ray are in multiples of direction
+template <std::size_t L, typename T>
+struct Ray {
+    Vec<L, T> origin;
+    Vec<L, T> direction;
+};
+
+// -- OPERATORS -- //
+
+// Comparison
+template <std::size_t L, typename T0, typename T1>
+constexpr bool operator==(const AABB<L, T0>& a, const AABB<L, T1>& b) {
+    return a.min == b.min && a.max == b.max;
+}
+
+template <std::size_t L, typename T0, typename T1>
+constexpr bool operator==(const Sphere<L, T0>& a, const Sphere<L, T1>& b) {
+    return a.center == b.center && a.radius == b.radius;
+}
+
+// Tests below combine per-axis comparisons with & instead of && so they
+// compile without branches
+
+// -- BOXES -- //
+
+template <std::size_t L, AnyNum T>
+constexpr Vec<L, T> center(const AABB<L, T>& box) {
+    return (box.min + box.max) / T(2);
+}
+
+// Half the size along every axis
+template <std::size_t L, AnyNum T>
+constexpr Vec<L, T> halfExtent(const AABB<L, T>& box) {
+    return (box.max - box.min) / T(2);
+}
+
+// Whether the boxes share any point
+template <std::size_t L, AnyNum T>
+constexpr bool overlaps(const AABB<L, T>& a, const AABB<L, T>& b) {
+    bool out = true;
+    for (std::size_t i = 0; i < L; i++) out &= (a.min[i] <= b.max[i]) & (b.min[i] <= a.max[i]);
+    return out;
+}
+
+template <std::size_t L, AnyNum T>
+constexpr bool contains(const AABB<L, T>& box, const Vec<L, T>& p) {
+    bool out = true;
+    for (std::size_t i = 0; i < L; i++) out &= (box.min[i] <= p[i]) & (p[i] <= box.max[i]);
+    return out;
+}
+
+// Whether inner lies entirely within outer
+template <std::size_t L, AnyNum T>
+constexpr bool contains(const AABB<L, T>& outer, const AABB<L, T>& inner) {
+    bool out = true;
+    for (std::size_t i = 0; i < L; i++) out &= (outer.min[i] <= inner.min[i]) & (inner.max[i] <= outer.max[i]);
+    return out;
+}
+
+// Smallest box containing both
+template <std::size_t L, AnyNum T>
+constexpr AABB<L, T> merge(const AABB<L, T>& a, const AABB<L, T>& b) {
+    return { min(a.min, b.min), max(a.max, b.max) };
+}
+
+template <std::size_t L, AnyNum T>
+constexpr AABB<L, T> merge(const AABB<L, T>& box, const Vec<L, T>& p) {
+    return { min(box.min, p), max(box.max, p) };
+}
+
+// Box around the transformed box, with Arvo's method
+// m transforms row vectors like mattrans and matrot, translation in row 3
+// Every output bound sums the smaller and larger of each input bound scaled
+// by the matrix entry, which is exact for the corners without visiting them
+template <AnyFloat T>
+constexpr AABB3<T> transform(const AABB3<T>& box, const Mat4<T>& m) {
+    AABB3<T> out = { Vec3<T>(m[3][0], m[3][1], m[3][2]), Vec3<T>(m[3][0], m[3][1], m[3][2]) };
+    for (std::size_t i = 0; i < 3; i++) {
+        for (std::size_t j = 0; j < 3; j++) {
+            const T a = m[i][j] * box.min[i];
+            const T b = m[i][j] * box.max[i];
+            out.min[j] += min(a, b);
+            out.max[j] += max(a, b);
+        }
+    }
+    return out;
+}
+
+// Entry distance of ray into box, with the slab method
+// Returns the distance in [0, tMax] where the ray enters the box, 0 if it
+// starts inside, or infinity if it misses
+// Rays parallel to an axis that start exactly on a face of that axis count
+// as inside it
+template <std::size_t L, AnyFloat T>
+constexpr T intersect(const Ray<L, T>& ray, const AABB<L, T>& box, T tMax = inf<T>()) {
+    T near = T(0);
+    T far = tMax;
+    for (std::size_t i = 0; i < L; i++) {
+        // The sign of the direction picks the face entered first, so a
+        // direction of 0 gives infinite distances of the right sign
+        const T inv = T(1) / ray.direction[i];
+        const bool flip = inv < T(0);
+        const T t0 = ((flip ? box.max[i] : box.min[i]) - ray.origin[i]) * inv;
+        const T t1 = ((flip ? box.min[i] : box.max[i]) - ray.origin[i]) * inv;
+        // 0 * infinity gives NaN for an origin on a face, min and max keep
+        // their first argument then
+        near = max(near, t0);
+        far = min(far, t1);
+    }
+    return near <= far ? near : inf<T>();
+}
+
+// -- SPHERES -- //
+
+template <std::size_t L, AnyNum T>
+constexpr bool overlaps(const Sphere<L, T>& a, const Sphere<L, T>& b) {
+    const T r = a.radius + b.radius;
+    return lengthSq(a.center - b.center) <= r * r;
+}
+
+template <std::size_t L, AnyNum T>
+constexpr bool contains(const Sphere<L, T>& s, const Vec<L, T>& p) {
+    return lengthSq(p - s.center) <= s.radius * s.radius;
+}
+
+template <std::size_t L, AnyFloat T>
+inline bool contains(const Sphere<L, T>& outer, const Sphere<L, T>& inner) {
+    const T r = outer.radius - inner.radius;
+    return (r >= T(0)) & (lengthSq(inner.center - outer.center) <= r * r);
+}
+
+// Whether the sphere and box share any point, through the point of the box
+// closest to the center
+template <std::size_t L, AnyNum T>
+constexpr bool overlaps(const Sphere<L, T>& s, const AABB<L, T>& box) {
+    return lengthSq(min(max(s.center, box.min), box.max) - s.center) <= s.radius * s.radius;
+}
+
+template <std::size_t L, AnyNum T>
+constexpr bool overlaps(const AABB<L, T>& box, const Sphere<L, T>& s) {
+    return overlaps(s, box);
+}
+
+// Smallest sphere containing both
+template <std::size_t L, AnyFloat T>
+inline Sphere<L, T> merge(const Sphere<L, T>& a, const Sphere<L, T>& b) {
+    const Vec<L, T> d = b.center - a.center;
+    const T dist = length(d);
+    // Either sphere may already contain the other
+    const bool keepA = dist + b.radius <= a.radius;
+    const bool keepB = dist + a.radius <= b.radius;
+    const T radius = (dist + a.radius + b.radius) / T(2);
+    // The merged center lies on the line between them, radius - a.radius
+    // from a, dist is not 0 unless one contains the other
+    const T f = keepA | keepB ? T(0) : (radius - a.radius) / dist;
+    const Sphere<L, T> both = { a.center + d * f, radius };
+    return keepA ? a : keepB ? b : both;
+}
+
+// Box around the sphere
+template <std::size_t L, AnyNum T>
+constexpr AABB<L, T> aabb(const Sphere<L, T>& s) {
+    Vec<L, T> r;
+    for (std::size_t i = 0; i < L; i++) r[i] = s.radius;
+    return { s.center - r, s.center + r };
+}
+
+// Sphere around the transformed sphere
+// m transforms row vectors like mattrans and matrot
+// The radius is scaled by a bound on the largest stretch of the 3x3 part,
+// the square root of the largest row sum of |m^T m| entries, which is exact
+// for rotations combined with any scale along the axes and never too small
+template <AnyFloat T>
+inline Sphere3<T> transform(const Sphere3<T>& s, const Mat4<T>& m) {
+    Vec3<T> c(m[3][0], m[3][1], m[3][2]);
+    for (std::size_t i = 0; i < 3; i++)
+        for (std::size_t j = 0; j < 3; j++) c[j] += s.center[i] * m[i][j];
+
+    // Rows of the linear part are the images of the axes
+    T stretch = T(0);
+    for (std::size_t i = 0; i < 3; i++) {
+        T sum = T(0);
+        for (std::size_t j = 0; j < 3; j++)
+            sum += abs(m[i][0] * m[j][0] + m[i][1] * m[j][1] + m[i][2] * m[j][2]);
+        stretch = max(stretch, sum);
+    }
+    return { c, s.radius * std::sqrt(stretch) };
+}
+
+// -- PACKETS -- //
+
+// W boxes or spheres stored component by component, to test one shape or
+// ray against all of them at once
+// Tests return a mask with bit i set for a hit on element i
+// W of 4 or 8 fills an SSE or AVX register with floats
+
+template <std::size_t W, std::size_t L, typename T>
+struct AABBPacket {
+    T min[L][W];
+    T max[L][W];
+
+    constexpr void set(std::size_t i, const AABB<L, T>& box) {
+        for (std::size_t c = 0; c < L; c++) {
+            min[c][i] = box.min[c];
+            max[c][i] = box.max[c];
+        }
+    }
+
+    constexpr AABB<L, T> get(std::size_t i) const {
+        AABB<L, T> out;
+        for (std::size_t c = 0; c < L; c++) {
+            out.min[c] = min[c][i];
+            out.max[c] = max[c][i];
+        }
+        return out;
+    }
+};
+
+template <std::size_t W, std::size_t L, typename T>
+struct SpherePacket {
+    T center[L][W];
+    T radius[W];
+
+    constexpr void set(std::size_t i, const Sphere<L, T>& s) {
+        for (std::size_t c = 0; c < L; c++) center[c][i] = s.center[c];
+        radius[i] = s.radius;
+    }
+
+    constexpr Sphere<L, T> get(std::size_t i) const {
+        Sphere<L, T> out;
+        for (std::size_t c = 0; c < L; c++) out.center[c] = center[c][i];
+        out.radius = radius[i];
+        return out;
+    }
+};
+
+namespace detail {
+
+template <std::size_t W>
+constexpr std::uint32_t laneMask(const bool (&hit)[W]) {
+    static_assert(W <= 32, "packets hold at most 32 elements");
+    std::uint32_t out = 0;
+    for (std::size_t w = 0; w < W; w++) out |= std::uint32_t(hit[w]) << w;
+    return out;
+}
+
+}
+
+template <std::size_t W, std::size_t L, AnyNum T>
+constexpr std::uint32_t overlaps(const AABB<L, T>& box, const AABBPacket<W, L, T>& p) {
+    bool hit[W];
+    for (std::size_t w = 0; w < W; w++) hit[w] = true;
+    for (std::size_t c = 0; c < L; c++)
+        for (std::size_t w = 0; w < W; w++) hit[w] &= (box.min[c] <= p.max[c][w]) & (p.min[c][w] <= box.max[c]);
+    return detail::laneMask(hit);
+}
+
+// Entry distances of ray into every box, infinity for misses, as for
+// intersect on a single box
+template <std::size_t W, std::size_t L, AnyFloat T>
+constexpr std::uint32_t intersect(const Ray<L, T>& ray, const AABBPacket<W, L, T>& p, T (&t)[W], T tMax = inf<T>()) {
+    T far[W];
+    for (std::size_t w = 0; w < W; w++) {
+        t[w] = T(0);
+        far[w] = tMax;
+    }
+    for (std::size_t c = 0; c < L; c++) {
+        const T inv = T(1) / ray.direction[c];
+        const T (&enter)[W] = inv < T(0) ? p.max[c] : p.min[c];
+        const T (&exit)[W] = inv < T(0) ? p.min[c] : p.max[c];
+        for (std::size_t w = 0; w < W; w++) {
+            t[w] = max(t[w], (enter[w] - ray.origin[c]) * inv);
+            far[w] = min(far[w], (exit[w] - ray.origin[c]) * inv);
+        }
+    }
+    bool hit[W];
+    for (std::size_t w = 0; w < W; w++) {
+        hit[w] = t[w] <= far[w];
+        t[w] = hit[w] ? t[w] : inf<T>();
+    }
+    return detail::laneMask(hit);
+}
+
+template <std::size_t W, std::size_t L, AnyNum T>
+constexpr std::uint32_t overlaps(const Sphere<L, T>& s, const SpherePacket<W, L, T>& p) {
+    T d[W];
+    bool hit[W];
+    for (std::size_t w = 0; w < W; w++) d[w] = T(0);
+    for (std::size_t c = 0; c < L; c++)
+        for (std::size_t w = 0; w < W; w++) d[w] += (p.center[c][w] - s.center[c]) * (p.center[c][w] - s.center[c]);
+    for (std::size_t w = 0; w < W; w++) hit[w] = d[w] <= (s.radius + p.radius[w]) * (s.radius + p.radius[w]);
+    return detail::laneMask(hit);
+}
+
+template <std::size_t W, std::size_t L, AnyNum T>
+constexpr std::uint32_t overlaps(const AABB<L, T>& box, const SpherePacket<W, L, T>& p) {
+    T d[W];
+    bool hit[W];
+    for (std::size_t w = 0; w < W; w++) d[w] = T(0);
+    for (std::size_t c = 0; c < L; c++) {
+        for (std::size_t w = 0; w < W; w++) {
+            const T e = min(max(p.center[c][w], box.min[c]), box.max[c]) - p.center[c][w];
+            d[w] += e * e;
+        }
+    }
+    for (std::size_t w = 0; w < W; w++) hit[w] = d[w] <= p.radius[w] * p.radius[w];
+    return detail::laneMask(hit);
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -0,0 +1,259 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "bounds.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace esd::math {
+
+namespace detail {
+
+// Sorted boxes per parallel task when collecting pairs
+constexpr std::size_t sweepGrain = std::size_t(1) << 12;
+
+// Candidates tested at a time along the sweep axis
+constexpr std::size_t sweepBlock = 16;
+
+}
+
+// Sweep and prune broadphase over Vec3 boxes
+// Boxes are kept sorted by their lower bound along one sweep axis, so every
+// box only needs to be tested against the boxes that follow it until their
+// lower bounds pass its upper bound
+//
+// Between updates the order is repaired with an insertion sort, which is
+// close to linear when boxes move a little every frame
+// The sorted bounds are stored as component arrays, the candidates of a box
+// are found with a binary search along the sweep axis and tested sweepBlock
+// at a time on the other two axes, which vectorizes
+// Pairs are collected on the thread pool into one compact buffer, in the
+// same order for any thread count
+//
+// Bounds must not contain NaN, boxes that share a face or corner overlap
+template <AnyFloat T>
+class SweepAndPrune {
+public:
+    // Indices of two overlapping boxes, first < second
+    struct Pair {
+        std::uint32_t first;
+        std::uint32_t second;
+
+        constexpr bool operator==(const Pair&) const = default;
+    };
+
+private:
+    ThreadPool* pool;
+    std::size_t sweepAxis;
+    bool sorted = false;
+
+    // Box index at every sorted position
+    std::vector<std::uint32_t> order;
+
+    // Bounds in sorted order, component 0 along the sweep axis and 1 and 2
+    // along the following axes
+    // sweepBlock NaN entries follow the boxes so scans can read whole blocks
+    // past the end
+    std::array<std::vector<T>, 3> lo;
+    std::array<std::vector<T>, 3> hi;
+
+    std::vector<Pair> pairBuffer;
+    std::size_t lastMoves = 0;
+
+    std::size_t axisOf(std::size_t c) const {
+        return (sweepAxis + c) % 3;
+    }
+
+    void resize(std::size_t n) {
+        for (std::size_t c = 0; c < 3; c++) {
+            lo[c].assign(n + detail::sweepBlock, std::numeric_limits<T>::quiet_NaN());
+            hi[c].assign(n + detail::sweepBlock, std::numeric_limits<T>::quiet_NaN());
+        }
+    }
+
+    // Sort lo[0] and order together, moving every box at most budget places
+    // in total
+    // Returns false once the budget runs out, leaving them partly sorted
+    bool insertionSort(std::size_t budget) {
+        T* key = lo[0].data();
+        std::uint32_t* index = order.data();
+        lastMoves = 0;
+        for (std::size_t i = 1; i < order.size(); i++) {
+            const T k = key[i];
+            const std::uint32_t b = index[i];
+            std::size_t j = i;
+            while (j > 0 && k < key[j - 1]) {
+                key[j] = key[j - 1];
+                index[j] = index[j - 1];
+                j--;
+            }
+            key[j] = k;
+            index[j] = b;
+            lastMoves += i - j;
+            if (lastMoves > budget) return false;
+        }
+        return true;
+    }
+
+    void fullSort() {
+        std::vector<std::pair<T, std::uint32_t>> entries(order.size());
+        for (std::size_t i = 0; i < order.size(); i++) entries[i] = { lo[0][i], order[i] };
+        std::sort(entries.begin(), entries.end());
+        for (std::size_t i = 0; i < order.size(); i++) {
+            lo[0][i] = entries[i].first;
+            order[i] = entries[i].second;
+        }
+    }
+
+    // Append the pairs of sorted positions [begin, end) with any later box
+    void collect(std::size_t begin, std::size_t end, std::vector<Pair>& out) const {
+        const T* lo0 = lo[0].data();
+        const T* lo1 = lo[1].data();
+        const T* lo2 = lo[2].data();
+        const T* hi1 = hi[1].data();
+        const T* hi2 = hi[2].data();
+        const std::size_t count = order.size();
+        for (std::size_t i = begin; i < end; i++) {
+            const T reach = hi[0][i];
+            const T min1 = lo1[i];
+            const T max1 = hi1[i];
+            const T min2 = lo2[i];
+            const T max2 = hi2[i];
+            const std::uint32_t self = order[i];
+            // Candidates are the following boxes whose lower bound does not
+            // pass reach, the last block is masked down to them
+            const std::size_t last = (std::size_t)(std::upper_bound(lo0 + i + 1, lo0 + count, reach) - lo0);
+            for (std::size_t j = i + 1; j < last; j += detail::sweepBlock) {
+                std::uint32_t mask = 0;
+                for (std::size_t k = 0; k < detail::sweepBlock; k++) {
+                    const bool hit = (lo1[j + k] <= max1) & (min1 <= hi1[j + k]) & (lo2[j + k] <= max2) & (min2 <= hi2[j + k]);
+                    mask |= std::uint32_t(hit) << k;
+                }
+                mask &= last - j < detail::sweepBlock ? (std::uint32_t(1) << (last - j)) - 1 : ~std::uint32_t(0);
+                for (; mask; mask &= mask - 1) {
+                    const std::uint32_t other = order[j + (std::size_t)std::countr_zero(mask)];
+                    out.push_back({ std::min(self, other), std::max(self, other) });
+                }
+            }
+        }
+    }
+
+public:
+    explicit SweepAndPrune(ThreadPool& pool = ThreadPool::global(), std::size_t axis = 0) :
+        pool(&pool), sweepAxis(axis) {}
+
+    // Number of boxes
+    std::size_t size() const {
+        return order.size();
+    }
+
+    std::size_t axis() const {
+        return sweepAxis;
+    }
+
+    // Sweep along another axis, the next update sorts from scratch
+    // The axis along which boxes are spread out the most gives the fewest
+    // candidates
+    void setAxis(std::size_t axis) {
+        sweepAxis = axis;
+        sorted = false;
+    }
+
+    // Sort the boxes and find every overlapping pair
+    // Box i is bounds[i], calls with the same number of boxes keep the order
+    // of the last call and repair it with an insertion sort
+    // Falls back to a full sort and returns false when the number of boxes
+    // changed or the insertion sort had to move boxes more than about
+    // size() * log2(size()) places in total, where sorting from scratch is
+    // cheaper
+    bool update(std::span<const AABB3<T>> bounds) {
+        const std::size_t n = bounds.size();
+        bool incremental = sorted && n == order.size();
+        lastMoves = 0;
+        if (!incremental) {
+            order.resize(n);
+            resize(n);
+            for (std::size_t i = 0; i < n; i++) order[i] = (std::uint32_t)i;
+        }
+
+        parallelFor(*pool, n, detail::sweepGrain, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) lo[0][i] = bounds[order[i]].min[sweepAxis];
+        });
+        if (!incremental || !insertionSort(n * (std::size_t)std::bit_width(n))) {
+            fullSort();
+            incremental = false;
+        }
+        sorted = true;
+
+        parallelFor(*pool, n, detail::sweepGrain, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                const AABB3<T>& box = bounds[order[i]];
+                hi[0][i] = box.max[sweepAxis];
+                for (std::size_t c = 1; c < 3; c++) {
+                    lo[c][i] = box.min[axisOf(c)];
+                    hi[c][i] = box.max[axisOf(c)];
+                }
+            }
+        });
+
+        const std::vector<std::vector<Pair>> found = parallelMap<std::vector<Pair>>(*pool, n, detail::sweepGrain,
+            [&](std::size_t begin, std::size_t end) {
+                std::vector<Pair> out;
+                collect(begin, end, out);
+                return out;
+            }
+        );
+
+        // Offsets of every task's pairs in the shared buffer
+        std::vector<std::size_t> offsets(found.size() + 1, 0);
+        for (std::size_t t = 0; t < found.size(); t++) offsets[t + 1] = offsets[t] + found[t].size();
+        pairBuffer.resize(offsets.back());
+        pool->run(found.size(), [&](std::size_t t) {
+            std::copy(found[t].begin(), found[t].end(), pairBuffer.begin() + (std::ptrdiff_t)offsets[t]);
+        });
+        return incremental;
+    }
+
+    // Overlapping pairs found by the last update
+    // Each pair is reported once, ordered by the sorted position of the box
+    // with the lower bound along the sweep axis
+    std::span<const Pair> pairs() const {
+        return pairBuffer;
+    }
+
+    // Places the last insertion sort moved boxes by in total
+    std::size_t moves() const {
+        return lastMoves;
+    }
+};
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -0,0 +1,503 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vec.hpp"
+#include "soa.hpp"
+#include "simd.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+namespace esd::math {
+
+// Lossy fixed point encodings for storage and network transfer
+//
+// snorm and unorm map [-1, 1] and [0, 1] onto the full range of an integer
+// type, rounding to nearest, so the decoded value is within half a step of
+// the input: 1 / (2 * max) where max is the largest value of the type
+//
+// Octahedral codes store a unit vector as a point on the octahedron unfolded
+// onto a square, Bits / 2 bits per coordinate
+// Largest angle between a unit vector and its decoded code, measured over
+// millions of random float vectors and rounded up:
+//   16 bits  1 degree
+//   24 bits  0.06 degrees
+//   32 bits  0.004 degrees
+//
+// Smallest three codes store a unit quaternion as the index of its largest
+// component in 2 bits and the other three, which lie in [-1 / sqrt(2),
+// 1 / sqrt(2)], in (Bits - 2) / 3 bits each
+// The largest component is made positive, which is the same rotation, and
+// restored from the unit length
+// Largest rotation angle between a unit quaternion and its decoded code,
+// measured the same way:
+//   32 bits (10 per component)  0.25 degrees
+//   48 bits (15 per component)  0.008 degrees
+//
+// The axes and the identity quaternion encode exactly
+// Inputs must be unit length, anything else gives an unspecified code
+
+namespace detail {
+
+// Elements per parallel task for the batch versions
+constexpr std::size_t codecGrain = std::size_t(1) << 14;
+
+// Elements staged on the stack at a time
+constexpr std::size_t codecBlock = 64;
+
+// x * scale rounded to nearest with ties away from zero, the result must
+// fit in 31 bits
+// Unlike std::lround this vectorizes
+template <AnyFloat T>
+constexpr std::int32_t roundScaled(T x, T scale) {
+    const T s = x * scale;
+    return (std::int32_t)(s + (s < T(0) ? T(-0.5) : T(0.5)));
+}
+
+// x in [-1, 1], or [0, 1] for unsigned I, times the largest value of I
+// rounded to nearest with ties away from zero
+// The largest value of a 32 or 64 bit type rounds up when converted to T,
+// so the result is clamped to [-max, max] before it is converted back
+template <AnyInt I, AnyFloat T>
+constexpr I roundToFull(T x) {
+    constexpr I hi = std::numeric_limits<I>::max();
+    if constexpr (sizeof(I) < sizeof(std::int32_t)) {
+        return (I)roundScaled(x, T(hi));
+    } else {
+        const T s = x * T(hi);
+        const T r = s + (s < T(0) ? T(-0.5) : T(0.5));
+        if (r >= T(hi)) return hi;
+        if constexpr (std::is_signed_v<I>) {
+            if (r <= -T(hi)) return -hi;
+        }
+        return (I)r;
+    }
+}
+
+// Code of the smallest three quaternion encoding
+template <std::size_t Bits>
+using QuaternionCode = std::conditional_t<(Bits <= 32), std::uint32_t, std::uint64_t>;
+
+// Octahedral codes of m unit vectors given as 3 component arrays
+template <std::size_t Bits, typename T>
+inline void encodeOctahedralLanes(const T* const* in, std::uint32_t* out, std::size_t m) {
+    constexpr std::size_t half = Bits / 2;
+    constexpr std::int32_t steps = (std::int32_t(1) << (half - 1)) - 1;
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < m; w++) {
+        const T x = in[0][w];
+        const T y = in[1][w];
+        const T z = in[2][w];
+        const T inv = T(1) / (std::abs(x) + std::abs(y) + std::abs(z));
+        const T px = x * inv;
+        const T py = y * inv;
+        // The lower half folds over the diagonals into the corners
+        const T fx = (T(1) - std::abs(py)) * (px >= T(0) ? T(1) : T(-1));
+        const T fy = (T(1) - std::abs(px)) * (py >= T(0) ? T(1) : T(-1));
+        const std::int32_t u = roundScaled(z < T(0) ? fx : px, T(steps)) + steps;
+        const std::int32_t v = roundScaled(z < T(0) ? fy : py, T(steps)) + steps;
+        out[w] = (std::uint32_t)u | (std::uint32_t)v << half;
+    }
+}
+
+// Unit vectors of m octahedral codes into 3 component arrays
+template <std::size_t Bits, typename T>
+inline void decodeOctahedralLanes(const std::uint32_t* in, T* const* out, std::size_t m) {
+    constexpr std::size_t half = Bits / 2;
+    constexpr std::uint32_t mask = (std::uint32_t(1) << half) - 1;
+    constexpr std::int32_t steps = (std::int32_t(1) << (half - 1)) - 1;
+    T len[codecBlock];
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < m; w++) {
+        const T u = std::min(T((std::int32_t)(in[w] & mask) - steps) / T(steps), T(1));
+        const T v = std::min(T((std::int32_t)(in[w] >> half & mask) - steps) / T(steps), T(1));
+        const T z = T(1) - std::abs(u) - std::abs(v);
+        const T t = std::max(-z, T(0));
+        const T x = u + (u >= T(0) ? -t : t);
+        const T y = v + (v >= T(0) ? -t : t);
+        out[0][w] = x;
+        out[1][w] = y;
+        out[2][w] = z;
+        len[w] = x * x + y * y + z * z;
+    }
+    sqrtInPlace(len, m);
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < m; w++) {
+        const T inv = T(1) / len[w];
+        for (std::size_t c = 0; c < 3; c++) out[c][w] *= inv;
+    }
+}
+
+// Smallest three codes of m unit quaternions given as 4 component arrays
+template <std::size_t Bits, typename T>
+inline void encodeQuaternionLanes(const T* const* in, QuaternionCode<Bits>* out, std::size_t m) {
+    using Code = QuaternionCode<Bits>;
+    constexpr std::size_t bits = (Bits - 2) / 3;
+    constexpr std::int32_t steps = (std::int32_t(1) << (bits - 1)) - 1;
+    // Maps [-1 / sqrt(2), 1 / sqrt(2)] onto [-steps, steps]
+    constexpr T scale = T(steps) * T(1.41421356237309504880);
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < m; w++) {
+        const T a0 = in[0][w];
+        const T a1 = in[1][w];
+        const T a2 = in[2][w];
+        const T a3 = in[3][w];
+
+        // Scan for the largest, keeping the other three in order
+        T k = T(0);
+        T big = a0;
+        T o0 = a1;
+        T o1 = a2;
+        T o2 = a3;
+        const bool b1 = std::abs(a1) > std::abs(big);
+        k = b1 ? T(1) : k;
+        big = b1 ? a1 : big;
+        o0 = b1 ? a0 : o0;
+        const bool b2 = std::abs(a2) > std::abs(big);
+        k = b2 ? T(2) : k;
+        big = b2 ? a2 : big;
+        o0 = b2 ? a0 : o0;
+        o1 = b2 ? a1 : o1;
+        const bool b3 = std::abs(a3) > std::abs(big);
+        k = b3 ? T(3) : k;
+        big = b3 ? a3 : big;
+        o0 = b3 ? a0 : o0;
+        o1 = b3 ? a1 : o1;
+        o2 = b3 ? a2 : o2;
+
+        // Negated along with the largest
+        const T sign = big < T(0) ? T(-1) : T(1);
+        const T o[3] = { o0 * sign, o1 * sign, o2 * sign };
+        Code code = (Code)(std::int32_t)k;
+        for (std::size_t j = 0; j < 3; j++) {
+            const std::int32_t q = std::min(std::max(roundScaled(o[j], scale), -steps), steps) + steps;
+            code |= (Code)q << (2 + j * bits);
+        }
+        out[w] = code;
+    }
+}
+
+// Unit quaternions of m smallest three codes into 4 component arrays
+template <std::size_t Bits, typename T>
+inline void decodeQuaternionLanes(const QuaternionCode<Bits>* in, T* const* out, std::size_t m) {
+    using Code = QuaternionCode<Bits>;
+    constexpr std::size_t bits = (Bits - 2) / 3;
+    constexpr Code mask = (Code(1) << bits) - 1;
+    constexpr std::int32_t steps = (std::int32_t(1) << (bits - 1)) - 1;
+    constexpr T scale = T(1) / (T(steps) * T(1.41421356237309504880));
+    T big[codecBlock];
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < m; w++) {
+        const Code c = in[w];
+        const T o0 = T((std::int32_t)(c >> 2 & mask) - steps) * scale;
+        const T o1 = T((std::int32_t)(c >> (2 + bits) & mask) - steps) * scale;
+        const T o2 = T((std::int32_t)(c >> (2 + 2 * bits) & mask) - steps) * scale;
+        out[0][w] = o0;
+        out[1][w] = o1;
+        out[2][w] = o2;
+        big[w] = std::max(T(1) - o0 * o0 - o1 * o1 - o2 * o2, T(0));
+    }
+    sqrtInPlace(big, m);
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < m; w++) {
+        const std::int32_t k = (std::int32_t)(in[w] & 3);
+        const T o0 = out[0][w];
+        const T o1 = out[1][w];
+        const T o2 = out[2][w];
+        const T b = big[w];
+        out[0][w] = k == 0 ? b : o0;
+        out[1][w] = k == 1 ? b : (k == 0 ? o0 : o1);
+        out[2][w] = k == 2 ? b : (k <= 1 ? o1 : o2);
+        out[3][w] = k == 3 ? b : o2;
+    }
+}
+
+// Run encode(in, out, m) over blocks of vectors, staging them as component
+// arrays
+template <std::size_t L, typename T, typename Code, typename Encode>
+void encodeEach(std::span<const Vec<L, T>> in, std::span<Code> out, Encode encode) {
+    parallelFor(in.size(), codecGrain, [&](std::size_t begin, std::size_t end) {
+        T staged[L][codecBlock];
+        const T* ptrs[L];
+        for (std::size_t c = 0; c < L; c++) ptrs[c] = staged[c];
+        for (std::size_t b = begin; b < end; b += codecBlock) {
+            const std::size_t m = std::min(codecBlock, end - b);
+            for (std::size_t i = 0; i < m; i++)
+                for (std::size_t c = 0; c < L; c++) staged[c][i] = in[b + i][c];
+            encode(ptrs, out.data() + b, m);
+        }
+    });
+}
+
+template <std::size_t L, typename T, typename Code, typename Encode>
+void encodeEach(VecSoASpan<L, const T> in, std::span<Code> out, Encode encode) {
+    parallelFor(in.size(), codecGrain, [&](std::size_t begin, std::size_t end) {
+        const T* ptrs[L];
+        for (std::size_t b = begin; b < end; b += codecBlock) {
+            const std::size_t m = std::min(codecBlock, end - b);
+            for (std::size_t c = 0; c < L; c++) ptrs[c] = in.component(c).data() + b;
+            encode(ptrs, out.data() + b, m);
+        }
+    });
+}
+
+// Run decode(in, out, m) over blocks of codes
+template <std::size_t L, typename T, typename Code, typename Decode>
+void decodeEach(std::span<const Code> in, std::span<Vec<L, T>> out, Decode decode) {
+    parallelFor(in.size(), codecGrain, [&](std::size_t begin, std::size_t end) {
+        T staged[L][codecBlock];
+        T* ptrs[L];
+        for (std::size_t c = 0; c < L; c++) ptrs[c] = staged[c];
+        for (std::size_t b = begin; b < end; b += codecBlock) {
+            const std::size_t m = std::min(codecBlock, end - b);
+            decode(in.data() + b, ptrs, m);
+            for (std::size_t i = 0; i < m; i++)
+                for (std::size_t c = 0; c < L; c++) out[b + i][c] = staged[c][i];
+        }
+    });
+}
+
+template <std::size_t L, typename T, typename Code, typename Decode>
+void decodeEach(std::span<const Code> in, VecSoASpan<L, T> out, Decode decode) {
+    parallelFor(in.size(), codecGrain, [&](std::size_t begin, std::size_t end) {
+        T* ptrs[L];
+        for (std::size_t b = begin; b < end; b += codecBlock) {
+            const std::size_t m = std::min(codecBlock, end - b);
+            for (std::size_t c = 0; c < L; c++) ptrs[c] = out.component(c).data() + b;
+            decode(in.data() + b, ptrs, m);
+        }
+    });
+}
+
+}
+
+// -- SNORM AND UNORM -- //
+
+// x clamped to [-1, 1] as a signed integer, e.g. packSnorm<std::int8_t>(x)
+// NaN packs as -1
+template <AnyInt I, AnyFloat T> requires std::is_signed_v<I>
+constexpr I packSnorm(T x) {
+    const T c = x > T(-1) ? (x < T(1) ? x : T(1)) : T(-1);
+    return detail::roundToFull<I>(c);
+}
+
+// Back to [-1, 1], the lowest value of I also decodes as -1
+template <AnyFloat T = float, AnyInt I> requires std::is_signed_v<I>
+constexpr T unpackSnorm(I q) {
+    return std::max(T(q) / T(std::numeric_limits<I>::max()), T(-1));
+}
+
+// x clamped to [0, 1] as an unsigned integer, e.g. packUnorm<std::uint16_t>(x)
+// NaN packs as 0
+template <AnyInt I, AnyFloat T> requires std::is_unsigned_v<I>
+constexpr I packUnorm(T x) {
+    const T c = x > T(0) ? (x < T(1) ? x : T(1)) : T(0);
+    return detail::roundToFull<I>(c);
+}
+
+template <AnyFloat T = float, AnyInt I> requires std::is_unsigned_v<I>
+constexpr T unpackUnorm(I q) {
+    return T(q) / T(std::numeric_limits<I>::max());
+}
+
+template <AnyInt I, std::size_t L, AnyFloat T> requires std::is_signed_v<I>
+constexpr Vec<L, I> packSnorm(const Vec<L, T>& v) {
+    Vec<L, I> out;
+    for (std::size_t i = 0; i < L; i++) out[i] = packSnorm<I>(v[i]);
+    return out;
+}
+
+template <AnyFloat T = float, std::size_t L, AnyInt I> requires std::is_signed_v<I>
+constexpr Vec<L, T> unpackSnorm(const Vec<L, I>& q) {
+    Vec<L, T> out;
+    for (std::size_t i = 0; i < L; i++) out[i] = unpackSnorm<T>(q[i]);
+    return out;
+}
+
+template <AnyInt I, std::size_t L, AnyFloat T> requires std::is_unsigned_v<I>
+constexpr Vec<L, I> packUnorm(const Vec<L, T>& v) {
+    Vec<L, I> out;
+    for (std::size_t i = 0; i < L; i++) out[i] = packUnorm<I>(v[i]);
+    return out;
+}
+
+template <AnyFloat T = float, std::size_t L, AnyInt I> requires std::is_unsigned_v<I>
+constexpr Vec<L, T> unpackUnorm(const Vec<L, I>& q) {
+    Vec<L, T> out;
+    for (std::size_t i = 0; i < L; i++) out[i] = unpackUnorm<T>(q[i]);
+    return out;
+}
+
+// -- OCTAHEDRAL -- //
+
+// Octahedral code of a unit vector in Bits bits, the first coordinate in the
+// low half
+template <std::size_t Bits, AnyFloat T> requires (Bits % 2 == 0 && Bits >= 4 && Bits <= 32)
+inline std::uint32_t encodeOctahedral(const Vec3<T>& n) {
+    const T c[3][1] = { { n[0] }, { n[1] }, { n[2] } };
+    const T* in[3] = { c[0], c[1], c[2] };
+    std::uint32_t out;
+    detail::encodeOctahedralLanes<Bits>(in, &out, 1);
+    return out;
+}
+
+template <std::size_t Bits, AnyFloat T = float> requires (Bits % 2 == 0 && Bits >= 4 && Bits <= 32)
+inline Vec3<T> decodeOctahedral(std::uint32_t code) {
+    Vec3<T> n;
+    T* out[3] = { &n[0], &n[1], &n[2] };
+    detail::decodeOctahedralLanes<Bits>(&code, out, 1);
+    return n;
+}
+
+// -- SMALLEST THREE -- //
+
+// Smallest three code of a unit quaternion given as a Vec4 in any component
+// order, 32 bit code up to 32 bits and 64 bit above
+template <std::size_t Bits, AnyFloat T> requires (Bits >= 8 && Bits <= 64)
+inline detail::QuaternionCode<Bits> encodeQuaternion(const Vec4<T>& q) {
+    const T c[4][1] = { { q[0] }, { q[1] }, { q[2] }, { q[3] } };
+    const T* in[4] = { c[0], c[1], c[2], c[3] };
+    detail::QuaternionCode<Bits> out;
+    detail::encodeQuaternionLanes<Bits>(in, &out, 1);
+    return out;
+}
+
+// The decoded quaternion has its largest component positive, so it may be
+// the negation of the encoded one
+template <std::size_t Bits, AnyFloat T = float> requires (Bits >= 8 && Bits <= 64)
+inline Vec4<T> decodeQuaternion(detail::QuaternionCode<Bits> code) {
+    Vec4<T> q;
+    T* out[4] = { &q[0], &q[1], &q[2], &q[3] };
+    detail::decodeQuaternionLanes<Bits>(&code, out, 1);
+    return q;
+}
+
+// -- BATCH -- //
+
+// Batch versions split large inputs across the thread pool and run the same
+// kernels in lanes, so they give the same codes as the single versions
+// Output spans must be at least as long as the input
+
+template <AnyInt I, AnyFloat T> requires std::is_signed_v<I>
+void packSnorm(std::span<const T> in, std::span<I> out) {
+    parallelFor(in.size(), detail::codecGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = packSnorm<I>(in[i]);
+    });
+}
+
+template <AnyFloat T, AnyInt I> requires std::is_signed_v<I>
+void unpackSnorm(std::span<const I> in, std::span<T> out) {
+    parallelFor(in.size(), detail::codecGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = unpackSnorm<T>(in[i]);
+    });
+}
+
+template <AnyInt I, AnyFloat T> requires std::is_unsigned_v<I>
+void packUnorm(std::span<const T> in, std::span<I> out) {
+    parallelFor(in.size(), detail::codecGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = packUnorm<I>(in[i]);
+    });
+}
+
+template <AnyFloat T, AnyInt I> requires std::is_unsigned_v<I>
+void unpackUnorm(std::span<const I> in, std::span<T> out) {
+    parallelFor(in.size(), detail::codecGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = unpackUnorm<T>(in[i]);
+    });
+}
+
+template <AnyInt I, std::size_t L, AnyFloat T> requires std::is_signed_v<I>
+void packSnorm(std::span<const Vec<L, T>> in, std::span<Vec<L, I>> out) {
+    parallelFor(in.size(), detail::codecGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = packSnorm<I>(in[i]);
+    });
+}
+
+template <AnyFloat T, std::size_t L, AnyInt I> requires std::is_signed_v<I>
+void unpackSnorm(std::span<const Vec<L, I>> in, std::span<Vec<L, T>> out) {
+    parallelFor(in.size(), detail::codecGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = unpackSnorm<T>(in[i]);
+    });
+}
+
+template <AnyInt I, std::size_t L, AnyFloat T> requires std::is_unsigned_v<I>
+void packUnorm(std::span<const Vec<L, T>> in, std::span<Vec<L, I>> out) {
+    parallelFor(in.size(), detail::codecGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = packUnorm<I>(in[i]);
+    });
+}
+
+template <AnyFloat T, std::size_t L, AnyInt I> requires std::is_unsigned_v<I>
+void unpackUnorm(std::span<const Vec<L, I>> in, std::span<Vec<L, T>> out) {
+    parallelFor(in.size(), detail::codecGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = unpackUnorm<T>(in[i]);
+    });
+}
+
+template <std::size_t Bits, AnyFloat T> requires (Bits % 2 == 0 && Bits >= 4 && Bits <= 32)
+void encodeOctahedral(std::span<const Vec3<T>> in, std::span<std::uint32_t> out) {
+    detail::encodeEach(in, out, detail::encodeOctahedralLanes<Bits, T>);
+}
+
+template <std::size_t Bits, typename U, AnyFloat T = std::remove_const_t<U>> requires (Bits % 2 == 0 && Bits >= 4 && Bits <= 32)
+void encodeOctahedral(VecSoASpan<3, U> in, std::span<std::uint32_t> out) {
+    detail::encodeEach(VecSoASpan<3, const T>(in), out, detail::encodeOctahedralLanes<Bits, T>);
+}
+
+template <std::size_t Bits, AnyFloat T> requires (Bits % 2 == 0 && Bits >= 4 && Bits <= 32)
+void decodeOctahedral(std::span<const std::uint32_t> in, std::span<Vec3<T>> out) {
+    detail::decodeEach(in, out, detail::decodeOctahedralLanes<Bits, T>);
+}
+
+template <std::size_t Bits, AnyFloat T> requires (Bits % 2 == 0 && Bits >= 4 && Bits <= 32)
+void decodeOctahedral(std::span<const std::uint32_t> in, VecSoASpan<3, T> out) {
+    detail::decodeEach(in, out, detail::decodeOctahedralLanes<Bits, T>);
+}
+
+template <std::size_t Bits, AnyFloat T> requires (Bits >= 8 && Bits <= 64)
+void encodeQuaternion(std::span<const Vec4<T>> in, std::span<detail::QuaternionCode<Bits>> out) {
+    detail::encodeEach(in, out, detail::encodeQuaternionLanes<Bits, T>);
+}
+
+template <std::size_t Bits, typename U, AnyFloat T = std::remove_const_t<U>> requires (Bits >= 8 && Bits <= 64)
+void encodeQuaternion(VecSoASpan<4, U> in, std::span<detail::QuaternionCode<Bits>> out) {
+    detail::encodeEach(VecSoASpan<4, const T>(in), out, detail::encodeQuaternionLanes<Bits, T>);
+}
+
+template <std::size_t Bits, AnyFloat T> requires (Bits >= 8 && Bits <= 64)
+void decodeQuaternion(std::span<const detail::QuaternionCode<Bits>> in, std::span<Vec4<T>> out) {
+    detail::decodeEach(in, out, detail::decodeQuaternionLanes<Bits, T>);
+}
+
+template <std::size_t Bits, AnyFloat T> requires (Bits >= 8 && Bits <= 64)
+void decodeQuaternion(std::span<const detail::QuaternionCode<Bits>> in, VecSoASpan<4, T> out) {
+    detail::decodeEach(in, out, detail::decodeQuaternionLanes<Bits, T>);
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -0,0 +1,427 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "mat.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <type_traits>
+
+namespace esd::math {
+
+// Decompositions of 3x3 matrices
+// Entry (i, j) is m[i][j] and matrices act on column vectors, so A * x and
+// u * v below use the operators of mat.hpp
+//
+// Everything runs a fixed number of steps with selects instead of branches,
+// after McAdams et al., "Computing the Singular Value Decomposition of 3x3
+// matrices with minimal branching and elementary floating point operations"
+// Each kernel works on W matrices at once with one array per entry, so the
+// batch versions keep all lanes in step and vectorize
+
+namespace detail {
+
+// Matrices per parallel task for the batch versions
+constexpr std::size_t decompGrain = std::size_t(1) << 12;
+
+// Cyclic Jacobi sweeps, convergence is quadratic so a few reach full
+// precision
+template <AnyFloat T>
+constexpr int jacobiSweeps = sizeof(T) > 4 ? 5 : 4;
+
+// Floor for rotation lengths, small enough not to matter and large enough
+// that its square is still a normal number
+template <AnyFloat T>
+constexpr T decompTiny = std::is_same_v<T, float> ? T(1e-18) : T(1e-150);
+
+// W matrices, entry (i, j) of matrix w at [i][j][w]
+template <AnyFloat T, std::size_t W>
+using Mat3Lanes = T[3][3][W];
+
+template <std::size_t W, AnyFloat T>
+inline void identityLanes(Mat3Lanes<T, W>& m) {
+    for (std::size_t i = 0; i < 3; i++)
+        for (std::size_t j = 0; j < 3; j++)
+            for (std::size_t w = 0; w < W; w++) m[i][j][w] = T(i == j);
+}
+
+// m = G^T m, where G rotates by (c, s) in the plane of axes P and Q
+template <std::size_t P, std::size_t Q, std::size_t W, AnyFloat T>
+inline void rotateRowsLanes(Mat3Lanes<T, W>& m, const T (&c)[W], const T (&s)[W]) {
+    for (std::size_t k = 0; k < 3; k++) {
+        ESEED_MATH_LANES
+        for (std::size_t w = 0; w < W; w++) {
+            const T p = m[P][k][w];
+            const T q = m[Q][k][w];
+            m[P][k][w] = c[w] * p + s[w] * q;
+            m[Q][k][w] = c[w] * q - s[w] * p;
+        }
+    }
+}
+
+// m = m G
+template <std::size_t P, std::size_t Q, std::size_t W, AnyFloat T>
+inline void rotateColsLanes(Mat3Lanes<T, W>& m, const T (&c)[W], const T (&s)[W]) {
+    for (std::size_t k = 0; k < 3; k++) {
+        ESEED_MATH_LANES
+        for (std::size_t w = 0; w < W; w++) {
+            const T p = m[k][P][w];
+            const T q = m[k][Q][w];
+            m[k][P][w] = c[w] * p + s[w] * q;
+            m[k][Q][w] = c[w] * q - s[w] * p;
+        }
+    }
+}
+
+// One Jacobi rotation zeroing s[P][Q] of the symmetric matrix s, which
+// becomes G^T s G, and accumulated into v
+// Uses the exact rotation rather than the approximate half angle of
+// McAdams et al., which needs about twice the sweeps for full precision
+template <std::size_t P, std::size_t Q, std::size_t W, AnyFloat T>
+inline void jacobiLanes(Mat3Lanes<T, W>& s, Mat3Lanes<T, W>& v) {
+    // Smaller root of t^2 + 2 tau t - 1, the tangent of the angle
+    T tau[W], c[W], sn[W];
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < W; w++) {
+        tau[w] = (s[P][P][w] - s[Q][Q][w]) / (T(2) * s[P][Q][w]);
+        c[w] = tau[w] * tau[w] + T(1);
+    }
+    sqrtInPlace(c, W);
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < W; w++) {
+        const T t = s[P][Q][w] == T(0) ? T(0) : std::copysign(T(1), tau[w]) / (std::abs(tau[w]) + c[w]);
+        sn[w] = t;
+        c[w] = t * t + T(1);
+    }
+    sqrtInPlace(c, W);
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < W; w++) {
+        c[w] = T(1) / c[w];
+        sn[w] *= c[w];
+    }
+    rotateRowsLanes<P, Q>(s, c, sn);
+    rotateColsLanes<P, Q>(s, c, sn);
+    rotateColsLanes<P, Q>(v, c, sn);
+}
+
+// Diagonalize the symmetric matrix s, v collects the rotations so that
+// the input is v s v^T
+template <std::size_t W, AnyFloat T>
+inline void jacobiEigenLanes(Mat3Lanes<T, W>& s, Mat3Lanes<T, W>& v) {
+    identityLanes(v);
+    for (int i = 0; i < jacobiSweeps<T>; i++) {
+        jacobiLanes<0, 1>(s, v);
+        jacobiLanes<1, 2>(s, v);
+        jacobiLanes<0, 2>(s, v);
+    }
+}
+
+// Swap columns P and Q of every matrix in m where key[P] < key[Q], and
+// the keys with them
+// One swapped column is negated so rotations stay rotations
+template <std::size_t P, std::size_t Q, std::size_t W, AnyFloat T, std::size_t N>
+inline void sortColsLanes(T (&key)[3][W], Mat3Lanes<T, W>* const (&m)[N]) {
+    for (std::size_t n = 0; n < N; n++) {
+        Mat3Lanes<T, W>& a = *m[n];
+        for (std::size_t k = 0; k < 3; k++) {
+            ESEED_MATH_LANES
+            for (std::size_t w = 0; w < W; w++) {
+                const bool swap = key[P][w] < key[Q][w];
+                const T p = a[k][P][w];
+                const T q = a[k][Q][w];
+                a[k][P][w] = swap ? q : p;
+                a[k][Q][w] = swap ? -p : q;
+            }
+        }
+    }
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < W; w++) {
+        const T p = key[P][w];
+        const T q = key[Q][w];
+        key[P][w] = std::max(p, q);
+        key[Q][w] = std::min(p, q);
+    }
+}
+
+// Sorting network for three keys, descending
+template <std::size_t W, AnyFloat T, std::size_t N>
+inline void sortColsLanes(T (&key)[3][W], Mat3Lanes<T, W>* const (&m)[N]) {
+    sortColsLanes<0, 1>(key, m);
+    sortColsLanes<0, 2>(key, m);
+    sortColsLanes<1, 2>(key, m);
+}
+
+// Eigenvalues in descending order and eigenvectors in the columns of v
+template <std::size_t W, AnyFloat T>
+inline void symmetricEigenLanes(Mat3Lanes<T, W>& a, T (&values)[3][W], Mat3Lanes<T, W>& v) {
+    jacobiEigenLanes(a, v);
+    for (std::size_t i = 0; i < 3; i++)
+        for (std::size_t w = 0; w < W; w++) values[i][w] = a[i][i][w];
+    Mat3Lanes<T, W>* const m[1] = { &v };
+    sortColsLanes(values, m);
+}
+
+// b = G^T b and u = u G, with G zeroing b[Q][P] against b[P][P]
+// Givens rotation from its half angle as in McAdams et al., which keeps
+// b[P][P] non-negative
+template <std::size_t P, std::size_t Q, std::size_t W, AnyFloat T>
+inline void givensLanes(Mat3Lanes<T, W>& b, Mat3Lanes<T, W>& u) {
+    T rho[W], ch[W], sh[W];
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < W; w++) rho[w] = b[P][P][w] * b[P][P][w] + b[Q][P][w] * b[Q][P][w];
+    sqrtInPlace(rho, W);
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < W; w++) {
+        const T a1 = b[P][P][w];
+        const T sh0 = rho[w] > decompTiny<T> ? b[Q][P][w] : T(0);
+        const T ch0 = std::abs(a1) + std::max(rho[w], decompTiny<T>);
+        ch[w] = a1 < T(0) ? sh0 : ch0;
+        sh[w] = a1 < T(0) ? ch0 : sh0;
+        rho[w] = ch[w] * ch[w] + sh[w] * sh[w];
+    }
+    sqrtInPlace(rho, W);
+    T c[W], sn[W];
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < W; w++) {
+        const T r = T(1) / rho[w];
+        c[w] = (ch[w] * ch[w] - sh[w] * sh[w]) * r * r;
+        sn[w] = T(2) * ch[w] * sh[w] * r * r;
+    }
+    rotateRowsLanes<P, Q>(b, c, sn);
+    rotateColsLanes<P, Q>(u, c, sn);
+}
+
+// a = u diag(sigma) v^T with u and v rotations
+template <std::size_t W, AnyFloat T>
+inline void svdLanes(const Mat3Lanes<T, W>& a, Mat3Lanes<T, W>& u, T (&sigma)[3][W], Mat3Lanes<T, W>& v) {
+    // Eigenvectors of a^T a are the right singular vectors
+    Mat3Lanes<T, W> s;
+    for (std::size_t i = 0; i < 3; i++)
+        for (std::size_t j = 0; j < 3; j++) {
+            ESEED_MATH_LANES
+            for (std::size_t w = 0; w < W; w++)
+                s[i][j][w] = a[0][i][w] * a[0][j][w] + a[1][i][w] * a[1][j][w] + a[2][i][w] * a[2][j][w];
+        }
+    jacobiEigenLanes(s, v);
+
+    // Columns of b = a v are orthogonal, ordered by length
+    Mat3Lanes<T, W> b;
+    for (std::size_t i = 0; i < 3; i++)
+        for (std::size_t j = 0; j < 3; j++) {
+            ESEED_MATH_LANES
+            for (std::size_t w = 0; w < W; w++)
+                b[i][j][w] = a[i][0][w] * v[0][j][w] + a[i][1][w] * v[1][j][w] + a[i][2][w] * v[2][j][w];
+        }
+    T norms[3][W];
+    for (std::size_t j = 0; j < 3; j++) {
+        ESEED_MATH_LANES
+        for (std::size_t w = 0; w < W; w++) norms[j][w] = b[0][j][w] * b[0][j][w] + b[1][j][w] * b[1][j][w] + b[2][j][w] * b[2][j][w];
+    }
+    Mat3Lanes<T, W>* const m[2] = { &b, &v };
+    sortColsLanes(norms, m);
+
+    // QR of b by Givens rotations, r is diagonal up to rounding
+    identityLanes(u);
+    givensLanes<0, 1>(b, u);
+    givensLanes<0, 2>(b, u);
+    givensLanes<1, 2>(b, u);
+    for (std::size_t i = 0; i < 3; i++)
+        for (std::size_t w = 0; w < W; w++) sigma[i][w] = b[i][i][w];
+}
+
+template <std::size_t W, AnyFloat T>
+inline void loadLanes(Mat3Lanes<T, W>& lanes, std::size_t w, const Mat3<T>& m) {
+    for (std::size_t i = 0; i < 3; i++)
+        for (std::size_t j = 0; j < 3; j++) lanes[i][j][w] = m[i][j];
+}
+
+template <std::size_t W, AnyFloat T>
+inline Mat3<T> storeLanes(const Mat3Lanes<T, W>& lanes, std::size_t w) {
+    Mat3<T> m;
+    for (std::size_t i = 0; i < 3; i++)
+        for (std::size_t j = 0; j < 3; j++) m[i][j] = lanes[i][j][w];
+    return m;
+}
+
+template <std::size_t W, AnyFloat T>
+inline Vec3<T> storeLanes(const T (&lanes)[3][W], std::size_t w) {
+    return { lanes[0][w], lanes[1][w], lanes[2][w] };
+}
+
+// Run kernel(in, w, out) on blocks of W matrices, padding the last block
+// with zero matrices
+template <std::size_t W, AnyFloat T, typename R, typename Kernel>
+void forEachMat3Block(std::span<const Mat3<T>> in, std::span<R> out, Kernel kernel) {
+    parallelFor(in.size(), decompGrain, [&](std::size_t begin, std::size_t end) {
+        Mat3Lanes<T, W> a;
+        for (std::size_t b = begin; b < end; b += W) {
+            const std::size_t n = std::min(W, end - b);
+            for (std::size_t w = 0; w < W; w++) loadLanes(a, w, w < n ? in[b + w] : Mat3<T>());
+            kernel(a, n, out.subspan(b, n));
+        }
+    });
+}
+
+}
+
+// -- RESULTS -- //
+
+// a == vectors * diag(values) * transpose(vectors)
+template <AnyFloat T>
+struct SymmetricEigen3 {
+    // Descending
+    Vec3<T> values;
+    // Unit eigenvector of values[i] in column i, a rotation
+    Mat3<T> vectors;
+};
+
+// a == u * diag(sigma) * transpose(v)
+template <AnyFloat T>
+struct Svd3 {
+    // Rotations, singular vectors in the columns
+    Mat3<T> u;
+    Mat3<T> v;
+    // Descending in magnitude, the last one is negative when det(a) < 0 so
+    // that u and v can stay rotations
+    Vec3<T> sigma;
+};
+
+// a == rotation * stretch
+template <AnyFloat T>
+struct Polar3 {
+    Mat3<T> rotation;
+    // Symmetric, with a negative eigenvalue when det(a) < 0
+    Mat3<T> stretch;
+};
+
+namespace detail {
+
+template <std::size_t W, AnyFloat T>
+inline SymmetricEigen3<T> symmetricEigenResult(const T (&values)[3][W], const Mat3Lanes<T, W>& v, std::size_t w) {
+    return { storeLanes(values, w), storeLanes(v, w) };
+}
+
+template <std::size_t W, AnyFloat T>
+inline Svd3<T> svdResult(const Mat3Lanes<T, W>& u, const T (&sigma)[3][W], const Mat3Lanes<T, W>& v, std::size_t w) {
+    return { storeLanes(u, w), storeLanes(v, w), storeLanes(sigma, w) };
+}
+
+// rotation = u v^T and stretch = v diag(sigma) v^T
+template <std::size_t W, AnyFloat T>
+inline Polar3<T> polarResult(const Mat3Lanes<T, W>& u, const T (&sigma)[3][W], const Mat3Lanes<T, W>& v, std::size_t w) {
+    Polar3<T> out;
+    for (std::size_t i = 0; i < 3; i++)
+        for (std::size_t j = 0; j < 3; j++) {
+            T r = T(0), s = T(0);
+            for (std::size_t k = 0; k < 3; k++) {
+                r += u[i][k][w] * v[j][k][w];
+                s += v[i][k][w] * sigma[k][w] * v[j][k][w];
+            }
+            out.rotation[i][j] = r;
+            out.stretch[i][j] = s;
+        }
+    return out;
+}
+
+}
+
+// -- SINGLE MATRIX -- //
+
+// Eigen decomposition of a symmetric matrix, only the upper triangle is
+// read
+template <AnyFloat T>
+SymmetricEigen3<T> symmetricEigen(const Mat3<T>& a) {
+    detail::Mat3Lanes<T, 1> s, v;
+    T values[3][1];
+    for (std::size_t i = 0; i < 3; i++)
+        for (std::size_t j = 0; j < 3; j++) s[i][j][0] = i <= j ? a[i][j] : a[j][i];
+    detail::symmetricEigenLanes(s, values, v);
+    return detail::symmetricEigenResult(values, v, 0);
+}
+
+// Singular value decomposition
+template <AnyFloat T>
+Svd3<T> svd(const Mat3<T>& a) {
+    detail::Mat3Lanes<T, 1> in, u, v;
+    T sigma[3][1];
+    detail::loadLanes(in, 0, a);
+    detail::svdLanes(in, u, sigma, v);
+    return detail::svdResult(u, sigma, v, 0);
+}
+
+// Polar decomposition, the rotation closest to a and the stretch applied
+// before it
+template <AnyFloat T>
+Polar3<T> polar(const Mat3<T>& a) {
+    detail::Mat3Lanes<T, 1> in, u, v;
+    T sigma[3][1];
+    detail::loadLanes(in, 0, a);
+    detail::svdLanes(in, u, sigma, v);
+    return detail::polarResult(u, sigma, v, 0);
+}
+
+// -- BATCH -- //
+
+// W matrices are decomposed together, 8 fills an AVX register of floats
+// Results equal the single matrix versions up to rounding
+// Large inputs are split across the thread pool
+
+template <std::size_t W = 8, AnyFloat T>
+void symmetricEigen(std::span<const Mat3<T>> in, std::span<SymmetricEigen3<T>> out) {
+    detail::forEachMat3Block<W>(in, out, [](detail::Mat3Lanes<T, W>& a, std::size_t n, std::span<SymmetricEigen3<T>> res) {
+        // Mirror the upper triangle like the single matrix version
+        for (std::size_t i = 0; i < 3; i++)
+            for (std::size_t j = 0; j < i; j++)
+                for (std::size_t w = 0; w < W; w++) a[i][j][w] = a[j][i][w];
+        detail::Mat3Lanes<T, W> v;
+        T values[3][W];
+        detail::symmetricEigenLanes(a, values, v);
+        for (std::size_t w = 0; w < n; w++) res[w] = detail::symmetricEigenResult(values, v, w);
+    });
+}
+
+template <std::size_t W = 8, AnyFloat T>
+void svd(std::span<const Mat3<T>> in, std::span<Svd3<T>> out) {
+    detail::forEachMat3Block<W>(in, out, [](const detail::Mat3Lanes<T, W>& a, std::size_t n, std::span<Svd3<T>> res) {
+        detail::Mat3Lanes<T, W> u, v;
+        T sigma[3][W];
+        detail::svdLanes(a, u, sigma, v);
+        for (std::size_t w = 0; w < n; w++) res[w] = detail::svdResult(u, sigma, v, w);
+    });
+}
+
+template <std::size_t W = 8, AnyFloat T>
+void polar(std::span<const Mat3<T>> in, std::span<Polar3<T>> out) {
+    detail::forEachMat3Block<W>(in, out, [](const detail::Mat3Lanes<T, W>& a, std::size_t n, std::span<Polar3<T>> res) {
+        detail::Mat3Lanes<T, W> u, v;
+        T sigma[3][W];
+        detail::svdLanes(a, u, sigma, v);
+        for (std::size_t w = 0; w < n; w++) res[w] = detail::polarResult(u, sigma, v, w);
+    });
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -0,0 +1,825 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vecops.hpp"
+#include "mat.hpp"
+#include "soa.hpp"
+#include "bounds.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace esd::math {
+
+// Convex shapes are given by their support function, the point of the shape
+// farthest along a direction
+// A shape type either has a member support(direction) or a free function
+// support(shape, direction) found by argument dependent lookup, and either a
+// member type Scalar or a detail::ShapeScalar specialization
+// Directions passed to support functions are not normalized and never zero
+//
+// Points, spheres and boxes are shapes as they are, point sets go through
+// ConvexPoints or ConvexPointsSoA and TransformedShape places any shape with
+// a Mat4
+
+namespace detail {
+
+// Points transposed at a time when searching AoS points for a support
+// point
+constexpr std::size_t supportBlock = 64;
+
+// GJK converges in a handful of iterations on polytopes, the limits only
+// guard against cycling on curved shapes
+constexpr std::size_t gjkMaxIterations = 64;
+constexpr std::size_t epaMaxIterations = 64;
+
+// EPA polytope capacity
+constexpr std::size_t epaMaxVertices = 4 + epaMaxIterations;
+constexpr std::size_t epaMaxFaces = 256;
+
+template <typename S>
+struct ShapeScalar {
+    using Type = typename S::Scalar;
+};
+
+template <typename T>
+struct ShapeScalar<Vec<3, T>> {
+    using Type = T;
+};
+
+template <typename T>
+struct ShapeScalar<Sphere<3, T>> {
+    using Type = T;
+};
+
+template <typename T>
+struct ShapeScalar<AABB<3, T>> {
+    using Type = T;
+};
+
+}
+
+// -- SUPPORT FUNCTIONS -- //
+
+template <AnyFloat T>
+constexpr Vec3<T> support(const Vec3<T>& point, const Vec3<T>&) {
+    return point;
+}
+
+template <AnyFloat T>
+inline Vec3<T> support(const Sphere3<T>& s, const Vec3<T>& d) {
+    return s.center + d * (s.radius * rsqrt(lengthSq(d)));
+}
+
+template <AnyFloat T>
+constexpr Vec3<T> support(const AABB3<T>& box, const Vec3<T>& d) {
+    return Vec3<T>(
+        d[0] < T(0) ? box.min[0] : box.max[0],
+        d[1] < T(0) ? box.min[1] : box.max[1],
+        d[2] < T(0) ? box.min[2] : box.max[2]
+    );
+}
+
+// Index of the point farthest along d, the first one on ties
+// points must not be empty
+// Float points are searched with SIMD, AoS points are transposed a block at a
+// time for it
+template <AnyFloat T>
+std::size_t supportIndex(VecSoASpan<3, const T> points, const Vec3<T>& d) {
+    const T* x = points.component(0).data();
+    const T* y = points.component(1).data();
+    const T* z = points.component(2).data();
+    if constexpr (std::is_same_v<T, float>) {
+        return detail::argmaxDot3(x, y, z, points.size(), d[0], d[1], d[2]);
+    } else {
+        std::size_t out = 0;
+        T top = x[0] * d[0] + y[0] * d[1] + z[0] * d[2];
+        for (std::size_t i = 1; i < points.size(); i++) {
+            const T s = x[i] * d[0] + y[i] * d[1] + z[i] * d[2];
+            if (s > top) {
+                top = s;
+                out = i;
+            }
+        }
+        return out;
+    }
+}
+
+template <AnyFloat T>
+std::size_t supportIndex(std::span<const Vec3<T>> points, const Vec3<T>& d) {
+    std::size_t out = 0;
+    T top = -inf<T>();
+    if constexpr (std::is_same_v<T, float>) {
+        constexpr std::size_t b = detail::supportBlock;
+        T x[b];
+        T y[b];
+        T z[b];
+        for (std::size_t i = 0; i < points.size(); i += b) {
+            const std::size_t m = std::min(b, points.size() - i);
+            for (std::size_t k = 0; k < m; k++) {
+                x[k] = points[i + k][0];
+                y[k] = points[i + k][1];
+                z[k] = points[i + k][2];
+            }
+            const std::size_t k = detail::argmaxDot3(x, y, z, m, d[0], d[1], d[2]);
+            const T s = x[k] * d[0] + y[k] * d[1] + z[k] * d[2];
+            if (s > top || i == 0) {
+                top = s;
+                out = i + k;
+            }
+        }
+    } else {
+        for (std::size_t i = 0; i < points.size(); i++) {
+            const T s = dot(points[i], d);
+            if (s > top || i == 0) {
+                top = s;
+                out = i;
+            }
+        }
+    }
+    return out;
+}
+
+// Convex hull of a point set, given by the points
+// Any point set works, points inside the hull only cost search time
+template <AnyFloat T>
+class ConvexPoints {
+private:
+    std::span<const Vec3<T>> points;
+
+public:
+    using Scalar = T;
+
+    explicit ConvexPoints(std::span<const Vec3<T>> points) : points(points) {}
+
+    Vec3<T> support(const Vec3<T>& d) const {
+        return points[supportIndex(points, d)];
+    }
+};
+
+template <AnyFloat T>
+class ConvexPointsSoA {
+private:
+    VecSoASpan<3, const T> points;
+
+public:
+    using Scalar = T;
+
+    explicit ConvexPointsSoA(VecSoASpan<3, const T> points) : points(points) {}
+
+    Vec3<T> support(const Vec3<T>& d) const {
+        return points.get(supportIndex(points, d));
+    }
+};
+
+// Shape placed by a transform, which maps row vectors like mattrans and
+// matrot
+// The linear part may also scale or shear, the shape is referenced and must
+// outlive this
+template <typename S>
+class TransformedShape {
+public:
+    using Scalar = typename detail::ShapeScalar<S>::Type;
+
+private:
+    const S* shape;
+    Mat4<Scalar> transform;
+
+public:
+    TransformedShape(const S& shape, const Mat4<Scalar>& transform) : shape(&shape), transform(transform) {}
+
+    Vec3<Scalar> support(const Vec3<Scalar>& d) const;
+};
+
+namespace detail {
+
+template <typename S, AnyFloat T>
+Vec3<T> supportOf(const S& shape, const Vec3<T>& d) {
+    if constexpr (requires { shape.support(d); }) return shape.support(d);
+    else return support(shape, d);
+}
+
+}
+
+template <typename S>
+Vec3<typename TransformedShape<S>::Scalar> TransformedShape<S>::support(const Vec3<Scalar>& d) const {
+    // The point farthest along d after the transform is the point farthest
+    // along d mapped back through the transposed linear part
+    const Mat4<Scalar>& m = transform;
+    const Vec3<Scalar> local(
+        m[0][0] * d[0] + m[0][1] * d[1] + m[0][2] * d[2],
+        m[1][0] * d[0] + m[1][1] * d[1] + m[1][2] * d[2],
+        m[2][0] * d[0] + m[2][1] * d[1] + m[2][2] * d[2]
+    );
+    const Vec3<Scalar> p = detail::supportOf(*shape, local);
+    return Vec3<Scalar>(
+        p[0] * m[0][0] + p[1] * m[1][0] + p[2] * m[2][0] + m[3][0],
+        p[0] * m[0][1] + p[1] * m[1][1] + p[2] * m[2][1] + m[3][1],
+        p[0] * m[0][2] + p[1] * m[1][2] + p[2] * m[2][2] + m[3][2]
+    );
+}
+
+// -- GJK -- //
+
+// Search directions of the simplex a query ended with
+// Passing the same cache to the next query on the same pair of shapes starts
+// it from the supports along these directions, which are usually close to the
+// answer when the shapes moved a little
+template <AnyFloat T>
+struct GjkCache {
+    std::array<Vec3<T>, 4> directions;
+    std::size_t count = 0;
+};
+
+template <AnyFloat T>
+struct GjkResult {
+    // Closest points on both shapes, meaningless when they overlap
+    Vec3<T> pointA;
+    Vec3<T> pointB;
+    // Distance between the shapes, 0 when they overlap
+    T distance;
+    bool overlap;
+    std::size_t iterations;
+};
+
+// Penetration of overlapping shapes, or separation of disjoint ones
+template <AnyFloat T>
+struct Contact {
+    // Points of deepest penetration on both shapes, or the closest points
+    Vec3<T> pointA;
+    Vec3<T> pointB;
+    // Unit direction from A towards B, moving B by normal * depth separates
+    // the shapes
+    // Zero when the shapes only touch and no direction can be found
+    Vec3<T> normal;
+    // Penetration depth, or minus the distance of disjoint shapes
+    T depth;
+    bool overlap;
+};
+
+namespace detail {
+
+// Relative tolerance for convergence and degeneracy, squared where it
+// bounds a distance compared as a squared length
+template <AnyFloat T>
+constexpr T gjkTolerance() {
+    return std::numeric_limits<T>::epsilon() * T(64);
+}
+
+template <AnyFloat T>
+struct GjkVertex {
+    // Point of the Minkowski difference A - B and the supports it came from
+    Vec3<T> w;
+    Vec3<T> a;
+    Vec3<T> b;
+    Vec3<T> d;
+};
+
+template <AnyFloat T, typename A, typename B>
+GjkVertex<T> gjkVertex(const A& a, const B& b, const Vec3<T>& d) {
+    const Vec3<T> pa = supportOf(a, d);
+    const Vec3<T> pb = supportOf(b, -d);
+    return { pa - pb, pa, pb, d };
+}
+
+// Simplex of up to four vertices with the barycentric coordinates of its
+// point closest to the origin
+template <AnyFloat T>
+struct GjkSimplex {
+    GjkVertex<T> v[4];
+    T bary[4];
+    std::size_t n = 0;
+
+    // Largest squared length of a vertex, the scale for tolerances
+    T scaleSq() const {
+        T out = T(0);
+        for (std::size_t i = 0; i < n; i++) out = max(out, lengthSq(v[i].w));
+        return out;
+    }
+
+    bool contains(const Vec3<T>& w) const {
+        const T tol = gjkTolerance<T>() * gjkTolerance<T>() * max(scaleSq(), lengthSq(w));
+        for (std::size_t i = 0; i < n; i++) if (lengthSq(v[i].w - w) <= tol) return true;
+        return false;
+    }
+
+    Vec3<T> point() const {
+        Vec3<T> out = v[0].w * bary[0];
+        for (std::size_t i = 1; i < n; i++) out = out + v[i].w * bary[i];
+        return out;
+    }
+
+    Vec3<T> pointA() const {
+        Vec3<T> out = v[0].a * bary[0];
+        for (std::size_t i = 1; i < n; i++) out = out + v[i].a * bary[i];
+        return out;
+    }
+
+    Vec3<T> pointB() const {
+        Vec3<T> out = v[0].b * bary[0];
+        for (std::size_t i = 1; i < n; i++) out = out + v[i].b * bary[i];
+        return out;
+    }
+
+    // Keep the listed vertices in that order
+    void keep(std::size_t count, const std::size_t* index, const T* weights) {
+        GjkVertex<T> kept[4];
+        for (std::size_t i = 0; i < count; i++) kept[i] = v[index[i]];
+        for (std::size_t i = 0; i < count; i++) {
+            v[i] = kept[i];
+            bary[i] = weights[i];
+        }
+        n = count;
+    }
+
+    // Closest point to the origin of segment i j, as count vertices with
+    // weights
+    static std::size_t segment(const Vec3<T>& a, const Vec3<T>& b, T* weights) {
+        const Vec3<T> ab = b - a;
+        const T t = -dot(a, ab);
+        const T len = dot(ab, ab);
+        if (t <= T(0) || len <= T(0)) {
+            weights[0] = T(1);
+            return 1;
+        }
+        if (t >= len) {
+            weights[1] = T(1);
+            return 2;
+        }
+        weights[1] = t / len;
+        weights[0] = T(1) - weights[1];
+        return 3;
+    }
+
+    void reduceSegment(std::size_t i, std::size_t j) {
+        T w[2] = { T(0), T(0) };
+        const std::size_t mask = segment(v[i].w, v[j].w, w);
+        const std::size_t both[2] = { i, j };
+        if (mask == 3) keep(2, both, w);
+        else keep(1, &both[mask - 1], &w[mask - 1]);
+    }
+
+    // Closest point of triangle i j k to the origin, after Ericson's
+    // Real-Time Collision Detection
+    void reduceTriangle(std::size_t i, std::size_t j, std::size_t k) {
+        const Vec3<T> a = v[i].w;
+        const Vec3<T> b = v[j].w;
+        const Vec3<T> c = v[k].w;
+        const Vec3<T> ab = b - a;
+        const Vec3<T> ac = c - a;
+
+        const T d1 = -dot(ab, a);
+        const T d2 = -dot(ac, a);
+        if (d1 <= T(0) && d2 <= T(0)) return keepOne(i);
+
+        const T d3 = -dot(ab, b);
+        const T d4 = -dot(ac, b);
+        if (d3 >= T(0) && d4 <= d3) return keepOne(j);
+
+        const T vc = d1 * d4 - d3 * d2;
+        if (vc <= T(0) && d1 >= T(0) && d3 <= T(0)) return keepTwo(i, j, d1 / (d1 - d3));
+
+        const T d5 = -dot(ab, c);
+        const T d6 = -dot(ac, c);
+        if (d6 >= T(0) && d5 <= d6) return keepOne(k);
+
+        const T vb = d5 * d2 - d1 * d6;
+        if (vb <= T(0) && d2 >= T(0) && d6 <= T(0)) return keepTwo(i, k, d2 / (d2 - d6));
+
+        const T va = d3 * d6 - d5 * d4;
+        if (va <= T(0) && d4 - d3 >= T(0) && d5 - d6 >= T(0)) return keepTwo(j, k, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+        const T sum = va + vb + vc;
+        if (!(sum > T(0))) {
+            // Degenerate triangle, the closest of its edges
+            return reduceClosest({ { i, j }, { j, k }, { i, k } });
+        }
+        const std::size_t index[3] = { i, j, k };
+        const T weights[3] = { va / sum, vb / sum, vc / sum };
+        keep(3, index, weights);
+    }
+
+    void keepOne(std::size_t i) {
+        const T one = T(1);
+        keep(1, &i, &one);
+    }
+
+    void keepTwo(std::size_t i, std::size_t j, T t) {
+        const std::size_t index[2] = { i, j };
+        const T weights[2] = { T(1) - t, t };
+        keep(2, index, weights);
+    }
+
+    // Reduce to the closest of several edges of the current simplex
+    void reduceClosest(std::initializer_list<std::array<std::size_t, 2>> edges) {
+        GjkSimplex best;
+        T bestSq = inf<T>();
+        for (const std::array<std::size_t, 2>& e : edges) {
+            GjkSimplex s = *this;
+            s.reduceSegment(e[0], e[1]);
+            const T sq = lengthSq(s.point());
+            if (sq < bestSq) {
+                bestSq = sq;
+                best = s;
+            }
+        }
+        *this = best;
+    }
+
+    // Closest point of tetrahedron 0 1 2 3 to the origin
+    // Keeps all four vertices when the origin is inside
+    void reduceTetrahedron() {
+        static constexpr std::size_t faces[4][4] = { { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 } };
+        const Vec3<T> a = v[0].w;
+        const T volume = dot(v[1].w - a, cross(v[2].w - a, v[3].w - a));
+        const T scale = scaleSq();
+        const bool flat = std::abs(volume) <= gjkTolerance<T>() * scale * std::sqrt(scale);
+
+        GjkSimplex best;
+        T bestSq = inf<T>();
+        bool outside = false;
+        for (const auto& f : faces) {
+            const Vec3<T> p = v[f[0]].w;
+            const Vec3<T> n = cross(v[f[1]].w - p, v[f[2]].w - p);
+            // The origin and the opposite vertex on different sides
+            if (!flat && dot(n, p) * dot(n, v[f[3]].w - p) < T(0)) continue;
+            outside = true;
+            GjkSimplex s = *this;
+            s.reduceTriangle(f[0], f[1], f[2]);
+            const T sq = lengthSq(s.point());
+            if (sq < bestSq) {
+                bestSq = sq;
+                best = s;
+            }
+        }
+        if (!outside) {
+            // Volumes of the tetrahedra with the origin in place of each
+            // vertex
+            const Vec3<T> w[4] = { v[0].w, v[1].w, v[2].w, v[3].w };
+            bary[0] = dot(w[1], cross(w[2], w[3])) / volume;
+            bary[1] = -dot(w[0], cross(w[2], w[3])) / volume;
+            bary[2] = dot(w[0], cross(w[1], w[3])) / volume;
+            bary[3] = T(1) - bary[0] - bary[1] - bary[2];
+            return;
+        }
+        *this = best;
+    }
+
+    // Reduce to the smallest face holding the point closest to the origin
+    void reduce() {
+        switch (n) {
+        case 1: bary[0] = T(1); break;
+        case 2: reduceSegment(0, 1); break;
+        case 3: reduceTriangle(0, 1, 2); break;
+        default: reduceTetrahedron(); break;
+        }
+    }
+};
+
+// Run GJK until the distance converges, the origin is enclosed or, when
+// early is set, a separating direction is found
+template <AnyFloat T, typename A, typename B>
+GjkResult<T> gjk(const A& a, const B& b, GjkCache<T>* cache, bool early, GjkSimplex<T>& s) {
+    s.n = 0;
+    if (cache) {
+        for (std::size_t i = 0; i < cache->count && i < 4; i++) {
+            const GjkVertex<T> nv = gjkVertex(a, b, cache->directions[i]);
+            if (!s.contains(nv.w)) s.v[s.n++] = nv;
+        }
+    }
+    if (s.n == 0) s.v[s.n++] = gjkVertex(a, b, Vec3<T>(T(1), T(0), T(0)));
+    s.reduce();
+
+    GjkResult<T> out;
+    out.overlap = false;
+    out.iterations = 0;
+    Vec3<T> v = s.point();
+    T vv = lengthSq(v);
+    const T tol = gjkTolerance<T>();
+    while (out.iterations < gjkMaxIterations) {
+        // The origin is within rounding of the simplex
+        if (s.n == 4 || vv <= tol * tol * s.scaleSq()) {
+            out.overlap = true;
+            break;
+        }
+        out.iterations++;
+        const GjkVertex<T> nv = gjkVertex(a, b, -v);
+        const T vw = dot(v, nv.w);
+        // The support along -v does not pass the origin, so -v separates
+        if (early && vw > T(0)) break;
+        // No vertex gets closer to the origin than the current point
+        if (vv - vw <= tol * vv || s.contains(nv.w)) break;
+
+        s.v[s.n++] = nv;
+        s.reduce();
+        if (s.n == 4) {
+            out.overlap = true;
+            break;
+        }
+        const Vec3<T> next = s.point();
+        const T nextSq = lengthSq(next);
+        v = next;
+        // Rounding can stop the distance from decreasing
+        if (nextSq >= vv) {
+            vv = nextSq;
+            break;
+        }
+        vv = nextSq;
+    }
+
+    if (cache) {
+        cache->count = s.n;
+        for (std::size_t i = 0; i < s.n; i++) cache->directions[i] = s.v[i].d;
+    }
+    out.pointA = s.pointA();
+    out.pointB = s.pointB();
+    out.distance = out.overlap ? T(0) : std::sqrt(vv);
+    return out;
+}
+
+}
+
+// Distance and closest points between two convex shapes
+template <typename A, typename B, AnyFloat T = typename detail::ShapeScalar<A>::Type>
+GjkResult<T> gjkDistance(const A& a, const B& b) {
+    detail::GjkSimplex<T> s;
+    return detail::gjk<T>(a, b, nullptr, false, s);
+}
+
+// Warm started from and updating cache
+template <typename A, typename B, AnyFloat T>
+GjkResult<T> gjkDistance(const A& a, const B& b, GjkCache<T>& cache) {
+    detail::GjkSimplex<T> s;
+    return detail::gjk<T>(a, b, &cache, false, s);
+}
+
+// Whether two convex shapes overlap, touching counts as overlapping
+// Stops as soon as a separating direction is found, which is much cheaper
+// than the distance for shapes that are far apart
+template <typename A, typename B, AnyFloat T = typename detail::ShapeScalar<A>::Type>
+bool gjkOverlap(const A& a, const B& b) {
+    detail::GjkSimplex<T> s;
+    return detail::gjk<T>(a, b, nullptr, true, s).overlap;
+}
+
+template <typename A, typename B, AnyFloat T>
+bool gjkOverlap(const A& a, const B& b, GjkCache<T>& cache) {
+    detail::GjkSimplex<T> s;
+    return detail::gjk<T>(a, b, &cache, true, s).overlap;
+}
+
+// -- EPA -- //
+
+namespace detail {
+
+template <AnyFloat T>
+struct EpaFace {
+    std::uint32_t i[3];
+    Vec3<T> n;
+    T dist;
+};
+
+// Expanding polytope of the Minkowski difference, on the stack
+template <AnyFloat T>
+struct EpaPolytope {
+    GjkVertex<T> v[epaMaxVertices];
+    EpaFace<T> f[epaMaxFaces];
+    std::size_t vertexCount = 0;
+    std::size_t faceCount = 0;
+
+    // Add face i j k wound so its normal points away from inner
+    bool addFace(std::uint32_t i, std::uint32_t j, std::uint32_t k) {
+        if (faceCount == epaMaxFaces) return false;
+        const Vec3<T> a = v[i].w;
+        const Vec3<T> n = normalizeSafe(cross(v[j].w - a, v[k].w - a));
+        f[faceCount++] = { { i, j, k }, n, dot(n, a) };
+        return true;
+    }
+};
+
+// Grow a simplex that encloses the origin on its boundary into a
+// tetrahedron, searching along directions the simplex does not span yet
+template <AnyFloat T, typename A, typename B>
+bool epaBlowUp(const A& a, const B& b, GjkSimplex<T>& s) {
+    const Vec3<T> axes[3] = { { T(1), T(0), T(0) }, { T(0), T(1), T(0) }, { T(0), T(0), T(1) } };
+    const T tol = gjkTolerance<T>();
+
+    if (s.n == 1) {
+        for (std::size_t i = 0; i < 6 && s.n == 1; i++) {
+            const Vec3<T> d = i < 3 ? axes[i] : -axes[i - 3];
+            const GjkVertex<T> nv = gjkVertex(a, b, d);
+            if (!s.contains(nv.w)) s.v[s.n++] = nv;
+        }
+    }
+    if (s.n == 2) {
+        const Vec3<T> line = s.v[1].w - s.v[0].w;
+        // The axis least aligned with the segment gives a well conditioned
+        // perpendicular
+        std::size_t axis = 0;
+        for (std::size_t i = 1; i < 3; i++) if (std::abs(line[i]) < std::abs(line[axis])) axis = i;
+        const Vec3<T> p = cross(line, axes[axis]);
+        const Vec3<T> q = cross(line, p);
+        const Vec3<T> dirs[4] = { p, q, -p, -q };
+        const T lineSq = lengthSq(line);
+        for (std::size_t i = 0; i < 4 && s.n == 2; i++) {
+            const GjkVertex<T> nv = gjkVertex(a, b, dirs[i]);
+            // Distance from the line through the segment
+            if (lengthSq(cross(nv.w - s.v[0].w, line)) > tol * lineSq * max(lineSq, s.scaleSq())) s.v[s.n++] = nv;
+        }
+    }
+    if (s.n == 3) {
+        const Vec3<T> n = cross(s.v[1].w - s.v[0].w, s.v[2].w - s.v[0].w);
+        const T nSq = lengthSq(n);
+        for (std::size_t i = 0; i < 2 && s.n == 3; i++) {
+            const GjkVertex<T> nv = gjkVertex(a, b, i == 0 ? n : -n);
+            const T h = dot(nv.w - s.v[0].w, n);
+            if (h * h > tol * nSq * s.scaleSq()) s.v[s.n++] = nv;
+        }
+    }
+    return s.n == 4;
+}
+
+template <AnyFloat T>
+Contact<T> epaContact(const EpaPolytope<T>& p, const EpaFace<T>& face) {
+    // Barycentric coordinates of the origin projected onto the face
+    const Vec3<T> a = p.v[face.i[0]].w;
+    const Vec3<T> e0 = p.v[face.i[1]].w - a;
+    const Vec3<T> e1 = p.v[face.i[2]].w - a;
+    const Vec3<T> e2 = face.n * face.dist - a;
+    const T d00 = dot(e0, e0);
+    const T d01 = dot(e0, e1);
+    const T d11 = dot(e1, e1);
+    const T d20 = dot(e2, e0);
+    const T d21 = dot(e2, e1);
+    const T denom = d00 * d11 - d01 * d01;
+    T u = T(1) / T(3);
+    T w = T(1) / T(3);
+    if (denom > T(0)) {
+        u = (d11 * d20 - d01 * d21) / denom;
+        w = (d00 * d21 - d01 * d20) / denom;
+    }
+    const T weights[3] = { T(1) - u - w, u, w };
+
+    Contact<T> out;
+    out.pointA = Vec3<T>();
+    out.pointB = Vec3<T>();
+    for (std::size_t i = 0; i < 3; i++) {
+        out.pointA = out.pointA + p.v[face.i[i]].a * weights[i];
+        out.pointB = out.pointB + p.v[face.i[i]].b * weights[i];
+    }
+    out.normal = face.n;
+    out.depth = face.dist;
+    out.overlap = true;
+    return out;
+}
+
+// Expanding polytope algorithm, from the tetrahedron of an overlapping GJK
+// query
+template <AnyFloat T, typename A, typename B>
+Contact<T> epa(const A& a, const B& b, GjkSimplex<T>& s) {
+    Contact<T> touch;
+    touch.pointA = s.pointA();
+    touch.pointB = s.pointB();
+    touch.normal = Vec3<T>();
+    touch.depth = T(0);
+    touch.overlap = true;
+    if (s.n < 4 && !epaBlowUp(a, b, s)) return touch;
+
+    EpaPolytope<T> p;
+    for (std::size_t i = 0; i < 4; i++) p.v[i] = s.v[i];
+    p.vertexCount = 4;
+    // Wind the first tetrahedron outwards
+    if (dot(cross(s.v[1].w - s.v[0].w, s.v[2].w - s.v[0].w), s.v[3].w - s.v[0].w) > T(0)) std::swap(p.v[1], p.v[2]);
+    p.addFace(0, 1, 2);
+    p.addFace(0, 3, 1);
+    p.addFace(0, 2, 3);
+    p.addFace(1, 3, 2);
+
+    // Stop once the surface is within rounding of the size of the shapes,
+    // or the support is a vertex already
+    // Curved shapes would otherwise take every iteration, so past half of
+    // them the surface only has to be within sqrt(epsilon)
+    const T scale = std::sqrt(s.scaleSq());
+    const T tight = gjkTolerance<T>() * scale;
+    const T loose = std::sqrt(std::numeric_limits<T>::epsilon()) * scale;
+    std::size_t closest = 0;
+    for (std::size_t iteration = 0;; iteration++) {
+        closest = 0;
+        for (std::size_t i = 1; i < p.faceCount; i++) if (p.f[i].dist < p.f[closest].dist) closest = i;
+        const EpaFace<T> face = p.f[closest];
+        if (iteration == epaMaxIterations || p.vertexCount == epaMaxVertices) break;
+
+        const GjkVertex<T> nv = gjkVertex(a, b, face.n);
+        const T grow = dot(nv.w, face.n) - face.dist;
+        if (grow <= (iteration < epaMaxIterations / 2 ? tight : loose) || lengthSq(face.n) == T(0)) break;
+        bool known = false;
+        for (std::size_t i = 0; i < p.vertexCount && !known; i++) known = p.v[i].w == nv.w;
+        if (known) break;
+
+        // Remove every face the new vertex sees, keeping the edges on the
+        // border of the hole
+        std::uint32_t edges[epaMaxFaces][2];
+        std::size_t edgeCount = 0;
+        bool full = false;
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < p.faceCount; i++) {
+            const EpaFace<T>& f = p.f[i];
+            if (dot(f.n, nv.w - p.v[f.i[0]].w) <= T(0)) {
+                p.f[kept++] = f;
+                continue;
+            }
+            for (std::size_t e = 0; e < 3; e++) {
+                const std::uint32_t from = f.i[e];
+                const std::uint32_t to = f.i[(e + 1) % 3];
+                // An edge shared with another removed face is not on the border
+                std::size_t k = 0;
+                while (k < edgeCount && !(edges[k][0] == to && edges[k][1] == from)) k++;
+                if (k < edgeCount) {
+                    edges[k][0] = edges[edgeCount - 1][0];
+                    edges[k][1] = edges[edgeCount - 1][1];
+                    edgeCount--;
+                } else if (edgeCount < epaMaxFaces) {
+                    edges[edgeCount][0] = from;
+                    edges[edgeCount][1] = to;
+                    edgeCount++;
+                } else {
+                    full = true;
+                }
+            }
+        }
+        if (full || kept + edgeCount > epaMaxFaces) {
+            // Out of room, the closest face so far is the answer
+            return epaContact(p, face);
+        }
+        p.faceCount = kept;
+
+        const std::uint32_t added = (std::uint32_t)p.vertexCount;
+        p.v[p.vertexCount++] = nv;
+        for (std::size_t e = 0; e < edgeCount; e++) p.addFace(edges[e][0], edges[e][1], added);
+    }
+    return epaContact(p, p.f[closest]);
+}
+
+}
+
+namespace detail {
+
+template <AnyFloat T, typename A, typename B>
+Contact<T> penetration(const A& a, const B& b, GjkCache<T>* cache) {
+    GjkSimplex<T> s;
+    const GjkResult<T> r = gjk<T>(a, b, cache, false, s);
+    if (r.overlap) return epa(a, b, s);
+    Contact<T> out;
+    out.pointA = r.pointA;
+    out.pointB = r.pointB;
+    out.normal = normalizeSafe(r.pointB - r.pointA);
+    out.depth = -r.distance;
+    out.overlap = false;
+    return out;
+}
+
+}
+
+// Penetration depth and contact points of two convex shapes
+// Overlapping shapes go through GJK and then EPA, disjoint shapes report
+// their closest points with the depth as minus the distance
+template <typename A, typename B, AnyFloat T = typename detail::ShapeScalar<A>::Type>
+Contact<T> penetration(const A& a, const B& b) {
+    return detail::penetration<T>(a, b, nullptr);
+}
+
+template <typename A, typename B, AnyFloat T>
+Contact<T> penetration(const A& a, const B& b, GjkCache<T>& cache) {
+    return detail::penetration<T>(a, b, &cache);
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -0,0 +1,457 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vecops.hpp"
+#include "reduce.hpp"
+#include "spatial.hpp"
+#include "sort.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace esd::math {
+
+namespace detail {
+
+// Slots per parallel task when building or scanning a grid
+constexpr std::size_t gridGrain = std::size_t(1) << 14;
+
+// Slots tested at a time when scanning a bucket
+constexpr std::size_t gridScanBlock = 16;
+
+// Pairs collected before they are handed to the caller
+constexpr std::size_t gridPairBlock = 256;
+
+}
+
+// Uniform grid over Vec3 positions with cells hashed into a table of buckets
+// Cell coordinates are ifloor(position / cellSize) and must stay within
+// [-2^20, 2^20) on every axis, since they are stored as Morton keys
+//
+// Points are laid out bucket by bucket, positions as component arrays, so a
+// query reads contiguous memory and the distance tests vectorize
+// Every bucket keeps some spare slots so that update() can move points that
+// crossed into a neighbouring cell without rebuilding
+template <AnyFloat T>
+class HashGrid {
+public:
+    // Slot that holds no point
+    static constexpr std::uint32_t none = 0xffffffff;
+
+private:
+    ThreadPool* pool;
+    RadixSorter<std::uint32_t> sorter;
+
+    T cell = T(1);
+    T invCell = T(1);
+    std::size_t count = 0;
+    std::uint32_t tableBits = 1;
+    Vec3<int> cellMin;
+    Vec3<int> cellMax;
+
+    // Bucket b owns slots [bucketStart[b], bucketStart[b + 1]), of which the
+    // first bucketCount[b] hold points
+    std::vector<std::uint32_t> bucketStart;
+    std::vector<std::uint32_t> bucketCount;
+
+    std::vector<T> slotX;
+    std::vector<T> slotY;
+    std::vector<T> slotZ;
+    std::vector<std::uint64_t> slotKey;
+    std::vector<std::uint32_t> slotIndex;
+
+    // Slot of every input point
+    std::vector<std::uint32_t> pointSlot;
+
+    // Build scratch
+    std::vector<std::uint64_t> pointKey;
+    std::vector<std::uint32_t> pointBucket;
+    std::vector<std::uint32_t> rankStart;
+
+    std::uint64_t keyOf(const Vec3<int>& c) const {
+        return mortonEncode(c);
+    }
+
+    std::uint64_t keyOf(const Vec3<T>& p) const {
+        return keyOf(cellOf(p));
+    }
+
+    std::uint32_t bucketOf(std::uint64_t key) const {
+        // Fibonacci hashing, keeps the top bits of a multiplicative hash
+        return (std::uint32_t)((key * 0x9e3779b97f4a7c15) >> (64 - tableBits));
+    }
+
+    // Spare slots per bucket, empty buckets get some too so points can
+    // move into cells that were empty at build time
+    static std::uint32_t slack(std::uint32_t n) {
+        return n / 2 + 2;
+    }
+
+    void writeSlot(std::uint32_t s, const Vec3<T>& p, std::uint64_t key, std::uint32_t index) {
+        slotX[s] = p[0];
+        slotY[s] = p[1];
+        slotZ[s] = p[2];
+        slotKey[s] = key;
+        slotIndex[s] = index;
+    }
+
+    // Call fn(slot, distSq) for every point of cell key in bucket b within
+    // sqrt(r2) of p, starting at slot first
+    template <typename F>
+    void scan(std::uint32_t b, std::uint32_t first, std::uint64_t key, const Vec3<T>& p, T r2, F&& fn) const {
+        const std::uint32_t end = bucketStart[b] + bucketCount[b];
+        T d2[detail::gridScanBlock];
+        for (std::uint32_t s = first; s < end; s += detail::gridScanBlock) {
+            const std::uint32_t m = std::min<std::uint32_t>(detail::gridScanBlock, end - s);
+            for (std::uint32_t i = 0; i < m; i++) {
+                const T dx = slotX[s + i] - p[0];
+                const T dy = slotY[s + i] - p[1];
+                const T dz = slotZ[s + i] - p[2];
+                d2[i] = dx * dx + dy * dy + dz * dz;
+            }
+            for (std::uint32_t i = 0; i < m; i++)
+                if (d2[i] <= r2 && slotKey[s + i] == key) fn(s + i, d2[i]);
+        }
+    }
+
+    template <typename F>
+    void scanCell(const Vec3<int>& c, const Vec3<T>& p, T r2, F&& fn) const {
+        const std::uint64_t key = keyOf(c);
+        const std::uint32_t b = bucketOf(key);
+        scan(b, bucketStart[b], key, p, r2, fn);
+    }
+
+    bool inBounds(const Vec3<int>& c) const {
+        for (std::size_t i = 0; i < 3; i++) if (c[i] < cellMin[i] || c[i] > cellMax[i]) return false;
+        return true;
+    }
+
+public:
+    explicit HashGrid(ThreadPool& pool = ThreadPool::global()) : pool(&pool), sorter(pool) {}
+
+    // Number of points
+    std::size_t size() const {
+        return count;
+    }
+
+    T cellSize() const {
+        return cell;
+    }
+
+    // Cell containing a position
+    Vec3<int> cellOf(const Vec3<T>& p) const {
+        return ifloor<int>(p * invCell);
+    }
+
+    // Rebuild from scratch
+    // Buckets are filled with a parallel counting sort on bucket index, so
+    // the layout is the same for any thread count
+    void build(std::span<const Vec3<T>> positions, T cellSize) {
+        cell = cellSize;
+        invCell = T(1) / cellSize;
+        count = positions.size();
+        tableBits = std::max<std::uint32_t>(1, (std::uint32_t)std::bit_width(count));
+        const std::size_t table = std::size_t(1) << tableBits;
+
+        if (count > 0) {
+            AABB3<T> box = aabb(*pool, positions);
+            cellMin = cellOf(box.min);
+            cellMax = cellOf(box.max);
+        }
+
+        pointKey.resize(count);
+        pointBucket.resize(count);
+        parallelFor(*pool, count, detail::gridGrain, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                pointKey[i] = keyOf(positions[i]);
+                pointBucket[i] = bucketOf(pointKey[i]);
+            }
+        });
+        std::span<const std::uint32_t> order = sorter.order(std::span<const std::uint32_t>(pointBucket));
+        auto sortedBucket = [&](std::size_t r) { return pointBucket[order[r]]; };
+
+        // Bucket ranges in sorted order, found from the boundaries between
+        // neighbouring ranks
+        // bucketCount holds one past the last rank until the pass below
+        bucketCount.assign(table, 0);
+        rankStart.resize(table);
+        parallelFor(*pool, count, detail::gridGrain, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t r = begin; r < end; r++) {
+                const std::uint32_t b = sortedBucket(r);
+                if (r == 0 || sortedBucket(r - 1) != b) rankStart[b] = (std::uint32_t)r;
+                if (r == count - 1 || sortedBucket(r + 1) != b) bucketCount[b] = (std::uint32_t)(r + 1);
+            }
+        });
+
+        bucketStart.resize(table + 1);
+        std::uint32_t slots = 0;
+        for (std::size_t b = 0; b < table; b++) {
+            if (bucketCount[b]) bucketCount[b] -= rankStart[b];
+            bucketStart[b] = slots;
+            slots += bucketCount[b] + slack(bucketCount[b]);
+        }
+        bucketStart[table] = slots;
+
+        slotX.resize(slots);
+        slotY.resize(slots);
+        slotZ.resize(slots);
+        slotKey.resize(slots);
+        slotIndex.assign(slots, none);
+        pointSlot.resize(count);
+        parallelFor(*pool, count, detail::gridGrain, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t r = begin; r < end; r++) {
+                const std::uint32_t i = order[r];
+                const std::uint32_t b = pointBucket[i];
+                const std::uint32_t s = bucketStart[b] + (std::uint32_t)(r - rankStart[b]);
+                writeSlot(s, positions[i], pointKey[i], i);
+                pointSlot[i] = s;
+            }
+        });
+    }
+
+    // Move the points to new positions, positions must have the same size as
+    // in build()
+    // Points that stay in their cell are updated in place, points that change
+    // cell are moved into the spare slots of their new bucket
+    // Falls back to build() and returns false when more than 1/8 of the
+    // points changed cell or a bucket ran out of spare slots
+    bool update(std::span<const Vec3<T>> positions) {
+        if (positions.size() != count) {
+            build(positions, cell);
+            return false;
+        }
+
+        std::vector<std::vector<std::uint32_t>> moved = parallelMap<std::vector<std::uint32_t>>(
+            *pool, count, detail::gridGrain,
+            [&](std::size_t begin, std::size_t end) {
+                std::vector<std::uint32_t> out;
+                for (std::size_t i = begin; i < end; i++) {
+                    const std::uint32_t s = pointSlot[i];
+                    if (keyOf(positions[i]) == slotKey[s]) writeSlot(s, positions[i], slotKey[s], (std::uint32_t)i);
+                    else out.push_back((std::uint32_t)i);
+                }
+                return out;
+            }
+        );
+
+        std::size_t movedCount = 0;
+        for (const std::vector<std::uint32_t>& m : moved) movedCount += m.size();
+        if (movedCount > count / 8) {
+            build(positions, cell);
+            return false;
+        }
+
+        // Take every moved point out of its old bucket first, so their slots
+        // are free again before anything is inserted
+        for (const std::vector<std::uint32_t>& m : moved) {
+            for (std::uint32_t i : m) {
+                const std::uint32_t s = pointSlot[i];
+                const std::uint32_t from = bucketOf(slotKey[s]);
+                const std::uint32_t last = bucketStart[from] + --bucketCount[from];
+                if (last != s) {
+                    writeSlot(s, { slotX[last], slotY[last], slotZ[last] }, slotKey[last], slotIndex[last]);
+                    pointSlot[slotIndex[s]] = s;
+                }
+                slotIndex[last] = none;
+            }
+        }
+
+        for (const std::vector<std::uint32_t>& m : moved) {
+            for (std::uint32_t i : m) {
+                const Vec3<int> c = cellOf(positions[i]);
+                const std::uint64_t key = keyOf(c);
+                const std::uint32_t to = bucketOf(key);
+                if (bucketStart[to] + bucketCount[to] == bucketStart[to + 1]) {
+                    build(positions, cell);
+                    return false;
+                }
+                const std::uint32_t dst = bucketStart[to] + bucketCount[to]++;
+                writeSlot(dst, positions[i], key, i);
+                pointSlot[i] = dst;
+                cellMin = min(cellMin, c);
+                cellMax = max(cellMax, c);
+            }
+        }
+        return true;
+    }
+
+    // Call fn(index, distSq) for every point within radius of center
+    template <typename F>
+    void forEachInRadius(const Vec3<T>& center, T radius, F&& fn) const {
+        if (count == 0) return;
+        const Vec3<int> lo = max(cellOf(center - radius), cellMin);
+        const Vec3<int> hi = min(cellOf(center + radius), cellMax);
+        const T r2 = radius * radius;
+        Vec3<int> c;
+        for (c[2] = lo[2]; c[2] <= hi[2]; c[2]++)
+            for (c[1] = lo[1]; c[1] <= hi[1]; c[1]++)
+                for (c[0] = lo[0]; c[0] <= hi[0]; c[0]++)
+                    scanCell(c, center, r2, [&](std::uint32_t s, T d2) { fn(slotIndex[s], d2); });
+    }
+
+    // Append the index of every point within radius of center to out
+    void queryRadius(const Vec3<T>& center, T radius, std::vector<std::uint32_t>& out) const {
+        forEachInRadius(center, radius, [&](std::uint32_t i, T) { out.push_back(i); });
+    }
+
+    // Replace out with the indices of the k points closest to center,
+    // nearest first
+    // Searches shells of cells outward, clipped to the occupied bounds, and
+    // stops once no unvisited cell can hold anything closer than the current
+    // k-th point
+    // Once a shell has more cells than there are slots, scanning every slot
+    // is cheaper than probing cells that are mostly empty, so sparse grids
+    // with far apart clusters fall back to that
+    void queryNearest(const Vec3<T>& center, std::size_t k, std::vector<std::uint32_t>& out) const {
+        out.clear();
+        if (count == 0 || k == 0) return;
+
+        // Ordered by distance, then index, so ties do not depend on the
+        // order points are visited in
+        using Entry = std::pair<T, std::uint32_t>;
+        std::vector<Entry> heap;
+        heap.reserve(k);
+        auto visit = [&](std::uint32_t s, T d2) {
+            const Entry e{ d2, slotIndex[s] };
+            if (heap.size() < k) {
+                heap.push_back(e);
+                std::push_heap(heap.begin(), heap.end());
+            } else if (e < heap.front()) {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back() = e;
+                std::push_heap(heap.begin(), heap.end());
+            }
+        };
+
+        const Vec3<int> c = cellOf(center);
+        int rings = 0;
+        for (std::size_t i = 0; i < 3; i++) rings = std::max({ rings, c[i] - cellMin[i], cellMax[i] - c[i] });
+
+        // Cells of the cube of radius s around c within the bounds
+        auto clippedCells = [&](int s) {
+            std::size_t n = 1;
+            for (std::size_t i = 0; i < 3; i++) n *= (std::size_t)std::max(0, std::min(c[i] + s, cellMax[i]) - std::max(c[i] - s, cellMin[i]) + 1);
+            return n;
+        };
+
+        const T all = inf<T>();
+        std::size_t inside = 0;
+        for (int s = 0; s <= rings; s++) {
+            const std::size_t cube = clippedCells(s);
+            if (cube - inside > slotIndex.size()) {
+                heap.clear();
+                for (std::uint32_t t = 0; t < slotIndex.size(); t++) {
+                    if (slotIndex[t] == none) continue;
+                    const T dx = slotX[t] - center[0];
+                    const T dy = slotY[t] - center[1];
+                    const T dz = slotZ[t] - center[2];
+                    visit(t, dx * dx + dy * dy + dz * dz);
+                }
+                break;
+            }
+            inside = cube;
+
+            const Vec3<int> lo = max(c - s, cellMin);
+            const Vec3<int> hi = min(c + s, cellMax);
+            Vec3<int> n;
+            for (n[2] = lo[2]; n[2] <= hi[2]; n[2]++) {
+                for (n[1] = lo[1]; n[1] <= hi[1]; n[1]++) {
+                    // Only the shell of the cube, the inside was visited already
+                    if (std::abs(n[2] - c[2]) == s || std::abs(n[1] - c[1]) == s) {
+                        for (n[0] = lo[0]; n[0] <= hi[0]; n[0]++) scanCell(n, center, all, visit);
+                    } else {
+                        n[0] = c[0] - s;
+                        if (n[0] >= lo[0]) scanCell(n, center, all, visit);
+                        n[0] = c[0] + s;
+                        if (n[0] <= hi[0]) scanCell(n, center, all, visit);
+                    }
+                }
+            }
+            // Anything outside ring s is at least s cells away
+            const T reach = T(s) * cell;
+            if (heap.size() == k && heap.front().first <= reach * reach) break;
+        }
+
+        std::sort_heap(heap.begin(), heap.end());
+        for (const Entry& e : heap) out.push_back(e.second);
+    }
+
+    // Call fn(first, second) with blocks of index pairs closer than radius
+    // Each unordered pair is reported once, first[i] pairs with second[i]
+    // Blocks are built on the thread pool and fn may be called from several
+    // threads at the same time
+    template <typename F>
+    void forEachPair(T radius, F&& fn) const {
+        if (count == 0) return;
+        const T r2 = radius * radius;
+        const int reach = std::max(1, iceil<int>(radius * invCell));
+
+        // Neighbour cells that come after the own cell, so every pair of
+        // cells is visited from one side only
+        std::vector<Vec3<int>> offsets;
+        Vec3<int> d;
+        for (d[2] = -reach; d[2] <= reach; d[2]++)
+            for (d[1] = -reach; d[1] <= reach; d[1]++)
+                for (d[0] = -reach; d[0] <= reach; d[0]++)
+                    if (d[2] > 0 || (d[2] == 0 && (d[1] > 0 || (d[1] == 0 && d[0] > 0))))
+                        offsets.push_back(d);
+
+        parallelFor(*pool, slotIndex.size(), detail::gridGrain, [&](std::size_t begin, std::size_t end) {
+            std::uint32_t first[detail::gridPairBlock];
+            std::uint32_t second[detail::gridPairBlock];
+            std::size_t m = 0;
+            auto flush = [&] {
+                if (m) fn(std::span<const std::uint32_t>(first, m), std::span<const std::uint32_t>(second, m));
+                m = 0;
+            };
+
+            for (std::size_t s = begin; s < end; s++) {
+                if (slotIndex[s] == none) continue;
+                const std::uint32_t self = slotIndex[s];
+                const std::uint64_t key = slotKey[s];
+                const Vec3<T> p(slotX[s], slotY[s], slotZ[s]);
+                auto emit = [&](std::uint32_t t, T) {
+                    first[m] = self;
+                    second[m] = slotIndex[t];
+                    if (++m == detail::gridPairBlock) flush();
+                };
+
+                scan(bucketOf(key), (std::uint32_t)s + 1, key, p, r2, emit);
+                const Vec3<int> c = mortonDecode<3, int>(key);
+                for (const Vec3<int>& o : offsets) {
+                    const Vec3<int> n = c + o;
+                    if (inBounds(n)) scanCell(n, p, r2, emit);
+                }
+            }
+            flush();
+        });
+    }
+};
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -0,0 +1,254 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vec.hpp"
+#include "mat.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace esd::math {
+
+namespace detail {
+
+// Bits of a component as an unsigned integer
+// -0 hashes as +0 since they compare equal
+template <AnyNum T>
+constexpr std::uint64_t hashBits(T n) {
+    if constexpr (std::is_same_v<T, float>) return n == T(0) ? 0 : std::bit_cast<std::uint32_t>(n);
+    else if constexpr (std::is_same_v<T, double>) return n == T(0) ? 0 : std::bit_cast<std::uint64_t>(n);
+    else if constexpr (std::is_floating_point_v<T>) return n == T(0) ? 0 : hashBits((double)n);
+    else if constexpr (std::is_same_v<T, bool>) return n;
+    else return (std::uint64_t)(std::make_unsigned_t<T>)n;
+}
+
+// Fold one component into the running hash
+constexpr std::uint64_t hashStep(std::uint64_t h, std::uint64_t bits) {
+    h = (h ^ bits) * 0x9e3779b97f4a7c15;
+    return h ^ (h >> 32);
+}
+
+// Final avalanche, every input bit affects every output bit
+// Finalizer of MurmurHash3
+constexpr std::uint64_t hashFinish(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccd;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53;
+    h ^= h >> 33;
+    return h;
+}
+
+}
+
+// -- HASHING -- //
+
+// Hash of all components, equal vectors always hash equal
+// Small integer vectors of up to 64 bits in total are packed and mixed once
+template <std::size_t L, AnyNum T>
+constexpr std::uint64_t hashValue(const Vec<L, T>& v) {
+    if constexpr (std::is_integral_v<T> && L * sizeof(T) <= 8 && sizeof(T) < 8) {
+        std::uint64_t packed = 0;
+        for (std::size_t i = 0; i < L; i++) packed |= detail::hashBits(v[i]) << (i * sizeof(T) * 8);
+        return detail::hashFinish(packed ^ L);
+    } else {
+        std::uint64_t h = L;
+        for (std::size_t i = 0; i < L; i++) h = detail::hashStep(h, detail::hashBits(v[i]));
+        return detail::hashFinish(h);
+    }
+}
+
+template <std::size_t M, std::size_t N, AnyNum T>
+constexpr std::uint64_t hashValue(const Mat<M, N, T>& m) {
+    std::uint64_t h = M * 64 + N;
+    for (std::size_t i = 0; i < M; i++)
+        for (std::size_t j = 0; j < N; j++) h = detail::hashStep(h, detail::hashBits(m[i][j]));
+    return detail::hashFinish(h);
+}
+
+// -- FLAT HASH MAP -- //
+
+// Open addressing hash map with linear probing, meant for small trivially
+// copyable keys like integer vectors
+// Entries live in one array, so there is no allocation per element and a
+// lookup usually touches a single cache line
+// Erasing shifts the following entries back instead of leaving tombstones,
+// so lookups do not slow down after many erases
+// Pointers to values are invalidated by any insert or erase
+template <typename K, typename V, typename Hash = std::hash<K>>
+class FlatHashMap {
+private:
+    struct Entry {
+        K key;
+        V value;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<unsigned char> used;
+    std::size_t count = 0;
+    std::size_t mask = 0;
+    Hash hasher;
+
+    std::size_t home(const K& key) const {
+        return (std::size_t)hasher(key) & mask;
+    }
+
+    // Slot holding key, or the empty slot where it would go
+    std::size_t probe(const K& key) const {
+        std::size_t i = home(key);
+        while (used[i] && !(entries[i].key == key)) i = (i + 1) & mask;
+        return i;
+    }
+
+    void rehash(std::size_t slots) {
+        std::vector<Entry> oldEntries(slots);
+        std::vector<unsigned char> oldUsed(slots, 0);
+        oldEntries.swap(entries);
+        oldUsed.swap(used);
+        mask = slots - 1;
+        for (std::size_t i = 0; i < oldUsed.size(); i++) {
+            if (!oldUsed[i]) continue;
+            std::size_t s = probe(oldEntries[i].key);
+            entries[s] = std::move(oldEntries[i]);
+            used[s] = 1;
+        }
+    }
+
+public:
+    FlatHashMap() = default;
+
+    explicit FlatHashMap(std::size_t capacity) {
+        reserve(capacity);
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    // Number of elements that fit without rehashing
+    std::size_t capacity() const {
+        return entries.size() / 8 * 7;
+    }
+
+    // Make room for capacity elements, keeps the load at most 7/8
+    void reserve(std::size_t capacity) {
+        std::size_t slots = std::bit_ceil(std::max<std::size_t>(8, capacity + capacity / 7 + 1));
+        if (slots > entries.size()) rehash(slots);
+    }
+
+    // Remove all elements, keeps the memory
+    void clear() {
+        std::fill(used.begin(), used.end(), (unsigned char)0);
+        count = 0;
+    }
+
+    V* find(const K& key) {
+        if (count == 0) return nullptr;
+        std::size_t s = probe(key);
+        return used[s] ? &entries[s].value : nullptr;
+    }
+
+    const V* find(const K& key) const {
+        return const_cast<FlatHashMap*>(this)->find(key);
+    }
+
+    bool contains(const K& key) const {
+        return find(key) != nullptr;
+    }
+
+    // Insert value if key is not present yet
+    // Returns the value stored for key and whether it was inserted
+    std::pair<V*, bool> insert(const K& key, V value) {
+        if (count + 1 > capacity()) reserve(count + 1);
+        std::size_t s = probe(key);
+        if (used[s]) return { &entries[s].value, false };
+        entries[s] = { key, std::move(value) };
+        used[s] = 1;
+        count++;
+        return { &entries[s].value, true };
+    }
+
+    // Value for key, default constructed if key is not present
+    V& operator[](const K& key) {
+        return *insert(key, V()).first;
+    }
+
+    // Remove key, returns whether it was present
+    bool erase(const K& key) {
+        if (count == 0) return false;
+        std::size_t hole = probe(key);
+        if (!used[hole]) return false;
+
+        // Shift back every following entry that may not sit after the hole
+        for (std::size_t i = (hole + 1) & mask; used[i]; i = (i + 1) & mask) {
+            std::size_t h = home(entries[i].key);
+            // Entries whose home lies cyclically in (hole, i] stay
+            if (((i - h) & mask) < ((i - hole) & mask)) continue;
+            entries[hole] = std::move(entries[i]);
+            hole = i;
+        }
+        used[hole] = 0;
+        count--;
+        return true;
+    }
+
+    // Call fn(key, value) for every element, in no particular order
+    template <typename F>
+    void forEach(F&& fn) {
+        for (std::size_t i = 0; i < used.size(); i++) if (used[i]) fn(std::as_const(entries[i].key), entries[i].value);
+    }
+
+    template <typename F>
+    void forEach(F&& fn) const {
+        for (std::size_t i = 0; i < used.size(); i++) if (used[i]) fn(entries[i].key, entries[i].value);
+    }
+};
+
+}
+
+// -- STANDARD LIBRARY -- //
+
+template <std::size_t L, typename T>
+struct std::hash<esd::math::Vec<L, T>> {
+    std::size_t operator()(const esd::math::Vec<L, T>& v) const noexcept {
+        return (std::size_t)esd::math::hashValue(v);
+    }
+};
+
+template <std::size_t M, std::size_t N, typename T>
+struct std::hash<esd::math::Mat<M, N, T>> {
+    std::size_t operator()(const esd::math::Mat<M, N, T>& m) const noexcept {
+        return (std::size_t)esd::math::hashValue(m);
+    }
+};
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -0,0 +1,315 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "mat.hpp"
+#include "vec.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace esd::math {
+
+// Transform hierarchy for scene graphs
+// Every node has a local affine transform relative to its parent, and update
+// computes the world transform of every node whose local transform or any
+// ancestor changed since the last update
+//
+// Transforms follow mattrans and matrot: points are row vectors, the
+// translation is row 3, and a world transform is local * parent world
+//
+// Nodes are stored level by level, with the children of a node next to each
+// other, and each of the 12 affine components is its own array
+// Levels are updated in order, each split across the thread pool, and nodes
+// are composed in lanes with a 3x4 affine product instead of a full 4x4 one
+
+namespace detail {
+
+// Nodes per parallel task
+constexpr std::size_t hierarchyGrain = std::size_t(1) << 12;
+
+// Nodes checked for changes at once, blocks without any are skipped
+constexpr std::size_t hierarchyBlock = 64;
+
+// Components of an affine transform, the 3x3 linear part row by row and then
+// the translation
+constexpr std::size_t affineSize = 12;
+
+// world = local * parent world for the n nodes from slot first
+// Unchanged nodes in the range are recomputed to the same transform, which
+// is cheaper than selecting per node
+template <AnyFloat T>
+void composeAffine(std::size_t first, std::size_t n, const std::uint32_t* parent,
+    std::array<const T*, affineSize> local, std::array<T*, affineSize> world) {
+    ESEED_MATH_LANES
+    for (std::size_t s = first; s < first + n; s++) {
+        const std::size_t p = parent[s];
+        T l[affineSize];
+        T q[affineSize];
+        for (std::size_t c = 0; c < affineSize; c++) {
+            l[c] = local[c][s];
+            q[c] = world[c][p];
+        }
+        for (std::size_t i = 0; i < 4; i++)
+            for (std::size_t j = 0; j < 3; j++)
+                world[i * 3 + j][s] = l[i * 3] * q[j] + l[i * 3 + 1] * q[3 + j] + l[i * 3 + 2] * q[6 + j] + (i == 3 ? q[9 + j] : T(0));
+    }
+}
+
+}
+
+template <AnyFloat T>
+class Hierarchy {
+public:
+    // Parent of root nodes
+    static constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+
+private:
+    // By node, nodes are numbered in the order they were added
+    std::vector<std::size_t> parents;
+    std::vector<std::size_t> slots;
+
+    // By slot
+    std::vector<std::size_t> nodes;
+    // 32 bits keep the gathers of parent transforms twice as wide
+    std::vector<std::uint32_t> parentSlots;
+    std::array<std::vector<T>, detail::affineSize> local;
+    std::array<std::vector<T>, detail::affineSize> world;
+    std::vector<unsigned char> changed;
+
+    // First slot of every level, and then the slot count
+    std::vector<std::size_t> levelStarts = { 0 };
+
+    // Parents changed since the slots were laid out
+    bool reorder = false;
+    // Lowest changed slot since the last update, slots below it and so every
+    // level above it are unaffected
+    std::size_t changedFrom = none;
+
+    void storeLocal(std::size_t s, const Mat4<T>& m) {
+        for (std::size_t i = 0; i < 4; i++)
+            for (std::size_t j = 0; j < 3; j++) local[i * 3 + j][s] = m[i][j];
+        changed[s] = 1;
+        changedFrom = std::min(changedFrom, s);
+    }
+
+    static Mat4<T> load(const std::array<std::vector<T>, detail::affineSize>& a, std::size_t s) {
+        Mat4<T> out;
+        for (std::size_t i = 0; i < 4; i++) {
+            for (std::size_t j = 0; j < 3; j++) out[i][j] = a[i * 3 + j][s];
+            out[i][3] = i == 3 ? T(1) : T(0);
+        }
+        return out;
+    }
+
+    // Sort the slots breadth first from the roots, keeping node order among
+    // siblings
+    void layout() {
+        const std::size_t n = parents.size();
+
+        // Children of every node, roots first
+        std::vector<std::size_t> first(n + 2, 0);
+        for (std::size_t node = 0; node < n; node++) first[parents[node] == none ? 1 : parents[node] + 2]++;
+        for (std::size_t i = 1; i < n + 2; i++) first[i] += first[i - 1];
+        std::vector<std::size_t> children(n);
+        std::vector<std::size_t> fill(first.begin(), first.end() - 1);
+        for (std::size_t node = 0; node < n; node++) children[fill[parents[node] == none ? 0 : parents[node] + 1]++] = node;
+
+        std::vector<std::size_t> order(children.begin() + first[0], children.begin() + first[1]);
+        order.reserve(n);
+        levelStarts.assign(1, 0);
+        for (std::size_t begin = 0; begin < order.size();) {
+            const std::size_t end = order.size();
+            levelStarts.push_back(end);
+            for (std::size_t i = begin; i < end; i++)
+                order.insert(order.end(), children.begin() + first[order[i] + 1], children.begin() + first[order[i] + 2]);
+            begin = end;
+        }
+
+        std::array<std::vector<T>, detail::affineSize> moved;
+        for (std::size_t c = 0; c < detail::affineSize; c++) moved[c].resize(n);
+        for (std::size_t s = 0; s < n; s++)
+            for (std::size_t c = 0; c < detail::affineSize; c++) moved[c][s] = local[c][slots[order[s]]];
+        local.swap(moved);
+
+        nodes = std::move(order);
+        for (std::size_t s = 0; s < n; s++) slots[nodes[s]] = s;
+        for (std::size_t s = 0; s < n; s++) parentSlots[s] = (std::uint32_t)(parents[nodes[s]] == none ? s : slots[parents[nodes[s]]]);
+        std::fill(changed.begin(), changed.end(), (unsigned char)1);
+        changedFrom = 0;
+        reorder = false;
+    }
+
+public:
+    Hierarchy() = default;
+
+    std::size_t size() const {
+        return parents.size();
+    }
+
+    void reserve(std::size_t capacity) {
+        parents.reserve(capacity);
+        slots.reserve(capacity);
+        nodes.reserve(capacity);
+        parentSlots.reserve(capacity);
+        changed.reserve(capacity);
+        for (std::size_t c = 0; c < detail::affineSize; c++) {
+            local[c].reserve(capacity);
+            world[c].reserve(capacity);
+        }
+    }
+
+    // Add a node below parent, or a root if parent is none
+    // Returns the new node, nodes are numbered from 0 in the order they were
+    // added
+    // Adding nodes lays the slots out again on the next update, which is
+    // linear in the node count, so add whole subtrees at once
+    std::size_t add(std::size_t parent, const Mat4<T>& transform = Mat4<T>::ident()) {
+        const std::size_t node = parents.size();
+        parents.push_back(parent);
+        slots.push_back(node);
+        nodes.push_back(node);
+        parentSlots.push_back((std::uint32_t)node);
+        changed.push_back(1);
+        for (std::size_t c = 0; c < detail::affineSize; c++) {
+            local[c].push_back(T(0));
+            world[c].push_back(T(0));
+        }
+        storeLocal(node, transform);
+        reorder = true;
+        return node;
+    }
+
+    std::size_t parent(std::size_t node) const {
+        return parents[node];
+    }
+
+    // Move node and its subtree below parent, which must not be in the
+    // subtree
+    void setParent(std::size_t node, std::size_t parent) {
+        if (parents[node] == parent) return;
+        parents[node] = parent;
+        reorder = true;
+    }
+
+    // Number of levels, roots are level 0
+    // Only up to date after update
+    std::size_t levelCount() const {
+        return levelStarts.size() - 1;
+    }
+
+    // Local transform, only the affine part is used, the last column is taken
+    // as (0, 0, 0, 1)
+    void setLocal(std::size_t node, const Mat4<T>& transform) {
+        storeLocal(slots[node], transform);
+    }
+
+    // Local transform from scale, then rotation, then translation
+    // rotation is the upper left of a matrot matrix
+    void setLocal(std::size_t node, const Vec3<T>& translation, const Mat3<T>& rotation, const Vec3<T>& scale) {
+        const std::size_t s = slots[node];
+        for (std::size_t i = 0; i < 3; i++) {
+            for (std::size_t j = 0; j < 3; j++) local[i * 3 + j][s] = scale[i] * rotation[i][j];
+            local[9 + i][s] = translation[i];
+        }
+        changed[s] = 1;
+        changedFrom = std::min(changedFrom, s);
+    }
+
+    Mat4<T> getLocal(std::size_t node) const {
+        return load(local, slots[node]);
+    }
+
+    // World transform as of the last update
+    Mat4<T> getWorld(std::size_t node) const {
+        return load(world, slots[node]);
+    }
+
+    // Recompute the world transform of every node whose local transform or
+    // any ancestor changed since the last update
+    // Levels above the first changed node are skipped, the rest are checked
+    // in blocks, and blocks with any change are composed whole
+    // Returns the number of changed nodes
+    std::size_t update(ThreadPool& pool) {
+        if (reorder) layout();
+        if (changedFrom == none) return 0;
+
+        std::array<const T*, detail::affineSize> l;
+        std::array<T*, detail::affineSize> w;
+        for (std::size_t c = 0; c < detail::affineSize; c++) {
+            l[c] = local[c].data();
+            w[c] = world[c].data();
+        }
+        const std::uint32_t* parent = parentSlots.data();
+        unsigned char* flags = changed.data();
+
+        std::size_t count = 0;
+        const std::size_t top = (std::size_t)(std::upper_bound(levelStarts.begin(), levelStarts.end(), changedFrom) - levelStarts.begin()) - 1;
+        for (std::size_t level = top; level + 1 < levelStarts.size(); level++) {
+            const std::size_t first = std::max(levelStarts[level], changedFrom);
+            const std::size_t size = levelStarts[level + 1] - first;
+            const std::vector<std::size_t> counts = parallelMap<std::size_t>(pool, size, detail::hierarchyGrain,
+                [&](std::size_t begin, std::size_t end) {
+                    std::size_t n = 0;
+                    for (std::size_t b = first + begin; b < first + end; b += detail::hierarchyBlock) {
+                        const std::size_t e = std::min(first + end, b + detail::hierarchyBlock);
+
+                        // Children of changed nodes change too
+                        unsigned char any = 0;
+                        for (std::size_t s = b; s < e; s++) {
+                            if (level > 0) flags[s] |= flags[parent[s]];
+                            any |= flags[s];
+                        }
+                        if (!any) continue;
+
+                        for (std::size_t s = b; s < e; s++) n += flags[s];
+                        if (level > 0) {
+                            detail::composeAffine<T>(b, e - b, parent, l, w);
+                        } else {
+                            for (std::size_t c = 0; c < detail::affineSize; c++)
+                                for (std::size_t s = b; s < e; s++) w[c][s] = flags[s] ? l[c][s] : w[c][s];
+                        }
+                    }
+                    return n;
+                });
+            for (std::size_t n : counts) count += n;
+        }
+
+        std::fill(changed.begin() + changedFrom, changed.end(), (unsigned char)0);
+        changedFrom = none;
+        return count;
+    }
+
+    std::size_t update() {
+        return update(ThreadPool::global());
+    }
+};
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
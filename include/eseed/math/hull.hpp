@@ -0,0 +1,462 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vecops.hpp"
+#include "parallel.hpp"
+#include "predicates.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace esd::math {
+
+namespace detail {
+
+// Points per parallel task when searching and partitioning the input
+constexpr std::size_t hullGrain = std::size_t(1) << 13;
+
+// Wider type the face planes are computed in
+template <AnyFloat T>
+using HullWide = std::conditional_t<std::is_same_v<T, float>, double, long double>;
+
+}
+
+// How QuickHull decides whether a point is above a face
+enum class HullMode {
+    // Signed distance to the rounded plane of the face, points closer than a
+    // tolerance scaled to the input count as coplanar
+    Fast,
+    // Exact orientation of the point against the three vertices of the face
+    // Neighbouring faces always agree on points near their shared edge, so
+    // nearly coplanar input keeps a consistent and exactly convex hull, at
+    // some speed cost
+    Robust
+};
+
+// 3D convex hull with the quickhull algorithm
+// The hull is triangulated, faces are wound counter-clockwise seen from
+// outside and their indices refer to the input points, so vertices() or
+// points() feed straight into ConvexPoints for GJK
+// Points within the tolerance of a face are left inside, so coplanar points
+// only become vertices where the hull needs them
+//
+// All buffers belong to the object and are reused, building hulls of similar
+// size over and over does not allocate once they have grown
+// The initial extreme point search and partitioning of the input run on the
+// thread pool, in fixed chunks so the result does not depend on the thread
+// count
+template <AnyFloat T>
+class QuickHull {
+public:
+    using Face = std::array<std::uint32_t, 3>;
+
+private:
+    using Wide = detail::HullWide<T>;
+    static constexpr std::uint32_t none = 0xffffffff;
+
+    struct HullFace {
+        // Vertices and the faces across edges v[i] v[i + 1]
+        std::uint32_t v[3];
+        std::uint32_t nb[3];
+        Vec3<T> n;
+        T d;
+        // Conflict list, points above the face, and the farthest of them
+        std::uint32_t head;
+        std::uint32_t far;
+        T farDist;
+        bool alive;
+        bool visible;
+    };
+
+    ThreadPool* pool;
+    HullMode hullMode;
+    std::span<const Vec3<T>> input;
+    T tolerance = T(0);
+
+    std::vector<HullFace> faceList;
+    // Next point in the same conflict list
+    std::vector<std::uint32_t> nextPoint;
+    // New face whose horizon edge starts at a vertex, while adding a point
+    std::vector<std::uint32_t> startOf;
+
+    // Scratch, kept between builds
+    std::vector<std::uint32_t> work;
+    std::vector<std::uint32_t> visible;
+    std::vector<std::uint32_t> stack;
+    std::vector<std::array<std::uint32_t, 3>> horizon;
+    std::vector<std::uint32_t> created;
+    std::vector<std::vector<std::array<std::uint32_t, 2>>> chunks;
+
+    // Output
+    std::vector<std::uint32_t> vertexList;
+    std::vector<Face> outFaces;
+    std::vector<Vec3<T>> outPoints;
+
+    T distance(const HullFace& f, std::uint32_t p) const {
+        return dot(f.n, input[p]) - f.d;
+    }
+
+    // Side of face f that p is on, positive above it and zero when coplanar
+    int side(const HullFace& f, std::uint32_t p) const {
+        if (hullMode == HullMode::Fast) {
+            const T d = distance(f, p);
+            return d > tolerance ? 1 : d < -tolerance ? -1 : 0;
+        }
+        // Positive when p is below face a b c
+        const T det = orient3d(input[f.v[0]], input[f.v[1]], input[f.v[2]], input[p]);
+        return det < T(0) ? 1 : det > T(0) ? -1 : 0;
+    }
+
+    bool above(const HullFace& f, std::uint32_t p) const {
+        return side(f, p) > 0;
+    }
+
+    std::uint32_t addFace(std::uint32_t a, std::uint32_t b, std::uint32_t c) {
+        HullFace f;
+        f.v[0] = a;
+        f.v[1] = b;
+        f.v[2] = c;
+        f.nb[0] = f.nb[1] = f.nb[2] = none;
+        // The plane only orders conflict points in robust mode but decides
+        // visibility in fast mode
+        Vec3<Wide> pa(input[a][0], input[a][1], input[a][2]);
+        Vec3<Wide> pb(input[b][0], input[b][1], input[b][2]);
+        Vec3<Wide> pc(input[c][0], input[c][1], input[c][2]);
+        const Vec3<Wide> n = normalizeSafe(cross(pb - pa, pc - pa));
+        f.n = Vec3<T>(T(n[0]), T(n[1]), T(n[2]));
+        f.d = T(dot(n, pa));
+        f.head = none;
+        f.far = none;
+        f.farDist = T(0);
+        f.alive = true;
+        f.visible = false;
+        faceList.push_back(f);
+        return (std::uint32_t)(faceList.size() - 1);
+    }
+
+    // Put p on the conflict list of f
+    void assign(std::uint32_t f, std::uint32_t p, T dist) {
+        HullFace& face = faceList[f];
+        nextPoint[p] = face.head;
+        face.head = p;
+        if (face.far == none || dist > face.farDist) {
+            face.far = p;
+            face.farDist = dist;
+        }
+    }
+
+    // Point with the largest metric
+    template <typename F>
+    std::uint32_t farthest(F&& metric) {
+        using Best = std::pair<T, std::uint32_t>;
+        const std::vector<Best> best = parallelMap<Best>(*pool, input.size(), detail::hullGrain,
+            [&](std::size_t begin, std::size_t end) {
+                Best out = { -inf<T>(), (std::uint32_t)begin };
+                for (std::size_t i = begin; i < end; i++) {
+                    const T m = metric(input[i]);
+                    if (m > out.first) out = { m, (std::uint32_t)i };
+                }
+                return out;
+            }
+        );
+        Best out = best[0];
+        for (const Best& b : best) if (b.first > out.first) out = b;
+        return out.second;
+    }
+
+    // Link the faces of the first tetrahedron across their shared edges
+    void linkAll() {
+        for (std::size_t f = 0; f < faceList.size(); f++) {
+            for (std::size_t e = 0; e < 3; e++) {
+                const std::uint32_t a = faceList[f].v[e];
+                const std::uint32_t b = faceList[f].v[(e + 1) % 3];
+                for (std::size_t g = 0; g < faceList.size(); g++)
+                    for (std::size_t k = 0; k < 3; k++)
+                        if (faceList[g].v[k] == b && faceList[g].v[(k + 1) % 3] == a) faceList[f].nb[e] = (std::uint32_t)g;
+            }
+        }
+    }
+
+    bool initial() {
+        // Extremes along the axes, the farthest pair of them spans the
+        // first edge
+        using Extremes = std::array<std::uint32_t, 6>;
+        const std::vector<Extremes> found = parallelMap<Extremes>(*pool, input.size(), detail::hullGrain,
+            [&](std::size_t begin, std::size_t end) {
+                Extremes out;
+                out.fill((std::uint32_t)begin);
+                for (std::size_t i = begin + 1; i < end; i++) {
+                    for (std::size_t c = 0; c < 3; c++) {
+                        if (input[i][c] < input[out[2 * c]][c]) out[2 * c] = (std::uint32_t)i;
+                        if (input[i][c] > input[out[2 * c + 1]][c]) out[2 * c + 1] = (std::uint32_t)i;
+                    }
+                }
+                return out;
+            }
+        );
+        Extremes extreme = found[0];
+        for (const Extremes& e : found) {
+            for (std::size_t c = 0; c < 3; c++) {
+                if (input[e[2 * c]][c] < input[extreme[2 * c]][c]) extreme[2 * c] = e[2 * c];
+                if (input[e[2 * c + 1]][c] > input[extreme[2 * c + 1]][c]) extreme[2 * c + 1] = e[2 * c + 1];
+            }
+        }
+        T magnitude = T(0);
+        for (std::size_t c = 0; c < 3; c++) {
+            const T lo = input[extreme[2 * c]][c];
+            const T hi = input[extreme[2 * c + 1]][c];
+            magnitude += max(std::abs(lo), std::abs(hi));
+        }
+        // Tolerance after Barber, Dobkin and Huhdanpaa
+        tolerance = T(3) * std::numeric_limits<T>::epsilon() * magnitude;
+
+        std::uint32_t p0 = extreme[0];
+        std::uint32_t p1 = extreme[1];
+        T span = T(-1);
+        for (std::size_t i = 0; i < 6; i++) {
+            for (std::size_t j = i + 1; j < 6; j++) {
+                const T s = lengthSq(input[extreme[j]] - input[extreme[i]]);
+                if (s > span) {
+                    span = s;
+                    p0 = extreme[i];
+                    p1 = extreme[j];
+                }
+            }
+        }
+        if (!(span > tolerance * tolerance)) return false;
+
+        const Vec3<T> a = input[p0];
+        const Vec3<T> line = input[p1] - a;
+        const std::uint32_t p2 = farthest([&](const Vec3<T>& p) { return lengthSq(cross(p - a, line)); });
+        const Vec3<T> normal = cross(line, input[p2] - a);
+        if (!(lengthSq(normal) > tolerance * tolerance * lengthSq(line))) return false;
+
+        const std::uint32_t p3 = farthest([&](const Vec3<T>& p) { return std::abs(dot(p - a, normal)); });
+        const T height = dot(input[p3] - a, normal);
+        if (!(std::abs(height) > tolerance * length(normal))) return false;
+
+        // Wind every face outwards, away from the fourth vertex
+        if (height > T(0)) {
+            addFace(p0, p2, p1);
+            addFace(p0, p1, p3);
+            addFace(p1, p2, p3);
+            addFace(p2, p0, p3);
+        } else {
+            addFace(p0, p1, p2);
+            addFace(p0, p3, p1);
+            addFace(p1, p3, p2);
+            addFace(p2, p3, p0);
+        }
+        linkAll();
+
+        // Every point goes to the first face it is above, chunks collect
+        // their assignments on the pool and are linked in order
+        const std::size_t count = (input.size() + detail::hullGrain - 1) / detail::hullGrain;
+        if (chunks.size() < count) chunks.resize(count);
+        pool->run(count, [&](std::size_t c) {
+            std::vector<std::array<std::uint32_t, 2>>& out = chunks[c];
+            out.clear();
+            const std::size_t end = std::min(input.size(), (c + 1) * detail::hullGrain);
+            for (std::size_t i = c * detail::hullGrain; i < end; i++) {
+                if (i == p0 || i == p1 || i == p2 || i == p3) continue;
+                for (std::uint32_t f = 0; f < 4; f++) {
+                    if (above(faceList[f], (std::uint32_t)i)) {
+                        out.push_back({ (std::uint32_t)i, f });
+                        break;
+                    }
+                }
+            }
+        });
+        for (std::size_t c = 0; c < count; c++)
+            for (const std::array<std::uint32_t, 2>& e : chunks[c]) assign(e[1], e[0], distance(faceList[e[1]], e[0]));
+        return true;
+    }
+
+    // Collect the faces reachable from f that side() puts the eye at least
+    // at minSide against, and the horizon edges around them
+    // Returns false when the horizon is not a single loop
+    bool findHorizon(std::uint32_t f, std::uint32_t eye, int minSide) {
+        for (std::uint32_t g : visible) faceList[g].visible = false;
+        visible.clear();
+        horizon.clear();
+        stack.clear();
+        faceList[f].visible = true;
+        visible.push_back(f);
+        stack.push_back(f);
+        while (!stack.empty()) {
+            const std::uint32_t g = stack.back();
+            stack.pop_back();
+            for (std::size_t e = 0; e < 3; e++) {
+                const std::uint32_t h = faceList[g].nb[e];
+                if (faceList[h].visible) continue;
+                if (side(faceList[h], eye) >= minSide) {
+                    faceList[h].visible = true;
+                    visible.push_back(h);
+                    stack.push_back(h);
+                } else {
+                    horizon.push_back({ faceList[g].v[e], faceList[g].v[(e + 1) % 3], h });
+                }
+            }
+        }
+        // The horizon must be one simple loop
+        for (const std::array<std::uint32_t, 3>& e : horizon) startOf[e[0]] = none;
+        for (std::uint32_t i = 0; i < horizon.size(); i++) {
+            if (startOf[horizon[i][0]] != none) return false;
+            startOf[horizon[i][0]] = i;
+        }
+        std::uint32_t i = 0;
+        for (std::size_t steps = 1; steps < horizon.size(); steps++) {
+            i = startOf[horizon[i][1]];
+            if (i == none || i == 0) return false;
+        }
+        return startOf[horizon[i][1]] == 0;
+    }
+
+    // Add the farthest conflict point of face f to the hull
+    void expand(std::uint32_t f) {
+        const std::uint32_t eye = faceList[f].far;
+
+        // Faces the eye sees, found across edges from f, and the edges
+        // between them and the faces it does not see
+        // Faces the eye is coplanar with are replaced too, so vertices in the
+        // middle of a flat region of the hull do not stay, unless that makes
+        // the horizon loop touch itself
+        if (!findHorizon(f, eye, 0)) findHorizon(f, eye, 1);
+
+        // A cone of new faces from the horizon to the eye
+        created.clear();
+        for (const std::array<std::uint32_t, 3>& e : horizon) {
+            const std::uint32_t g = addFace(e[0], e[1], eye);
+            created.push_back(g);
+            HullFace& out = faceList[e[2]];
+            for (std::size_t k = 0; k < 3; k++) if (out.v[k] == e[1] && out.v[(k + 1) % 3] == e[0]) out.nb[k] = g;
+            faceList[g].nb[0] = e[2];
+            startOf[e[0]] = g;
+        }
+        for (std::uint32_t g : created) {
+            const std::uint32_t next = startOf[faceList[g].v[1]];
+            faceList[g].nb[1] = next;
+            faceList[next].nb[2] = g;
+        }
+
+        // Hand the conflict points of the removed faces to the new ones,
+        // points above none of them are inside the hull now
+        for (std::uint32_t g : visible) {
+            HullFace& gone = faceList[g];
+            gone.alive = false;
+            for (std::uint32_t p = gone.head; p != none;) {
+                const std::uint32_t next = nextPoint[p];
+                if (p != eye) {
+                    for (std::uint32_t h : created) {
+                        if (above(faceList[h], p)) {
+                            assign(h, p, distance(faceList[h], p));
+                            break;
+                        }
+                    }
+                }
+                p = next;
+            }
+            gone.head = none;
+        }
+        for (std::uint32_t g : created) if (faceList[g].head != none) work.push_back(g);
+    }
+
+public:
+    explicit QuickHull(ThreadPool& pool = ThreadPool::global(), HullMode mode = HullMode::Fast) :
+        pool(&pool), hullMode(mode) {}
+
+    HullMode mode() const {
+        return hullMode;
+    }
+
+    void setMode(HullMode mode) {
+        hullMode = mode;
+    }
+
+    // Build the hull of points
+    // Returns false and leaves the hull empty when the points do not span a
+    // volume, fewer than 4 of them or all on a plane within the tolerance
+    bool build(std::span<const Vec3<T>> points) {
+        input = points;
+        faceList.clear();
+        vertexList.clear();
+        outFaces.clear();
+        outPoints.clear();
+        work.clear();
+        visible.clear();
+        if (points.size() < 4) return false;
+        nextPoint.assign(points.size(), none);
+        startOf.resize(points.size());
+
+        if (!initial()) {
+            faceList.clear();
+            return false;
+        }
+        for (std::uint32_t f = 0; f < 4; f++) if (faceList[f].head != none) work.push_back(f);
+        while (!work.empty()) {
+            const std::uint32_t f = work.back();
+            work.pop_back();
+            if (faceList[f].alive && faceList[f].head != none) expand(f);
+        }
+
+        // Compact the output, the conflict links are free again and mark
+        // the vertices so they come out in input order
+        std::fill(nextPoint.begin(), nextPoint.end(), none);
+        for (const HullFace& f : faceList) {
+            if (!f.alive) continue;
+            outFaces.push_back({ f.v[0], f.v[1], f.v[2] });
+            for (std::uint32_t v : f.v) nextPoint[v] = 0;
+        }
+        for (std::size_t i = 0; i < points.size(); i++) {
+            if (nextPoint[i] == 0) {
+                vertexList.push_back((std::uint32_t)i);
+                outPoints.push_back(points[i]);
+            }
+        }
+        return true;
+    }
+
+    // Indices of the hull vertices into the input, ascending
+    std::span<const std::uint32_t> vertices() const {
+        return vertexList;
+    }
+
+    // Positions of the hull vertices, in the order of vertices()
+    std::span<const Vec3<T>> points() const {
+        return outPoints;
+    }
+
+    // Triangles as indices into the input, counter-clockwise from outside
+    std::span<const Face> faces() const {
+        return outFaces;
+    }
+};
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -0,0 +1,306 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vecops.hpp"
+#include "soa.hpp"
+#include "poly.hpp"
+#include "bounds.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace esd::math {
+
+// Particle state as component arrays
+// Integrators read force and inverseMass and update position and velocity
+// An inverse mass of 0 makes a particle kinematic, forces, gravity and
+// damping do not act on it and it keeps its velocity, so one at rest stays
+// pinned
+template <AnyFloat T>
+struct Particles {
+    VecSoA<3, T> position;
+    VecSoA<3, T> velocity;
+    // Per-particle force, left as it is by the integrators
+    VecSoA<3, T> force;
+    std::vector<T> inverseMass;
+
+    std::size_t size() const {
+        return inverseMass.size();
+    }
+
+    // New particles are at rest at the origin with unit mass
+    void resize(std::size_t count) {
+        position.resize(count);
+        velocity.resize(count);
+        force.resize(count);
+        inverseMass.resize(count, T(1));
+    }
+
+    void push_back(const Vec3<T>& p, const Vec3<T>& v = Vec3<T>(), T invMass = T(1)) {
+        position.push_back(p);
+        velocity.push_back(v);
+        force.push_back(Vec3<T>());
+        inverseMass.push_back(invMass);
+    }
+
+    void clearForces() {
+        for (std::size_t c = 0; c < 3; c++) std::fill(force.component(c).begin(), force.component(c).end(), T(0));
+    }
+};
+
+// Settings shared by every particle in a step
+template <AnyFloat T>
+struct ParticleStep {
+    T dt;
+    Vec3<T> gravity;
+    // Linear drag, acceleration of -damping * velocity
+    T damping = T(0);
+};
+
+enum class Integrator {
+    // Position from the old velocity, first order, gains energy
+    Euler,
+    // Velocity first and position from the new velocity, first order and
+    // symplectic, the usual choice for games
+    SemiImplicitEuler,
+    // Velocity Verlet, second order and symplectic, evaluates the
+    // acceleration twice
+    Verlet,
+    // Classic fourth order Runge-Kutta, evaluates the acceleration four times
+    RK4
+};
+
+namespace detail {
+
+// Particles per parallel task
+constexpr std::size_t particleGrain = std::size_t(1) << 14;
+
+// Particles staged on the stack at a time, RK4 keeps 15 arrays of them
+constexpr std::size_t particleBlock = 128;
+
+// Field that adds nothing
+struct NoField {
+    template <typename T>
+    void operator()(std::size_t, std::size_t, const T* const*, const T* const*, T* const*) const {}
+};
+
+// Acceleration of m particles from their forces, gravity, damping and the
+// field, zero for kinematic particles
+template <AnyFloat T, typename Field>
+inline void accelerationBlock(
+    std::size_t first, std::size_t m, const T* const* x, const T* const* v, const T* const* f, const T* w,
+    const ParticleStep<T>& step, Field& field, T* const* a
+) {
+    // Without a field the kinematic mask folds into the same loop
+    constexpr bool none = std::is_same_v<Field, NoField>;
+    for (std::size_t c = 0; c < 3; c++) {
+        const T g = step.gravity[c];
+        const T drag = -step.damping;
+        ESEED_MATH_LANES
+        for (std::size_t i = 0; i < m; i++) {
+            const T sum = madd(f[c][i], w[i], madd(drag, v[c][i], g));
+            a[c][i] = !none || w[i] > T(0) ? sum : T(0);
+        }
+    }
+    if constexpr (!none) {
+        field(first, m, x, v, a);
+        for (std::size_t c = 0; c < 3; c++) {
+            ESEED_MATH_LANES
+            for (std::size_t i = 0; i < m; i++) a[c][i] = w[i] > T(0) ? a[c][i] : T(0);
+        }
+    }
+}
+
+// out = a * s + b for m particles
+template <AnyFloat T>
+inline void maddBlock(std::size_t m, const T* const* a, T s, const T* const* b, T* const* out) {
+    for (std::size_t c = 0; c < 3; c++) {
+        ESEED_MATH_LANES
+        for (std::size_t i = 0; i < m; i++) out[c][i] = madd(a[c][i], s, b[c][i]);
+    }
+}
+
+template <Integrator M, AnyFloat T, typename Field>
+void integrateBlock(
+    std::size_t first, std::size_t m, T* const* x, T* const* v, const T* const* f, const T* w,
+    const ParticleStep<T>& step, Field& field
+) {
+    const T dt = step.dt;
+    T aStore[3][particleBlock];
+    T* a[3] = { aStore[0], aStore[1], aStore[2] };
+    accelerationBlock(first, m, x, v, f, w, step, field, a);
+
+    if constexpr (M == Integrator::Euler) {
+        maddBlock(m, v, dt, x, x);
+        maddBlock(m, a, dt, v, v);
+    } else if constexpr (M == Integrator::SemiImplicitEuler) {
+        maddBlock(m, a, dt, v, v);
+        maddBlock(m, v, dt, x, x);
+    } else if constexpr (M == Integrator::Verlet) {
+        // x += v dt + a dt^2 / 2 as (v + a dt / 2) dt, which is also the
+        // half step velocity the new acceleration is evaluated with
+        maddBlock(m, a, dt / T(2), v, v);
+        maddBlock(m, v, dt, x, x);
+        accelerationBlock(first, m, x, v, f, w, step, field, a);
+        maddBlock(m, a, dt / T(2), v, v);
+    } else {
+        T store[4][3][particleBlock];
+        T* xs[3] = { store[0][0], store[0][1], store[0][2] };
+        T* vs[3] = { store[1][0], store[1][1], store[1][2] };
+        T* sumX[3] = { store[2][0], store[2][1], store[2][2] };
+        T* sumV[3] = { store[3][0], store[3][1], store[3][2] };
+        const T half = dt / T(2);
+
+        // k1 = (v, a), the sums collect k1 + 2 k2 + 2 k3 + k4
+        for (std::size_t c = 0; c < 3; c++) {
+            for (std::size_t i = 0; i < m; i++) {
+                sumX[c][i] = v[c][i];
+                sumV[c][i] = a[c][i];
+            }
+        }
+        // k2 and k3 at half steps along the previous stage, k4 at a full one
+        for (std::size_t k = 0; k < 3; k++) {
+            const T h = k < 2 ? half : dt;
+            const T weight = k < 2 ? T(2) : T(1);
+            maddBlock(m, k ? vs : v, h, x, xs);
+            maddBlock(m, a, h, v, vs);
+            accelerationBlock(first, m, xs, vs, f, w, step, field, a);
+            maddBlock(m, vs, weight, sumX, sumX);
+            maddBlock(m, a, weight, sumV, sumV);
+        }
+        maddBlock(m, sumX, dt / T(6), x, x);
+        maddBlock(m, sumV, dt / T(6), v, v);
+    }
+}
+
+// Run kernel(first, m, x, v, f, w) over blocks of particles on the pool
+template <AnyFloat T, typename Kernel>
+void forEachParticleBlock(Particles<T>& particles, ThreadPool& pool, Kernel&& kernel) {
+    parallelFor(pool, particles.size(), particleGrain, [&](std::size_t begin, std::size_t end) {
+        T* x[3];
+        T* v[3];
+        const T* f[3];
+        for (std::size_t b = begin; b < end; b += particleBlock) {
+            const std::size_t m = std::min(particleBlock, end - b);
+            for (std::size_t c = 0; c < 3; c++) {
+                x[c] = particles.position.component(c).data() + b;
+                v[c] = particles.velocity.component(c).data() + b;
+                f[c] = particles.force.component(c).data() + b;
+            }
+            kernel(b, m, x, v, f, particles.inverseMass.data() + b);
+        }
+    });
+}
+
+}
+
+// -- INTEGRATION -- //
+
+// Advance every particle by step.dt
+// field adds accelerations that depend on the state, such as springs or
+// wind, and is called as field(first, m, position, velocity, acceleration)
+// for particles first to first + m with three component pointers each
+// The position and velocity it gets are those of the current stage, not
+// necessarily of the particles, and it is called once per evaluation of the
+// integrator and from several threads at once
+template <AnyFloat T, typename Field = detail::NoField>
+void integrate(
+    Particles<T>& particles,
+    Integrator method,
+    const ParticleStep<T>& step,
+    Field field = {},
+    ThreadPool& pool = ThreadPool::global()
+) {
+    auto run = [&]<Integrator M>() {
+        detail::forEachParticleBlock(particles, pool, [&](std::size_t first, std::size_t m, T* const* x, T* const* v, const T* const* f, const T* w) {
+            detail::integrateBlock<M>(first, m, x, v, f, w, step, field);
+        });
+    };
+    switch (method) {
+    case Integrator::Euler: run.template operator()<Integrator::Euler>(); break;
+    case Integrator::SemiImplicitEuler: run.template operator()<Integrator::SemiImplicitEuler>(); break;
+    case Integrator::Verlet: run.template operator()<Integrator::Verlet>(); break;
+    case Integrator::RK4: run.template operator()<Integrator::RK4>(); break;
+    }
+}
+
+// Without a field, on another pool
+template <AnyFloat T>
+void integrate(Particles<T>& particles, Integrator method, const ParticleStep<T>& step, ThreadPool& pool) {
+    integrate(particles, method, step, detail::NoField{}, pool);
+}
+
+// -- CONSTRAINTS -- //
+
+// Constraints project positions back into the allowed region and remove the
+// velocity leaving it, reflected and scaled by restitution
+// They apply to kinematic particles too
+
+// Keep particles inside box
+template <AnyFloat T>
+void constrainBox(Particles<T>& particles, const AABB3<T>& box, T restitution = T(0), ThreadPool& pool = ThreadPool::global()) {
+    detail::forEachParticleBlock(particles, pool, [&](std::size_t, std::size_t m, T* const* x, T* const* v, const T* const*, const T*) {
+        for (std::size_t c = 0; c < 3; c++) {
+            const T lo = box.min[c];
+            const T hi = box.max[c];
+            ESEED_MATH_LANES
+            for (std::size_t i = 0; i < m; i++) {
+                const T p = x[c][i];
+                const T s = v[c][i];
+                const bool below = p < lo;
+                const bool above = p > hi;
+                x[c][i] = below ? lo : above ? hi : p;
+                v[c][i] = (below && s < T(0)) || (above && s > T(0)) ? -s * restitution : s;
+            }
+        }
+    });
+}
+
+// Keep particles on the side of the plane dot(normal, p) = offset that
+// normal points to, normal must be unit length
+template <AnyFloat T>
+void constrainPlane(Particles<T>& particles, const Vec3<T>& normal, T offset, T restitution = T(0), ThreadPool& pool = ThreadPool::global()) {
+    detail::forEachParticleBlock(particles, pool, [&](std::size_t, std::size_t m, T* const* x, T* const* v, const T* const*, const T*) {
+        const T nx = normal[0], ny = normal[1], nz = normal[2];
+        ESEED_MATH_LANES
+        for (std::size_t i = 0; i < m; i++) {
+            const T depth = std::min(T(0), detail::madd(nz, x[2][i], detail::madd(ny, x[1][i], detail::madd(nx, x[0][i], -offset))));
+            const T into = std::min(T(0), detail::madd(nz, v[2][i], detail::madd(ny, v[1][i], nx * v[0][i])));
+            // Push out along the normal and reflect the velocity into it
+            const T push = depth < T(0) ? -into * (T(1) + restitution) : T(0);
+            x[0][i] = detail::madd(-depth, nx, x[0][i]);
+            x[1][i] = detail::madd(-depth, ny, x[1][i]);
+            x[2][i] = detail::madd(-depth, nz, x[2][i]);
+            v[0][i] = detail::madd(push, nx, v[0][i]);
+            v[1][i] = detail::madd(push, ny, v[1][i]);
+            v[2][i] = detail::madd(push, nz, v[2][i]);
+        }
+    });
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
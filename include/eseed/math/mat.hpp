@@ -106,6 +106,8 @@ using Mat4 = Mat4x4<T>;
 template <std::size_t M, std::size_t N, typename T>
 class Mat : public MatData<M, N, T> {
 public:
+    using MatData<M, N, T>::data;
+
     using Col = Vec<M, T>;
     using Row = Vec<N, T>;
 
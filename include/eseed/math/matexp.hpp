@@ -0,0 +1,271 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "mat.hpp"
+#include "matops.hpp"
+#include "vecops.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <span>
+
+namespace esd::math {
+
+// Matrix exponential and logarithm
+// Entry (i, j) is m[i][j] and matrices act on column vectors, so
+// skew(w) * v == cross(w, v)
+//
+// Rotations have closed forms through the rotation vector, whose direction
+// is the axis and whose length is the angle
+// General matrices use scaling and squaring with a Pade approximant for exp
+// and inverse scaling and squaring with square roots for log
+
+namespace detail {
+
+// Matrices per parallel task for the batch versions
+constexpr std::size_t matexpGrain = std::size_t(1) << 10;
+
+// Pade degree of exp, accurate to double precision once the norm is below
+// 1 / 2
+constexpr int expPadeDegree = 6;
+
+// Maximum absolute row sum
+template <std::size_t N, AnyFloat T>
+constexpr T normInf(const Mat<N, N, T>& m) {
+    T out = T(0);
+    for (std::size_t i = 0; i < N; i++) {
+        T row = T(0);
+        for (std::size_t j = 0; j < N; j++) row += abs(m[i][j]);
+        out = std::max(out, row);
+    }
+    return out;
+}
+
+// Principal square root by the Denman-Beavers iteration
+template <std::size_t N, AnyFloat T>
+Mat<N, N, T> sqrtm(const Mat<N, N, T>& a) {
+    Mat<N, N, T> y = a;
+    Mat<N, N, T> z = Mat<N, N, T>::ident();
+    for (int i = 0; i < 40; i++) {
+        const Mat<N, N, T> next = (y + inverse(z)) * T(0.5);
+        z = (z + inverse(y)) * T(0.5);
+        const T change = normInf(next - y);
+        y = next;
+        if (!(change > T(4) * std::numeric_limits<T>::epsilon() * normInf(y))) break;
+    }
+    return y;
+}
+
+}
+
+// -- ROTATIONS -- //
+
+// Cross product matrix, skew(w) * v == cross(w, v)
+template <AnyFloat T>
+constexpr Mat3<T> skew(const Vec3<T>& w) {
+    return Mat3<T>(
+        T(0), -w[2], w[1],
+        w[2], T(0), -w[0],
+        -w[1], w[0], T(0)
+    );
+}
+
+// Vector of the skew-symmetric part, unskew(skew(w)) == w
+template <AnyFloat T>
+constexpr Vec3<T> unskew(const Mat3<T>& k) {
+    return Vec3<T>(k[2][1] - k[1][2], k[0][2] - k[2][0], k[1][0] - k[0][1]) * T(0.5);
+}
+
+// Rotation by length(w) radians about w, Rodrigues' formula
+// Counterclockwise when looking down w
+template <AnyFloat T>
+Mat3<T> expRotation(const Vec3<T>& w) {
+    const T theta2 = dot(w, w);
+    const T theta = std::sqrt(theta2);
+    // sin(theta) / theta and (1 - cos(theta)) / theta^2, the second from the
+    // half angle to avoid cancellation
+    T a, b;
+    if (theta2 < T(1e-8)) {
+        a = T(1) - theta2 / T(6);
+        b = T(0.5) - theta2 / T(24);
+    } else {
+        const T h = std::sin(theta * T(0.5)) / (theta * T(0.5));
+        a = std::sin(theta) / theta;
+        b = T(0.5) * h * h;
+    }
+    Mat3<T> out;
+    for (std::size_t i = 0; i < 3; i++)
+        for (std::size_t j = 0; j < 3; j++) out[i][j] = b * w[i] * w[j] + (i == j ? T(1) - b * theta2 : T(0));
+    const Vec3<T> aw = w * a;
+    out[0][1] -= aw[2];
+    out[0][2] += aw[1];
+    out[1][0] += aw[2];
+    out[1][2] -= aw[0];
+    out[2][0] -= aw[1];
+    out[2][1] += aw[0];
+    return out;
+}
+
+// Exponential of a skew-symmetric matrix, only the skew part is read
+template <AnyFloat T>
+Mat3<T> expSkew(const Mat3<T>& k) {
+    return expRotation(unskew(k));
+}
+
+// Rotation vector of a rotation matrix, the angle is in [0, pi]
+template <AnyFloat T>
+Vec3<T> logRotation(const Mat3<T>& r) {
+    // v = sin(theta) n from the antisymmetric part, cos(theta) from the trace
+    const Vec3<T> v = unskew(r);
+    const T s = length(v);
+    const T c = std::clamp((r[0][0] + r[1][1] + r[2][2] - T(1)) * T(0.5), T(-1), T(1));
+    const T theta = std::atan2(s, c);
+
+    if (c > T(0)) {
+        // theta / sin(theta), near 1 for small angles
+        return v * (s > T(1e-8) ? theta / s : T(1) + s * s / T(6));
+    }
+
+    // Near pi the antisymmetric part vanishes, the axis comes from the
+    // symmetric part (1 - cos(theta)) n n^T instead
+    std::size_t k = 0;
+    for (std::size_t i = 1; i < 3; i++) if (r[i][i] > r[k][k]) k = i;
+    Vec3<T> n;
+    for (std::size_t i = 0; i < 3; i++) n[i] = (r[i][k] + r[k][i]) * T(0.5) - (i == k ? c : T(0));
+    n = n / std::sqrt(std::max(n[k] * (T(1) - c), std::numeric_limits<T>::min()));
+    if (dot(n, v) < T(0)) n = -n;
+    return normalize(n) * theta;
+}
+
+// Logarithm of a rotation matrix as a skew-symmetric matrix
+template <AnyFloat T>
+Mat3<T> logSkew(const Mat3<T>& r) {
+    return skew(logRotation(r));
+}
+
+// Rotation at t along the shortest arc from a to b, at constant angular
+// speed
+template <AnyFloat T>
+Mat3<T> slerp(const Mat3<T>& a, const Mat3<T>& b, T t) {
+    return a * expRotation(logRotation(transpose(a) * b) * t);
+}
+
+// -- GENERAL MATRICES -- //
+
+// Matrix exponential
+template <std::size_t N, AnyFloat T>
+Mat<N, N, T> exp(const Mat<N, N, T>& a) {
+    // Scale so the norm is at most 1 / 2, then square back up
+    const T norm = detail::normInf(a);
+    int squarings = 0;
+    if (norm > T(0.5)) squarings = std::min(64, (int)std::ceil(std::log2(norm / T(0.5))));
+    const Mat<N, N, T> x = a * std::ldexp(T(1), -squarings);
+
+    // [q / q] Pade approximant, n(x) / d(x) with d(x) = n(-x)
+    constexpr int q = detail::expPadeDegree;
+    Mat<N, N, T> power = x;
+    Mat<N, N, T> num = Mat<N, N, T>::ident() + x * T(0.5);
+    Mat<N, N, T> den = Mat<N, N, T>::ident() - x * T(0.5);
+    T c = T(0.5);
+    for (int k = 2; k <= q; k++) {
+        c = c * T(q - k + 1) / T(k * (2 * q - k + 1));
+        power = power * x;
+        num = num + power * c;
+        den = k % 2 ? den - power * c : den + power * c;
+    }
+    Mat<N, N, T> out = inverse(den) * num;
+    for (int i = 0; i < squarings; i++) out = out * out;
+    return out;
+}
+
+// Principal matrix logarithm
+// Defined when no eigenvalue is zero or negative real, gives NaN or
+// meaningless entries otherwise
+template <std::size_t N, AnyFloat T>
+Mat<N, N, T> log(const Mat<N, N, T>& a) {
+    const Mat<N, N, T> id = Mat<N, N, T>::ident();
+
+    // Square roots until close to the identity, log(a) = 2^k log(a^(1/2^k))
+    Mat<N, N, T> x = a;
+    int roots = 0;
+    while (roots < 64 && detail::normInf(x - id) > T(0.25)) {
+        x = detail::sqrtm(x);
+        roots++;
+    }
+
+    // log(x) = 2 atanh(z) with z = (x - I)(x + I)^-1, whose norm is below
+    // 0.15 here, so the odd series converges quickly
+    const Mat<N, N, T> z = (x - id) * inverse(x + id);
+    const Mat<N, N, T> z2 = z * z;
+    Mat<N, N, T> power = z;
+    Mat<N, N, T> sum = z;
+    for (int k = 3; k <= 25; k += 2) {
+        power = power * z2;
+        sum = sum + power * (T(1) / T(k));
+    }
+    return sum * std::ldexp(T(2), roots);
+}
+
+// Transform at t on the path exp(t log(a^-1 b)) from a to b
+// For rigid transforms this moves at constant linear and angular speed
+template <std::size_t N, AnyFloat T>
+Mat<N, N, T> interpolate(const Mat<N, N, T>& a, const Mat<N, N, T>& b, T t) {
+    return a * exp(log(inverse(a) * b) * t);
+}
+
+// -- BATCH -- //
+
+// Large inputs are split across the thread pool
+
+template <AnyFloat T>
+void expRotation(std::span<const Vec3<T>> in, std::span<Mat3<T>> out) {
+    parallelFor(in.size(), detail::matexpGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = expRotation(in[i]);
+    });
+}
+
+template <AnyFloat T>
+void logRotation(std::span<const Mat3<T>> in, std::span<Vec3<T>> out) {
+    parallelFor(in.size(), detail::matexpGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = logRotation(in[i]);
+    });
+}
+
+template <std::size_t N, AnyFloat T>
+void exp(std::span<const Mat<N, N, T>> in, std::span<Mat<N, N, T>> out) {
+    parallelFor(in.size(), detail::matexpGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = exp(in[i]);
+    });
+}
+
+template <std::size_t N, AnyFloat T>
+void log(std::span<const Mat<N, N, T>> in, std::span<Mat<N, N, T>> out) {
+    parallelFor(in.size(), detail::matexpGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = log(in[i]);
+    });
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -22,6 +22,10 @@
 
 #include "mat.hpp"
 #include "ops.hpp"
+#include "vecops.hpp"
+
+#include <type_traits>
+#include <utility>
 
 namespace esd::math {
 
@@ -30,13 +34,207 @@ namespace esd::math {
 // Transpose of a matrix
 template <std::size_t M, std::size_t N, typename T>
 constexpr Mat<N, M, T> transpose(const Mat<M, N, T> m) {
-    Mat<M, N, T> out;
-    for (std::size_t i = 0; i < M; i++)
-        for (std::size_t j = 0; j < N; j++)
+    Mat<N, M, T> out;
+    for (std::size_t i = 0; i < N; i++)
+        for (std::size_t j = 0; j < M; j++)
             out[i][j] = m[j][i];
     return out;
 }
 
+// -- DETERMINANT AND INVERSE -- //
+
+// Sizes up to 4 use closed forms, with det, adjugate and inverse sharing
+// the same 2x2 minors
+// Larger sizes use Gaussian elimination with partial pivoting and need a
+// floating point type
+
+namespace detail {
+
+// Closed forms read entry (i, j) through a(i, j), so the batch versions
+// can run them on component arrays
+
+template <std::size_t N, typename T, typename Get>
+constexpr T detClosed(Get a) {
+    if constexpr (N == 1) {
+        return a(0, 0);
+    } else if constexpr (N == 2) {
+        return a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0);
+    } else if constexpr (N == 3) {
+        return a(0, 0) * (a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1))
+            + a(0, 1) * (a(1, 2) * a(2, 0) - a(1, 0) * a(2, 2))
+            + a(0, 2) * (a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0));
+    } else {
+        // Laplace expansion along the 2x2 minors of rows 0, 1 and rows 2, 3
+        const T s0 = a(0, 0) * a(1, 1) - a(1, 0) * a(0, 1);
+        const T s1 = a(0, 0) * a(1, 2) - a(1, 0) * a(0, 2);
+        const T s2 = a(0, 0) * a(1, 3) - a(1, 0) * a(0, 3);
+        const T s3 = a(0, 1) * a(1, 2) - a(1, 1) * a(0, 2);
+        const T s4 = a(0, 1) * a(1, 3) - a(1, 1) * a(0, 3);
+        const T s5 = a(0, 2) * a(1, 3) - a(1, 2) * a(0, 3);
+        const T c5 = a(2, 2) * a(3, 3) - a(3, 2) * a(2, 3);
+        const T c4 = a(2, 1) * a(3, 3) - a(3, 1) * a(2, 3);
+        const T c3 = a(2, 1) * a(3, 2) - a(3, 1) * a(2, 2);
+        const T c2 = a(2, 0) * a(3, 3) - a(3, 0) * a(2, 3);
+        const T c1 = a(2, 0) * a(3, 2) - a(3, 0) * a(2, 2);
+        const T c0 = a(2, 0) * a(3, 1) - a(3, 0) * a(2, 1);
+        return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    }
+}
+
+// Adjugate written through b(i, j, value), returns the determinant
+template <std::size_t N, typename T, typename Get, typename Set>
+constexpr T adjugateClosed(Get a, Set b) {
+    if constexpr (N == 1) {
+        b(0, 0, T(1));
+        return a(0, 0);
+    } else if constexpr (N == 2) {
+        b(0, 0, a(1, 1));
+        b(0, 1, -a(0, 1));
+        b(1, 0, -a(1, 0));
+        b(1, 1, a(0, 0));
+        return a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0);
+    } else if constexpr (N == 3) {
+        const T c0 = a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1);
+        const T c1 = a(1, 2) * a(2, 0) - a(1, 0) * a(2, 2);
+        const T c2 = a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0);
+        b(0, 0, c0);
+        b(1, 0, c1);
+        b(2, 0, c2);
+        b(0, 1, a(0, 2) * a(2, 1) - a(0, 1) * a(2, 2));
+        b(1, 1, a(0, 0) * a(2, 2) - a(0, 2) * a(2, 0));
+        b(2, 1, a(0, 1) * a(2, 0) - a(0, 0) * a(2, 1));
+        b(0, 2, a(0, 1) * a(1, 2) - a(0, 2) * a(1, 1));
+        b(1, 2, a(0, 2) * a(1, 0) - a(0, 0) * a(1, 2));
+        b(2, 2, a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0));
+        return a(0, 0) * c0 + a(0, 1) * c1 + a(0, 2) * c2;
+    } else {
+        const T s0 = a(0, 0) * a(1, 1) - a(1, 0) * a(0, 1);
+        const T s1 = a(0, 0) * a(1, 2) - a(1, 0) * a(0, 2);
+        const T s2 = a(0, 0) * a(1, 3) - a(1, 0) * a(0, 3);
+        const T s3 = a(0, 1) * a(1, 2) - a(1, 1) * a(0, 2);
+        const T s4 = a(0, 1) * a(1, 3) - a(1, 1) * a(0, 3);
+        const T s5 = a(0, 2) * a(1, 3) - a(1, 2) * a(0, 3);
+        const T c5 = a(2, 2) * a(3, 3) - a(3, 2) * a(2, 3);
+        const T c4 = a(2, 1) * a(3, 3) - a(3, 1) * a(2, 3);
+        const T c3 = a(2, 1) * a(3, 2) - a(3, 1) * a(2, 2);
+        const T c2 = a(2, 0) * a(3, 3) - a(3, 0) * a(2, 3);
+        const T c1 = a(2, 0) * a(3, 2) - a(3, 0) * a(2, 2);
+        const T c0 = a(2, 0) * a(3, 1) - a(3, 0) * a(2, 1);
+        b(0, 0, a(1, 1) * c5 - a(1, 2) * c4 + a(1, 3) * c3);
+        b(0, 1, -a(0, 1) * c5 + a(0, 2) * c4 - a(0, 3) * c3);
+        b(0, 2, a(3, 1) * s5 - a(3, 2) * s4 + a(3, 3) * s3);
+        b(0, 3, -a(2, 1) * s5 + a(2, 2) * s4 - a(2, 3) * s3);
+        b(1, 0, -a(1, 0) * c5 + a(1, 2) * c2 - a(1, 3) * c1);
+        b(1, 1, a(0, 0) * c5 - a(0, 2) * c2 + a(0, 3) * c1);
+        b(1, 2, -a(3, 0) * s5 + a(3, 2) * s2 - a(3, 3) * s1);
+        b(1, 3, a(2, 0) * s5 - a(2, 2) * s2 + a(2, 3) * s1);
+        b(2, 0, a(1, 0) * c4 - a(1, 1) * c2 + a(1, 3) * c0);
+        b(2, 1, -a(0, 0) * c4 + a(0, 1) * c2 - a(0, 3) * c0);
+        b(2, 2, a(3, 0) * s4 - a(3, 1) * s2 + a(3, 3) * s0);
+        b(2, 3, -a(2, 0) * s4 + a(2, 1) * s2 - a(2, 3) * s0);
+        b(3, 0, -a(1, 0) * c3 + a(1, 1) * c1 - a(1, 2) * c0);
+        b(3, 1, a(0, 0) * c3 - a(0, 1) * c1 + a(0, 2) * c0);
+        b(3, 2, -a(3, 0) * s3 + a(3, 1) * s1 - a(3, 2) * s0);
+        b(3, 3, a(2, 0) * s3 - a(2, 1) * s1 + a(2, 2) * s0);
+        return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    }
+}
+
+// Determinant by Gaussian elimination with partial pivoting
+template <std::size_t N, AnyFloat T>
+constexpr T detGauss(Mat<N, N, T> m) {
+    T out = T(1);
+    for (std::size_t k = 0; k < N; k++) {
+        std::size_t p = k;
+        for (std::size_t i = k + 1; i < N; i++) if (abs(m[i][k]) > abs(m[p][k])) p = i;
+        if (m[p][k] == T(0)) return T(0);
+        if (p != k) {
+            std::swap(m[p], m[k]);
+            out = -out;
+        }
+        out *= m[k][k];
+        for (std::size_t i = k + 1; i < N; i++) {
+            const T f = m[i][k] / m[k][k];
+            for (std::size_t j = k + 1; j < N; j++) m[i][j] -= f * m[k][j];
+        }
+    }
+    return out;
+}
+
+// Inverse by Gauss-Jordan elimination with partial pivoting
+template <std::size_t N, AnyFloat T>
+constexpr Mat<N, N, T> inverseGauss(Mat<N, N, T> m) {
+    Mat<N, N, T> out = Mat<N, N, T>::ident();
+    for (std::size_t k = 0; k < N; k++) {
+        std::size_t p = k;
+        for (std::size_t i = k + 1; i < N; i++) if (abs(m[i][k]) > abs(m[p][k])) p = i;
+        std::swap(m[p], m[k]);
+        std::swap(out[p], out[k]);
+        const T inv = T(1) / m[k][k];
+        for (std::size_t j = 0; j < N; j++) {
+            m[k][j] *= inv;
+            out[k][j] *= inv;
+        }
+        for (std::size_t i = 0; i < N; i++) {
+            if (i == k) continue;
+            const T f = m[i][k];
+            for (std::size_t j = 0; j < N; j++) {
+                m[i][j] -= f * m[k][j];
+                out[i][j] -= f * out[k][j];
+            }
+        }
+    }
+    return out;
+}
+
+}
+
+// Determinant
+template <std::size_t N, AnyNum T>
+constexpr T det(const Mat<N, N, T>& m) {
+    static_assert(N <= 4 || std::is_floating_point_v<T>, "det of matrices larger than 4x4 needs a floating point type");
+    if constexpr (N <= 4) return detail::detClosed<N, T>([&](std::size_t i, std::size_t j) { return m[i][j]; });
+    else return detail::detGauss(m);
+}
+
+// Transpose of the cofactor matrix, adjugate(m) * m == det(m) * ident
+// Defined for singular matrices too
+template <std::size_t N, AnyNum T>
+constexpr Mat<N, N, T> adjugate(const Mat<N, N, T>& m) {
+    static_assert(N <= 4 || std::is_floating_point_v<T>, "adjugate of matrices larger than 4x4 needs a floating point type");
+    Mat<N, N, T> out;
+    if constexpr (N <= 4) {
+        detail::adjugateClosed<N, T>([&](std::size_t i, std::size_t j) { return m[i][j]; },
+            [&](std::size_t i, std::size_t j, T v) { out[i][j] = v; });
+    } else {
+        // Cofactors from the determinants of the minors
+        for (std::size_t i = 0; i < N; i++)
+            for (std::size_t j = 0; j < N; j++) {
+                Mat<N - 1, N - 1, T> minor;
+                for (std::size_t r = 0; r + 1 < N; r++)
+                    for (std::size_t c = 0; c + 1 < N; c++) minor[r][c] = m[r < i ? r : r + 1][c < j ? c : c + 1];
+                out[j][i] = (i + j) % 2 ? -det(minor) : det(minor);
+            }
+    }
+    return out;
+}
+
+// Inverse, singular matrices give infinite or NaN entries
+template <std::size_t N, AnyFloat T>
+constexpr Mat<N, N, T> inverse(const Mat<N, N, T>& m) {
+    if constexpr (N <= 4) {
+        Mat<N, N, T> out;
+        const T d = detail::adjugateClosed<N, T>([&](std::size_t i, std::size_t j) { return m[i][j]; },
+            [&](std::size_t i, std::size_t j, T v) { out[i][j] = v; });
+        const T inv = T(1) / d;
+        for (std::size_t i = 0; i < N; i++)
+            for (std::size_t j = 0; j < N; j++) out[i][j] *= inv;
+        return out;
+    } else {
+        return detail::inverseGauss(m);
+    }
+}
+
 // -- MATRIX GENERATION -- //
 
 // Generate translation matrix from offset
@@ -45,9 +243,9 @@ constexpr Mat4<T> mattrans(const Vec3<T> &translation) {
 
     constexpr T n0 = T(0);
     constexpr T n1 = T(1);
-    const T nx = translation.x;
-    const T ny = translation.y;
-    const T nz = translation.z;
+    const T nx = translation.getX();
+    const T ny = translation.getY();
+    const T nz = translation.getZ();
     
     return Mat4<T> {
         n1, n0, n0, n0,
@@ -64,9 +262,9 @@ constexpr Mat4<T> matrot(const Vec3<T>& axis, T angle) {
     const T c = cos(angle);
     const T s = sin(angle);
     const T t = 1 - c;
-    const T x = axis.x;
-    const T y = axis.y;
-    const T z = axis.z;
+    const T x = axis.getX();
+    const T y = axis.getY();
+    const T z = axis.getZ();
 
     constexpr T n0 = 0;
     constexpr T n1 = 1;
@@ -88,6 +286,240 @@ constexpr Mat4<T> matrot(const Vec3<T>& axis, T angle) {
     };
 }
 
+// -- CAMERA -- //
+
+// Cameras are right-handed and look down -z, with y up
+// Projections map view space depth to [0, 1] like Vulkan and Direct3D
+// Reversed variants map the near plane to 1 and the far plane to 0, which
+// spreads floating point depth precision far more evenly
+// Every builder has a closed-form inverse taking the same arguments, which
+// is cheaper than a general inverse and exact up to rounding
+
+namespace detail {
+
+// Perspective projection from x and y scale and the depth terms
+// Clip space is (x * sx, y * sy, z * a + b, -z)
+template <typename T>
+constexpr Mat4<T> perspectiveMatrix(T sx, T sy, T a, T b) {
+    constexpr T n0 = T(0);
+    return Mat4<T> {
+        sx, n0, n0, n0,
+        n0, sy, n0, n0,
+        n0, n0, a, -T(1),
+        n0, n0, b, n0
+    };
+}
+
+// Inverse of perspectiveMatrix
+template <typename T>
+constexpr Mat4<T> perspectiveInverseMatrix(T sx, T sy, T a, T b) {
+    constexpr T n0 = T(0);
+    return Mat4<T> {
+        T(1) / sx, n0, n0, n0,
+        n0, T(1) / sy, n0, n0,
+        n0, n0, n0, T(1) / b,
+        n0, n0, -T(1), a / b
+    };
+}
+
+// Orthographic projection from scale and offset on every axis
+template <typename T>
+constexpr Mat4<T> orthographicFrom(const Vec3<T>& scale, const Vec3<T>& offset) {
+    constexpr T n0 = T(0);
+    return Mat4<T> {
+        scale[0], n0, n0, n0,
+        n0, scale[1], n0, n0,
+        n0, n0, scale[2], n0,
+        offset[0], offset[1], offset[2], T(1)
+    };
+}
+
+// Inverse of orthographicFrom
+template <typename T>
+constexpr Mat4<T> orthographicInverseFrom(const Vec3<T>& scale, const Vec3<T>& offset) {
+    return orthographicFrom<T>(T(1) / scale, -offset / scale);
+}
+
+// Square root by Newton's method for constant evaluation, where std::sqrt is
+// not available on every compiler
+template <AnyFloat T>
+constexpr T constexprSqrt(T n) {
+    if (!(n > T(0)) || n == inf<T>()) return n == T(0) ? n : (n > T(0) ? n : qnan<T>());
+    // Starting at or above the root the iterates decrease until they settle
+    T x = n > T(1) ? n : T(1);
+    for (;;) {
+        const T next = (x + n / x) / T(2);
+        if (!(next < x)) return x;
+        x = next;
+    }
+}
+
+// normalize that can be evaluated at compile time
+template <AnyFloat T>
+constexpr Vec3<T> cameraAxis(const Vec3<T>& v) {
+    if (std::is_constant_evaluated()) return v / constexprSqrt(lengthSq(v));
+    return normalize(v);
+}
+
+}
+
+// Perspective projections from the focal scale 1 / tan(fovY / 2) instead of
+// the field of view, so they can be evaluated at compile time
+template <AnyFloat T>
+constexpr Mat4<T> perspectiveFrom(T focal, T aspect, T near, T far) {
+    return detail::perspectiveMatrix(focal / aspect, focal, far / (near - far), near * far / (near - far));
+}
+
+template <AnyFloat T>
+constexpr Mat4<T> perspectiveInverseFrom(T focal, T aspect, T near, T far) {
+    return detail::perspectiveInverseMatrix(focal / aspect, focal, far / (near - far), near * far / (near - far));
+}
+
+template <AnyFloat T>
+constexpr Mat4<T> perspectiveReversedFrom(T focal, T aspect, T near, T far) {
+    return detail::perspectiveMatrix(focal / aspect, focal, near / (far - near), near * far / (far - near));
+}
+
+template <AnyFloat T>
+constexpr Mat4<T> perspectiveReversedInverseFrom(T focal, T aspect, T near, T far) {
+    return detail::perspectiveInverseMatrix(focal / aspect, focal, near / (far - near), near * far / (far - near));
+}
+
+template <AnyFloat T>
+constexpr Mat4<T> perspectiveInfiniteFrom(T focal, T aspect, T near) {
+    return detail::perspectiveMatrix(focal / aspect, focal, -T(1), -near);
+}
+
+template <AnyFloat T>
+constexpr Mat4<T> perspectiveInfiniteInverseFrom(T focal, T aspect, T near) {
+    return detail::perspectiveInverseMatrix(focal / aspect, focal, -T(1), -near);
+}
+
+template <AnyFloat T>
+constexpr Mat4<T> perspectiveInfiniteReversedFrom(T focal, T aspect, T near) {
+    return detail::perspectiveMatrix(focal / aspect, focal, T(0), near);
+}
+
+template <AnyFloat T>
+constexpr Mat4<T> perspectiveInfiniteReversedInverseFrom(T focal, T aspect, T near) {
+    return detail::perspectiveInverseMatrix(focal / aspect, focal, T(0), near);
+}
+
+// Perspective projection from vertical field of view in radians, width over
+// height, and near and far plane distances
+// Not constexpr, tan is only evaluated at compile time by some compilers,
+// use the From versions for that
+template <AnyFloat T>
+inline Mat4<T> perspective(T fovY, T aspect, T near, T far) {
+    return perspectiveFrom(T(1) / tan(fovY / T(2)), aspect, near, far);
+}
+
+template <AnyFloat T>
+inline Mat4<T> perspectiveInverse(T fovY, T aspect, T near, T far) {
+    return perspectiveInverseFrom(T(1) / tan(fovY / T(2)), aspect, near, far);
+}
+
+// Perspective projection with near at depth 1 and far at depth 0
+template <AnyFloat T>
+inline Mat4<T> perspectiveReversed(T fovY, T aspect, T near, T far) {
+    return perspectiveReversedFrom(T(1) / tan(fovY / T(2)), aspect, near, far);
+}
+
+template <AnyFloat T>
+inline Mat4<T> perspectiveReversedInverse(T fovY, T aspect, T near, T far) {
+    return perspectiveReversedInverseFrom(T(1) / tan(fovY / T(2)), aspect, near, far);
+}
+
+// Perspective projection with the far plane at infinity
+template <AnyFloat T>
+inline Mat4<T> perspectiveInfinite(T fovY, T aspect, T near) {
+    return perspectiveInfiniteFrom(T(1) / tan(fovY / T(2)), aspect, near);
+}
+
+template <AnyFloat T>
+inline Mat4<T> perspectiveInfiniteInverse(T fovY, T aspect, T near) {
+    return perspectiveInfiniteInverseFrom(T(1) / tan(fovY / T(2)), aspect, near);
+}
+
+// Perspective projection with near at depth 1 and infinity at depth 0
+// The usual choice with a floating point depth buffer
+template <AnyFloat T>
+inline Mat4<T> perspectiveInfiniteReversed(T fovY, T aspect, T near) {
+    return perspectiveInfiniteReversedFrom(T(1) / tan(fovY / T(2)), aspect, near);
+}
+
+template <AnyFloat T>
+inline Mat4<T> perspectiveInfiniteReversedInverse(T fovY, T aspect, T near) {
+    return perspectiveInfiniteReversedInverseFrom(T(1) / tan(fovY / T(2)), aspect, near);
+}
+
+// Orthographic projection of the box between the given view space planes
+template <AnyFloat T>
+constexpr Mat4<T> orthographic(T left, T right, T bottom, T top, T near, T far) {
+    return detail::orthographicFrom<T>(
+        { T(2) / (right - left), T(2) / (top - bottom), T(1) / (near - far) },
+        { (left + right) / (left - right), (bottom + top) / (bottom - top), near / (near - far) }
+    );
+}
+
+template <AnyFloat T>
+constexpr Mat4<T> orthographicInverse(T left, T right, T bottom, T top, T near, T far) {
+    return detail::orthographicInverseFrom<T>(
+        { T(2) / (right - left), T(2) / (top - bottom), T(1) / (near - far) },
+        { (left + right) / (left - right), (bottom + top) / (bottom - top), near / (near - far) }
+    );
+}
+
+// Orthographic projection with near at depth 1 and far at depth 0
+template <AnyFloat T>
+constexpr Mat4<T> orthographicReversed(T left, T right, T bottom, T top, T near, T far) {
+    return detail::orthographicFrom<T>(
+        { T(2) / (right - left), T(2) / (top - bottom), T(1) / (far - near) },
+        { (left + right) / (left - right), (bottom + top) / (bottom - top), far / (far - near) }
+    );
+}
+
+template <AnyFloat T>
+constexpr Mat4<T> orthographicReversedInverse(T left, T right, T bottom, T top, T near, T far) {
+    return detail::orthographicInverseFrom<T>(
+        { T(2) / (right - left), T(2) / (top - bottom), T(1) / (far - near) },
+        { (left + right) / (left - right), (bottom + top) / (bottom - top), far / (far - near) }
+    );
+}
+
+// View matrix of a camera at eye looking at center
+// up must not be parallel to the viewing direction
+// Can be evaluated at compile time, where the axes are normalized with a
+// Newton square root that may differ from std::sqrt in the last bit
+template <AnyFloat T>
+constexpr Mat4<T> lookAt(const Vec3<T>& eye, const Vec3<T>& center, const Vec3<T>& up) {
+    const Vec3<T> f = detail::cameraAxis(center - eye);
+    const Vec3<T> s = detail::cameraAxis(cross(f, up));
+    const Vec3<T> u = cross(s, f);
+    constexpr T n0 = T(0);
+    return Mat4<T> {
+        s[0], u[0], -f[0], n0,
+        s[1], u[1], -f[1], n0,
+        s[2], u[2], -f[2], n0,
+        -dot(s, eye), -dot(u, eye), dot(f, eye), T(1)
+    };
+}
+
+// Camera to world matrix, the rotation transposed and the eye as translation
+template <AnyFloat T>
+constexpr Mat4<T> lookAtInverse(const Vec3<T>& eye, const Vec3<T>& center, const Vec3<T>& up) {
+    const Vec3<T> f = detail::cameraAxis(center - eye);
+    const Vec3<T> s = detail::cameraAxis(cross(f, up));
+    const Vec3<T> u = cross(s, f);
+    constexpr T n0 = T(0);
+    return Mat4<T> {
+        s[0], s[1], s[2], n0,
+        u[0], u[1], u[2], n0,
+        -f[0], -f[1], -f[2], n0,
+        eye[0], eye[1], eye[2], T(1)
+    };
+}
+
 };
 
 namespace esdm = esd::math;
\ No newline at end of file
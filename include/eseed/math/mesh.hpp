@@ -0,0 +1,225 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vecops.hpp"
+#include "parallel.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace esd::math {
+
+// Triangle meshes are given as positions and a flat index span, three
+// indices per triangle
+//
+// Vertex kernels do not scatter face results into vertices, which would make
+// threads race on shared vertices
+// Instead MeshTopology lists the corners around every vertex once per
+// topology, face results are computed face by face and every vertex gathers
+// its own sum, so each output is written by one thread, sums are always in
+// the same order and deforming meshes reuse the topology every frame
+
+namespace detail {
+
+// Faces or vertices per parallel task
+constexpr std::size_t meshGrain = std::size_t(1) << 12;
+
+// Angle between a and b, more accurate than acos for small angles
+template <AnyFloat T>
+T angleBetween(const Vec3<T>& a, const Vec3<T>& b) {
+    return std::atan2(length(cross(a, b)), dot(a, b));
+}
+
+}
+
+// How vertexNormals weights the faces around a vertex
+enum class NormalWeight {
+    // Face area, cheapest, large faces dominate
+    Area,
+    // Angle of the face at the vertex, independent of how the surface is
+    // triangulated
+    Angle
+};
+
+// Corners around every vertex of a triangle mesh
+// Corner 3 f + k is the k-th vertex of face f
+class MeshTopology {
+    ThreadPool* pool;
+    std::vector<std::uint32_t> indexList;
+    // Corners of vertex v are corners[offsets[v]] to corners[offsets[v + 1]]
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> cornerList;
+
+public:
+    explicit MeshTopology(ThreadPool& pool = ThreadPool::global()) : pool(&pool) {}
+
+    // Rebuild from three indices per triangle, all below vertexCount
+    // A counting sort by vertex, corners of a vertex stay in face order
+    void build(std::span<const std::uint32_t> indices, std::size_t vertexCount) {
+        indexList.assign(indices.begin(), indices.end());
+        offsets.assign(vertexCount + 1, 0);
+        for (std::uint32_t v : indices) offsets[v + 1]++;
+        for (std::size_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+        cornerList.resize(indices.size());
+        for (std::size_t c = 0; c < indices.size(); c++) cornerList[offsets[indices[c]]++] = (std::uint32_t)c;
+        // The fill moved every offset to the next vertex
+        for (std::size_t v = vertexCount; v > 0; v--) offsets[v] = offsets[v - 1];
+        offsets[0] = 0;
+    }
+
+    ThreadPool& threadPool() const {
+        return *pool;
+    }
+
+    std::size_t vertexCount() const {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+
+    std::size_t faceCount() const {
+        return indexList.size() / 3;
+    }
+
+    std::span<const std::uint32_t> indices() const {
+        return indexList;
+    }
+
+    // Corners at vertex v
+    std::span<const std::uint32_t> corners(std::size_t v) const {
+        return std::span<const std::uint32_t>(cornerList).subspan(offsets[v], offsets[v + 1] - offsets[v]);
+    }
+};
+
+// Unit normal of every face, counter-clockwise faces point towards the viewer
+// Degenerate faces get the zero vector
+template <AnyFloat T>
+void faceNormals(
+    std::span<const Vec3<T>> positions,
+    std::span<const std::uint32_t> indices,
+    std::span<Vec3<T>> out,
+    ThreadPool& pool = ThreadPool::global()
+) {
+    parallelFor(pool, indices.size() / 3, detail::meshGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t f = begin; f < end; f++) {
+            const Vec3<T>& p0 = positions[indices[3 * f]];
+            const Vec3<T> n = cross(positions[indices[3 * f + 1]] - p0, positions[indices[3 * f + 2]] - p0);
+            out[f] = normalizeSafe(n);
+        }
+    });
+}
+
+// Unit normal of every vertex from the faces around it
+// faces needs one entry per face and is left holding their cross products,
+// twice the area of the face along its normal, first computed face by face
+// and then gathered by every vertex
+// Vertices without faces or only degenerate ones get the zero vector
+template <AnyFloat T>
+void vertexNormals(
+    const MeshTopology& topology,
+    std::span<const Vec3<T>> positions,
+    std::span<Vec3<T>> faces,
+    std::span<Vec3<T>> out,
+    NormalWeight weight = NormalWeight::Area
+) {
+    const std::span<const std::uint32_t> indices = topology.indices();
+    parallelFor(topology.threadPool(), topology.faceCount(), detail::meshGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t f = begin; f < end; f++) {
+            const Vec3<T>& p0 = positions[indices[3 * f]];
+            faces[f] = cross(positions[indices[3 * f + 1]] - p0, positions[indices[3 * f + 2]] - p0);
+        }
+    });
+    parallelFor(topology.threadPool(), topology.vertexCount(), detail::meshGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t v = begin; v < end; v++) {
+            Vec3<T> sum;
+            if (weight == NormalWeight::Area) {
+                for (std::uint32_t c : topology.corners(v)) sum = sum + faces[c / 3];
+            } else {
+                for (std::uint32_t c : topology.corners(v)) {
+                    // Edges leaving the vertex
+                    const std::uint32_t f = c - c % 3;
+                    const Vec3<T> e1 = positions[indices[f + (c + 1) % 3]] - positions[v];
+                    const Vec3<T> e2 = positions[indices[f + (c + 2) % 3]] - positions[v];
+                    sum = sum + normalizeSafe(faces[c / 3]) * detail::angleBetween(e1, e2);
+                }
+            }
+            out[v] = normalizeSafe(sum);
+        }
+    });
+}
+
+// Tangent frame of every vertex for normal mapping, in the manner of
+// MikkTSpace
+// xyz is the unit tangent along increasing u, orthogonal to the vertex
+// normal, and w is +1 or -1 so that cross(normal, tangent) * w is the
+// bitangent along increasing v
+// Faces are weighted by their angle at the vertex, faces with degenerate
+// texture coordinates are skipped and vertices left without a tangent get
+// one orthogonal to their normal
+template <AnyFloat T>
+void vertexTangents(
+    const MeshTopology& topology,
+    std::span<const Vec3<T>> positions,
+    std::span<const Vec2<T>> uvs,
+    std::span<const Vec3<T>> normals,
+    std::span<Vec4<T>> out
+) {
+    const std::span<const std::uint32_t> indices = topology.indices();
+    parallelFor(topology.threadPool(), topology.vertexCount(), detail::meshGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t v = begin; v < end; v++) {
+            Vec3<T> tangent;
+            Vec3<T> bitangent;
+            for (std::uint32_t c : topology.corners(v)) {
+                const std::uint32_t f = c - c % 3;
+                const std::uint32_t i1 = indices[f + (c + 1) % 3];
+                const std::uint32_t i2 = indices[f + (c + 2) % 3];
+                const Vec3<T> e1 = positions[i1] - positions[v];
+                const Vec3<T> e2 = positions[i2] - positions[v];
+                const Vec2<T> d1 = uvs[i1] - uvs[v];
+                const Vec2<T> d2 = uvs[i2] - uvs[v];
+                // Solve e1 = d1.u t + d1.v b, e2 = d2.u t + d2.v b
+                const T det = d1[0] * d2[1] - d2[0] * d1[1];
+                if (det == T(0)) continue;
+                // Directions only, so texture scale does not change the weights
+                const T r = T(1) / det;
+                const T angle = detail::angleBetween(e1, e2);
+                tangent = tangent + normalizeSafe((e1 * d2[1] - e2 * d1[1]) * r) * angle;
+                bitangent = bitangent + normalizeSafe((e2 * d1[0] - e1 * d2[0]) * r) * angle;
+            }
+
+            // Gram-Schmidt against the normal
+            const Vec3<T>& n = normals[v];
+            Vec3<T> t = normalizeSafe(tangent - n * dot(n, tangent));
+            if (t == Vec3<T>()) {
+                // Any direction orthogonal to the normal
+                const Vec3<T> axis = std::abs(n[0]) < T(0.9) ? Vec3<T>(T(1), T(0), T(0)) : Vec3<T>(T(0), T(1), T(0));
+                t = normalizeSafe(axis - n * dot(n, axis));
+            }
+            const T handedness = dot(cross(n, t), bitangent) < T(0) ? T(-1) : T(1);
+            out[v] = Vec4<T>(t[0], t[1], t[2], handedness);
+        }
+    });
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
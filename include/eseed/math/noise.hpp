@@ -0,0 +1,434 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vec.hpp"
+#include "soa.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <utility>
+
+namespace esd::math {
+
+// Gradient noise in 2, 3 and 4 dimensions
+// Every function is written once over W lanes of component arrays; the
+// single point versions use one lane and the batch versions 8 or 16, which
+// the compiler turns into SIMD code, so both give the same results up to
+// rounding
+// Results are roughly in [-1, 1]
+
+// Kinds of noise for noise() and fbm()
+enum class NoiseKind {
+    // Gradients at integer points, smooth interpolation between them
+    Perlin,
+    // Gradients at the corners of a simplex grid, cheaper in 3 and 4
+    // dimensions and without axis aligned artifacts
+    Simplex,
+    // Random values at integer points, smooth interpolation between them
+    Value
+};
+
+// Seeded permutation of 0 to 255 that hashes integer lattice points
+class NoiseTable {
+private:
+    // Stored twice so that hashing never has to wrap
+    // 32 bit entries so that SIMD code can gather them
+    std::array<std::uint32_t, 512> perm;
+
+public:
+    explicit NoiseTable(std::uint64_t seed = 0) {
+        for (std::size_t i = 0; i < 256; i++) perm[i] = (std::uint32_t)i;
+        // Fisher-Yates with a splitmix64 stream
+        std::uint64_t state = seed;
+        for (std::size_t i = 255; i > 0; i--) {
+            std::uint64_t z = (state += 0x9e3779b97f4a7c15);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            z ^= z >> 31;
+            std::swap(perm[i], perm[z % (i + 1)]);
+        }
+        for (std::size_t i = 0; i < 256; i++) perm[256 + i] = perm[i];
+    }
+
+    // Hash of a lattice point given as L integer coordinates, 0 to 255
+    template <std::size_t L>
+    unsigned hash(const int* c) const {
+        unsigned h = perm[c[0] & 255];
+        for (std::size_t i = 1; i < L; i++) h = perm[h + (c[i] & 255)];
+        return h;
+    }
+
+    // The permutation, 512 entries
+    const std::uint32_t* data() const {
+        return perm.data();
+    }
+};
+
+namespace detail {
+
+// Points per parallel task for the batch versions
+constexpr std::size_t noiseGrain = std::size_t(1) << 12;
+
+// Gradient sets, the directions to the edge midpoints of a square, cube
+// and tesseract
+constexpr float noiseGrad2[8][2] = {
+    { 1, 1 }, { -1, 1 }, { 1, -1 }, { -1, -1 }, { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }
+};
+
+// 12 edges, 4 repeated to make a power of two
+constexpr float noiseGrad3[16][3] = {
+    { 1, 1, 0 }, { -1, 1, 0 }, { 1, -1, 0 }, { -1, -1, 0 },
+    { 1, 0, 1 }, { -1, 0, 1 }, { 1, 0, -1 }, { -1, 0, -1 },
+    { 0, 1, 1 }, { 0, -1, 1 }, { 0, 1, -1 }, { 0, -1, -1 },
+    { 1, 1, 0 }, { -1, 1, 0 }, { 0, -1, 1 }, { 0, -1, -1 }
+};
+
+constexpr float noiseGrad4[32][4] = {
+    { 0, 1, 1, 1 }, { 0, 1, 1, -1 }, { 0, 1, -1, 1 }, { 0, 1, -1, -1 },
+    { 0, -1, 1, 1 }, { 0, -1, 1, -1 }, { 0, -1, -1, 1 }, { 0, -1, -1, -1 },
+    { 1, 0, 1, 1 }, { 1, 0, 1, -1 }, { 1, 0, -1, 1 }, { 1, 0, -1, -1 },
+    { -1, 0, 1, 1 }, { -1, 0, 1, -1 }, { -1, 0, -1, 1 }, { -1, 0, -1, -1 },
+    { 1, 1, 0, 1 }, { 1, 1, 0, -1 }, { 1, -1, 0, 1 }, { 1, -1, 0, -1 },
+    { -1, 1, 0, 1 }, { -1, 1, 0, -1 }, { -1, -1, 0, 1 }, { -1, -1, 0, -1 },
+    { 1, 1, 1, 0 }, { 1, 1, -1, 0 }, { 1, -1, 1, 0 }, { 1, -1, -1, 0 },
+    { -1, 1, 1, 0 }, { -1, 1, -1, 0 }, { -1, -1, 1, 0 }, { -1, -1, -1, 0 }
+};
+
+// Gradient set for L dimensions, flattened
+template <std::size_t L>
+inline const float* gradients() {
+    if constexpr (L == 2) return &noiseGrad2[0][0];
+    else if constexpr (L == 3) return &noiseGrad3[0][0];
+    else return &noiseGrad4[0][0];
+}
+
+// Mask that picks a gradient from a hash
+template <std::size_t L>
+constexpr unsigned gradientMask = L == 2 ? 7 : L == 3 ? 15 : 31;
+
+// Simplex grid constants
+// Skew (sqrt(L + 1) - 1) / L, unskew (1 - 1 / sqrt(L + 1)) / L, kernel radius
+// squared and the scale that brings the result to about [-1, 1]
+template <std::size_t L>
+struct SimplexConstants;
+
+template <>
+struct SimplexConstants<2> {
+    static constexpr double skew = 0.36602540378443865;
+    static constexpr double unskew = 0.21132486540518713;
+    static constexpr double radiusSq = 0.5;
+    static constexpr double scale = 70;
+};
+
+template <>
+struct SimplexConstants<3> {
+    static constexpr double skew = 1.0 / 3.0;
+    static constexpr double unskew = 1.0 / 6.0;
+    static constexpr double radiusSq = 0.6;
+    static constexpr double scale = 32;
+};
+
+template <>
+struct SimplexConstants<4> {
+    static constexpr double skew = 0.30901699437494745;
+    static constexpr double unskew = 0.13819660112501053;
+    static constexpr double radiusSq = 0.6;
+    static constexpr double scale = 27;
+};
+
+// The lane kernels below are sequences of simple loops over the W lanes, one
+// per step, so that the compiler can vectorize each step and gather from the
+// tables
+
+// Hash of lattice point cell + offset in every lane
+template <std::size_t L, std::size_t W>
+inline void hashLanes(const std::uint32_t* perm, const int (&cell)[L][W], const int (&offset)[L][W], unsigned (&h)[W]) {
+    ESEED_MATH_LANES
+    for (std::size_t k = 0; k < W; k++) h[k] = perm[(cell[0][k] + offset[0][k]) & 255];
+    for (std::size_t i = 1; i < L; i++)
+        ESEED_MATH_LANES
+        for (std::size_t k = 0; k < W; k++) h[k] = perm[h[k] + ((cell[i][k] + offset[i][k]) & 255)];
+}
+
+// Dot product of the gradient picked by h with d in every lane
+template <std::size_t L, std::size_t W, typename T>
+inline void gradLanes(const unsigned (&h)[W], const T (&d)[L][W], T (&out)[W]) {
+    const float* g = gradients<L>();
+    ESEED_MATH_LANES
+    for (std::size_t k = 0; k < W; k++) out[k] = T(0);
+    for (std::size_t i = 0; i < L; i++)
+        ESEED_MATH_LANES
+        for (std::size_t k = 0; k < W; k++) out[k] += T(g[(h[k] & gradientMask<L>) * L + i]) * d[i][k];
+}
+
+// Perlin and value noise over W lanes
+template <bool Gradient, std::size_t L, std::size_t W, typename T>
+inline void latticeLanes(const NoiseTable& table, const T (&in)[L][W], T (&out)[W]) {
+    int cell[L][W];
+    T frac[L][W];
+    T fade[L][W];
+    for (std::size_t i = 0; i < L; i++) {
+        ESEED_MATH_LANES
+        for (std::size_t k = 0; k < W; k++) {
+            cell[i][k] = ifloor<int>(in[i][k]);
+            const T f = frac[i][k] = in[i][k] - T(cell[i][k]);
+            fade[i][k] = f * f * f * (f * (f * T(6) - T(15)) + T(10));
+        }
+    }
+
+    ESEED_MATH_LANES
+    for (std::size_t k = 0; k < W; k++) out[k] = T(0);
+    for (unsigned corner = 0; corner < (1u << L); corner++) {
+        int offset[L][W];
+        T d[L][W];
+        T weight[W];
+        T v[W];
+        unsigned h[W];
+        ESEED_MATH_LANES
+        for (std::size_t k = 0; k < W; k++) weight[k] = T(1);
+        for (std::size_t i = 0; i < L; i++) {
+            const int bit = (corner >> i) & 1;
+            ESEED_MATH_LANES
+            for (std::size_t k = 0; k < W; k++) {
+                offset[i][k] = bit;
+                d[i][k] = frac[i][k] - T(bit);
+                weight[k] *= bit ? fade[i][k] : T(1) - fade[i][k];
+            }
+        }
+        hashLanes(table.data(), cell, offset, h);
+        if constexpr (Gradient) {
+            gradLanes(h, d, v);
+        } else {
+            ESEED_MATH_LANES
+            for (std::size_t k = 0; k < W; k++) v[k] = T(h[k]) * T(2.0 / 255.0) - T(1);
+        }
+        ESEED_MATH_LANES
+        for (std::size_t k = 0; k < W; k++) out[k] += weight[k] * v[k];
+    }
+}
+
+// Simplex noise over W lanes
+template <std::size_t L, std::size_t W, typename T>
+inline void simplexLanes(const NoiseTable& table, const T (&in)[L][W], T (&out)[W]) {
+    using C = SimplexConstants<L>;
+
+    // Skew into the grid of simplices and find the containing one
+    T s[W];
+    T t[W];
+    int cell[L][W];
+    T x0[L][W];
+    ESEED_MATH_LANES
+    for (std::size_t k = 0; k < W; k++) s[k] = T(0);
+    for (std::size_t i = 0; i < L; i++)
+        ESEED_MATH_LANES
+        for (std::size_t k = 0; k < W; k++) s[k] += in[i][k];
+    ESEED_MATH_LANES
+    for (std::size_t k = 0; k < W; k++) {
+        s[k] *= T(C::skew);
+        t[k] = T(0);
+    }
+    for (std::size_t i = 0; i < L; i++) {
+        ESEED_MATH_LANES
+        for (std::size_t k = 0; k < W; k++) {
+            cell[i][k] = ifloor<int>(in[i][k] + s[k]);
+            t[k] += T(cell[i][k]);
+        }
+    }
+    ESEED_MATH_LANES
+    for (std::size_t k = 0; k < W; k++) t[k] *= T(C::unskew);
+    for (std::size_t i = 0; i < L; i++)
+        ESEED_MATH_LANES
+        for (std::size_t k = 0; k < W; k++) x0[i][k] = in[i][k] - (T(cell[i][k]) - t[k]);
+
+    // The order of the components decides which corners are visited
+    int rank[L][W] = {};
+    for (std::size_t i = 0; i < L; i++) {
+        for (std::size_t j = i + 1; j < L; j++) {
+            ESEED_MATH_LANES
+            for (std::size_t k = 0; k < W; k++) {
+                rank[i][k] += x0[i][k] > x0[j][k];
+                rank[j][k] += x0[i][k] <= x0[j][k];
+            }
+        }
+    }
+
+    ESEED_MATH_LANES
+    for (std::size_t k = 0; k < W; k++) out[k] = T(0);
+    for (std::size_t q = 0; q <= L; q++) {
+        int offset[L][W];
+        T d[L][W];
+        T r[W];
+        T v[W];
+        unsigned h[W];
+        ESEED_MATH_LANES
+        for (std::size_t k = 0; k < W; k++) r[k] = T(C::radiusSq);
+        for (std::size_t i = 0; i < L; i++) {
+            ESEED_MATH_LANES
+            for (std::size_t k = 0; k < W; k++) {
+                offset[i][k] = q > 0 && rank[i][k] >= int(L - q);
+                d[i][k] = x0[i][k] - T(offset[i][k]) + T(q) * T(C::unskew);
+                r[k] -= d[i][k] * d[i][k];
+            }
+        }
+        hashLanes(table.data(), cell, offset, h);
+        gradLanes(h, d, v);
+        ESEED_MATH_LANES
+        for (std::size_t k = 0; k < W; k++) {
+            T f = r[k] > T(0) ? r[k] : T(0);
+            f *= f;
+            out[k] += f * f * v[k];
+        }
+    }
+    ESEED_MATH_LANES
+    for (std::size_t k = 0; k < W; k++) out[k] *= T(C::scale);
+}
+
+template <NoiseKind K, std::size_t L, std::size_t W, typename T>
+inline void noiseLanes(const NoiseTable& table, const T (&in)[L][W], T (&out)[W]) {
+    if constexpr (K == NoiseKind::Simplex) simplexLanes(table, in, out);
+    else latticeLanes<K == NoiseKind::Perlin>(table, in, out);
+}
+
+// Sum of octaves, each at lacunarity times the frequency and gain times the
+// amplitude of the one before, divided by the sum of amplitudes
+template <NoiseKind K, std::size_t L, std::size_t W, typename T>
+inline void fbmLanes(const NoiseTable& table, const T (&in)[L][W], T (&out)[W], int octaves, T lacunarity, T gain) {
+    T p[L][W];
+    T octave[W];
+    for (std::size_t i = 0; i < L; i++)
+        ESEED_MATH_LANES
+        for (std::size_t k = 0; k < W; k++) p[i][k] = in[i][k];
+    ESEED_MATH_LANES
+    for (std::size_t k = 0; k < W; k++) out[k] = T(0);
+
+    T amplitude = T(1);
+    T total = T(0);
+    for (int o = 0; o < octaves; o++) {
+        noiseLanes<K>(table, p, octave);
+        ESEED_MATH_LANES
+        for (std::size_t k = 0; k < W; k++) out[k] += amplitude * octave[k];
+        total += amplitude;
+        amplitude *= gain;
+        for (std::size_t i = 0; i < L; i++)
+            ESEED_MATH_LANES
+            for (std::size_t k = 0; k < W; k++) p[i][k] *= lacunarity;
+    }
+    if (total > T(0))
+        ESEED_MATH_LANES
+        for (std::size_t k = 0; k < W; k++) out[k] /= total;
+}
+
+// Run lanes(in, out) over blocks of W points, the last block padded with 0
+template <std::size_t W, std::size_t L, typename T, typename Get, typename Lanes>
+inline void forEachNoiseBlock(std::size_t count, Get get, std::span<T> out, Lanes lanes) {
+    parallelFor(count, noiseGrain, [&](std::size_t begin, std::size_t end) {
+        T in[L][W];
+        T res[W];
+        for (std::size_t b = begin; b < end; b += W) {
+            const std::size_t m = std::min(W, end - b);
+            for (std::size_t i = 0; i < L; i++)
+                ESEED_MATH_LANES
+                for (std::size_t k = 0; k < W; k++) in[i][k] = k < m ? get(b + k, i) : T(0);
+            lanes(in, res);
+            for (std::size_t k = 0; k < m; k++) out[b + k] = res[k];
+        }
+    });
+}
+
+}
+
+// -- SINGLE POINT -- //
+
+template <NoiseKind K, std::size_t L, AnyFloat T> requires (L >= 2 && L <= 4)
+T noise(const NoiseTable& table, const Vec<L, T>& p) {
+    T in[L][1];
+    T out[1];
+    for (std::size_t i = 0; i < L; i++) in[i][0] = p[i];
+    detail::noiseLanes<K>(table, in, out);
+    return out[0];
+}
+
+template <std::size_t L, AnyFloat T> requires (L >= 2 && L <= 4)
+T perlin(const NoiseTable& table, const Vec<L, T>& p) {
+    return noise<NoiseKind::Perlin>(table, p);
+}
+
+template <std::size_t L, AnyFloat T> requires (L >= 2 && L <= 4)
+T simplex(const NoiseTable& table, const Vec<L, T>& p) {
+    return noise<NoiseKind::Simplex>(table, p);
+}
+
+template <std::size_t L, AnyFloat T> requires (L >= 2 && L <= 4)
+T valueNoise(const NoiseTable& table, const Vec<L, T>& p) {
+    return noise<NoiseKind::Value>(table, p);
+}
+
+// Fractal Brownian motion, octaves of noise at rising frequency and falling
+// amplitude
+template <NoiseKind K, std::size_t L, AnyFloat T> requires (L >= 2 && L <= 4)
+T fbm(const NoiseTable& table, const Vec<L, T>& p, int octaves = 5, T lacunarity = T(2), T gain = T(0.5)) {
+    T in[L][1];
+    T out[1];
+    for (std::size_t i = 0; i < L; i++) in[i][0] = p[i];
+    detail::fbmLanes<K>(table, in, out, octaves, lacunarity, gain);
+    return out[0];
+}
+
+// -- BATCH -- //
+
+// W is the number of lanes evaluated together, 8 fills an AVX register of
+// floats and 16 an AVX-512 one
+// Large inputs are split across the thread pool
+
+template <NoiseKind K, std::size_t W = 8, std::size_t L, typename U, AnyFloat T = std::remove_const_t<U>>
+    requires (L >= 2 && L <= 4)
+void noise(const NoiseTable& table, VecSoASpan<L, U> in, std::span<T> out) {
+    detail::forEachNoiseBlock<W, L>(in.size(), [&](std::size_t j, std::size_t i) { return in.component(i)[j]; }, out,
+        [&](const T (&lanes)[L][W], T (&res)[W]) { detail::noiseLanes<K>(table, lanes, res); });
+}
+
+template <NoiseKind K, std::size_t W = 8, std::size_t L, AnyFloat T> requires (L >= 2 && L <= 4)
+void noise(const NoiseTable& table, std::span<const Vec<L, T>> in, std::span<T> out) {
+    detail::forEachNoiseBlock<W, L>(in.size(), [&](std::size_t j, std::size_t i) { return in[j][i]; }, out,
+        [&](const T (&lanes)[L][W], T (&res)[W]) { detail::noiseLanes<K>(table, lanes, res); });
+}
+
+template <NoiseKind K, std::size_t W = 8, std::size_t L, typename U, AnyFloat T = std::remove_const_t<U>>
+    requires (L >= 2 && L <= 4)
+void fbm(const NoiseTable& table, VecSoASpan<L, U> in, std::span<T> out, int octaves = 5, T lacunarity = T(2), T gain = T(0.5)) {
+    detail::forEachNoiseBlock<W, L>(in.size(), [&](std::size_t j, std::size_t i) { return in.component(i)[j]; }, out,
+        [&](const T (&lanes)[L][W], T (&res)[W]) { detail::fbmLanes<K>(table, lanes, res, octaves, lacunarity, gain); });
+}
+
+template <NoiseKind K, std::size_t W = 8, std::size_t L, AnyFloat T> requires (L >= 2 && L <= 4)
+void fbm(const NoiseTable& table, std::span<const Vec<L, T>> in, std::span<T> out, int octaves = 5, T lacunarity = T(2), T gain = T(0.5)) {
+    detail::forEachNoiseBlock<W, L>(in.size(), [&](std::size_t j, std::size_t i) { return in[j][i]; }, out,
+        [&](const T (&lanes)[L][W], T (&res)[W]) { detail::fbmLanes<K>(table, lanes, res, octaves, lacunarity, gain); });
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -21,12 +21,14 @@
 #pragma once
 
 #include <eseed/math/concepts.hpp>
+#include <eseed/math/simd.hpp>
 #include <cstddef>
 #include <cstdint>
 #include <algorithm>
 #include <type_traits>
 #include <cmath>
 #include <concepts>
+#include <limits>
 
 namespace esd::math {
 
@@ -84,6 +86,18 @@ constexpr T abs(T n) {
     return n < T(0) ? -n : n;
 }
 
+// Minimum
+template <AnyNum T>
+constexpr T min(T a, T b) {
+    return b < a ? b : a;
+}
+
+// Maximum
+template <AnyNum T>
+constexpr T max(T a, T b) {
+    return a < b ? b : a;
+}
+
 // Square
 template <AnyNum T>
 constexpr T sq(T n) {
@@ -96,6 +110,21 @@ inline T sqrt(T n) {
     return (T)std::sqrt(n);
 }
 
+// Reciprocal square root
+template <AnyFloat T>
+inline T rsqrt(T n) {
+    return T(1) / std::sqrt(n);
+}
+
+// Approximate reciprocal square root
+// For float with SSE, relative error is below 2^-21 (about 4.8e-7), otherwise
+// the same as rsqrt
+template <AnyFloat T>
+inline T fastRsqrt(T n) {
+    if constexpr (std::is_same_v<T, float>) return detail::rsqrtApprox(n);
+    else return rsqrt(n);
+}
+
 // Power
 template <AnyNum T0, AnyNum T1>
 inline std::common_type_t<T0, T1> pow(T0 b, T1 e) {
@@ -145,14 +174,14 @@ constexpr I itrunc(T n) {
 template <AnyInt I, AnyFloat T>
 constexpr I ifloor(T n) {
     I ni = (I)n;
-    return n < ni ? ni - 1 : ni;
+    return ni - (I)(n < ni);
 }
 
 // Direct-to-int ceil
 template <AnyInt I, AnyFloat T>
 constexpr I iceil(T n) {
     I ni = (I)n;
-    return n > ni ? ni + 1 : ni;
+    return ni + (I)(n > ni);
 }
 
 // Direct-to-int round
@@ -0,0 +1,215 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace esd::math {
+
+// Fixed set of worker threads used by the batch functions
+// The calling thread always takes part in the work, so a pool of size 1 has
+// no workers and simply runs everything inline
+class ThreadPool {
+private:
+    struct Job {
+        void* context;
+        void (*call)(void*, std::size_t);
+        std::size_t count;
+        std::atomic<std::size_t> next;
+        // First exception thrown by a call, the rest of the indices are skipped
+        std::atomic<bool> failed;
+        std::exception_ptr error;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex submitMutex;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    Job* current = nullptr;
+    std::size_t generation = 0;
+    std::size_t active = 0;
+    bool stopping = false;
+
+    // Number of runs this thread is working on, nested runs execute inline
+    // instead of waiting on a pool whose threads may all be busy with the
+    // outer run, the submitting thread included
+    static std::size_t& runDepth() {
+        thread_local std::size_t depth = 0;
+        return depth;
+    }
+
+    static void work(Job& job) {
+        runDepth()++;
+        try {
+            for (;;) {
+                std::size_t i = job.next.fetch_add(1, std::memory_order_relaxed);
+                if (i >= job.count) break;
+                job.call(job.context, i);
+            }
+        } catch (...) {
+            if (!job.failed.exchange(true)) job.error = std::current_exception();
+            job.next.store(job.count, std::memory_order_relaxed);
+        }
+        runDepth()--;
+    }
+
+    void workerLoop() {
+        std::size_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            Job* job = current;
+            if (!job) continue;
+            active++;
+            lock.unlock();
+            work(*job);
+            lock.lock();
+            if (--active == 0) finished.notify_all();
+        }
+    }
+
+public:
+    // Total thread count including the caller
+    explicit ThreadPool(std::size_t threadCount = std::thread::hardware_concurrency()) {
+        for (std::size_t i = 1; i < threadCount; i++)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    // Pool shared by every batch function that is not given one explicitly
+    static ThreadPool& global() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    // Number of threads that take part in a run, including the caller
+    std::size_t size() const {
+        return workers.size() + 1;
+    }
+
+    // Call fn(i) for every i in [0, count) and wait for all calls to finish
+    // Indices are handed out dynamically, so fn must not depend on which
+    // thread runs it
+    // If a call throws, indices not yet started are skipped and the first
+    // exception is rethrown once every thread has left the run
+    template <typename F>
+    void run(std::size_t count, F&& fn) {
+        if (count == 0) return;
+        if (count == 1 || workers.empty() || runDepth() > 0) {
+            for (std::size_t i = 0; i < count; i++) fn(i);
+            return;
+        }
+
+        std::lock_guard<std::mutex> submit(submitMutex);
+        Job job{
+            &fn,
+            [](void* context, std::size_t i) { (*static_cast<std::remove_reference_t<F>*>(context))(i); },
+            count,
+            0,
+            false,
+            nullptr
+        };
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current = &job;
+            generation++;
+        }
+        wake.notify_all();
+
+        work(job);
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&] { return active == 0; });
+            current = nullptr;
+        }
+        if (job.error) std::rethrow_exception(job.error);
+    }
+};
+
+// Split [0, count) into ranges of grain elements and call fn(begin, end) for
+// each of them on the pool
+// Range boundaries only depend on count and grain, never on the thread count
+template <typename F>
+void parallelFor(ThreadPool& pool, std::size_t count, std::size_t grain, F&& fn) {
+    grain = std::max<std::size_t>(grain, 1);
+    std::size_t chunks = (count + grain - 1) / grain;
+    if (chunks <= 1) {
+        if (count > 0) fn(std::size_t(0), count);
+        return;
+    }
+    pool.run(chunks, [&](std::size_t c) {
+        fn(c * grain, std::min(count, (c + 1) * grain));
+    });
+}
+
+template <typename F>
+void parallelFor(std::size_t count, std::size_t grain, F&& fn) {
+    parallelFor(ThreadPool::global(), count, grain, fn);
+}
+
+// Same ranges as parallelFor, but every call returns a value
+// Results are returned in range order, so combining them front to back gives
+// the same answer no matter how many threads were used
+template <typename T, typename F>
+std::vector<T> parallelMap(ThreadPool& pool, std::size_t count, std::size_t grain, F&& fn) {
+    grain = std::max<std::size_t>(grain, 1);
+    std::vector<T> out((count + grain - 1) / grain);
+    if (out.size() == 1) {
+        out[0] = fn(std::size_t(0), count);
+        return out;
+    }
+    pool.run(out.size(), [&](std::size_t c) {
+        out[c] = fn(c * grain, std::min(count, (c + 1) * grain));
+    });
+    return out;
+}
+
+template <typename T, typename F>
+std::vector<T> parallelMap(std::size_t count, std::size_t grain, F&& fn) {
+    return parallelMap<T>(ThreadPool::global(), count, grain, fn);
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
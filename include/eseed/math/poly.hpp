@@ -0,0 +1,196 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vec.hpp"
+#include "soa.hpp"
+#include "parallel.hpp"
+
+#include <array>
+#include <cmath>
+#include <span>
+#include <type_traits>
+
+namespace esd::math {
+
+// Coefficients are given lowest degree first, so {c0, c1, c2} evaluates
+// c0 + c1 x + c2 x^2
+//
+// Low degrees use Horner's scheme, which needs the fewest operations
+// Higher degrees use Estrin's scheme, which evaluates independent pairs of
+// terms first and so has a dependency chain of log2(n) instead of n
+// multiply-adds, letting the CPU overlap them
+
+namespace detail {
+
+// Lowest degree evaluated with Estrin's scheme
+constexpr std::size_t estrinDegree = 5;
+
+// Elements per parallel task for the batch versions
+constexpr std::size_t polyGrain = std::size_t(1) << 14;
+
+// Component type and count of a scalar or vector argument
+template <typename X>
+struct PolyElement {
+    using Type = X;
+    static constexpr std::size_t size = 1;
+};
+
+template <std::size_t L, typename T>
+struct PolyElement<Vec<L, T>> {
+    using Type = T;
+    static constexpr std::size_t size = L;
+};
+
+// Coefficient as a scalar or a vector with every component set to it
+template <typename X, typename T>
+constexpr X splat(T c) {
+    if constexpr (std::is_arithmetic_v<X>) {
+        return X(c);
+    } else {
+        X out;
+        for (std::size_t i = 0; i < PolyElement<X>::size; i++) out[i] = c;
+        return out;
+    }
+}
+
+// a * b + c, fused when the target has fast FMA
+template <AnyFloat T>
+constexpr T madd(T a, T b, T c) {
+#if defined(FP_FAST_FMA) || defined(FP_FAST_FMAF)
+    if (!std::is_constant_evaluated()) return std::fma(a, b, c);
+#endif
+    return a * b + c;
+}
+
+template <std::size_t L, AnyFloat T>
+constexpr Vec<L, T> madd(const Vec<L, T>& a, const Vec<L, T>& b, const Vec<L, T>& c) {
+    Vec<L, T> out;
+    for (std::size_t i = 0; i < L; i++) out[i] = madd(a[i], b[i], c[i]);
+    return out;
+}
+
+template <std::size_t N, typename X, typename T>
+constexpr X horner(const T* c, const X& x) {
+    X out = splat<X>(c[N - 1]);
+    for (std::size_t i = N - 1; i-- > 0;) out = madd(out, x, splat<X>(c[i]));
+    return out;
+}
+
+template <std::size_t N, typename X, typename T>
+constexpr X estrin(const T* c, const X& x) {
+    // Fold neighbouring terms pairwise, squaring x every level
+    X t[N];
+    for (std::size_t i = 0; i < N; i++) t[i] = splat<X>(c[i]);
+    X p = x;
+    for (std::size_t n = N; n > 1; n = (n + 1) / 2) {
+        for (std::size_t i = 0; i < n / 2; i++) t[i] = madd(t[2 * i + 1], p, t[2 * i]);
+        if (n % 2) t[n / 2] = t[n - 1];
+        p = p * p;
+    }
+    return t[0];
+}
+
+// Pick the scheme for N coefficients
+template <std::size_t N, typename X, typename T>
+constexpr X polyval(const T* c, const X& x) {
+    if constexpr (N == 0) return X();
+    else if constexpr (N - 1 < estrinDegree) return horner<N>(c, x);
+    else return estrin<N>(c, x);
+}
+
+// Run eval on every element of in
+template <typename E, typename Eval>
+void polyvalEach(std::span<const E> in, std::span<E> out, Eval eval) {
+    parallelFor(in.size(), polyGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = eval(in[i]);
+    });
+}
+
+}
+
+// -- COMPILE-TIME COEFFICIENTS -- //
+
+// Coefficients as template arguments, so they fold into the code
+// polyval<1.0, 0.5, 1.0 / 6.0>(x)
+template <auto... C, typename X>
+constexpr X polyval(const X& x) {
+    using T = typename detail::PolyElement<X>::Type;
+    constexpr T c[sizeof...(C) ? sizeof...(C) : 1] = { T(C)... };
+    return detail::polyval<sizeof...(C)>(c, x);
+}
+
+// -- RUNTIME COEFFICIENTS -- //
+
+// Degree fixed at compile time
+template <std::size_t N, AnyFloat T, typename X>
+constexpr X polyval(const std::array<T, N>& c, const X& x) {
+    return detail::polyval<N>(c.data(), x);
+}
+
+// Degree chosen at run time, always uses Horner's scheme
+template <AnyFloat T, typename X>
+constexpr X polyval(std::span<const T> c, const X& x) {
+    if (c.empty()) return X();
+    X out = detail::splat<X>(c.back());
+    for (std::size_t i = c.size() - 1; i-- > 0;) out = detail::madd(out, x, detail::splat<X>(c[i]));
+    return out;
+}
+
+// -- BATCH -- //
+
+// Batch versions split large inputs across the thread pool
+// Output spans must be at least as long as the input, and may be the input
+// Vectors are evaluated component-wise
+
+template <auto... C, AnyFloat T>
+void polyval(std::span<const T> in, std::span<T> out) {
+    detail::polyvalEach(in, out, [](T x) { return polyval<C...>(x); });
+}
+
+template <auto... C, std::size_t L, AnyFloat T>
+void polyval(std::span<const Vec<L, T>> in, std::span<Vec<L, T>> out) {
+    detail::polyvalEach(in, out, [](const Vec<L, T>& x) { return polyval<C...>(x); });
+}
+
+template <auto... C, std::size_t L, typename U, AnyFloat T = std::remove_const_t<U>>
+void polyval(VecSoASpan<L, U> in, VecSoASpan<L, T> out) {
+    for (std::size_t c = 0; c < L; c++) polyval<C...>(std::span<const T>(in.component(c)), out.component(c));
+}
+
+template <std::size_t N, AnyFloat T>
+void polyval(const std::array<T, N>& c, std::span<const T> in, std::span<T> out) {
+    detail::polyvalEach(in, out, [&](T x) { return polyval(c, x); });
+}
+
+template <std::size_t N, std::size_t L, AnyFloat T>
+void polyval(const std::array<T, N>& c, std::span<const Vec<L, T>> in, std::span<Vec<L, T>> out) {
+    detail::polyvalEach(in, out, [&](const Vec<L, T>& x) { return polyval(c, x); });
+}
+
+template <std::size_t N, std::size_t L, typename U, AnyFloat T = std::remove_const_t<U>>
+void polyval(const std::array<T, N>& c, VecSoASpan<L, U> in, VecSoASpan<L, T> out) {
+    for (std::size_t i = 0; i < L; i++) polyval(c, std::span<const T>(in.component(i)), out.component(i));
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
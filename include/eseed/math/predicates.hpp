@@ -0,0 +1,341 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vec.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace esd::math {
+
+// Exact geometric predicates after Shewchuk, "Adaptive Precision
+// Floating-Point Arithmetic and Fast Robust Geometric Predicates"
+//
+// Every predicate first evaluates its determinant the usual way and compares
+// it with a bound on the rounding error, which settles nearly every call
+// Only when the result is within the bound is the determinant evaluated
+// again exactly with expansion arithmetic, numbers held as a sum of
+// non-overlapping floats
+// The sign of the result is always exact, its magnitude is an approximation
+// Inputs must be finite and their products must not overflow or underflow
+
+namespace detail {
+
+// Relative rounding error of one operation
+template <AnyFloat T>
+constexpr T predicateEps = std::numeric_limits<T>::epsilon() / 2;
+
+// Splits a float into two halves of at most half its mantissa bits
+template <AnyFloat T>
+constexpr T predicateSplitter = T((1ull << ((std::numeric_limits<T>::digits + 1) / 2)) + 1);
+
+// Error bounds of the filters
+template <AnyFloat T>
+constexpr T orient2dBound = (T(3) + T(16) * predicateEps<T>) * predicateEps<T>;
+
+template <AnyFloat T>
+constexpr T orient3dBound = (T(7) + T(56) * predicateEps<T>) * predicateEps<T>;
+
+template <AnyFloat T>
+constexpr T incircleBound = (T(10) + T(96) * predicateEps<T>) * predicateEps<T>;
+
+// x + y == a + b exactly with x the rounded sum
+template <AnyFloat T>
+inline void twoSum(T a, T b, T& x, T& y) {
+    x = a + b;
+    const T bv = x - a;
+    const T av = x - bv;
+    y = (a - av) + (b - bv);
+}
+
+// Same with |a| >= |b|
+template <AnyFloat T>
+inline void fastTwoSum(T a, T b, T& x, T& y) {
+    x = a + b;
+    y = b - (x - a);
+}
+
+// x + y == a - b exactly
+template <AnyFloat T>
+inline void twoDiff(T a, T b, T& x, T& y) {
+    x = a - b;
+    const T bv = a - x;
+    const T av = x + bv;
+    y = (a - av) + (bv - b);
+}
+
+// x + y == a * b exactly
+template <AnyFloat T>
+inline void twoProduct(T a, T b, T& x, T& y) {
+    x = a * b;
+#if defined(FP_FAST_FMA) || defined(FP_FAST_FMAF)
+    // Also keeps contraction from breaking the split below
+    y = std::fma(a, b, -x);
+#else
+    const T ca = predicateSplitter<T> * a;
+    const T ahi = ca - (ca - a);
+    const T alo = a - ahi;
+    const T cb = predicateSplitter<T> * b;
+    const T bhi = cb - (cb - b);
+    const T blo = b - bhi;
+    y = alo * blo - (((x - ahi * bhi) - alo * bhi) - ahi * blo);
+#endif
+}
+
+// Sum of up to N non-overlapping components, increasing in magnitude,
+// without zeros
+template <AnyFloat T, std::size_t N>
+struct Expansion {
+    T v[N];
+    std::size_t n = 0;
+
+    // Component with the largest magnitude, which has the sign of the sum
+    T sign() const {
+        return n ? v[n - 1] : T(0);
+    }
+};
+
+template <AnyFloat T>
+inline Expansion<T, 2> expansionDiff(T a, T b) {
+    Expansion<T, 2> out;
+    T x, y;
+    twoDiff(a, b, x, y);
+    if (y != T(0)) out.v[out.n++] = y;
+    if (x != T(0)) out.v[out.n++] = x;
+    return out;
+}
+
+// Shewchuk's fast_expansion_sum_zeroelim, h may not alias e or f
+template <AnyFloat T>
+inline std::size_t expansionSum(const T* e, std::size_t en, const T* f, std::size_t fn, T* h) {
+    if (en == 0) {
+        for (std::size_t i = 0; i < fn; i++) h[i] = f[i];
+        return fn;
+    }
+    if (fn == 0) {
+        for (std::size_t i = 0; i < en; i++) h[i] = e[i];
+        return en;
+    }
+    std::size_t ei = 0;
+    std::size_t fi = 0;
+    std::size_t hn = 0;
+    T q;
+    T x, y;
+    // Merge by magnitude, always adding the smaller next component
+    auto next = [&] {
+        if (fi == fn || (ei < en && (f[fi] > e[ei]) == (f[fi] > -e[ei]))) return e[ei++];
+        return f[fi++];
+    };
+    q = next();
+    if (ei + fi < en + fn) {
+        const T n = next();
+        fastTwoSum(n, q, x, y);
+        q = x;
+        if (y != T(0)) h[hn++] = y;
+        while (ei + fi < en + fn) {
+            twoSum(q, next(), x, y);
+            q = x;
+            if (y != T(0)) h[hn++] = y;
+        }
+    }
+    if (q != T(0) || hn == 0) h[hn++] = q;
+    if (hn == 1 && h[0] == T(0)) hn = 0;
+    return hn;
+}
+
+// Shewchuk's scale_expansion_zeroelim
+template <AnyFloat T>
+inline std::size_t expansionScale(const T* e, std::size_t en, T b, T* h) {
+    std::size_t hn = 0;
+    if (en == 0) return 0;
+    T q, hh;
+    twoProduct(e[0], b, q, hh);
+    if (hh != T(0)) h[hn++] = hh;
+    for (std::size_t i = 1; i < en; i++) {
+        T p1, p0, sum;
+        twoProduct(e[i], b, p1, p0);
+        twoSum(q, p0, sum, hh);
+        if (hh != T(0)) h[hn++] = hh;
+        fastTwoSum(p1, sum, q, hh);
+        if (hh != T(0)) h[hn++] = hh;
+    }
+    if (q != T(0)) h[hn++] = q;
+    return hn;
+}
+
+template <AnyFloat T, std::size_t N, std::size_t M>
+inline Expansion<T, N + M> operator+(const Expansion<T, N>& a, const Expansion<T, M>& b) {
+    Expansion<T, N + M> out;
+    out.n = expansionSum(a.v, a.n, b.v, b.n, out.v);
+    return out;
+}
+
+template <AnyFloat T, std::size_t N>
+inline Expansion<T, N> operator-(const Expansion<T, N>& a) {
+    Expansion<T, N> out = a;
+    for (std::size_t i = 0; i < out.n; i++) out.v[i] = -out.v[i];
+    return out;
+}
+
+template <AnyFloat T, std::size_t N, std::size_t M>
+inline Expansion<T, N + M> operator-(const Expansion<T, N>& a, const Expansion<T, M>& b) {
+    return a + -b;
+}
+
+// Sum of a scaled by every component of b
+template <AnyFloat T, std::size_t N, std::size_t M>
+inline Expansion<T, 2 * N * M> operator*(const Expansion<T, N>& a, const Expansion<T, M>& b) {
+    Expansion<T, 2 * N * M> out;
+    T partial[2 * N];
+    T sum[2 * N * M];
+    for (std::size_t i = 0; i < b.n; i++) {
+        const std::size_t pn = expansionScale(a.v, a.n, b.v[i], partial);
+        for (std::size_t k = 0; k < out.n; k++) sum[k] = out.v[k];
+        out.n = expansionSum(sum, out.n, partial, pn, out.v);
+    }
+    return out;
+}
+
+template <AnyFloat T>
+T orient2dExact(const Vec2<T>& a, const Vec2<T>& b, const Vec2<T>& c) {
+    const auto acx = expansionDiff(a[0], c[0]);
+    const auto acy = expansionDiff(a[1], c[1]);
+    const auto bcx = expansionDiff(b[0], c[0]);
+    const auto bcy = expansionDiff(b[1], c[1]);
+    return (acx * bcy - acy * bcx).sign();
+}
+
+template <AnyFloat T>
+T orient3dExact(const Vec3<T>& a, const Vec3<T>& b, const Vec3<T>& c, const Vec3<T>& d) {
+    const auto adx = expansionDiff(a[0], d[0]);
+    const auto ady = expansionDiff(a[1], d[1]);
+    const auto adz = expansionDiff(a[2], d[2]);
+    const auto bdx = expansionDiff(b[0], d[0]);
+    const auto bdy = expansionDiff(b[1], d[1]);
+    const auto bdz = expansionDiff(b[2], d[2]);
+    const auto cdx = expansionDiff(c[0], d[0]);
+    const auto cdy = expansionDiff(c[1], d[1]);
+    const auto cdz = expansionDiff(c[2], d[2]);
+    return (adz * (bdx * cdy - cdx * bdy) + bdz * (cdx * ady - adx * cdy) + cdz * (adx * bdy - bdx * ady)).sign();
+}
+
+template <AnyFloat T>
+T incircleExact(const Vec2<T>& a, const Vec2<T>& b, const Vec2<T>& c, const Vec2<T>& d) {
+    const auto adx = expansionDiff(a[0], d[0]);
+    const auto ady = expansionDiff(a[1], d[1]);
+    const auto bdx = expansionDiff(b[0], d[0]);
+    const auto bdy = expansionDiff(b[1], d[1]);
+    const auto cdx = expansionDiff(c[0], d[0]);
+    const auto cdy = expansionDiff(c[1], d[1]);
+    const auto alift = adx * adx + ady * ady;
+    const auto blift = bdx * bdx + bdy * bdy;
+    const auto clift = cdx * cdx + cdy * cdy;
+    return (alift * (bdx * cdy - cdx * bdy) + blift * (cdx * ady - adx * cdy) + clift * (adx * bdy - bdx * ady)).sign();
+}
+
+// Filters return true and the determinant when its sign is certain
+
+template <AnyFloat T>
+inline bool orient2dFilter(const Vec2<T>& a, const Vec2<T>& b, const Vec2<T>& c, T& det) {
+    const T left = (a[0] - c[0]) * (b[1] - c[1]);
+    const T right = (a[1] - c[1]) * (b[0] - c[0]);
+    det = left - right;
+    // Shewchuk returns early when the terms have opposite signs, which
+    // cannot cancel, but that branch is unpredictable on random input and
+    // the bound below accepts those cases anyway
+    const T bound = orient2dBound<T> * (std::abs(left) + std::abs(right));
+    return std::abs(det) >= bound;
+}
+
+template <AnyFloat T>
+inline bool orient3dFilter(const Vec3<T>& a, const Vec3<T>& b, const Vec3<T>& c, const Vec3<T>& d, T& det) {
+    const T adx = a[0] - d[0], ady = a[1] - d[1], adz = a[2] - d[2];
+    const T bdx = b[0] - d[0], bdy = b[1] - d[1], bdz = b[2] - d[2];
+    const T cdx = c[0] - d[0], cdy = c[1] - d[1], cdz = c[2] - d[2];
+    const T bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    const T cdxady = cdx * ady, adxcdy = adx * cdy;
+    const T adxbdy = adx * bdy, bdxady = bdx * ady;
+    det = adz * (bdxcdy - cdxbdy) + bdz * (cdxady - adxcdy) + cdz * (adxbdy - bdxady);
+    const T permanent = (std::abs(bdxcdy) + std::abs(cdxbdy)) * std::abs(adz)
+        + (std::abs(cdxady) + std::abs(adxcdy)) * std::abs(bdz)
+        + (std::abs(adxbdy) + std::abs(bdxady)) * std::abs(cdz);
+    const T bound = orient3dBound<T> * permanent;
+    return std::abs(det) > bound;
+}
+
+template <AnyFloat T>
+inline bool incircleFilter(const Vec2<T>& a, const Vec2<T>& b, const Vec2<T>& c, const Vec2<T>& d, T& det) {
+    const T adx = a[0] - d[0], ady = a[1] - d[1];
+    const T bdx = b[0] - d[0], bdy = b[1] - d[1];
+    const T cdx = c[0] - d[0], cdy = c[1] - d[1];
+    const T bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    const T cdxady = cdx * ady, adxcdy = adx * cdy;
+    const T adxbdy = adx * bdy, bdxady = bdx * ady;
+    const T alift = adx * adx + ady * ady;
+    const T blift = bdx * bdx + bdy * bdy;
+    const T clift = cdx * cdx + cdy * cdy;
+    det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) + clift * (adxbdy - bdxady);
+    const T permanent = (std::abs(bdxcdy) + std::abs(cdxbdy)) * alift
+        + (std::abs(cdxady) + std::abs(adxcdy)) * blift
+        + (std::abs(adxbdy) + std::abs(bdxady)) * clift;
+    const T bound = incircleBound<T> * permanent;
+    return std::abs(det) > bound;
+}
+
+}
+
+// Positive when a, b, c turn counter-clockwise, negative when clockwise and
+// zero when they are collinear
+// Approximately twice the signed area of the triangle
+template <AnyFloat T>
+T orient2d(const Vec2<T>& a, const Vec2<T>& b, const Vec2<T>& c) {
+    T det;
+    if (detail::orient2dFilter(a, b, c, det)) return det;
+    return detail::orient2dExact(a, b, c);
+}
+
+// Positive when d is below the plane through a, b, c, which turn
+// counter-clockwise seen from above, negative when above and zero when the
+// four points are coplanar
+// Approximately six times the signed volume of the tetrahedron
+template <AnyFloat T>
+T orient3d(const Vec3<T>& a, const Vec3<T>& b, const Vec3<T>& c, const Vec3<T>& d) {
+    T det;
+    if (detail::orient3dFilter(a, b, c, d, det)) return det;
+    return detail::orient3dExact(a, b, c, d);
+}
+
+// Positive when d is inside the circle through a, b, c, which must turn
+// counter-clockwise, negative when outside and zero when the four points are
+// cocircular
+// The sign flips when a, b, c turn clockwise
+template <AnyFloat T>
+T incircle(const Vec2<T>& a, const Vec2<T>& b, const Vec2<T>& c, const Vec2<T>& d) {
+    T det;
+    if (detail::incircleFilter(a, b, c, d, det)) return det;
+    return detail::incircleExact(a, b, c, d);
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -0,0 +1,293 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vec.hpp"
+#include "ops.hpp"
+#include "soa.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+namespace esd::math {
+
+// Random numbers from a counter-based generator
+// Sample i is a pure function of the seed, the stream and i, so any range
+// of samples can be produced on its own, in any order and on any thread,
+// and batch results never depend on how the work was split
+
+// Philox4x32-10 by Salmon et al., "Parallel random numbers: as easy as
+// 1, 2, 3"
+// Ten rounds of 32 bit multiplies and xors turn a 128 bit counter into 128
+// random bits, passing BigCrush
+class Philox {
+public:
+    // Four random words
+    using Block = std::array<std::uint32_t, 4>;
+
+    static constexpr std::uint32_t mul0 = 0xd2511f53;
+    static constexpr std::uint32_t mul1 = 0xcd9e8d57;
+    static constexpr std::uint32_t weyl0 = 0x9e3779b9;
+    static constexpr std::uint32_t weyl1 = 0xbb67ae85;
+
+private:
+    std::uint32_t key[2];
+
+public:
+    constexpr explicit Philox(std::uint64_t seed = 0) : key{ (std::uint32_t)seed, (std::uint32_t)(seed >> 32) } {}
+
+    // Words for counter (index, stream)
+    constexpr Block operator()(std::uint64_t index, std::uint64_t stream = 0) const {
+        std::uint32_t c[4] = { (std::uint32_t)index, (std::uint32_t)(index >> 32), (std::uint32_t)stream, (std::uint32_t)(stream >> 32) };
+        std::uint32_t k0 = key[0];
+        std::uint32_t k1 = key[1];
+        for (int r = 0; r < 10; r++) {
+            const std::uint64_t p0 = (std::uint64_t)mul0 * c[0];
+            const std::uint64_t p1 = (std::uint64_t)mul1 * c[2];
+            const std::uint32_t n0 = (std::uint32_t)(p1 >> 32) ^ c[1] ^ k0;
+            const std::uint32_t n2 = (std::uint32_t)(p0 >> 32) ^ c[3] ^ k1;
+            c[0] = n0;
+            c[1] = (std::uint32_t)p1;
+            c[2] = n2;
+            c[3] = (std::uint32_t)p0;
+            k0 += weyl0;
+            k1 += weyl1;
+        }
+        return { c[0], c[1], c[2], c[3] };
+    }
+
+    // Key words, the seed split in two
+    constexpr std::uint32_t key0() const {
+        return key[0];
+    }
+
+    constexpr std::uint32_t key1() const {
+        return key[1];
+    }
+};
+
+namespace detail {
+
+// Samples per parallel task for the batch versions
+constexpr std::size_t randomGrain = std::size_t(1) << 14;
+
+// Samples whose words are generated together
+constexpr std::size_t randomLanes = 16;
+
+// Word to [0, 1) with as many bits as the mantissa holds, up to 32
+template <AnyFloat T>
+constexpr T unitFloat(std::uint32_t w) {
+    if constexpr (std::numeric_limits<T>::digits < 32) {
+        constexpr int digits = std::numeric_limits<T>::digits;
+        return T(w >> (32 - digits)) * (T(1) / T(std::uint32_t(1) << digits));
+    } else {
+        return T(w) * T(1.0 / 4294967296.0);
+    }
+}
+
+// Two standard normal values from two words, Box-Muller transform
+template <AnyFloat T>
+inline void normalPair(std::uint32_t a, std::uint32_t b, T& n0, T& n1) {
+    // (0, 1] so the log stays finite
+    const T r = std::sqrt(T(-2) * std::log(T(1) - unitFloat<T>(a)));
+    const T angle = T(2) * pi<T>() * unitFloat<T>(b);
+    n0 = r * std::cos(angle);
+    n1 = r * std::sin(angle);
+}
+
+// Point on the unit circle scaled by r
+template <AnyFloat T>
+inline Vec<2, T> polar(T r, std::uint32_t w) {
+    const T angle = T(2) * pi<T>() * unitFloat<T>(w);
+    return { r * std::cos(angle), r * std::sin(angle) };
+}
+
+// Words of randomLanes consecutive indices, one array per word
+// Written as plain per-lane loops so the 32 bit multiplies vectorize
+inline void philoxLanes(const Philox& rng, std::uint64_t first, std::uint64_t stream, std::uint32_t (&out)[4][randomLanes]) {
+    std::uint32_t c0[randomLanes], c1[randomLanes], c2[randomLanes], c3[randomLanes];
+    ESEED_MATH_LANES
+    for (std::size_t w = 0; w < randomLanes; w++) {
+        const std::uint64_t index = first + w;
+        c0[w] = (std::uint32_t)index;
+        c1[w] = (std::uint32_t)(index >> 32);
+        c2[w] = (std::uint32_t)stream;
+        c3[w] = (std::uint32_t)(stream >> 32);
+    }
+    std::uint32_t k0 = rng.key0();
+    std::uint32_t k1 = rng.key1();
+    for (int r = 0; r < 10; r++) {
+        ESEED_MATH_LANES
+        for (std::size_t w = 0; w < randomLanes; w++) {
+            const std::uint64_t p0 = (std::uint64_t)Philox::mul0 * c0[w];
+            const std::uint64_t p1 = (std::uint64_t)Philox::mul1 * c2[w];
+            const std::uint32_t n0 = (std::uint32_t)(p1 >> 32) ^ c1[w] ^ k0;
+            const std::uint32_t n2 = (std::uint32_t)(p0 >> 32) ^ c3[w] ^ k1;
+            c0[w] = n0;
+            c1[w] = (std::uint32_t)p1;
+            c2[w] = n2;
+            c3[w] = (std::uint32_t)p0;
+        }
+        k0 += Philox::weyl0;
+        k1 += Philox::weyl1;
+    }
+    for (std::size_t w = 0; w < randomLanes; w++) {
+        out[0][w] = c0[w];
+        out[1][w] = c1[w];
+        out[2][w] = c2[w];
+        out[3][w] = c3[w];
+    }
+}
+
+// Call store(i, sample) for samples [0, count) with indices starting at
+// first
+template <typename Dist, typename Store>
+void forEachSample(ThreadPool& pool, const Philox& rng, const Dist& dist, std::size_t count, std::uint64_t first, std::uint64_t stream, Store store) {
+    parallelFor(pool, count, randomGrain, [&](std::size_t begin, std::size_t end) {
+        std::uint32_t words[4][randomLanes];
+        for (std::size_t i = begin; i < end; i += randomLanes) {
+            philoxLanes(rng, first + i, stream, words);
+            const std::size_t n = std::min(randomLanes, end - i);
+            for (std::size_t w = 0; w < n; w++) store(i + w, dist(Philox::Block{ words[0][w], words[1][w], words[2][w], words[3][w] }));
+        }
+    });
+}
+
+}
+
+// -- DISTRIBUTIONS -- //
+
+// A distribution turns the four words of one counter into one sample, so
+// every sample uses exactly one counter
+
+// Every component uniform in [lo, hi)
+template <std::size_t L, AnyFloat T> requires (L >= 1 && L <= 4)
+struct Uniform {
+    using Result = Vec<L, T>;
+
+    T lo = T(0);
+    T hi = T(1);
+
+    Result operator()(const Philox::Block& w) const {
+        Result out;
+        for (std::size_t i = 0; i < L; i++) out[i] = lo + (hi - lo) * detail::unitFloat<T>(w[i]);
+        return out;
+    }
+};
+
+// Every component normally distributed
+template <std::size_t L, AnyFloat T> requires (L >= 1 && L <= 4)
+struct Normal {
+    using Result = Vec<L, T>;
+
+    T mean = T(0);
+    T stddev = T(1);
+
+    Result operator()(const Philox::Block& w) const {
+        T n[4];
+        detail::normalPair(w[0], w[1], n[0], n[1]);
+        if constexpr (L > 2) detail::normalPair(w[2], w[3], n[2], n[3]);
+        Result out;
+        for (std::size_t i = 0; i < L; i++) out[i] = mean + stddev * n[i];
+        return out;
+    }
+};
+
+// Uniform on the surface of the unit sphere
+template <AnyFloat T>
+struct UnitSphere {
+    using Result = Vec<3, T>;
+
+    Result operator()(const Philox::Block& w) const {
+        // Archimedes: z is uniform in [-1, 1]
+        const T z = T(1) - T(2) * detail::unitFloat<T>(w[0]);
+        const Vec<2, T> xy = detail::polar(std::sqrt(std::max(T(0), T(1) - z * z)), w[1]);
+        return { xy[0], xy[1], z };
+    }
+};
+
+// Hemisphere around +z with density proportional to the cosine of the
+// angle to +z
+template <AnyFloat T>
+struct CosineHemisphere {
+    using Result = Vec<3, T>;
+
+    Result operator()(const Philox::Block& w) const {
+        // Malley's method: project a uniform disk sample up to the hemisphere
+        const T u = detail::unitFloat<T>(w[0]);
+        const Vec<2, T> xy = detail::polar(std::sqrt(u), w[1]);
+        return { xy[0], xy[1], std::sqrt(T(1) - u) };
+    }
+};
+
+// Uniform inside the unit disk
+template <AnyFloat T>
+struct UnitDisk {
+    using Result = Vec<2, T>;
+
+    Result operator()(const Philox::Block& w) const {
+        return detail::polar(std::sqrt(detail::unitFloat<T>(w[0])), w[1]);
+    }
+};
+
+// -- SAMPLING -- //
+
+// Sample at index of the given stream
+template <typename Dist>
+typename Dist::Result sample(const Philox& rng, const Dist& dist, std::uint64_t index, std::uint64_t stream = 0) {
+    return dist(rng(index, stream));
+}
+
+// -- BATCH -- //
+
+// out[i] is sample(rng, dist, first + i, stream), whatever the pool size
+// The words of 16 samples are generated together, which vectorizes
+// Large outputs are split across the thread pool
+
+template <typename Dist, std::size_t L, AnyFloat T>
+void generate(ThreadPool& pool, const Philox& rng, const Dist& dist, std::span<Vec<L, T>> out, std::uint64_t first = 0, std::uint64_t stream = 0) {
+    detail::forEachSample(pool, rng, dist, out.size(), first, stream, [&](std::size_t i, const Vec<L, T>& v) { out[i] = v; });
+}
+
+template <typename Dist, std::size_t L, AnyFloat T>
+void generate(const Philox& rng, const Dist& dist, std::span<Vec<L, T>> out, std::uint64_t first = 0, std::uint64_t stream = 0) {
+    generate(ThreadPool::global(), rng, dist, out, first, stream);
+}
+
+template <typename Dist, std::size_t L, AnyFloat T>
+void generate(ThreadPool& pool, const Philox& rng, const Dist& dist, VecSoASpan<L, T> out, std::uint64_t first = 0, std::uint64_t stream = 0) {
+    detail::forEachSample(pool, rng, dist, out.size(), first, stream, [&](std::size_t i, const Vec<L, T>& v) { out.set(i, v); });
+}
+
+template <typename Dist, std::size_t L, AnyFloat T>
+void generate(const Philox& rng, const Dist& dist, VecSoASpan<L, T> out, std::uint64_t first = 0, std::uint64_t stream = 0) {
+    generate(ThreadPool::global(), rng, dist, out, first, stream);
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -0,0 +1,256 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vecops.hpp"
+#include "bounds.hpp"
+#include "parallel.hpp"
+
+#include <span>
+#include <utility>
+#include <limits>
+
+namespace esd::math {
+
+namespace detail {
+
+// Independent accumulators per component
+// Breaks the serial dependency between iterations so the compiler can keep
+// several vector registers busy
+constexpr std::size_t reduceLanes = 8;
+
+// Elements per parallel task, smaller inputs run on the calling thread
+constexpr std::size_t reduceGrain = std::size_t(1) << 15;
+
+// Leaf size of the pairwise summation tree
+constexpr std::size_t sumBlock = 256;
+
+// Smallest value of T, used as the identity of max
+template <AnyNum T>
+constexpr T lowest() {
+    if constexpr (std::numeric_limits<T>::has_infinity) return -std::numeric_limits<T>::infinity();
+    else return std::numeric_limits<T>::lowest();
+}
+
+// Largest value of T, used as the identity of min
+template <AnyNum T>
+constexpr T highest() {
+    if constexpr (std::numeric_limits<T>::has_infinity) return std::numeric_limits<T>::infinity();
+    else return std::numeric_limits<T>::max();
+}
+
+// Component-wise fold of n vectors using reduceLanes accumulators
+template <std::size_t L, typename T, typename Op>
+constexpr Vec<L, T> foldLanes(const Vec<L, T>* v, std::size_t n, T identity, Op op) {
+    T acc[reduceLanes][L];
+    for (std::size_t k = 0; k < reduceLanes; k++)
+        for (std::size_t c = 0; c < L; c++) acc[k][c] = identity;
+
+    std::size_t i = 0;
+    for (; i + reduceLanes <= n; i += reduceLanes)
+        for (std::size_t k = 0; k < reduceLanes; k++)
+            for (std::size_t c = 0; c < L; c++)
+                acc[k][c] = op(acc[k][c], v[i + k][c]);
+    for (std::size_t k = 0; i < n; i++, k++)
+        for (std::size_t c = 0; c < L; c++)
+            acc[k][c] = op(acc[k][c], v[i][c]);
+
+    // Combine lanes as a tree so sums stay pairwise
+    for (std::size_t width = reduceLanes / 2; width > 0; width /= 2)
+        for (std::size_t k = 0; k < width; k++)
+            for (std::size_t c = 0; c < L; c++)
+                acc[k][c] = op(acc[k][c], acc[k + width][c]);
+
+    Vec<L, T> out;
+    for (std::size_t c = 0; c < L; c++) out[c] = acc[0][c];
+    return out;
+}
+
+// Component-wise minimum and maximum of n vectors in one pass
+template <std::size_t L, typename T>
+constexpr std::pair<Vec<L, T>, Vec<L, T>> minmaxLanes(const Vec<L, T>* v, std::size_t n) {
+    T lo[reduceLanes][L];
+    T hi[reduceLanes][L];
+    for (std::size_t k = 0; k < reduceLanes; k++) {
+        for (std::size_t c = 0; c < L; c++) {
+            lo[k][c] = highest<T>();
+            hi[k][c] = lowest<T>();
+        }
+    }
+
+    std::size_t i = 0;
+    for (; i + reduceLanes <= n; i += reduceLanes) {
+        for (std::size_t k = 0; k < reduceLanes; k++) {
+            for (std::size_t c = 0; c < L; c++) {
+                lo[k][c] = min(lo[k][c], v[i + k][c]);
+                hi[k][c] = max(hi[k][c], v[i + k][c]);
+            }
+        }
+    }
+    for (std::size_t k = 0; i < n; i++, k++) {
+        for (std::size_t c = 0; c < L; c++) {
+            lo[k][c] = min(lo[k][c], v[i][c]);
+            hi[k][c] = max(hi[k][c], v[i][c]);
+        }
+    }
+
+    std::pair<Vec<L, T>, Vec<L, T>> out;
+    for (std::size_t c = 0; c < L; c++) {
+        out.first[c] = lo[0][c];
+        out.second[c] = hi[0][c];
+        for (std::size_t k = 1; k < reduceLanes; k++) {
+            out.first[c] = min(out.first[c], lo[k][c]);
+            out.second[c] = max(out.second[c], hi[k][c]);
+        }
+    }
+    return out;
+}
+
+// Pairwise summation, error grows with log(n) instead of n
+template <std::size_t L, typename T>
+constexpr Vec<L, T> sumPairwise(const Vec<L, T>* v, std::size_t n) {
+    if (n <= sumBlock) return foldLanes(v, n, T(0), [](T a, T b) { return a + b; });
+    std::size_t half = n / 2;
+    return sumPairwise(v, half) + sumPairwise(v + half, n - half);
+}
+
+template <std::size_t L, typename T>
+constexpr Vec<L, T> sumPairwise(const std::vector<Vec<L, T>>& partials, std::size_t begin, std::size_t end) {
+    if (end - begin == 1) return partials[begin];
+    std::size_t half = begin + (end - begin) / 2;
+    return sumPairwise(partials, begin, half) + sumPairwise(partials, half, end);
+}
+
+template <std::size_t L, typename T, typename Op>
+Vec<L, T> reduceParallel(ThreadPool& pool, std::span<const Vec<L, T>> v, T identity, Op op) {
+    if (v.size() <= reduceGrain) return foldLanes(v.data(), v.size(), identity, op);
+    std::vector<Vec<L, T>> partials = parallelMap<Vec<L, T>>(pool, v.size(), reduceGrain,
+        [&](std::size_t begin, std::size_t end) {
+            return foldLanes(v.data() + begin, end - begin, identity, op);
+        }
+    );
+    Vec<L, T> out = partials[0];
+    for (std::size_t i = 1; i < partials.size(); i++)
+        for (std::size_t c = 0; c < L; c++) out[c] = op(out[c], partials[i][c]);
+    return out;
+}
+
+}
+
+// Reductions run on the thread pool once the input is large enough
+// Chunking depends only on the input size, so results are identical
+// regardless of the number of threads
+
+// Component-wise minimum of all vectors
+// Returns the largest representable value (infinity for floats) if empty
+template <std::size_t L, AnyNum T>
+Vec<L, T> reduce_min(ThreadPool& pool, std::span<const Vec<L, T>> v) {
+    return detail::reduceParallel(pool, v, detail::highest<T>(), [](T a, T b) { return min(a, b); });
+}
+
+template <std::size_t L, AnyNum T>
+Vec<L, T> reduce_min(std::span<const Vec<L, T>> v) {
+    return reduce_min(ThreadPool::global(), v);
+}
+
+// Component-wise maximum of all vectors
+// Returns the smallest representable value (-infinity for floats) if empty
+template <std::size_t L, AnyNum T>
+Vec<L, T> reduce_max(ThreadPool& pool, std::span<const Vec<L, T>> v) {
+    return detail::reduceParallel(pool, v, detail::lowest<T>(), [](T a, T b) { return max(a, b); });
+}
+
+template <std::size_t L, AnyNum T>
+Vec<L, T> reduce_max(std::span<const Vec<L, T>> v) {
+    return reduce_max(ThreadPool::global(), v);
+}
+
+// Component-wise sum of all vectors
+// Uses pairwise summation, so the rounding error of float sums grows with
+// log(n) rather than n
+template <std::size_t L, AnyNum T>
+Vec<L, T> sum(ThreadPool& pool, std::span<const Vec<L, T>> v) {
+    if (v.size() <= detail::reduceGrain) return detail::sumPairwise(v.data(), v.size());
+    std::vector<Vec<L, T>> partials = parallelMap<Vec<L, T>>(pool, v.size(), detail::reduceGrain,
+        [&](std::size_t begin, std::size_t end) {
+            return detail::sumPairwise(v.data() + begin, end - begin);
+        }
+    );
+    return detail::sumPairwise(partials, 0, partials.size());
+}
+
+template <std::size_t L, AnyNum T>
+Vec<L, T> sum(std::span<const Vec<L, T>> v) {
+    return sum(ThreadPool::global(), v);
+}
+
+// Component-wise mean of all vectors
+// Returns NaN if empty
+template <std::size_t L, AnyFloat T>
+Vec<L, T> mean(ThreadPool& pool, std::span<const Vec<L, T>> v) {
+    return sum(pool, v) / T(v.size());
+}
+
+template <std::size_t L, AnyFloat T>
+Vec<L, T> mean(std::span<const Vec<L, T>> v) {
+    return mean(ThreadPool::global(), v);
+}
+
+// Component-wise minimum and maximum in a single pass
+template <std::size_t L, AnyNum T>
+std::pair<Vec<L, T>, Vec<L, T>> minmax(ThreadPool& pool, std::span<const Vec<L, T>> v) {
+    using Pair = std::pair<Vec<L, T>, Vec<L, T>>;
+    if (v.size() <= detail::reduceGrain) return detail::minmaxLanes(v.data(), v.size());
+    std::vector<Pair> partials = parallelMap<Pair>(pool, v.size(), detail::reduceGrain,
+        [&](std::size_t begin, std::size_t end) {
+            return detail::minmaxLanes(v.data() + begin, end - begin);
+        }
+    );
+    Pair out = partials[0];
+    for (std::size_t i = 1; i < partials.size(); i++) {
+        out.first = min(out.first, partials[i].first);
+        out.second = max(out.second, partials[i].second);
+    }
+    return out;
+}
+
+template <std::size_t L, AnyNum T>
+std::pair<Vec<L, T>, Vec<L, T>> minmax(std::span<const Vec<L, T>> v) {
+    return minmax(ThreadPool::global(), v);
+}
+
+// Smallest axis-aligned box containing all vectors
+// An empty input gives an inverted box (min > max) that acts as the
+// identity when merged with other boxes
+template <std::size_t L, AnyNum T>
+AABB<L, T> aabb(ThreadPool& pool, std::span<const Vec<L, T>> v) {
+    auto [lo, hi] = minmax(pool, v);
+    return { lo, hi };
+}
+
+template <std::size_t L, AnyNum T>
+AABB<L, T> aabb(std::span<const Vec<L, T>> v) {
+    return aabb(ThreadPool::global(), v);
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
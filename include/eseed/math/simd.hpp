@@ -0,0 +1,223 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cmath>
+#include <type_traits>
+
+// Instruction set detection
+// Everything in the library has a portable fallback, these only enable the
+// faster paths when the compiler targets the matching instructions
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define ESEED_MATH_SSE 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ESEED_MATH_SSE2 1
+#endif
+
+#if defined(__AVX__)
+#define ESEED_MATH_AVX 1
+#endif
+
+// BMI2 (pdep / pext), only used for 64 bit targets
+#if (defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))) && \
+    (defined(__x86_64__) || defined(_M_X64)) && !defined(ESEED_MATH_NO_BMI2)
+#define ESEED_MATH_BMI2 1
+#endif
+
+#if defined(ESEED_MATH_SSE) || defined(ESEED_MATH_BMI2)
+#include <immintrin.h>
+#endif
+
+// Placed before a short loop over SIMD lanes to ask for it to be vectorized
+// GCC would otherwise unroll such loops completely before its loop
+// vectorizer runs, which loses gathers from lookup tables
+#if defined(__clang__)
+#define ESEED_MATH_LANES _Pragma("clang loop vectorize(enable)")
+#elif defined(__GNUC__)
+#define ESEED_MATH_LANES _Pragma("GCC unroll 1") _Pragma("GCC ivdep")
+#else
+#define ESEED_MATH_LANES
+#endif
+
+// Placed before loops over the rows or columns of small matrices to unroll
+// them completely up to 6 iterations, so pivots and indices become constants
+#if defined(__clang__)
+#define ESEED_MATH_UNROLL _Pragma("unroll 6")
+#elif defined(__GNUC__)
+#define ESEED_MATH_UNROLL _Pragma("GCC unroll 6")
+#else
+#define ESEED_MATH_UNROLL
+#endif
+
+namespace esd::math::detail {
+
+#if defined(ESEED_MATH_SSE)
+// rsqrtps followed by one Newton-Raphson step, y * (1.5 - 0.5 * x * y * y)
+inline __m128 rsqrtRefined(__m128 x) {
+    const __m128 y = _mm_rsqrt_ps(x);
+    const __m128 hx = _mm_mul_ps(_mm_set1_ps(0.5f), x);
+    return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(hx, _mm_mul_ps(y, y))));
+}
+#endif
+
+// Approximate 1 / sqrt(n)
+// With SSE this is rsqrtps refined by one Newton-Raphson step, relative error
+// stays below 2^-21 (about 4.8e-7) for positive normal inputs
+// Without SSE it is exact
+// 0 and infinity give NaN
+inline float rsqrtApprox(float n) {
+#if defined(ESEED_MATH_SSE)
+    return _mm_cvtss_f32(rsqrtRefined(_mm_set_ss(n)));
+#else
+    return 1.f / std::sqrt(n);
+#endif
+}
+
+// rsqrtApprox for every element of in
+inline void rsqrtApprox(const float* in, float* out, std::size_t n) {
+#if defined(ESEED_MATH_SSE)
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm_storeu_ps(out + i, rsqrtRefined(_mm_loadu_ps(in + i)));
+    for (; i < n; i++) out[i] = rsqrtApprox(in[i]);
+#else
+    for (std::size_t i = 0; i < n; i++) out[i] = 1.f / std::sqrt(in[i]);
+#endif
+}
+
+// Square root of every element, in place
+// std::sqrt may set errno unless compiled with -fno-math-errno, and the
+// branch for that keeps the compiler from vectorizing loops around it, so
+// lane kernels gather their arguments and take the roots here
+template <typename T>
+inline void sqrtInPlace(T* x, std::size_t n) {
+    // Vector loops run up to multiples of their width, written so the
+    // compiler can see the tail starts at or below n
+    std::size_t i = 0;
+    if constexpr (std::is_same_v<T, float>) {
+#if defined(ESEED_MATH_AVX)
+        for (; i < (n & ~std::size_t(7)); i += 8) _mm256_storeu_ps(x + i, _mm256_sqrt_ps(_mm256_loadu_ps(x + i)));
+#endif
+#if defined(ESEED_MATH_SSE)
+        for (; i < (n & ~std::size_t(3)); i += 4) _mm_storeu_ps(x + i, _mm_sqrt_ps(_mm_loadu_ps(x + i)));
+#endif
+    } else if constexpr (std::is_same_v<T, double>) {
+#if defined(ESEED_MATH_AVX)
+        for (; i < (n & ~std::size_t(3)); i += 4) _mm256_storeu_pd(x + i, _mm256_sqrt_pd(_mm256_loadu_pd(x + i)));
+#endif
+#if defined(ESEED_MATH_SSE2)
+        for (; i < (n & ~std::size_t(1)); i += 2) _mm_storeu_pd(x + i, _mm_sqrt_pd(_mm_loadu_pd(x + i)));
+#endif
+    }
+    for (; i < n; i++) x[i] = std::sqrt(x[i]);
+}
+
+// Index of the largest x[i] * dx + y[i] * dy + z[i] * dz, the first one on
+// ties, n must not be 0
+// Compilers do not vectorize an argmax without fast math, so every lane keeps
+// its own best value and the block it came from, and the lanes are compared
+// at the end of every chunk
+inline std::size_t argmaxDot3(const float* x, const float* y, const float* z, std::size_t n, float dx, float dy, float dz) {
+    float top = -HUGE_VALF;
+    std::size_t out = 0;
+    std::size_t i = 0;
+#if defined(ESEED_MATH_AVX) || defined(ESEED_MATH_SSE)
+#if defined(ESEED_MATH_AVX)
+    constexpr std::size_t w = 8;
+#else
+    constexpr std::size_t w = 4;
+#endif
+    // Block numbers are counted in floats, which are exact up to 2^24, so
+    // the input is taken in chunks of at most that many blocks
+    constexpr std::size_t chunkBlocks = std::size_t(1) << 24;
+    while (n - i >= w) {
+        const std::size_t first = i;
+        const std::size_t end = i + std::min((n - i) / w, chunkBlocks) * w;
+#if defined(ESEED_MATH_AVX)
+        const __m256 vx = _mm256_set1_ps(dx);
+        const __m256 vy = _mm256_set1_ps(dy);
+        const __m256 vz = _mm256_set1_ps(dz);
+        __m256 best = _mm256_set1_ps(-HUGE_VALF);
+        __m256 bestBlock = _mm256_setzero_ps();
+        __m256 block = _mm256_setzero_ps();
+        for (; i < end; i += w) {
+            const __m256 s = _mm256_add_ps(_mm256_add_ps(
+                _mm256_mul_ps(_mm256_loadu_ps(x + i), vx),
+                _mm256_mul_ps(_mm256_loadu_ps(y + i), vy)),
+                _mm256_mul_ps(_mm256_loadu_ps(z + i), vz));
+            const __m256 better = _mm256_cmp_ps(s, best, _CMP_GT_OQ);
+            best = _mm256_blendv_ps(best, s, better);
+            bestBlock = _mm256_blendv_ps(bestBlock, block, better);
+            block = _mm256_add_ps(block, _mm256_set1_ps(1.f));
+        }
+        alignas(32) float lanes[w];
+        alignas(32) float blocks[w];
+        _mm256_store_ps(lanes, best);
+        _mm256_store_ps(blocks, bestBlock);
+#else
+        const __m128 vx = _mm_set1_ps(dx);
+        const __m128 vy = _mm_set1_ps(dy);
+        const __m128 vz = _mm_set1_ps(dz);
+        __m128 best = _mm_set1_ps(-HUGE_VALF);
+        __m128 bestBlock = _mm_setzero_ps();
+        __m128 block = _mm_setzero_ps();
+        for (; i < end; i += w) {
+            const __m128 s = _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_loadu_ps(x + i), vx),
+                _mm_mul_ps(_mm_loadu_ps(y + i), vy)),
+                _mm_mul_ps(_mm_loadu_ps(z + i), vz));
+            const __m128 better = _mm_cmpgt_ps(s, best);
+            best = _mm_or_ps(_mm_and_ps(better, s), _mm_andnot_ps(better, best));
+            bestBlock = _mm_or_ps(_mm_and_ps(better, block), _mm_andnot_ps(better, bestBlock));
+            block = _mm_add_ps(block, _mm_set1_ps(1.f));
+        }
+        alignas(16) float lanes[w];
+        alignas(16) float blocks[w];
+        _mm_store_ps(lanes, best);
+        _mm_store_ps(blocks, bestBlock);
+#endif
+        // Earlier chunks win ties, their indices are smaller
+        for (std::size_t k = 0; k < w; k++) {
+            const std::size_t index = first + (std::size_t)blocks[k] * w + k;
+            if (lanes[k] > top || (lanes[k] == top && index < out)) {
+                top = lanes[k];
+                out = index;
+            }
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        const float s = x[i] * dx + y[i] * dy + z[i] * dz;
+        if (s > top || i == 0) {
+            top = s;
+            out = i;
+        }
+    }
+    return out;
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
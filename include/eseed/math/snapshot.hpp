@@ -0,0 +1,338 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vec.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+namespace esd::math {
+
+// Snapshot encoding for streams of vector state, like entity positions sent
+// every tick
+//
+// Values are quantized to integer codes on a grid over fixed bounds, and
+// each snapshot stores the change of every code from a baseline snapshot
+// both sides already have
+// Changes are zigzag coded, so small changes either way are small numbers,
+// and bit packed at the width of the largest change in their block
+//
+// Blocks hold up to 256 values of one component, laid out as 8 lanes of 32
+// rows: value r * 8 + j goes into lane j, and every lane packs its values
+// into consecutive 32 bit words, so packing and unpacking work on 8 values
+// at once
+// A block is a width byte followed by its words, lanes interleaved, in
+// little endian byte order
+// Blocks without any change take a single byte per component
+
+namespace detail {
+
+// Values packed side by side
+constexpr std::size_t snapshotLanes = 8;
+
+// Values per block
+constexpr std::size_t snapshotBlock = snapshotLanes * 32;
+
+constexpr std::uint32_t zigzag(std::int32_t d) {
+    return (std::uint32_t)d << 1 ^ (std::uint32_t)(d >> 31);
+}
+
+constexpr std::int32_t unzigzag(std::uint32_t z) {
+    return (std::int32_t)(z >> 1) ^ -(std::int32_t)(z & 1);
+}
+
+// Pack rows * snapshotLanes values of width bits into lanes
+// Returns the number of words per lane
+inline std::size_t packLanes(const std::uint32_t* in, std::size_t rows, unsigned width, std::uint32_t* out) {
+    constexpr std::size_t W = snapshotLanes;
+    if (width == 0) return 0;
+    std::uint32_t acc[W] = {};
+    unsigned used = 0;
+    std::size_t words = 0;
+    for (std::size_t r = 0; r < rows; r++) {
+        const std::uint32_t* v = in + r * W;
+        ESEED_MATH_LANES
+        for (std::size_t j = 0; j < W; j++) acc[j] |= v[j] << used;
+        used += width;
+        if (used >= 32) {
+            used -= 32;
+            // Bits of this row that did not fit start the next word
+            const unsigned shift = width - used;
+            ESEED_MATH_LANES
+            for (std::size_t j = 0; j < W; j++) {
+                out[words * W + j] = acc[j];
+                acc[j] = used ? v[j] >> shift : 0;
+            }
+            words++;
+        }
+    }
+    if (used) {
+        for (std::size_t j = 0; j < W; j++) out[words * W + j] = acc[j];
+        words++;
+    }
+    return words;
+}
+
+// Unpack rows * snapshotLanes values of width bits from lanes
+inline void unpackLanes(const std::uint32_t* in, std::size_t rows, unsigned width, std::uint32_t* out) {
+    constexpr std::size_t W = snapshotLanes;
+    if (width == 0) {
+        std::fill(out, out + rows * W, 0u);
+        return;
+    }
+    const std::uint32_t mask = width == 32 ? ~0u : (1u << width) - 1;
+    unsigned used = 0;
+    const std::uint32_t* word = in;
+    for (std::size_t r = 0; r < rows; r++) {
+        std::uint32_t* v = out + r * W;
+        if (used + width <= 32) {
+            ESEED_MATH_LANES
+            for (std::size_t j = 0; j < W; j++) v[j] = word[j] >> used & mask;
+            used += width;
+            if (used == 32) {
+                used = 0;
+                word += W;
+            }
+        } else {
+            // Straddles two words
+            const std::uint32_t* next = word + W;
+            const unsigned shift = 32 - used;
+            ESEED_MATH_LANES
+            for (std::size_t j = 0; j < W; j++) v[j] = (word[j] >> used | next[j] << shift) & mask;
+            used = used + width - 32;
+            word = next;
+        }
+    }
+}
+
+// Codes of m values of one component, (in - base) * scale rounded to
+// nearest and clamped to [0, maxCode], NaN gives 0
+// The clamp is done with min and max, which keeps the loop free of branches
+// so it vectorizes, and again on the integer code since maxCode may round up
+// when converted to T
+template <typename T>
+inline void quantizeLanes(const T* in, std::uint32_t* out, std::size_t m, T base, T scale, std::uint32_t maxCode) {
+    const std::int32_t topCode = (std::int32_t)maxCode;
+    const T top = T(maxCode);
+    ESEED_MATH_LANES
+    for (std::size_t i = 0; i < m; i++) {
+        const std::int32_t q = (std::int32_t)(std::min(top, std::max(T(0), (in[i] - base) * scale)) + T(0.5));
+        out[i] = (std::uint32_t)std::min(q, topCode);
+    }
+}
+
+}
+
+// Quantization grid for vectors with components in [lo, hi]
+// Each component gets bits bits, clamped to [1, 30], and decodes within
+// about maxError() of the input inside the bounds
+// Inputs outside the bounds are clamped
+template <std::size_t L, AnyFloat T>
+class SnapshotCodec {
+public:
+    using Code = Vec<L, std::uint32_t>;
+
+private:
+    Vec<L, T> lo;
+    Vec<L, T> step;
+    Vec<L, T> invStep;
+    std::uint32_t maxCode;
+
+public:
+    SnapshotCodec(const Vec<L, T>& lo, const Vec<L, T>& hi, unsigned bits) : lo(lo) {
+        maxCode = (std::uint32_t(1) << std::clamp(bits, 1u, 30u)) - 1;
+        for (std::size_t c = 0; c < L; c++) {
+            step[c] = (hi[c] - lo[c]) / T(maxCode);
+            invStep[c] = T(maxCode) / (hi[c] - lo[c]);
+        }
+    }
+
+    // Largest difference between a value inside the bounds and its decoded
+    // code, not counting rounding in T, which adds up to about
+    // 2^bits * epsilon steps
+    Vec<L, T> maxError() const {
+        return step * T(0.5);
+    }
+
+    Code quantize(const Vec<L, T>& v) const {
+        Code out;
+        for (std::size_t c = 0; c < L; c++) {
+            const T x = v[c];
+            detail::quantizeLanes(&x, &out[c], 1, lo[c], invStep[c], maxCode);
+        }
+        return out;
+    }
+
+    Vec<L, T> dequantize(const Code& q) const {
+        Vec<L, T> out;
+        for (std::size_t c = 0; c < L; c++) out[c] = lo[c] + T((std::int32_t)q[c]) * step[c];
+        return out;
+    }
+
+    // Blocks of vectors are staged as component arrays, so every component
+    // is quantized over whole lanes
+    void quantize(std::span<const Vec<L, T>> in, std::span<Code> out) const {
+        T staged[L][detail::snapshotBlock];
+        std::uint32_t codes[L][detail::snapshotBlock];
+        for (std::size_t b = 0; b < in.size(); b += detail::snapshotBlock) {
+            const std::size_t m = std::min(detail::snapshotBlock, in.size() - b);
+            for (std::size_t i = 0; i < m; i++)
+                for (std::size_t c = 0; c < L; c++) staged[c][i] = in[b + i][c];
+            for (std::size_t c = 0; c < L; c++) detail::quantizeLanes(staged[c], codes[c], m, lo[c], invStep[c], maxCode);
+            for (std::size_t i = 0; i < m; i++)
+                for (std::size_t c = 0; c < L; c++) out[b + i][c] = codes[c][i];
+        }
+    }
+
+    // Already branch free and vectorized across the components of each
+    // vector, staging it like quantize only adds copies
+    void dequantize(std::span<const Code> in, std::span<Vec<L, T>> out) const {
+        for (std::size_t i = 0; i < in.size(); i++) out[i] = dequantize(in[i]);
+    }
+};
+
+// Builds a snapshot out of any number of fields, each written against its
+// own baseline
+// An empty baseline stands for all zero codes, for the first snapshot sent
+class SnapshotWriter {
+private:
+    std::vector<std::uint8_t> bytes;
+
+public:
+    // Encode codes against baseline, which is empty or as long as codes
+    template <std::size_t L>
+    void write(std::span<const Vec<L, std::uint32_t>> codes, std::span<const Vec<L, std::uint32_t>> baseline) {
+        static_assert(std::endian::native == std::endian::little, "snapshots are only implemented for little endian targets");
+        constexpr std::size_t W = detail::snapshotLanes;
+        std::uint32_t changes[detail::snapshotBlock];
+        std::uint32_t words[detail::snapshotBlock];
+        for (std::size_t b = 0; b < codes.size(); b += detail::snapshotBlock) {
+            const std::size_t m = std::min(detail::snapshotBlock, codes.size() - b);
+            const std::size_t rows = (m + W - 1) / W;
+            std::fill(changes + m, changes + rows * W, 0u);
+            for (std::size_t c = 0; c < L; c++) {
+                std::uint32_t any = 0;
+                if (baseline.empty()) {
+                    for (std::size_t i = 0; i < m; i++) any |= changes[i] = detail::zigzag((std::int32_t)codes[b + i][c]);
+                } else {
+                    for (std::size_t i = 0; i < m; i++) any |= changes[i] = detail::zigzag((std::int32_t)(codes[b + i][c] - baseline[b + i][c]));
+                }
+                const unsigned width = (unsigned)std::bit_width(any);
+                const std::size_t count = detail::packLanes(changes, rows, width, words) * W;
+                const std::size_t at = bytes.size();
+                bytes.resize(at + 1 + count * 4);
+                bytes[at] = (std::uint8_t)width;
+                std::memcpy(bytes.data() + at + 1, words, count * 4);
+            }
+        }
+    }
+
+    // Quantize values with codec, encode them against baseline and store the
+    // codes sent in codes, which become the baseline for a later snapshot
+    template <std::size_t L, AnyFloat T>
+    void write(const SnapshotCodec<L, T>& codec, std::span<const Vec<L, T>> values,
+        std::span<const Vec<L, std::uint32_t>> baseline, std::span<Vec<L, std::uint32_t>> codes) {
+        codec.quantize(values, codes);
+        write(std::span<const Vec<L, std::uint32_t>>(codes.data(), values.size()), baseline);
+    }
+
+    std::span<const std::uint8_t> data() const {
+        return bytes;
+    }
+
+    std::size_t size() const {
+        return bytes.size();
+    }
+
+    // Start a new snapshot, keeps the memory
+    void clear() {
+        bytes.clear();
+    }
+};
+
+// Reads the fields of a snapshot in the order they were written
+// Each read must ask for as many values, against the same baseline, as the
+// matching write
+class SnapshotReader {
+private:
+    std::span<const std::uint8_t> bytes;
+    std::size_t at = 0;
+
+public:
+    explicit SnapshotReader(std::span<const std::uint8_t> bytes) : bytes(bytes) {}
+
+    // Decode codes.size() codes against baseline, which is empty or as long
+    // as codes
+    // Returns false if the snapshot ends early or is malformed, leaving codes
+    // partly written
+    template <std::size_t L>
+    bool read(std::span<const Vec<L, std::uint32_t>> baseline, std::span<Vec<L, std::uint32_t>> codes) {
+        static_assert(std::endian::native == std::endian::little, "snapshots are only implemented for little endian targets");
+        constexpr std::size_t W = detail::snapshotLanes;
+        std::uint32_t changes[detail::snapshotBlock];
+        std::uint32_t words[detail::snapshotBlock];
+        for (std::size_t b = 0; b < codes.size(); b += detail::snapshotBlock) {
+            const std::size_t m = std::min(detail::snapshotBlock, codes.size() - b);
+            const std::size_t rows = (m + W - 1) / W;
+            for (std::size_t c = 0; c < L; c++) {
+                if (at >= bytes.size()) return false;
+                const unsigned width = bytes[at];
+                if (width > 32) return false;
+                const std::size_t count = (rows * width + 31) / 32 * W;
+                if (bytes.size() - at - 1 < count * 4) return false;
+                std::memcpy(words, bytes.data() + at + 1, count * 4);
+                at += 1 + count * 4;
+                detail::unpackLanes(words, rows, width, changes);
+                if (baseline.empty()) {
+                    for (std::size_t i = 0; i < m; i++) codes[b + i][c] = (std::uint32_t)detail::unzigzag(changes[i]);
+                } else {
+                    for (std::size_t i = 0; i < m; i++) codes[b + i][c] = baseline[b + i][c] + (std::uint32_t)detail::unzigzag(changes[i]);
+                }
+            }
+        }
+        return true;
+    }
+
+    // Decode codes and dequantize them into values
+    template <std::size_t L, AnyFloat T>
+    bool read(const SnapshotCodec<L, T>& codec, std::span<const Vec<L, std::uint32_t>> baseline,
+        std::span<Vec<L, std::uint32_t>> codes, std::span<Vec<L, T>> values) {
+        if (!read(baseline, codes)) return false;
+        codec.dequantize(std::span<const Vec<L, std::uint32_t>>(codes), values);
+        return true;
+    }
+
+    // Bytes not read yet
+    std::size_t remaining() const {
+        return bytes.size() - at;
+    }
+};
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -0,0 +1,179 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vec.hpp"
+
+#include <array>
+#include <span>
+#include <vector>
+#include <type_traits>
+
+namespace esd::math {
+
+// Non-owning structure-of-arrays view over L component arrays
+// Element i is [component(0)[i], component(1)[i], ...]
+// T may be const for read-only views
+template <std::size_t L, typename T>
+class VecSoASpan {
+private:
+    std::array<T*, L> components{};
+    std::size_t count = 0;
+
+public:
+    using Element = Vec<L, std::remove_const_t<T>>;
+
+    constexpr VecSoASpan() = default;
+
+    // All component arrays must hold at least count elements
+    constexpr VecSoASpan(const std::array<T*, L>& components, std::size_t count) :
+        components(components), count(count) {}
+
+    // Read-only view of a mutable view (implicit)
+    template <typename T1> requires std::is_same_v<const T1, T>
+    constexpr VecSoASpan(const VecSoASpan<L, T1>& other) : count(other.size()) {
+        for (std::size_t c = 0; c < L; c++) components[c] = other.component(c).data();
+    }
+
+    constexpr std::size_t size() const {
+        return count;
+    }
+
+    constexpr bool empty() const {
+        return count == 0;
+    }
+
+    // Array of component c
+    constexpr std::span<T> component(std::size_t c) const {
+        return std::span<T>(components[c], count);
+    }
+
+    constexpr Element get(std::size_t i) const {
+        Element out;
+        for (std::size_t c = 0; c < L; c++) out[c] = components[c][i];
+        return out;
+    }
+
+    constexpr void set(std::size_t i, const Element& v) const requires (!std::is_const_v<T>) {
+        for (std::size_t c = 0; c < L; c++) components[c][i] = v[c];
+    }
+
+    // View of n elements starting at offset
+    constexpr VecSoASpan subspan(std::size_t offset, std::size_t n) const {
+        std::array<T*, L> sub;
+        for (std::size_t c = 0; c < L; c++) sub[c] = components[c] + offset;
+        return VecSoASpan(sub, n);
+    }
+};
+
+// Owning structure-of-arrays storage, one std::vector per component
+template <std::size_t L, typename T>
+class VecSoA {
+private:
+    std::array<std::vector<T>, L> components;
+
+public:
+    VecSoA() = default;
+
+    // count zero vectors
+    explicit VecSoA(std::size_t count) {
+        resize(count);
+    }
+
+    // Transpose from an array of vectors
+    explicit VecSoA(std::span<const Vec<L, T>> v) {
+        resize(v.size());
+        for (std::size_t i = 0; i < v.size(); i++) set(i, v[i]);
+    }
+
+    std::size_t size() const {
+        return components[0].size();
+    }
+
+    bool empty() const {
+        return components[0].empty();
+    }
+
+    void resize(std::size_t count) {
+        for (std::vector<T>& c : components) c.resize(count);
+    }
+
+    void reserve(std::size_t count) {
+        for (std::vector<T>& c : components) c.reserve(count);
+    }
+
+    void clear() {
+        for (std::vector<T>& c : components) c.clear();
+    }
+
+    void push_back(const Vec<L, T>& v) {
+        for (std::size_t c = 0; c < L; c++) components[c].push_back(v[c]);
+    }
+
+    Vec<L, T> get(std::size_t i) const {
+        Vec<L, T> out;
+        for (std::size_t c = 0; c < L; c++) out[c] = components[c][i];
+        return out;
+    }
+
+    void set(std::size_t i, const Vec<L, T>& v) {
+        for (std::size_t c = 0; c < L; c++) components[c][i] = v[c];
+    }
+
+    std::span<T> component(std::size_t c) {
+        return components[c];
+    }
+
+    std::span<const T> component(std::size_t c) const {
+        return components[c];
+    }
+
+    VecSoASpan<L, T> view() {
+        std::array<T*, L> ptrs;
+        for (std::size_t c = 0; c < L; c++) ptrs[c] = components[c].data();
+        return VecSoASpan<L, T>(ptrs, size());
+    }
+
+    VecSoASpan<L, const T> view() const {
+        std::array<const T*, L> ptrs;
+        for (std::size_t c = 0; c < L; c++) ptrs[c] = components[c].data();
+        return VecSoASpan<L, const T>(ptrs, size());
+    }
+
+    operator VecSoASpan<L, T>() {
+        return view();
+    }
+
+    operator VecSoASpan<L, const T>() const {
+        return view();
+    }
+
+    // Transpose back to an array of vectors
+    std::vector<Vec<L, T>> toAoS() const {
+        std::vector<Vec<L, T>> out(size());
+        for (std::size_t i = 0; i < out.size(); i++) out[i] = get(i);
+        return out;
+    }
+};
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
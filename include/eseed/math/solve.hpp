@@ -0,0 +1,479 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "mat.hpp"
+#include "soa.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+namespace esd::math {
+
+// Factorizations and solvers for small square systems A x = b
+// Entry (i, j) of A is a[i][j], so A * x is the Mat * Vec operator
+//
+// Loops run over compile time sizes and unroll completely up to N = 6
+// The batch versions solve W systems at once with one array per entry,
+// pivoting with selects instead of branches so all lanes stay in step
+// Singular systems are not detected by the solvers and give infinite or
+// NaN components
+
+namespace detail {
+
+// Systems per parallel task for the batch versions
+constexpr std::size_t solveGrain = std::size_t(1) << 12;
+
+// Gaussian elimination with partial pivoting of W systems, the solutions
+// replace b
+template <std::size_t N, std::size_t W, AnyFloat T>
+inline void luSolveLanes(T (&a)[N][N][W], T (&b)[N][W]) {
+    ESEED_MATH_UNROLL
+    for (std::size_t k = 0; k < N; k++) {
+        // Swap every larger candidate into the pivot row
+        // Column k goes last since it decides the swap
+        ESEED_MATH_UNROLL
+        for (std::size_t i = k + 1; i < N; i++) {
+            ESEED_MATH_LANES
+            for (std::size_t w = 0; w < W; w++) {
+                const bool swap = std::abs(a[i][k][w]) > std::abs(a[k][k][w]);
+                const T p = b[k][w];
+                const T q = b[i][w];
+                b[k][w] = swap ? q : p;
+                b[i][w] = swap ? p : q;
+            }
+            ESEED_MATH_UNROLL
+            for (std::size_t r = 0; r < N - k; r++) {
+                const std::size_t j = N - 1 - r;
+                ESEED_MATH_LANES
+                for (std::size_t w = 0; w < W; w++) {
+                    const bool swap = std::abs(a[i][k][w]) > std::abs(a[k][k][w]);
+                    const T p = a[k][j][w];
+                    const T q = a[i][j][w];
+                    a[k][j][w] = swap ? q : p;
+                    a[i][j][w] = swap ? p : q;
+                }
+            }
+        }
+
+        T inv[W];
+        ESEED_MATH_LANES
+        for (std::size_t w = 0; w < W; w++) inv[w] = T(1) / a[k][k][w];
+        ESEED_MATH_UNROLL
+        for (std::size_t i = k + 1; i < N; i++) {
+            T f[W];
+            ESEED_MATH_LANES
+            for (std::size_t w = 0; w < W; w++) {
+                f[w] = a[i][k][w] * inv[w];
+                b[i][w] -= f[w] * b[k][w];
+            }
+            ESEED_MATH_UNROLL
+            for (std::size_t j = k + 1; j < N; j++) {
+                ESEED_MATH_LANES
+                for (std::size_t w = 0; w < W; w++) a[i][j][w] -= f[w] * a[k][j][w];
+            }
+        }
+    }
+
+    // Back substitution
+    ESEED_MATH_UNROLL
+    for (std::size_t r = 0; r < N; r++) {
+        const std::size_t k = N - 1 - r;
+        ESEED_MATH_UNROLL
+        for (std::size_t j = k + 1; j < N; j++) {
+            ESEED_MATH_LANES
+            for (std::size_t w = 0; w < W; w++) b[k][w] -= a[k][j][w] * b[j][w];
+        }
+        ESEED_MATH_LANES
+        for (std::size_t w = 0; w < W; w++) b[k][w] /= a[k][k][w];
+    }
+}
+
+// Cholesky factorization of W symmetric positive definite systems, the
+// lower triangle of a becomes L and the solutions replace b
+// Only the lower triangle of a is read
+template <std::size_t N, std::size_t W, AnyFloat T>
+inline void choleskySolveLanes(T (&a)[N][N][W], T (&b)[N][W]) {
+    T inv[N][W];
+    ESEED_MATH_UNROLL
+    for (std::size_t j = 0; j < N; j++) {
+        ESEED_MATH_UNROLL
+        for (std::size_t k = 0; k < j; k++) {
+            ESEED_MATH_LANES
+            for (std::size_t w = 0; w < W; w++) a[j][j][w] -= a[j][k][w] * a[j][k][w];
+        }
+        sqrtInPlace(a[j][j], W);
+        ESEED_MATH_LANES
+        for (std::size_t w = 0; w < W; w++) inv[j][w] = T(1) / a[j][j][w];
+
+        ESEED_MATH_UNROLL
+        for (std::size_t i = j + 1; i < N; i++) {
+            ESEED_MATH_UNROLL
+            for (std::size_t k = 0; k < j; k++) {
+                ESEED_MATH_LANES
+                for (std::size_t w = 0; w < W; w++) a[i][j][w] -= a[i][k][w] * a[j][k][w];
+            }
+            ESEED_MATH_LANES
+            for (std::size_t w = 0; w < W; w++) a[i][j][w] *= inv[j][w];
+        }
+    }
+
+    // L y = b, then L^T x = y
+    ESEED_MATH_UNROLL
+    for (std::size_t i = 0; i < N; i++) {
+        ESEED_MATH_UNROLL
+        for (std::size_t k = 0; k < i; k++) {
+            ESEED_MATH_LANES
+            for (std::size_t w = 0; w < W; w++) b[i][w] -= a[i][k][w] * b[k][w];
+        }
+        ESEED_MATH_LANES
+        for (std::size_t w = 0; w < W; w++) b[i][w] *= inv[i][w];
+    }
+    ESEED_MATH_UNROLL
+    for (std::size_t r = 0; r < N; r++) {
+        const std::size_t i = N - 1 - r;
+        ESEED_MATH_UNROLL
+        for (std::size_t k = i + 1; k < N; k++) {
+            ESEED_MATH_LANES
+            for (std::size_t w = 0; w < W; w++) b[i][w] -= a[k][i][w] * b[k][w];
+        }
+        ESEED_MATH_LANES
+        for (std::size_t w = 0; w < W; w++) b[i][w] *= inv[i][w];
+    }
+}
+
+// Run kernel(a, b) on blocks of W systems
+// get(j, i) is component i of right hand side j and set(j, x) stores
+// solution j
+// The last block is padded with identity systems
+template <std::size_t W, std::size_t N, AnyFloat T, typename Get, typename Set, typename Kernel>
+void forEachSystemBlock(std::span<const Mat<N, N, T>> m, Get get, Set set, Kernel kernel) {
+    parallelFor(m.size(), solveGrain, [&](std::size_t begin, std::size_t end) {
+        T a[N][N][W];
+        T b[N][W];
+        for (std::size_t s = begin; s < end; s += W) {
+            const std::size_t n = std::min(W, end - s);
+            for (std::size_t w = 0; w < W; w++) {
+                for (std::size_t i = 0; i < N; i++) {
+                    for (std::size_t j = 0; j < N; j++) a[i][j][w] = w < n ? m[s + w][i][j] : T(i == j);
+                    b[i][w] = w < n ? get(s + w, i) : T(0);
+                }
+            }
+            kernel(a, b);
+            for (std::size_t w = 0; w < n; w++) {
+                Vec<N, T> x;
+                for (std::size_t i = 0; i < N; i++) x[i] = b[i][w];
+                set(s + w, x);
+            }
+        }
+    });
+}
+
+}
+
+// -- LU -- //
+
+// P A = L U with partial pivoting
+template <std::size_t N, AnyFloat T>
+struct LU {
+    // U on and above the diagonal, L below it with an implicit unit diagonal
+    Mat<N, N, T> lu;
+    // Row i of P A is row perm[i] of A
+    std::array<std::size_t, N> perm;
+    // Determinant of P, 1 or -1
+    T parity;
+    // A pivot vanished relative to the largest entry of A, within N
+    // machine epsilons
+    bool singular;
+};
+
+template <std::size_t N, AnyFloat T>
+LU<N, T> lu(const Mat<N, N, T>& a) {
+    LU<N, T> out{ a, {}, T(1), false };
+    Mat<N, N, T>& m = out.lu;
+    for (std::size_t i = 0; i < N; i++) out.perm[i] = i;
+    T scale = T(0);
+    for (std::size_t i = 0; i < N; i++)
+        for (std::size_t j = 0; j < N; j++) scale = std::max(scale, std::abs(a[i][j]));
+    const T tiny = scale * T(N) * std::numeric_limits<T>::epsilon();
+
+    ESEED_MATH_UNROLL
+    for (std::size_t k = 0; k < N; k++) {
+        std::size_t p = k;
+        ESEED_MATH_UNROLL
+        for (std::size_t i = k + 1; i < N; i++) if (std::abs(m[i][k]) > std::abs(m[p][k])) p = i;
+        if (p != k) {
+            std::swap(m[p], m[k]);
+            std::swap(out.perm[p], out.perm[k]);
+            out.parity = -out.parity;
+        }
+        if (!(std::abs(m[k][k]) > tiny)) out.singular = true;
+        if (m[k][k] == T(0)) continue;
+
+        const T inv = T(1) / m[k][k];
+        ESEED_MATH_UNROLL
+        for (std::size_t i = k + 1; i < N; i++) {
+            const T f = m[i][k] * inv;
+            m[i][k] = f;
+            ESEED_MATH_UNROLL
+            for (std::size_t j = k + 1; j < N; j++) m[i][j] -= f * m[k][j];
+        }
+    }
+    return out;
+}
+
+template <std::size_t N, AnyFloat T>
+constexpr Vec<N, T> solve(const LU<N, T>& f, const Vec<N, T>& b) {
+    const Mat<N, N, T>& m = f.lu;
+    Vec<N, T> x;
+    ESEED_MATH_UNROLL
+    for (std::size_t i = 0; i < N; i++) {
+        T sum = b[f.perm[i]];
+        ESEED_MATH_UNROLL
+        for (std::size_t k = 0; k < i; k++) sum -= m[i][k] * x[k];
+        x[i] = sum;
+    }
+    ESEED_MATH_UNROLL
+    for (std::size_t r = 0; r < N; r++) {
+        const std::size_t i = N - 1 - r;
+        T sum = x[i];
+        ESEED_MATH_UNROLL
+        for (std::size_t k = i + 1; k < N; k++) sum -= m[i][k] * x[k];
+        x[i] = sum / m[i][i];
+    }
+    return x;
+}
+
+// -- CHOLESKY -- //
+
+// A = L L^T for symmetric positive definite A
+template <std::size_t N, AnyFloat T>
+struct Cholesky {
+    // Lower triangular, zero above the diagonal
+    Mat<N, N, T> l;
+    // A is positive definite, l is meaningless otherwise
+    bool positive;
+};
+
+// Only the lower triangle of a is read
+template <std::size_t N, AnyFloat T>
+Cholesky<N, T> cholesky(const Mat<N, N, T>& a) {
+    Cholesky<N, T> out{ {}, true };
+    Mat<N, N, T>& l = out.l;
+    ESEED_MATH_UNROLL
+    for (std::size_t j = 0; j < N; j++) {
+        T d = a[j][j];
+        ESEED_MATH_UNROLL
+        for (std::size_t k = 0; k < j; k++) d -= l[j][k] * l[j][k];
+        if (!(d > T(0))) out.positive = false;
+        l[j][j] = std::sqrt(d);
+        const T inv = T(1) / l[j][j];
+        ESEED_MATH_UNROLL
+        for (std::size_t i = j + 1; i < N; i++) {
+            T sum = a[i][j];
+            ESEED_MATH_UNROLL
+            for (std::size_t k = 0; k < j; k++) sum -= l[i][k] * l[j][k];
+            l[i][j] = sum * inv;
+        }
+    }
+    return out;
+}
+
+template <std::size_t N, AnyFloat T>
+constexpr Vec<N, T> solve(const Cholesky<N, T>& f, const Vec<N, T>& b) {
+    const Mat<N, N, T>& l = f.l;
+    Vec<N, T> x;
+    ESEED_MATH_UNROLL
+    for (std::size_t i = 0; i < N; i++) {
+        T sum = b[i];
+        ESEED_MATH_UNROLL
+        for (std::size_t k = 0; k < i; k++) sum -= l[i][k] * x[k];
+        x[i] = sum / l[i][i];
+    }
+    ESEED_MATH_UNROLL
+    for (std::size_t r = 0; r < N; r++) {
+        const std::size_t i = N - 1 - r;
+        T sum = x[i];
+        ESEED_MATH_UNROLL
+        for (std::size_t k = i + 1; k < N; k++) sum -= l[k][i] * x[k];
+        x[i] = sum / l[i][i];
+    }
+    return x;
+}
+
+// -- QR -- //
+
+// A = Q R by Householder reflections
+// Slower than LU but backward stable without pivoting
+template <std::size_t N, AnyFloat T>
+struct QR {
+    // Orthogonal
+    Mat<N, N, T> q;
+    // Upper triangular
+    Mat<N, N, T> r;
+};
+
+template <std::size_t N, AnyFloat T>
+QR<N, T> qr(const Mat<N, N, T>& a) {
+    QR<N, T> out{ Mat<N, N, T>::ident(), a };
+    Mat<N, N, T>& q = out.q;
+    Mat<N, N, T>& r = out.r;
+    ESEED_MATH_UNROLL
+    for (std::size_t k = 0; k + 1 < N; k++) {
+        // Reflect column k below the diagonal onto the axis, v = x + sign(x0) |x| e0
+        T norm = T(0);
+        ESEED_MATH_UNROLL
+        for (std::size_t i = k; i < N; i++) norm += r[i][k] * r[i][k];
+        if (norm == T(0)) continue;
+        norm = std::copysign(std::sqrt(norm), r[k][k]);
+
+        Vec<N, T> v;
+        v[k] = r[k][k] + norm;
+        ESEED_MATH_UNROLL
+        for (std::size_t i = k + 1; i < N; i++) v[i] = r[i][k];
+        // H = I - v v^T / (v0 norm)
+        const T scale = T(1) / (v[k] * norm);
+
+        // R = H R and Q = Q H
+        ESEED_MATH_UNROLL
+        for (std::size_t j = k; j < N; j++) {
+            T d = T(0);
+            ESEED_MATH_UNROLL
+            for (std::size_t i = k; i < N; i++) d += v[i] * r[i][j];
+            d *= scale;
+            ESEED_MATH_UNROLL
+            for (std::size_t i = k; i < N; i++) r[i][j] -= d * v[i];
+        }
+        ESEED_MATH_UNROLL
+        for (std::size_t i = 0; i < N; i++) {
+            T d = T(0);
+            ESEED_MATH_UNROLL
+            for (std::size_t j = k; j < N; j++) d += q[i][j] * v[j];
+            d *= scale;
+            ESEED_MATH_UNROLL
+            for (std::size_t j = k; j < N; j++) q[i][j] -= d * v[j];
+        }
+        ESEED_MATH_UNROLL
+        for (std::size_t i = k + 1; i < N; i++) r[i][k] = T(0);
+    }
+    return out;
+}
+
+template <std::size_t N, AnyFloat T>
+constexpr Vec<N, T> solve(const QR<N, T>& f, const Vec<N, T>& b) {
+    // R x = Q^T b
+    Vec<N, T> x;
+    ESEED_MATH_UNROLL
+    for (std::size_t i = 0; i < N; i++) {
+        T sum = T(0);
+        ESEED_MATH_UNROLL
+        for (std::size_t k = 0; k < N; k++) sum += f.q[k][i] * b[k];
+        x[i] = sum;
+    }
+    ESEED_MATH_UNROLL
+    for (std::size_t r = 0; r < N; r++) {
+        const std::size_t i = N - 1 - r;
+        T sum = x[i];
+        ESEED_MATH_UNROLL
+        for (std::size_t k = i + 1; k < N; k++) sum -= f.r[i][k] * x[k];
+        x[i] = sum / f.r[i][i];
+    }
+    return x;
+}
+
+// -- DIRECT SOLVE -- //
+
+// Gaussian elimination with partial pivoting, without keeping the factors
+// Same steps as the batch version, so results match it exactly
+template <std::size_t N, AnyFloat T>
+Vec<N, T> solve(const Mat<N, N, T>& a, const Vec<N, T>& b) {
+    T la[N][N][1];
+    T lb[N][1];
+    for (std::size_t i = 0; i < N; i++) {
+        for (std::size_t j = 0; j < N; j++) la[i][j][0] = a[i][j];
+        lb[i][0] = b[i];
+    }
+    detail::luSolveLanes(la, lb);
+    Vec<N, T> x;
+    for (std::size_t i = 0; i < N; i++) x[i] = lb[i][0];
+    return x;
+}
+
+// Symmetric positive definite systems, about twice as fast as solve
+// Only the lower triangle of a is read
+template <std::size_t N, AnyFloat T>
+Vec<N, T> solveCholesky(const Mat<N, N, T>& a, const Vec<N, T>& b) {
+    T la[N][N][1];
+    T lb[N][1];
+    for (std::size_t i = 0; i < N; i++) {
+        for (std::size_t j = 0; j < N; j++) la[i][j][0] = a[i][j];
+        lb[i][0] = b[i];
+    }
+    detail::choleskySolveLanes(la, lb);
+    Vec<N, T> x;
+    for (std::size_t i = 0; i < N; i++) x[i] = lb[i][0];
+    return x;
+}
+
+// -- BATCH -- //
+
+// x[i] solves a[i] x = b[i]
+// W systems are solved together, 8 fills an AVX register of floats
+// Large batches are split across the thread pool
+// Results equal the single system versions up to rounding
+
+template <std::size_t W = 8, std::size_t N, AnyFloat T>
+void solve(std::span<const Mat<N, N, T>> a, std::span<const Vec<N, T>> b, std::span<Vec<N, T>> x) {
+    detail::forEachSystemBlock<W>(a, [&](std::size_t j, std::size_t i) { return b[j][i]; },
+        [&](std::size_t j, const Vec<N, T>& v) { x[j] = v; },
+        [](T (&la)[N][N][W], T (&lb)[N][W]) { detail::luSolveLanes(la, lb); });
+}
+
+template <std::size_t W = 8, std::size_t N, typename U, AnyFloat T = std::remove_const_t<U>>
+void solve(std::span<const Mat<N, N, T>> a, VecSoASpan<N, U> b, VecSoASpan<N, T> x) {
+    detail::forEachSystemBlock<W>(a, [&](std::size_t j, std::size_t i) { return b.component(i)[j]; },
+        [&](std::size_t j, const Vec<N, T>& v) { x.set(j, v); },
+        [](T (&la)[N][N][W], T (&lb)[N][W]) { detail::luSolveLanes(la, lb); });
+}
+
+template <std::size_t W = 8, std::size_t N, AnyFloat T>
+void solveCholesky(std::span<const Mat<N, N, T>> a, std::span<const Vec<N, T>> b, std::span<Vec<N, T>> x) {
+    detail::forEachSystemBlock<W>(a, [&](std::size_t j, std::size_t i) { return b[j][i]; },
+        [&](std::size_t j, const Vec<N, T>& v) { x[j] = v; },
+        [](T (&la)[N][N][W], T (&lb)[N][W]) { detail::choleskySolveLanes(la, lb); });
+}
+
+template <std::size_t W = 8, std::size_t N, typename U, AnyFloat T = std::remove_const_t<U>>
+void solveCholesky(std::span<const Mat<N, N, T>> a, VecSoASpan<N, U> b, VecSoASpan<N, T> x) {
+    detail::forEachSystemBlock<W>(a, [&](std::size_t j, std::size_t i) { return b.component(i)[j]; },
+        [&](std::size_t j, const Vec<N, T>& v) { x.set(j, v); },
+        [](T (&la)[N][N][W], T (&lb)[N][W]) { detail::choleskySolveLanes(la, lb); });
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
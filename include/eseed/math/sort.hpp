@@ -0,0 +1,198 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "concepts.hpp"
+#include "soa.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace esd::math {
+
+namespace detail {
+
+// Key bits consumed per pass
+constexpr std::size_t radixBits = 8;
+constexpr std::size_t radixBuckets = std::size_t(1) << radixBits;
+
+// Elements per histogram / scatter chunk
+// Chunks are fixed by the input size, the pool only decides who runs them
+constexpr std::size_t radixGrain = std::size_t(1) << 16;
+
+// Elements per parallel task when permuting payloads
+constexpr std::size_t permuteGrain = std::size_t(1) << 14;
+
+}
+
+// Least significant digit radix sort on unsigned keys
+// Keeps its buffers between calls so sorting every frame does not allocate
+// once the sizes settle
+//
+// The histogram and scatter phases of every pass are split into fixed size
+// chunks that run on the thread pool, and passes where every key has the
+// same digit are skipped, so sorting 64 bit Morton keys of a small region
+// only pays for the bits that actually differ
+template <AnyUnsigned K>
+class RadixSorter {
+private:
+    ThreadPool* pool;
+    std::vector<K> keysA;
+    std::vector<K> keysB;
+    std::vector<std::uint32_t> orderA;
+    std::vector<std::uint32_t> orderB;
+    std::vector<std::size_t> counts;
+    std::vector<std::byte> scratch;
+
+    bool isSorted(std::span<const K> keys) {
+        if (keys.size() < 2) return true;
+        std::vector<unsigned char> sorted = parallelMap<unsigned char>(*pool, keys.size() - 1, detail::radixGrain,
+            [&](std::size_t begin, std::size_t end) -> unsigned char {
+                for (std::size_t i = begin; i < end; i++) if (keys[i + 1] < keys[i]) return 0;
+                return 1;
+            }
+        );
+        for (unsigned char s : sorted) if (!s) return false;
+        return true;
+    }
+
+    // Sort keysA / orderA into keysB / orderB on the digit at shift
+    // Returns false without touching anything if every key has the same digit
+    bool pass(std::size_t shift) {
+        const std::size_t n = keysA.size();
+        const std::size_t chunks = (n + detail::radixGrain - 1) / detail::radixGrain;
+        counts.assign(chunks * detail::radixBuckets, 0);
+
+        // Histogram of every chunk
+        pool->run(chunks, [&](std::size_t c) {
+            std::size_t* hist = counts.data() + c * detail::radixBuckets;
+            const std::size_t end = std::min(n, (c + 1) * detail::radixGrain);
+            for (std::size_t i = c * detail::radixGrain; i < end; i++)
+                hist[(keysA[i] >> shift) & (detail::radixBuckets - 1)]++;
+        });
+
+        // Turn counts into each chunk's first output index per digit
+        // Digits first, then chunks, which keeps the sort stable
+        std::size_t offset = 0;
+        for (std::size_t d = 0; d < detail::radixBuckets; d++) {
+            std::size_t total = 0;
+            for (std::size_t c = 0; c < chunks; c++) total += counts[c * detail::radixBuckets + d];
+            if (total == n) return false;
+            for (std::size_t c = 0; c < chunks; c++) {
+                std::size_t count = counts[c * detail::radixBuckets + d];
+                counts[c * detail::radixBuckets + d] = offset;
+                offset += count;
+            }
+        }
+
+        // Scatter every chunk
+        keysB.resize(n);
+        orderB.resize(n);
+        pool->run(chunks, [&](std::size_t c) {
+            std::size_t* next = counts.data() + c * detail::radixBuckets;
+            const std::size_t end = std::min(n, (c + 1) * detail::radixGrain);
+            for (std::size_t i = c * detail::radixGrain; i < end; i++) {
+                std::size_t dst = next[(keysA[i] >> shift) & (detail::radixBuckets - 1)]++;
+                keysB[dst] = keysA[i];
+                orderB[dst] = orderA[i];
+            }
+        });
+
+        keysA.swap(keysB);
+        orderA.swap(orderB);
+        return true;
+    }
+
+public:
+    explicit RadixSorter(ThreadPool& pool = ThreadPool::global()) : pool(&pool) {}
+
+    // Stable ascending order of at most 2^32 - 1 keys
+    // order[i] is the index of the i-th smallest key, equal keys keep their
+    // input order
+    // The returned span stays valid until the next call
+    std::span<const std::uint32_t> order(std::span<const K> keys) {
+        keysA.assign(keys.begin(), keys.end());
+        orderA.resize(keys.size());
+        std::iota(orderA.begin(), orderA.end(), std::uint32_t(0));
+
+        // Layouts that are re-sorted every frame are often already in order
+        if (isSorted(keys)) return orderA;
+
+        for (std::size_t shift = 0; shift < std::size_t(std::numeric_limits<K>::digits); shift += detail::radixBits)
+            pass(shift);
+        return orderA;
+    }
+
+    // Reorder data so that data[i] becomes the old data[order[i]]
+    // T must be trivially copyable, e.g. Vec or Mat
+    template <typename T>
+    void permute(std::span<const std::uint32_t> order, std::span<T> data) {
+        static_assert(std::is_trivially_copyable_v<T>, "permuted payloads must be trivially copyable");
+        const std::size_t n = order.size();
+        scratch.resize(n * sizeof(T));
+        std::byte* out = scratch.data();
+        parallelFor(*pool, n, detail::permuteGrain, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++)
+                std::memcpy(out + i * sizeof(T), &data[order[i]], sizeof(T));
+        });
+        parallelFor(*pool, n, detail::permuteGrain, [&](std::size_t begin, std::size_t end) {
+            std::memcpy(data.data() + begin, out + begin * sizeof(T), (end - begin) * sizeof(T));
+        });
+    }
+
+    // Reorder every component of a structure-of-arrays payload
+    template <std::size_t L, typename T>
+    void permute(std::span<const std::uint32_t> order, VecSoASpan<L, T> data) {
+        for (std::size_t c = 0; c < L; c++) permute(order, data.component(c));
+    }
+
+    // Sort keys ascending in place and reorder every payload the same way
+    // Payloads are spans of trivially copyable values or VecSoASpans, each at
+    // least as long as keys
+    template <typename... Payloads>
+    void sort(std::span<K> keys, Payloads... payloads) {
+        if (keys.empty()) return;
+        std::span<const std::uint32_t> sorted = order(keys);
+        std::memcpy(keys.data(), keysA.data(), keys.size() * sizeof(K));
+        (permute(sorted, payloads), ...);
+    }
+};
+
+// Sort keys ascending in place and reorder every payload the same way
+// Allocates its buffers on every call, keep a RadixSorter around instead for
+// per-frame use
+template <AnyUnsigned K, typename... Payloads>
+void radixSort(std::span<K> keys, Payloads... payloads) {
+    RadixSorter<K> sorter;
+    sorter.sort(keys, payloads...);
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -0,0 +1,298 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vec.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+namespace esd::math {
+
+// Spatial keys map integer grid coordinates to a single integer so that
+// sorting by key keeps nearby cells close together in memory
+//
+// Keys of type K hold digits(K) / L bits per component, e.g. 21 bits for a
+// Vec3 in a 64 bit key or 16 bits for a Vec2 in a 32 bit key
+// Signed components are offset by half the range first, so a 21 bit
+// component covers [-2^20, 2^20) and ordering is preserved across zero
+// Higher bits are discarded
+
+namespace detail {
+
+// Bits per component in a key
+template <AnyUnsigned K, std::size_t L>
+constexpr std::size_t keyBits = std::numeric_limits<K>::digits / L;
+
+// Component to unsigned key bits
+template <AnyUnsigned K, std::size_t L, AnyInt I>
+constexpr std::uint64_t toKeyBits(I n) {
+    constexpr std::size_t bits = keyBits<K, L>;
+    constexpr std::uint64_t mask = bits >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << bits) - 1;
+    // Sign extend first, so components narrower than the key still order
+    // negative values below zero
+    std::uint64_t u;
+    if constexpr (std::is_signed_v<I>) u = (std::uint64_t)(std::int64_t)n + (std::uint64_t(1) << (bits - 1));
+    else u = (std::uint64_t)n;
+    return u & mask;
+}
+
+// Unsigned key bits back to a component
+template <AnyUnsigned K, std::size_t L, AnyInt I>
+constexpr I fromKeyBits(std::uint64_t u) {
+    constexpr std::size_t bits = keyBits<K, L>;
+    if constexpr (std::is_signed_v<I>) return (I)(std::int64_t)(u - (std::uint64_t(1) << (bits - 1)));
+    else return (I)u;
+}
+
+// Spread the low 21 bits of n so there are two zero bits between each
+constexpr std::uint64_t spreadBits3(std::uint64_t n) {
+    n &= 0x1fffff;
+    n = (n | n << 32) & 0x1f00000000ffff;
+    n = (n | n << 16) & 0x1f0000ff0000ff;
+    n = (n | n << 8) & 0x100f00f00f00f00f;
+    n = (n | n << 4) & 0x10c30c30c30c30c3;
+    n = (n | n << 2) & 0x1249249249249249;
+    return n;
+}
+
+// Inverse of spreadBits3
+constexpr std::uint64_t compactBits3(std::uint64_t n) {
+    n &= 0x1249249249249249;
+    n = (n ^ (n >> 2)) & 0x10c30c30c30c30c3;
+    n = (n ^ (n >> 4)) & 0x100f00f00f00f00f;
+    n = (n ^ (n >> 8)) & 0x1f0000ff0000ff;
+    n = (n ^ (n >> 16)) & 0x1f00000000ffff;
+    n = (n ^ (n >> 32)) & 0x1fffff;
+    return n;
+}
+
+// Spread the low 32 bits of n so there is one zero bit between each
+constexpr std::uint64_t spreadBits2(std::uint64_t n) {
+    n &= 0xffffffff;
+    n = (n | n << 16) & 0x0000ffff0000ffff;
+    n = (n | n << 8) & 0x00ff00ff00ff00ff;
+    n = (n | n << 4) & 0x0f0f0f0f0f0f0f0f;
+    n = (n | n << 2) & 0x3333333333333333;
+    n = (n | n << 1) & 0x5555555555555555;
+    return n;
+}
+
+// Inverse of spreadBits2
+constexpr std::uint64_t compactBits2(std::uint64_t n) {
+    n &= 0x5555555555555555;
+    n = (n ^ (n >> 1)) & 0x3333333333333333;
+    n = (n ^ (n >> 2)) & 0x0f0f0f0f0f0f0f0f;
+    n = (n ^ (n >> 4)) & 0x00ff00ff00ff00ff;
+    n = (n ^ (n >> 8)) & 0x0000ffff0000ffff;
+    n = (n ^ (n >> 16)) & 0xffffffff;
+    return n;
+}
+
+// Interleave L components, component i goes to bit i of every group
+// Uses pdep when BMI2 is available and not evaluated at compile time
+// pdep is microcoded on AMD before Zen 3, define ESEED_MATH_NO_BMI2 to always
+// use the shift sequence there
+template <std::size_t L>
+constexpr std::uint64_t interleave(const std::uint64_t (&c)[L]) {
+    static_assert(L == 2 || L == 3, "interleave only supports 2 and 3 components");
+    constexpr std::uint64_t mask = L == 2 ? 0x5555555555555555 : 0x9249249249249249;
+#if defined(ESEED_MATH_BMI2)
+    if (!std::is_constant_evaluated()) {
+        std::uint64_t out = 0;
+        for (std::size_t i = 0; i < L; i++) out |= _pdep_u64(c[i], mask << i);
+        return out;
+    }
+#endif
+    (void)mask;
+    std::uint64_t out = 0;
+    for (std::size_t i = 0; i < L; i++) out |= (L == 2 ? spreadBits2(c[i]) : spreadBits3(c[i])) << i;
+    return out;
+}
+
+// Inverse of interleave
+template <std::size_t L>
+constexpr void deinterleave(std::uint64_t n, std::uint64_t (&c)[L]) {
+    static_assert(L == 2 || L == 3, "deinterleave only supports 2 and 3 components");
+    constexpr std::uint64_t mask = L == 2 ? 0x5555555555555555 : 0x9249249249249249;
+#if defined(ESEED_MATH_BMI2)
+    if (!std::is_constant_evaluated()) {
+        for (std::size_t i = 0; i < L; i++) c[i] = _pext_u64(n, mask << i);
+        return;
+    }
+#endif
+    (void)mask;
+    for (std::size_t i = 0; i < L; i++) c[i] = L == 2 ? compactBits2(n >> i) : compactBits3(n >> i);
+}
+
+// Skilling's in-place conversion from axes to the transposed Hilbert index
+// "Programming the Hilbert curve", AIP Conference Proceedings 707, 2004
+template <std::size_t L>
+constexpr void axesToTranspose(std::uint64_t (&x)[L], std::size_t bits) {
+    const std::uint64_t m = std::uint64_t(1) << (bits - 1);
+
+    // Inverse undo
+    for (std::uint64_t q = m; q > 1; q >>= 1) {
+        const std::uint64_t p = q - 1;
+        for (std::size_t i = 0; i < L; i++) {
+            if (x[i] & q) {
+                x[0] ^= p;
+            } else {
+                const std::uint64_t t = (x[0] ^ x[i]) & p;
+                x[0] ^= t;
+                x[i] ^= t;
+            }
+        }
+    }
+
+    // Gray encode
+    for (std::size_t i = 1; i < L; i++) x[i] ^= x[i - 1];
+    std::uint64_t t = 0;
+    for (std::uint64_t q = m; q > 1; q >>= 1)
+        if (x[L - 1] & q) t ^= q - 1;
+    for (std::size_t i = 0; i < L; i++) x[i] ^= t;
+}
+
+// Inverse of axesToTranspose
+template <std::size_t L>
+constexpr void transposeToAxes(std::uint64_t (&x)[L], std::size_t bits) {
+    const std::uint64_t n = std::uint64_t(2) << (bits - 1);
+
+    // Gray decode
+    std::uint64_t t = x[L - 1] >> 1;
+    for (std::size_t i = L - 1; i > 0; i--) x[i] ^= x[i - 1];
+    x[0] ^= t;
+
+    // Undo excess work
+    for (std::uint64_t q = 2; q != n; q <<= 1) {
+        const std::uint64_t p = q - 1;
+        for (std::size_t i = L; i-- > 0;) {
+            if (x[i] & q) {
+                x[0] ^= p;
+            } else {
+                t = (x[0] ^ x[i]) & p;
+                x[0] ^= t;
+                x[i] ^= t;
+            }
+        }
+    }
+}
+
+// Elements per parallel task for the batch versions
+constexpr std::size_t keyGrain = std::size_t(1) << 15;
+
+}
+
+// -- MORTON (Z-ORDER) -- //
+
+// Interleave the bits of all components, x in the lowest bit
+template <AnyUnsigned K = std::uint64_t, std::size_t L, AnyInt I> requires (L == 2 || L == 3)
+constexpr K mortonEncode(const Vec<L, I>& v) {
+    std::uint64_t c[L];
+    for (std::size_t i = 0; i < L; i++) c[i] = detail::toKeyBits<K, L>(v[i]);
+    return (K)detail::interleave(c);
+}
+
+// Inverse of mortonEncode
+// mortonDecode<3, int>(key)
+template <std::size_t L, AnyInt I, AnyUnsigned K> requires (L == 2 || L == 3)
+constexpr Vec<L, I> mortonDecode(K key) {
+    std::uint64_t c[L];
+    detail::deinterleave((std::uint64_t)key, c);
+    Vec<L, I> out;
+    for (std::size_t i = 0; i < L; i++) out[i] = detail::fromKeyBits<K, L, I>(c[i]);
+    return out;
+}
+
+// -- HILBERT -- //
+
+// Position along the Hilbert curve through the key's grid
+// Consecutive keys are always neighbouring cells, which gives better
+// locality than Morton order at a higher encoding cost
+template <AnyUnsigned K = std::uint64_t, std::size_t L, AnyInt I> requires (L == 2 || L == 3)
+constexpr K hilbertEncode(const Vec<L, I>& v) {
+    std::uint64_t x[L];
+    for (std::size_t i = 0; i < L; i++) x[i] = detail::toKeyBits<K, L>(v[i]);
+    detail::axesToTranspose(x, detail::keyBits<K, L>);
+    // The first axis holds the most significant bit of every group
+    std::uint64_t reversed[L];
+    for (std::size_t i = 0; i < L; i++) reversed[i] = x[L - 1 - i];
+    return (K)detail::interleave(reversed);
+}
+
+// Inverse of hilbertEncode
+// hilbertDecode<2, int>(key)
+template <std::size_t L, AnyInt I, AnyUnsigned K> requires (L == 2 || L == 3)
+constexpr Vec<L, I> hilbertDecode(K key) {
+    std::uint64_t reversed[L];
+    detail::deinterleave((std::uint64_t)key, reversed);
+    std::uint64_t x[L];
+    for (std::size_t i = 0; i < L; i++) x[i] = reversed[L - 1 - i];
+    detail::transposeToAxes(x, detail::keyBits<K, L>);
+    Vec<L, I> out;
+    for (std::size_t i = 0; i < L; i++) out[i] = detail::fromKeyBits<K, L, I>(x[i]);
+    return out;
+}
+
+// -- BATCH -- //
+
+// Key type is taken from the output span
+// Large inputs are split across the thread pool
+
+// Morton key of every vector
+template <std::size_t L, AnyInt I, AnyUnsigned K>
+void mortonEncode(std::span<const Vec<L, I>> in, std::span<K> out) {
+    parallelFor(in.size(), detail::keyGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = mortonEncode<K>(in[i]);
+    });
+}
+
+// Vector of every Morton key
+template <std::size_t L, AnyInt I, AnyUnsigned K>
+void mortonDecode(std::span<const K> in, std::span<Vec<L, I>> out) {
+    parallelFor(in.size(), detail::keyGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = mortonDecode<L, I>(in[i]);
+    });
+}
+
+// Hilbert key of every vector
+template <std::size_t L, AnyInt I, AnyUnsigned K>
+void hilbertEncode(std::span<const Vec<L, I>> in, std::span<K> out) {
+    parallelFor(in.size(), detail::keyGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = hilbertEncode<K>(in[i]);
+    });
+}
+
+// Vector of every Hilbert key
+template <std::size_t L, AnyInt I, AnyUnsigned K>
+void hilbertDecode(std::span<const K> in, std::span<Vec<L, I>> out) {
+    parallelFor(in.size(), detail::keyGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) out[i] = hilbertDecode<L, I>(in[i]);
+    });
+}
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -0,0 +1,267 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "vecops.hpp"
+#include "soa.hpp"
+#include "poly.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <vector>
+
+namespace esd::math {
+
+namespace detail {
+
+// Parameters per parallel task for the batch versions
+constexpr std::size_t splineGrain = std::size_t(1) << 14;
+
+// 5 point Gauss-Legendre quadrature on [0, 1]
+constexpr double gaussNodes[5] = {
+    0.04691007703066800, 0.23076534494715845, 0.5, 0.76923465505284155, 0.95308992296933200
+};
+constexpr double gaussWeights[5] = {
+    0.11846344252809454, 0.23931433524968324, 0.28444444444444444, 0.23931433524968324, 0.11846344252809454
+};
+
+}
+
+// Piecewise cubic curve stored as one polynomial per segment
+// Segment i covers parameters [i, i + 1] and is evaluated as
+// c0 + c1 u + c2 u^2 + c3 u^3 with u = t - i, so building the curve converts
+// the control points once and every evaluation is three multiply-adds per
+// component
+// Parameters outside [0, segmentCount()] are clamped
+// A spline without segments evaluates to zero everywhere
+//
+// An optional arc length table maps distances along the curve back to
+// parameters for constant speed sampling
+template <std::size_t L, AnyFloat T>
+class CubicSpline {
+public:
+    // Power basis coefficients of a segment, lowest degree first
+    using Segment = std::array<Vec<L, T>, 4>;
+
+private:
+    std::vector<Segment> segments;
+
+    // Cumulative length at evenly spaced parameters, arcTable[0] is 0
+    std::vector<T> arcTable;
+    std::size_t arcSteps = 0;
+
+    // Segment containing t and the local parameter within it, there must be
+    // at least one segment
+    std::size_t locate(T t, T& u) const {
+        const T clamped = std::clamp(t, T(0), T(segments.size()));
+        const std::size_t s = std::min(segments.size() - 1, (std::size_t)clamped);
+        u = clamped - T(s);
+        return s;
+    }
+
+    static Vec<L, T> horner(const Segment& c, T u) {
+        const Vec<L, T> uu = detail::splat<Vec<L, T>>(u);
+        return detail::madd(detail::madd(detail::madd(c[3], uu, c[2]), uu, c[1]), uu, c[0]);
+    }
+
+    static Vec<L, T> hornerDerivative(const Segment& c, T u) {
+        const Vec<L, T> uu = detail::splat<Vec<L, T>>(u);
+        return detail::madd(detail::madd(c[3] * T(3), uu, c[2] * T(2)), uu, c[1]);
+    }
+
+    // Parameter where the arc length table reaches distance, starting the
+    // search at entry first and leaving it at the entry found
+    T paramFrom(std::size_t& first, T distance) const {
+        const std::size_t last = arcTable.size() - 1;
+        if (!(distance > T(0))) return T(0);
+        if (distance >= arcTable[last]) return T(segments.size());
+
+        if (first >= last || arcTable[first] > distance) first = 0;
+        if (arcTable[first + 1] <= distance) {
+            // Sorted distances usually land in the next entry
+            if (arcTable[first + 2] > distance) first++;
+            else first = (std::size_t)(std::upper_bound(arcTable.begin() + first + 2, arcTable.end(), distance) - arcTable.begin()) - 1;
+        }
+
+        const T f = (distance - arcTable[first]) / (arcTable[first + 1] - arcTable[first]);
+        return (T(first) + f) * T(segments.size()) / T(arcSteps);
+    }
+
+public:
+    CubicSpline() = default;
+
+    explicit CubicSpline(std::vector<Segment> segments) : segments(std::move(segments)) {}
+
+    // Through every point with the given tangents
+    // A single point gives one constant segment
+    static CubicSpline hermite(std::span<const Vec<L, T>> points, std::span<const Vec<L, T>> tangents) {
+        std::vector<Segment> out;
+        if (points.size() == 1) out.push_back({ points[0], Vec<L, T>(), Vec<L, T>(), Vec<L, T>() });
+        for (std::size_t i = 0; i + 1 < points.size(); i++) {
+            const Vec<L, T>& p0 = points[i];
+            const Vec<L, T>& p1 = points[i + 1];
+            const Vec<L, T>& m0 = tangents[i];
+            const Vec<L, T>& m1 = tangents[i + 1];
+            out.push_back({ p0, m0, (p1 - p0) * T(3) - m0 * T(2) - m1, (p0 - p1) * T(2) + m0 + m1 });
+        }
+        return CubicSpline(std::move(out));
+    }
+
+    // Uniform Catmull-Rom spline through every point
+    // The end points are repeated to get the first and last tangents
+    static CubicSpline catmullRom(std::span<const Vec<L, T>> points) {
+        std::vector<Vec<L, T>> tangents(points.size());
+        for (std::size_t i = 0; i < points.size(); i++) {
+            const Vec<L, T>& prev = points[i > 0 ? i - 1 : i];
+            const Vec<L, T>& next = points[i + 1 < points.size() ? i + 1 : i];
+            tangents[i] = (next - prev) * T(0.5);
+        }
+        return hermite(points, tangents);
+    }
+
+    // Cubic Bezier segments sharing end points, 3n + 1 control points for n
+    // segments
+    static CubicSpline bezier(std::span<const Vec<L, T>> controls) {
+        std::vector<Segment> out;
+        for (std::size_t i = 0; i + 3 < controls.size(); i += 3) {
+            const Vec<L, T>& b0 = controls[i];
+            const Vec<L, T>& b1 = controls[i + 1];
+            const Vec<L, T>& b2 = controls[i + 2];
+            const Vec<L, T>& b3 = controls[i + 3];
+            out.push_back({ b0, (b1 - b0) * T(3), (b0 - b1 * T(2) + b2) * T(3), b3 - b0 + (b1 - b2) * T(3) });
+        }
+        return CubicSpline(std::move(out));
+    }
+
+    std::size_t segmentCount() const {
+        return segments.size();
+    }
+
+    std::span<const Segment> coefficients() const {
+        return segments;
+    }
+
+    // Point at parameter t
+    Vec<L, T> evaluate(T t) const {
+        if (segments.empty()) return Vec<L, T>();
+        T u;
+        const std::size_t s = locate(t, u);
+        return horner(segments[s], u);
+    }
+
+    // Derivative with respect to t
+    Vec<L, T> derivative(T t) const {
+        if (segments.empty()) return Vec<L, T>();
+        T u;
+        const std::size_t s = locate(t, u);
+        return hornerDerivative(segments[s], u);
+    }
+
+    // Point at every parameter
+    void evaluate(std::span<const T> t, std::span<Vec<L, T>> out) const {
+        parallelFor(t.size(), detail::splineGrain, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) out[i] = evaluate(t[i]);
+        });
+    }
+
+    // Point at every parameter into component arrays
+    // Every run of parameters in the same segment is evaluated one component
+    // at a time with the coefficients held in registers, which vectorizes, so
+    // sorted parameters are fastest
+    void evaluate(std::span<const T> t, VecSoASpan<L, T> out) const {
+        if (segments.empty()) {
+            for (std::size_t k = 0; k < L; k++) std::fill_n(out.component(k).data(), t.size(), T(0));
+            return;
+        }
+        parallelFor(t.size(), detail::splineGrain, [&](std::size_t begin, std::size_t end) {
+            T u;
+            for (std::size_t i = begin; i < end;) {
+                const std::size_t s = locate(t[i], u);
+                std::size_t j = i + 1;
+                while (j < end && locate(t[j], u) == s) j++;
+
+                const Segment& c = segments[s];
+                const T lo = T(s);
+                const T hi = T(s + 1);
+                for (std::size_t k = 0; k < L; k++) {
+                    const T c0 = c[0][k];
+                    const T c1 = c[1][k];
+                    const T c2 = c[2][k];
+                    const T c3 = c[3][k];
+                    T* dst = out.component(k).data();
+                    for (std::size_t r = i; r < j; r++) {
+                        const T x = std::clamp(t[r], lo, hi) - lo;
+                        dst[r] = detail::madd(detail::madd(detail::madd(c3, x, c2), x, c1), x, c0);
+                    }
+                }
+                i = j;
+            }
+        });
+    }
+
+    // -- ARC LENGTH -- //
+
+    // Tabulate the length of the curve at stepsPerSegment points per segment
+    // Each step is integrated with 5 point Gauss-Legendre quadrature
+    void buildArcLength(std::size_t stepsPerSegment = 16) {
+        arcSteps = segments.size() * stepsPerSegment;
+        arcTable.resize(arcSteps + 1);
+        arcTable[0] = T(0);
+        const T h = T(1) / T(stepsPerSegment);
+        for (std::size_t s = 0; s < segments.size(); s++) {
+            for (std::size_t k = 0; k < stepsPerSegment; k++) {
+                T sum = T(0);
+                for (std::size_t q = 0; q < 5; q++)
+                    sum += T(detail::gaussWeights[q]) * length(hornerDerivative(segments[s], (T(k) + T(detail::gaussNodes[q])) * h));
+                const std::size_t i = s * stepsPerSegment + k;
+                arcTable[i + 1] = arcTable[i] + sum * h;
+            }
+        }
+    }
+
+    // Length of the whole curve, buildArcLength must have been called
+    T arcLength() const {
+        return arcTable.empty() ? T(0) : arcTable.back();
+    }
+
+    // Parameter at distance along the curve, buildArcLength must have been
+    // called
+    // Interpolates linearly between table entries
+    T paramAtDistance(T distance) const {
+        std::size_t first = 0;
+        return paramFrom(first, distance);
+    }
+
+    // Parameter at every distance
+    // Sorted distances walk the table instead of searching it
+    void paramAtDistance(std::span<const T> distance, std::span<T> out) const {
+        parallelFor(distance.size(), detail::splineGrain, [&](std::size_t begin, std::size_t end) {
+            std::size_t first = 0;
+            for (std::size_t i = begin; i < end; i++) out[i] = paramFrom(first, distance[i]);
+        });
+    }
+};
+
+}
+
+namespace esdm = esd::math;
\ No newline at end of file
@@ -64,6 +64,22 @@ constexpr Vec<L, T> abs(const Vec<L, T>& v) {
     return out;
 }
 
+// Component-wise minimum
+template <std::size_t L, AnyNum T>
+constexpr Vec<L, T> min(const Vec<L, T>& a, const Vec<L, T>& b) {
+    Vec<L, T> out;
+    for (std::size_t i = 0; i < L; i++) out[i] = min(a[i], b[i]);
+    return out;
+}
+
+// Component-wise maximum
+template <std::size_t L, AnyNum T>
+constexpr Vec<L, T> max(const Vec<L, T>& a, const Vec<L, T>& b) {
+    Vec<L, T> out;
+    for (std::size_t i = 0; i < L; i++) out[i] = max(a[i], b[i]);
+    return out;
+}
+
 // Square all components
 template <std::size_t L, AnyNum T>
 constexpr Vec<L, T> sq(const Vec<L, T>& v) {
@@ -83,8 +99,8 @@ inline Vec<L, T> sqrt(const Vec<L, T>& v) {
 // Raise components to a power
 template <std::size_t L, AnyNum T0, AnyNum T1>
 constexpr Vec<L, std::common_type_t<T0, T1>> pow(const Vec<L, T0>& b, T1 e) {
-    Vec<L, T> out;
-    for (std::size_t i = 0; i < L; i++) out[i] = sq(v[i]);
+    Vec<L, std::common_type_t<T0, T1>> out;
+    for (std::size_t i = 0; i < L; i++) out[i] = pow(b[i], e);
     return out;
 }
 
@@ -112,6 +128,46 @@ constexpr Vec3<std::common_type_t<T0, T1>> cross(
     );
 }
 
+// -- LENGTH -- //
+
+// Squared length
+template <std::size_t L, AnyNum T>
+constexpr T lengthSq(const Vec<L, T>& v) {
+    return dot(v, v);
+}
+
+// Length
+template <std::size_t L, AnyFloat T>
+inline T length(const Vec<L, T>& v) {
+    return sqrt(lengthSq(v));
+}
+
+// Scale to unit length
+// One reciprocal square root and L multiplications
+// The zero vector gives NaN components, see normalizeSafe
+template <std::size_t L, AnyFloat T>
+inline Vec<L, T> normalize(const Vec<L, T>& v) {
+    return v * rsqrt(lengthSq(v));
+}
+
+// Scale to unit length, or return fallback if the length is zero, denormal
+// or not finite
+template <std::size_t L, AnyFloat T>
+inline Vec<L, T> normalizeSafe(const Vec<L, T>& v, const Vec<L, T>& fallback = Vec<L, T>()) {
+    const T sq = lengthSq(v);
+    return sq >= std::numeric_limits<T>::min() && sq <= std::numeric_limits<T>::max() 
+        ? v * rsqrt(sq) 
+        : fallback;
+}
+
+// Scale to approximately unit length using fastRsqrt
+// For float with SSE, the relative error of the resulting length is below
+// 2^-21 plus the rounding of the dot product
+template <std::size_t L, AnyFloat T>
+inline Vec<L, T> fastNormalize(const Vec<L, T>& v) {
+    return v * fastRsqrt(lengthSq(v));
+}
+
 // -- ROUNDING -- //
 
 // Truncate all components
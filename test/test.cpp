@@ -19,13 +19,43 @@
 // SOFTWARE.
 
 #define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_NO_POSIX_SIGNALS
 #include "catch.hpp"
 
 #include <eseed/math/ops.hpp>
 #include <eseed/math/vec.hpp>
 #include <eseed/math/vecops.hpp>
 #include <eseed/math/matops.hpp>
+#include <eseed/math/reduce.hpp>
+#include <eseed/math/batch.hpp>
+#include <eseed/math/spatial.hpp>
+#include <eseed/math/sort.hpp>
+#include <eseed/math/grid.hpp>
+#include <eseed/math/hash.hpp>
+#include <eseed/math/poly.hpp>
+#include <eseed/math/spline.hpp>
+#include <eseed/math/noise.hpp>
+#include <eseed/math/random.hpp>
+#include <eseed/math/decomp.hpp>
+#include <eseed/math/solve.hpp>
+#include <eseed/math/matexp.hpp>
+#include <eseed/math/hierarchy.hpp>
+#include <eseed/math/codec.hpp>
+#include <eseed/math/snapshot.hpp>
+#include <eseed/math/bounds.hpp>
+#include <eseed/math/broadphase.hpp>
+#include <eseed/math/gjk.hpp>
+#include <eseed/math/hull.hpp>
+#include <eseed/math/predicates.hpp>
+#include <eseed/math/mesh.hpp>
+#include <eseed/math/integrate.hpp>
+#include <random>
+#include <numeric>
+#include <mutex>
+#include <unordered_map>
+#include <map>
 #include <iostream>
+#include <chrono>
 
 TEST_CASE("scalar functions", "[scalar]") {
 
@@ -262,6 +292,34 @@ TEST_CASE("vector functions", "[vector]") {
         REQUIRE(n == 32.f);
     }
 
+    SECTION("length") {
+        constexpr float sq = esdm::lengthSq(esdm::Vec3<float>(1.f, 2.f, 2.f));
+        REQUIRE(sq == 9.f);
+        REQUIRE(esdm::length(esdm::Vec3<float>(1.f, 2.f, 2.f)) == 3.f);
+    }
+
+    SECTION("normalize") {
+        REQUIRE(esdm::normalize(esdm::Vec2<float>(3.f, 4.f)) == esdm::Vec2<float>(0.6f, 0.8f));
+        REQUIRE(esdm::anynan(esdm::normalize(esdm::Vec3<float>())));
+
+        constexpr esdm::Vec3<float> fallback(0.f, 0.f, 1.f);
+        REQUIRE(esdm::normalizeSafe(esdm::Vec3<float>(), fallback) == fallback);
+        REQUIRE(esdm::normalizeSafe(esdm::Vec3<float>(1e-30f, 0.f, 0.f), fallback) == fallback);
+        REQUIRE(esdm::normalizeSafe(esdm::Vec3<float>(esdm::inf<float>(), 0.f, 0.f), fallback) == fallback);
+        REQUIRE(esdm::normalizeSafe(esdm::Vec3<float>(0.f, 2.f, 0.f)) == esdm::Vec3<float>(0.f, 1.f, 0.f));
+    }
+
+    SECTION("fast normalize error bound") {
+        float worst = 0.f;
+        for (float f = 1e-3f; f < 1e4f; f *= 1.01f) {
+            esdm::Vec3<float> v(f, 0.5f * f, -0.25f * f);
+            double len = esdm::length(esdm::Vec3<double>(esdm::fastNormalize(v)));
+            worst = std::max(worst, (float)std::abs(len - 1.0));
+            REQUIRE(std::abs(esdm::fastRsqrt(f) * std::sqrt((double)f) - 1.0) < 4.8e-7);
+        }
+        REQUIRE(worst < 1e-6f);
+    }
+
     SECTION("cross product") {
         constexpr esdm::Vec3<float> a(2.f, 3.f, 4.f);
         constexpr esdm::Vec3<float> b(5.f, 6.f, 7.f);
@@ -408,4 +466,2541 @@ TEST_CASE("matrix functions", "[matrix]") {
         REQUIRE(d == esdm::Vec2<float>(5, 11));
         REQUIRE(e == esdm::Vec2<float>(7, 10));
     }
+
+    SECTION("generation") {
+        const esdm::Vec4<float> p = esdm::Vec4<float>(1, 2, 3, 1) * esdm::mattrans(esdm::Vec3<float>(4, 5, 6));
+        REQUIRE(p == esdm::Vec4<float>(5, 7, 9, 1));
+
+        const esdm::Vec4<float> r = esdm::Vec4<float>(1, 0, 0, 1) * esdm::matrot(esdm::Vec3<float>(0, 0, 1), esdm::pi<float>() / 2);
+        REQUIRE(r[0] == Approx(0).margin(1e-6));
+        REQUIRE(r[1] == Approx(1));
+    }
+
+    SECTION("camera") {
+        using M4 = esdm::Mat4<double>;
+        using V4 = esdm::Vec4<double>;
+
+        auto project = [](const V4& v, const M4& m) {
+            V4 c = v * m;
+            return V4(c[0] / c[3], c[1] / c[3], c[2] / c[3], c[3]);
+        };
+        auto requireIdentity = [](const M4& m) {
+            for (std::size_t i = 0; i < 4; i++)
+                for (std::size_t j = 0; j < 4; j++)
+                    REQUIRE(m[i][j] == Approx(i == j ? 1 : 0).margin(1e-9));
+        };
+
+        const double fov = 1.2;
+        const double aspect = 16.0 / 9.0;
+        const double near = 0.1;
+        const double far = 100;
+        const double f = 1 / std::tan(fov / 2);
+
+        // Corner of the near plane and centre of the far plane
+        const V4 nearCorner(near * aspect / f, near / f, -near, 1);
+        const V4 farCentre(0, 0, -far, 1);
+
+        REQUIRE(project(nearCorner, esdm::perspective(fov, aspect, near, far))[0] == Approx(1));
+        REQUIRE(project(nearCorner, esdm::perspective(fov, aspect, near, far))[1] == Approx(1));
+        REQUIRE(project(nearCorner, esdm::perspective(fov, aspect, near, far))[2] == Approx(0).margin(1e-9));
+        REQUIRE(project(farCentre, esdm::perspective(fov, aspect, near, far))[2] == Approx(1));
+        REQUIRE(project(nearCorner, esdm::perspectiveReversed(fov, aspect, near, far))[2] == Approx(1));
+        REQUIRE(project(farCentre, esdm::perspectiveReversed(fov, aspect, near, far))[2] == Approx(0).margin(1e-9));
+        REQUIRE(project(nearCorner, esdm::perspectiveInfinite(fov, aspect, near))[2] == Approx(0).margin(1e-9));
+        REQUIRE(project(V4(0, 0, -1e12, 1), esdm::perspectiveInfinite(fov, aspect, near))[2] == Approx(1));
+        REQUIRE(project(nearCorner, esdm::perspectiveInfiniteReversed(fov, aspect, near))[2] == Approx(1));
+        REQUIRE(project(V4(0, 0, -1e12, 1), esdm::perspectiveInfiniteReversed(fov, aspect, near))[2] == Approx(0).margin(1e-9));
+
+        const V4 boxCorner(-2, 3, -1, 1);
+        const V4 o = project(boxCorner, esdm::orthographic(-2.0, 4.0, -3.0, 3.0, 1.0, 10.0));
+        REQUIRE(o[0] == Approx(-1));
+        REQUIRE(o[1] == Approx(1));
+        REQUIRE(o[2] == Approx(0).margin(1e-9));
+        REQUIRE(project(boxCorner, esdm::orthographicReversed(-2.0, 4.0, -3.0, 3.0, 1.0, 10.0))[2] == Approx(1));
+
+        constexpr esdm::Vec3<double> eye(1, 2, 3);
+        constexpr esdm::Vec3<double> target(-4, 0, 1);
+        const M4 view = esdm::lookAt(eye, target, esdm::Vec3<double>(0, 1, 0));
+        const V4 e = V4(1, 2, 3, 1) * view;
+        REQUIRE(esdm::length(esdm::Vec3<double>(e[0], e[1], e[2])) == Approx(0).margin(1e-9));
+        const V4 t = V4(-4, 0, 1, 1) * view;
+        REQUIRE(t[0] == Approx(0).margin(1e-9));
+        REQUIRE(t[1] == Approx(0).margin(1e-9));
+        REQUIRE(t[2] == Approx(-esdm::length(target - eye)));
+
+        requireIdentity(esdm::perspective(fov, aspect, near, far) * esdm::perspectiveInverse(fov, aspect, near, far));
+        requireIdentity(esdm::perspectiveReversed(fov, aspect, near, far) * esdm::perspectiveReversedInverse(fov, aspect, near, far));
+        requireIdentity(esdm::perspectiveInfinite(fov, aspect, near) * esdm::perspectiveInfiniteInverse(fov, aspect, near));
+        requireIdentity(esdm::perspectiveInfiniteReversed(fov, aspect, near) * esdm::perspectiveInfiniteReversedInverse(fov, aspect, near));
+        requireIdentity(esdm::orthographic(-2.0, 4.0, -3.0, 3.0, 1.0, 10.0) * esdm::orthographicInverse(-2.0, 4.0, -3.0, 3.0, 1.0, 10.0));
+        requireIdentity(esdm::orthographicReversed(-2.0, 4.0, -3.0, 3.0, 1.0, 10.0) * esdm::orthographicReversedInverse(-2.0, 4.0, -3.0, 3.0, 1.0, 10.0));
+        requireIdentity(view * esdm::lookAtInverse(eye, target, esdm::Vec3<double>(0, 1, 0)));
+
+        constexpr esdm::Mat4<float> ortho = esdm::orthographic(0.f, 2.f, 0.f, 2.f, 0.f, 1.f);
+        STATIC_REQUIRE(ortho[3][0] == -1.f);
+
+        // Focal scale 1 for a 90 degree field of view
+        constexpr esdm::Mat4<double> persp = esdm::perspectiveFrom(1.0, 2.0, 1.0, 3.0);
+        STATIC_REQUIRE(persp[0][0] == 0.5);
+        STATIC_REQUIRE(persp[2][3] == -1.0);
+        STATIC_REQUIRE(esdm::perspectiveReversedInverseFrom(1.0, 2.0, 1.0, 3.0)[0][0] == 2.0);
+        STATIC_REQUIRE(esdm::perspectiveInfiniteReversedFrom(1.0, 2.0, 1.0)[3][2] == 1.0);
+        requireIdentity(esdm::perspectiveFrom(f, aspect, near, far) * esdm::perspectiveInverse(fov, aspect, near, far));
+
+        constexpr esdm::Mat4<double> look = esdm::lookAt(esdm::Vec3<double>(0, 0, 5), esdm::Vec3<double>(0, 0, 0), esdm::Vec3<double>(0, 1, 0));
+        STATIC_REQUIRE(look[0][0] == 1.0);
+        STATIC_REQUIRE(look[2][2] == 1.0);
+        STATIC_REQUIRE(look[3][2] == -5.0);
+        constexpr esdm::Mat4<double> lookBack = esdm::lookAtInverse(eye, target, esdm::Vec3<double>(0, 1, 0));
+        for (std::size_t i = 0; i < 4; i++)
+            for (std::size_t j = 0; j < 4; j++)
+                REQUIRE(lookBack[i][j] == Approx(esdm::lookAtInverse(eye, target, esdm::Vec3<double>(0, 1, 0))[i][j]).margin(1e-12));
+        STATIC_REQUIRE(esdm::detail::constexprSqrt(4.0) == 2.0);
+        STATIC_REQUIRE(esdm::detail::constexprSqrt(0.0) == 0.0);
+        for (double x : { 2.0, 0.3, 1e-300, 1e300 }) REQUIRE(esdm::detail::constexprSqrt(x) == Approx(std::sqrt(x)).epsilon(1e-15));
+    }
+}
+
+TEST_CASE("vector reductions", "[reduce]") {
+    std::vector<esdm::Vec3<float>> small = {
+        { 1.f, -2.f, 3.f },
+        { -4.f, 5.f, 0.5f },
+        { 2.f, 1.f, -6.f }
+    };
+    std::span<const esdm::Vec3<float>> s(small);
+
+    SECTION("min / max") {
+        REQUIRE(esdm::reduce_min(s) == esdm::Vec3<float>(-4.f, -2.f, -6.f));
+        REQUIRE(esdm::reduce_max(s) == esdm::Vec3<float>(2.f, 5.f, 3.f));
+
+        auto [lo, hi] = esdm::minmax(s);
+        REQUIRE(lo == esdm::Vec3<float>(-4.f, -2.f, -6.f));
+        REQUIRE(hi == esdm::Vec3<float>(2.f, 5.f, 3.f));
+
+        esdm::AABB3<float> box = esdm::aabb(s);
+        REQUIRE(box.min == lo);
+        REQUIRE(box.max == hi);
+    }
+
+    SECTION("sum / mean") {
+        REQUIRE(esdm::sum(s) == esdm::Vec3<float>(-1.f, 4.f, -2.5f));
+        REQUIRE(esdm::mean(s) == esdm::Vec3<float>(-1.f / 3.f, 4.f / 3.f, -2.5f / 3.f));
+
+        std::vector<esdm::Vec2<int>> ints = { { 1, 2 }, { 3, 4 }, { 5, 6 } };
+        REQUIRE(esdm::sum(std::span<const esdm::Vec2<int>>(ints)) == esdm::Vec2<int>(9, 12));
+    }
+
+    SECTION("empty") {
+        std::span<const esdm::Vec3<float>> empty;
+        REQUIRE(esdm::allinf(esdm::reduce_min(empty)));
+        REQUIRE(esdm::sum(empty) == esdm::Vec3<float>());
+        REQUIRE(esdm::allnan(esdm::mean(empty)));
+    }
+
+    SECTION("large input is thread count independent") {
+        std::vector<esdm::Vec3<float>> big(300001);
+        for (std::size_t i = 0; i < big.size(); i++)
+            big[i] = { 0.1f, float(i % 1000) - 500.f, float(i) };
+        std::span<const esdm::Vec3<float>> b(big);
+
+        esdm::ThreadPool serial(1);
+        esdm::ThreadPool threaded(4);
+
+        esdm::Vec3<float> total = esdm::sum(threaded, b);
+        REQUIRE(total == esdm::sum(serial, b));
+        // Naive float accumulation of 0.1 drifts by hundreds at this size
+        REQUIRE(std::abs(total[0] - 30000.1f) < 0.05f);
+        REQUIRE(total[2] == Approx(300000.0 * 300001.0 / 2.0));
+
+        REQUIRE(esdm::reduce_min(threaded, b) == esdm::Vec3<float>(0.1f, -500.f, 0.f));
+        REQUIRE(esdm::reduce_max(threaded, b) == esdm::Vec3<float>(0.1f, 499.f, 300000.f));
+        REQUIRE(esdm::minmax(threaded, b) == esdm::minmax(serial, b));
+    }
+}
+
+TEST_CASE("thread pool", "[parallel]") {
+    esdm::ThreadPool pool(4);
+
+    SECTION("nested runs on the same pool") {
+        // Inner runs come from the submitting thread as well as the workers
+        std::vector<std::size_t> sums = esdm::parallelMap<std::size_t>(pool, 64, 1, [&](std::size_t begin, std::size_t) {
+            std::vector<std::size_t> inner = esdm::parallelMap<std::size_t>(pool, 1000, 10, [&](std::size_t b, std::size_t e) {
+                std::size_t total = 0;
+                for (std::size_t i = b; i < e; i++) total += i;
+                return total;
+            });
+            std::atomic<std::size_t> counted = 0;
+            esdm::parallelFor(pool, 100, 1, [&](std::size_t b, std::size_t e) { counted += e - b; });
+            return std::accumulate(inner.begin(), inner.end(), std::size_t(0)) + counted + begin;
+        });
+        for (std::size_t c = 0; c < sums.size(); c++) REQUIRE(sums[c] == 999 * 1000 / 2 + 100 + c);
+    }
+
+    SECTION("throwing calls") {
+        std::atomic<std::size_t> calls = 0;
+        REQUIRE_THROWS_AS(pool.run(10000, [&](std::size_t i) {
+            calls++;
+            if (i == 17) throw std::runtime_error("fail");
+        }), std::runtime_error);
+        REQUIRE(calls < 10000);
+
+        // The pool is still usable afterwards
+        std::atomic<std::size_t> total = 0;
+        pool.run(1000, [&](std::size_t i) { total += i; });
+        REQUIRE(total == 999 * 1000 / 2);
+    }
+}
+
+TEST_CASE("batch vector functions", "[batch]") {
+    std::vector<esdm::Vec3<float>> v;
+    for (int i = 0; i < 100; i++)
+        v.push_back({ float(i) - 50.f, float(i % 7) + 0.5f, 0.25f * float(i) });
+    std::span<const esdm::Vec3<float>> in(v);
+
+    SECTION("length") {
+        std::vector<float> len(v.size());
+        esdm::length(in, std::span<float>(len));
+        for (std::size_t i = 0; i < v.size(); i++) REQUIRE(len[i] == esdm::length(v[i]));
+
+        esdm::VecSoA<3, float> soa(in);
+        std::vector<float> soaLen(v.size());
+        esdm::length(soa.view(), std::span<float>(soaLen));
+        REQUIRE(soaLen == len);
+    }
+
+    SECTION("normalize matches single vector version") {
+        std::vector<esdm::Vec3<float>> out(v.size());
+        esdm::normalize(in, std::span<esdm::Vec3<float>>(out));
+        for (std::size_t i = 0; i < v.size(); i++) REQUIRE(out[i] == esdm::normalize(v[i]));
+
+        esdm::fastNormalize(in, std::span<esdm::Vec3<float>>(out));
+        for (std::size_t i = 0; i < v.size(); i++) REQUIRE(out[i] == esdm::fastNormalize(v[i]));
+    }
+
+    SECTION("structure of arrays") {
+        esdm::VecSoA<3, float> soa(in);
+        REQUIRE(soa.size() == v.size());
+        REQUIRE(soa.get(3) == v[3]);
+
+        esdm::normalize(soa.view());
+        for (std::size_t i = 0; i < v.size(); i++) REQUIRE(soa.get(i) == esdm::normalize(v[i]));
+
+        esdm::VecSoA<3, float> fast(in);
+        esdm::fastNormalize(fast.view());
+        for (std::size_t i = 0; i < v.size(); i++) REQUIRE(fast.get(i) == esdm::fastNormalize(v[i]));
+
+        REQUIRE(soa.view().subspan(10, 5).get(0) == soa.get(10));
+    }
+}
+
+TEST_CASE("spatial keys", "[spatial]") {
+    SECTION("morton layout") {
+        static_assert(esdm::mortonEncode(esdm::Vec3<unsigned>(1, 0, 0)) == 1);
+        static_assert(esdm::mortonEncode(esdm::Vec3<unsigned>(0, 1, 0)) == 2);
+        static_assert(esdm::mortonEncode(esdm::Vec3<unsigned>(0, 0, 1)) == 4);
+        static_assert(esdm::mortonEncode(esdm::Vec3<unsigned>(3, 3, 3)) == 63);
+        static_assert(esdm::mortonEncode<std::uint32_t>(esdm::Vec2<unsigned>(0, 0xffff)) == 0xaaaaaaaa);
+
+        REQUIRE(esdm::mortonEncode(esdm::Vec3<unsigned>(5, 9, 17)) == esdm::mortonEncode(esdm::Vec3<std::uint64_t>(5, 9, 17)));
+        REQUIRE(esdm::mortonEncode(esdm::Vec3<unsigned>(0x1fffff, 0x1fffff, 0x1fffff)) == 0x7fffffffffffffff);
+    }
+
+    SECTION("signed components keep their order") {
+        REQUIRE(esdm::mortonEncode(esdm::Vec3<int>(-1, 0, 0)) < esdm::mortonEncode(esdm::Vec3<int>(0, 0, 0)));
+        REQUIRE(esdm::mortonEncode(esdm::Vec2<int>(-5, -5)) < esdm::mortonEncode(esdm::Vec2<int>(-4, -4)));
+        REQUIRE(esdm::mortonEncode(esdm::Vec3<int>(-1 << 20, -1 << 20, -1 << 20)) == 0);
+    }
+
+    SECTION("narrow signed components keep their order") {
+        // Components narrower than the key bits straddling zero
+        for (int i = -100; i < 100; i++) {
+            const std::int8_t n8 = std::int8_t(i);
+            const std::int16_t n16 = std::int16_t(i * 300);
+            esdm::Vec2<std::int8_t> a2(n8, n8);
+            esdm::Vec2<std::int8_t> b2(std::int8_t(n8 + 1), std::int8_t(n8 + 1));
+            esdm::Vec3<std::int16_t> a3(n16, n16, n16);
+            esdm::Vec3<std::int16_t> b3(std::int16_t(n16 + 300), std::int16_t(n16 + 300), std::int16_t(n16 + 300));
+            REQUIRE(esdm::mortonEncode<std::uint32_t>(a2) < esdm::mortonEncode<std::uint32_t>(b2));
+            REQUIRE(esdm::mortonEncode(a3) < esdm::mortonEncode(b3));
+            REQUIRE(esdm::mortonDecode<2, std::int8_t>(esdm::mortonEncode<std::uint32_t>(a2)) == a2);
+            REQUIRE(esdm::mortonDecode<3, std::int16_t>(esdm::mortonEncode(a3)) == a3);
+            REQUIRE(esdm::hilbertDecode<2, std::int8_t>(esdm::hilbertEncode<std::uint32_t>(a2)) == a2);
+            REQUIRE(esdm::hilbertDecode<3, std::int16_t>(esdm::hilbertEncode(a3)) == a3);
+        }
+        REQUIRE(esdm::mortonEncode(esdm::Vec3<std::int16_t>(-1, 0, 0)) < esdm::mortonEncode(esdm::Vec3<std::int16_t>(0, 0, 0)));
+    }
+
+    SECTION("morton round trip") {
+        constexpr esdm::Vec3<int> c(-7, 123, -100000);
+        static_assert(esdm::mortonDecode<3, int>(esdm::mortonEncode(c)) == c);
+
+        for (int i = -1000; i < 1000; i += 7) {
+            esdm::Vec3<int> v3(i, -3 * i, i * 1000);
+            esdm::Vec2<int> v2(i * 100000, -i);
+            REQUIRE(esdm::mortonDecode<3, int>(esdm::mortonEncode(v3)) == v3);
+            REQUIRE(esdm::mortonDecode<2, int>(esdm::mortonEncode(v2)) == v2);
+            REQUIRE(esdm::mortonDecode<2, int>(esdm::mortonEncode<std::uint32_t>(esdm::Vec2<int>(i, -i))) == esdm::Vec2<int>(i, -i));
+        }
+    }
+
+    SECTION("hilbert curve is continuous") {
+        auto manhattan = []<std::size_t L>(esdm::Vec<L, int> a, esdm::Vec<L, int> b) {
+            return esdm::dot(esdm::abs(a - b), esdm::Vec<L, int>(esdm::Vec4<int>(1, 1, 1, 1)));
+        };
+
+        esdm::Vec2<unsigned> prev2 = esdm::hilbertDecode<2, unsigned>(std::uint32_t(0));
+        esdm::Vec3<unsigned> prev3 = esdm::hilbertDecode<3, unsigned>(std::uint64_t(0));
+        for (std::uint32_t d = 1; d < 5000; d++) {
+            esdm::Vec2<unsigned> p2 = esdm::hilbertDecode<2, unsigned>(d);
+            esdm::Vec3<unsigned> p3 = esdm::hilbertDecode<3, unsigned>(std::uint64_t(d));
+            REQUIRE(manhattan(esdm::Vec2<int>(p2), esdm::Vec2<int>(prev2)) == 1);
+            REQUIRE(manhattan(esdm::Vec3<int>(p3), esdm::Vec3<int>(prev3)) == 1);
+            REQUIRE(esdm::hilbertEncode<std::uint32_t>(p2) == d);
+            REQUIRE(esdm::hilbertEncode(p3) == d);
+            prev2 = p2;
+            prev3 = p3;
+        }
+    }
+
+    SECTION("hilbert round trip") {
+        constexpr esdm::Vec3<int> c(-7, 123, -100000);
+        static_assert(esdm::hilbertDecode<3, int>(esdm::hilbertEncode(c)) == c);
+
+        for (int i = -1000; i < 1000; i += 7) {
+            esdm::Vec3<int> v3(i, -3 * i, i * 1000);
+            esdm::Vec2<int> v2(i * 100000, -i);
+            REQUIRE(esdm::hilbertDecode<3, int>(esdm::hilbertEncode(v3)) == v3);
+            REQUIRE(esdm::hilbertDecode<2, int>(esdm::hilbertEncode(v2)) == v2);
+        }
+    }
+
+    SECTION("batch") {
+        std::vector<esdm::Vec3<int>> v;
+        for (int i = 0; i < 1000; i++) v.push_back({ i, -i, i * 3 });
+        std::vector<std::uint64_t> keys(v.size());
+        std::vector<esdm::Vec3<int>> back(v.size());
+
+        esdm::mortonEncode(std::span<const esdm::Vec3<int>>(v), std::span<std::uint64_t>(keys));
+        for (std::size_t i = 0; i < v.size(); i++) REQUIRE(keys[i] == esdm::mortonEncode(v[i]));
+        esdm::mortonDecode(std::span<const std::uint64_t>(keys), std::span<esdm::Vec3<int>>(back));
+        REQUIRE(back == v);
+
+        esdm::hilbertEncode(std::span<const esdm::Vec3<int>>(v), std::span<std::uint64_t>(keys));
+        for (std::size_t i = 0; i < v.size(); i++) REQUIRE(keys[i] == esdm::hilbertEncode(v[i]));
+        esdm::hilbertDecode(std::span<const std::uint64_t>(keys), std::span<esdm::Vec3<int>>(back));
+        REQUIRE(back == v);
+    }
+}
+
+TEST_CASE("radix sort", "[sort]") {
+    std::mt19937_64 rng(1234);
+
+    SECTION("order is stable") {
+        std::vector<std::uint32_t> keys = { 5, 3, 5, 1, 3, 0, 5 };
+        esdm::RadixSorter<std::uint32_t> sorter;
+        std::span<const std::uint32_t> order = sorter.order(std::span<const std::uint32_t>(keys));
+        REQUIRE(std::vector<std::uint32_t>(order.begin(), order.end()) == std::vector<std::uint32_t>{ 5, 3, 1, 4, 0, 2, 6 });
+    }
+
+    SECTION("payloads follow their keys") {
+        std::vector<std::uint64_t> keys(1000);
+        std::vector<esdm::Vec3<float>> positions(keys.size());
+        std::vector<esdm::Mat2<float>> mats(keys.size());
+        esdm::VecSoA<2, int> soa(keys.size());
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            keys[i] = rng() % 100;
+            positions[i] = { float(i), float(keys[i]), 0.f };
+            mats[i] = esdm::Mat2<float>::ident(float(i));
+            soa.set(i, { int(i), -int(i) });
+        }
+
+        esdm::radixSort(
+            std::span<std::uint64_t>(keys), 
+            std::span<esdm::Vec3<float>>(positions), 
+            std::span<esdm::Mat2<float>>(mats), 
+            soa.view()
+        );
+
+        REQUIRE(std::is_sorted(keys.begin(), keys.end()));
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            std::size_t from = (std::size_t)positions[i][0];
+            REQUIRE(positions[i][1] == float(keys[i]));
+            REQUIRE(mats[i] == esdm::Mat2<float>::ident(float(from)));
+            REQUIRE(soa.get(i) == esdm::Vec2<int>(int(from), -int(from)));
+            // Stable
+            if (i > 0 && keys[i] == keys[i - 1]) REQUIRE(positions[i - 1][0] < positions[i][0]);
+        }
+    }
+
+    SECTION("large input matches std::stable_sort on any thread count") {
+        std::vector<std::uint32_t> keys(200000);
+        for (std::uint32_t& k : keys) k = (std::uint32_t)rng();
+        std::vector<std::uint32_t> expected(keys.size());
+        std::iota(expected.begin(), expected.end(), 0);
+        std::stable_sort(expected.begin(), expected.end(), [&](std::uint32_t a, std::uint32_t b) { return keys[a] < keys[b]; });
+
+        esdm::ThreadPool pool(4);
+        esdm::RadixSorter<std::uint32_t> sorter(pool);
+        std::span<const std::uint32_t> order = sorter.order(std::span<const std::uint32_t>(keys));
+        REQUIRE(std::equal(order.begin(), order.end(), expected.begin(), expected.end()));
+
+        // Already sorted input is recognised and kept as is
+        std::vector<std::uint32_t> payload(keys.size());
+        std::iota(payload.begin(), payload.end(), 0);
+        sorter.sort(std::span<std::uint32_t>(keys), std::span<std::uint32_t>(payload));
+        REQUIRE(payload == expected);
+        sorter.sort(std::span<std::uint32_t>(keys), std::span<std::uint32_t>(payload));
+        REQUIRE(payload == expected);
+    }
+
+    SECTION("sort by morton key") {
+        std::vector<esdm::Vec3<int>> cells;
+        for (int i = 0; i < 500; i++) cells.push_back({ int(rng() % 64) - 32, int(rng() % 64) - 32, int(rng() % 64) - 32 });
+        std::vector<std::uint64_t> keys(cells.size());
+        esdm::mortonEncode(std::span<const esdm::Vec3<int>>(cells), std::span<std::uint64_t>(keys));
+        esdm::radixSort(std::span<std::uint64_t>(keys), std::span<esdm::Vec3<int>>(cells));
+        for (std::size_t i = 0; i < cells.size(); i++) REQUIRE(esdm::mortonEncode(cells[i]) == keys[i]);
+        REQUIRE(std::is_sorted(keys.begin(), keys.end()));
+    }
+}
+
+TEST_CASE("hash grid", "[grid]") {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> coord(-6.f, 6.f);
+    std::vector<esdm::Vec3<float>> points(3000);
+    for (esdm::Vec3<float>& p : points) p = { coord(rng), coord(rng), coord(rng) };
+
+    esdm::ThreadPool pool(4);
+    esdm::HashGrid<float> grid(pool);
+    grid.build(std::span<const esdm::Vec3<float>>(points), 1.f);
+    REQUIRE(grid.size() == points.size());
+
+    auto bruteRadius = [&](esdm::Vec3<float> c, float r) {
+        std::vector<std::uint32_t> out;
+        for (std::size_t i = 0; i < points.size(); i++)
+            if (esdm::lengthSq(points[i] - c) <= r * r) out.push_back((std::uint32_t)i);
+        return out;
+    };
+
+    auto checkRadius = [&] {
+        for (int q = 0; q < 50; q++) {
+            esdm::Vec3<float> c(coord(rng), coord(rng), coord(rng));
+            float r = 0.1f * float(q % 25);
+            std::vector<std::uint32_t> found;
+            grid.queryRadius(c, r, found);
+            std::sort(found.begin(), found.end());
+            REQUIRE(found == bruteRadius(c, r));
+        }
+    };
+
+    auto pairSet = [&](float r) {
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> pairs;
+        std::mutex mutex;
+        grid.forEachPair(r, [&](std::span<const std::uint32_t> a, std::span<const std::uint32_t> b) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (std::size_t i = 0; i < a.size(); i++) pairs.push_back(std::minmax(a[i], b[i]));
+        });
+        std::sort(pairs.begin(), pairs.end());
+        return pairs;
+    };
+
+    auto brutePairs = [&](float r) {
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> pairs;
+        for (std::uint32_t i = 0; i < points.size(); i++)
+            for (std::uint32_t j = i + 1; j < points.size(); j++)
+                if (esdm::lengthSq(points[i] - points[j]) <= r * r) pairs.push_back({ i, j });
+        return pairs;
+    };
+
+    SECTION("radius queries") {
+        checkRadius();
+    }
+
+    SECTION("nearest neighbours") {
+        for (int q = 0; q < 20; q++) {
+            esdm::Vec3<float> c(coord(rng) * 1.5f, coord(rng), coord(rng));
+            std::vector<std::uint32_t> found;
+            grid.queryNearest(c, 8, found);
+
+            std::vector<std::uint32_t> expected(points.size());
+            std::iota(expected.begin(), expected.end(), 0);
+            std::partial_sort(expected.begin(), expected.begin() + 8, expected.end(), [&](std::uint32_t a, std::uint32_t b) {
+                return std::make_pair(esdm::lengthSq(points[a] - c), a) < std::make_pair(esdm::lengthSq(points[b] - c), b);
+            });
+            expected.resize(8);
+            REQUIRE(found == expected);
+        }
+
+        std::vector<std::uint32_t> all;
+        grid.queryNearest(esdm::Vec3<float>(), points.size() + 10, all);
+        REQUIRE(all.size() == points.size());
+    }
+
+    SECTION("nearest neighbours across far apart clusters") {
+        // Two clusters at opposite corners of a box 1000 cells wide, probing
+        // every cell between them took seconds per query
+        std::vector<esdm::Vec3<float>> far;
+        for (int i = 0; i < 200; i++) far.push_back(points[i] * 0.1f);
+        for (int i = 200; i < 400; i++) far.push_back(points[i] * 0.1f + 1000.f);
+        esdm::HashGrid<float> sparse(pool);
+        sparse.build(std::span<const esdm::Vec3<float>>(far), 1.f);
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::uint32_t> found;
+        sparse.queryNearest(esdm::Vec3<float>(), 201, found);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        REQUIRE(seconds < 0.5);
+
+        REQUIRE(found.size() == 201);
+        std::vector<std::uint32_t> near(found.begin(), found.end() - 1);
+        std::sort(near.begin(), near.end());
+        for (std::uint32_t i = 0; i < 200; i++) REQUIRE(near[i] == i);
+        REQUIRE(found.back() >= 200);
+
+        std::vector<std::uint32_t> all;
+        sparse.queryNearest(esdm::Vec3<float>(500.f), 1000, all);
+        REQUIRE(all.size() == far.size());
+    }
+
+    SECTION("pairs within radius") {
+        REQUIRE(pairSet(0.5f) == brutePairs(0.5f));
+        REQUIRE(pairSet(1.7f) == brutePairs(1.7f));
+    }
+
+    SECTION("incremental update") {
+        std::uniform_real_distribution<float> jitter(-0.02f, 0.02f);
+        for (int frame = 0; frame < 3; frame++) {
+            for (esdm::Vec3<float>& p : points) p += esdm::Vec3<float>(jitter(rng), jitter(rng), jitter(rng));
+            REQUIRE(grid.update(std::span<const esdm::Vec3<float>>(points)));
+            checkRadius();
+            REQUIRE(pairSet(0.5f) == brutePairs(0.5f));
+        }
+
+        for (esdm::Vec3<float>& p : points) p = { coord(rng), coord(rng), coord(rng) };
+        REQUIRE(!grid.update(std::span<const esdm::Vec3<float>>(points)));
+        checkRadius();
+    }
+}
+
+TEST_CASE("hashing", "[hash]") {
+    SECTION("vector and matrix hashes") {
+        std::hash<esdm::Vec3<int>> h3;
+        REQUIRE(h3({ 1, 2, 3 }) == h3({ 1, 2, 3 }));
+        REQUIRE(h3({ 1, 2, 3 }) != h3({ 3, 2, 1 }));
+        REQUIRE(std::hash<esdm::Vec2<float>>()({ 0.f, 1.f }) == std::hash<esdm::Vec2<float>>()({ -0.f, 1.f }));
+        REQUIRE(std::hash<esdm::Mat2<double>>()(esdm::Mat2<double>(1, 2, 3, 4)) == std::hash<esdm::Mat2<double>>()(esdm::Mat2<double>(1, 2, 3, 4)));
+        REQUIRE(std::hash<esdm::Mat2<double>>()(esdm::Mat2<double>(1, 2, 3, 4)) != std::hash<esdm::Mat2<double>>()(esdm::Mat2<double>(1, 2, 4, 3)));
+
+        // Neighbouring voxels should spread over the low bits
+        std::unordered_map<std::size_t, int> low;
+        for (int z = 0; z < 16; z++)
+            for (int y = 0; y < 16; y++)
+                for (int x = 0; x < 16; x++) low[h3({ x, y, z }) & 4095]++;
+        REQUIRE(low.size() > 2500);
+
+        std::unordered_map<esdm::Vec2<int>, int> tiles;
+        tiles[{ 3, -4 }] = 7;
+        REQUIRE(tiles.at({ 3, -4 }) == 7);
+    }
+
+    SECTION("flat hash map") {
+        esdm::FlatHashMap<esdm::Vec3<int>, int> map;
+        std::unordered_map<esdm::Vec3<int>, int> expected;
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<int> coord(-8, 8);
+        for (int op = 0; op < 20000; op++) {
+            esdm::Vec3<int> key(coord(rng), coord(rng), coord(rng));
+            if (op % 3 == 2) {
+                REQUIRE(map.erase(key) == (expected.erase(key) == 1));
+            } else {
+                auto [value, inserted] = map.insert(key, op);
+                REQUIRE(inserted == expected.insert({ key, op }).second);
+                REQUIRE(*value == expected[key]);
+            }
+        }
+        REQUIRE(map.size() == expected.size());
+        for (const auto& [key, value] : expected) {
+            REQUIRE(map.find(key));
+            REQUIRE(*map.find(key) == value);
+        }
+
+        std::size_t visited = 0;
+        map.forEach([&](const esdm::Vec3<int>& key, int& value) {
+            REQUIRE(expected.at(key) == value);
+            value = -1;
+            visited++;
+        });
+        REQUIRE(visited == expected.size());
+        REQUIRE(map[expected.begin()->first] == -1);
+        REQUIRE(map[esdm::Vec3<int>(100, 100, 100)] == 0);
+        REQUIRE(map.size() == expected.size() + 1);
+
+        map.clear();
+        REQUIRE(map.empty());
+        REQUIRE(!map.contains(expected.begin()->first));
+    }
+}
+
+TEST_CASE("polynomial evaluation", "[poly]") {
+    auto direct = [](std::span<const double> c, double x) {
+        double out = 0;
+        for (std::size_t i = 0; i < c.size(); i++) out += c[i] * std::pow(x, (double)i);
+        return out;
+    };
+
+    SECTION("scalar") {
+        STATIC_REQUIRE(esdm::polyval<1.0, 2.0, 3.0>(2.0) == 17.0);
+        STATIC_REQUIRE(esdm::polyval<>(2.0) == 0.0);
+        STATIC_REQUIRE(esdm::polyval(std::array<double, 3>{ 1, 2, 3 }, 2.0) == 17.0);
+
+        // Horner and Estrin degrees, odd and even coefficient counts
+        const std::array<double, 4> c4 = { 0.5, -1.25, 2, 0.75 };
+        const std::array<double, 8> c8 = { 1, -0.5, 0.25, 2, -1, 0.125, 0.5, -0.75 };
+        const std::array<double, 9> c9 = { 1, -0.5, 0.25, 2, -1, 0.125, 0.5, -0.75, 0.3 };
+        for (double x = -2; x <= 2; x += 0.25) {
+            REQUIRE(esdm::polyval(c4, x) == Approx(direct(c4, x)));
+            REQUIRE(esdm::polyval(c8, x) == Approx(direct(c8, x)));
+            REQUIRE(esdm::polyval(c9, x) == Approx(direct(c9, x)));
+            REQUIRE(esdm::polyval(std::span<const double>(c9), x) == Approx(direct(c9, x)));
+            REQUIRE(esdm::polyval<1.0, -0.5, 0.25, 2.0, -1.0, 0.125, 0.5, -0.75, 0.3>(x) == Approx(direct(c9, x)));
+        }
+    }
+
+    SECTION("vector and batch") {
+        const std::array<float, 6> c = { 1, 1, 0.5f, 1 / 6.f, 1 / 24.f, 1 / 120.f };
+        const esdm::Vec3<float> v(-1, 0.5f, 2);
+        const esdm::Vec3<float> pv = esdm::polyval(c, v);
+        for (std::size_t i = 0; i < 3; i++) REQUIRE(pv[i] == Approx(esdm::polyval(c, v[i])));
+        REQUIRE(esdm::polyval<1.f, 2.f>(v) == esdm::Vec3<float>(-1, 2, 5));
+
+        std::vector<float> xs(40000);
+        for (std::size_t i = 0; i < xs.size(); i++) xs[i] = (float)i / xs.size() * 4 - 2;
+        std::vector<float> ys(xs.size());
+        esdm::polyval(c, std::span<const float>(xs), std::span<float>(ys));
+        for (std::size_t i = 0; i < xs.size(); i += 97) REQUIRE(ys[i] == esdm::polyval(c, xs[i]));
+        esdm::polyval<1.f, 2.f>(std::span<const float>(xs), std::span<float>(ys));
+        for (std::size_t i = 0; i < xs.size(); i += 97) REQUIRE(ys[i] == 1 + 2 * xs[i]);
+
+        std::vector<esdm::Vec3<float>> aos(1000);
+        for (std::size_t i = 0; i < aos.size(); i++) aos[i] = { xs[i], xs[i + 1], xs[i + 2] };
+        esdm::VecSoA<3, float> soa{ std::span<const esdm::Vec3<float>>(aos) };
+        esdm::polyval(c, soa.view(), soa.view());
+        esdm::polyval(c, std::span<const esdm::Vec3<float>>(aos), std::span<esdm::Vec3<float>>(aos));
+        for (std::size_t i = 0; i < aos.size(); i++) REQUIRE(soa.get(i) == aos[i]);
+        esdm::polyval<0.f, 3.f>(soa.view(), soa.view());
+        REQUIRE(soa.get(10) == aos[10] * 3.f);
+    }
+}
+
+TEST_CASE("splines", "[spline]") {
+    using V3 = esdm::Vec3<float>;
+    auto near = [](const V3& a, const V3& b, float eps = 1e-5f) {
+        return esdm::length(a - b) <= eps;
+    };
+
+    SECTION("construction") {
+        const std::vector<V3> points = { { 0, 0, 0 }, { 1, 2, 0 }, { 3, 1, 1 }, { 4, -1, 2 } };
+        const esdm::CubicSpline<3, float> cr = esdm::CubicSpline<3, float>::catmullRom(points);
+        REQUIRE(cr.segmentCount() == 3);
+        for (std::size_t i = 0; i < points.size(); i++) REQUIRE(near(cr.evaluate((float)i), points[i]));
+        REQUIRE(near(cr.derivative(1), (points[2] - points[0]) * 0.5f));
+        REQUIRE(near(cr.evaluate(-5), points[0]));
+        REQUIRE(near(cr.evaluate(10), points[3]));
+
+        const std::vector<V3> tangents = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 }, { 1, 1, 1 } };
+        const esdm::CubicSpline<3, float> h = esdm::CubicSpline<3, float>::hermite(points, tangents);
+        for (std::size_t i = 0; i < points.size(); i++) {
+            REQUIRE(near(h.evaluate((float)i), points[i]));
+            REQUIRE(near(h.derivative((float)i), tangents[i]));
+        }
+
+        // De Casteljau at u = 0.5
+        const std::vector<V3> controls = { { 0, 0, 0 }, { 1, 2, 0 }, { 3, 2, 0 }, { 4, 0, 0 } };
+        const esdm::CubicSpline<3, float> b = esdm::CubicSpline<3, float>::bezier(controls);
+        REQUIRE(near(b.evaluate(0.5f), (controls[0] + controls[1] * 3.f + controls[2] * 3.f + controls[3]) / 8.f));
+        REQUIRE(near(b.derivative(0), (controls[1] - controls[0]) * 3.f));
+    }
+
+    SECTION("fewer than two points") {
+        const std::vector<float> t = { -1.f, 0.f, 0.5f, 2.f };
+        std::vector<V3> aos(t.size());
+        esdm::VecSoA<3, float> soa(t.size());
+
+        const esdm::CubicSpline<3, float> empty = esdm::CubicSpline<3, float>::catmullRom(std::vector<V3>());
+        REQUIRE(empty.segmentCount() == 0);
+        REQUIRE(empty.evaluate(0.5f) == V3());
+        REQUIRE(empty.derivative(0.5f) == V3());
+        empty.evaluate(t, std::span<V3>(aos));
+        empty.evaluate(t, soa.view());
+        for (std::size_t i = 0; i < t.size(); i++) {
+            REQUIRE(aos[i] == V3());
+            REQUIRE(soa.get(i) == V3());
+        }
+
+        const std::vector<V3> point = { { 1, 2, 3 } };
+        const esdm::CubicSpline<3, float> single = esdm::CubicSpline<3, float>::catmullRom(point);
+        REQUIRE(single.segmentCount() == 1);
+        REQUIRE(single.derivative(0.5f) == V3());
+        single.evaluate(t, soa.view());
+        for (std::size_t i = 0; i < t.size(); i++) REQUIRE(soa.get(i) == point[0]);
+
+        esdm::CubicSpline<3, float> none = esdm::CubicSpline<3, float>::bezier(point);
+        REQUIRE(none.segmentCount() == 0);
+        none.buildArcLength();
+        REQUIRE(none.arcLength() == 0.f);
+        REQUIRE(none.paramAtDistance(1.f) == 0.f);
+    }
+
+    SECTION("batch evaluation") {
+        std::vector<V3> points(50);
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> coord(-5, 5);
+        for (V3& p : points) p = { coord(rng), coord(rng), coord(rng) };
+        const esdm::CubicSpline<3, float> cr = esdm::CubicSpline<3, float>::catmullRom(points);
+
+        std::vector<float> t(100000);
+        for (std::size_t i = 0; i < t.size(); i++) t[i] = -1 + 51.f * i / t.size();
+        std::vector<V3> aos(t.size());
+        esdm::VecSoA<3, float> soa(t.size());
+        cr.evaluate(t, std::span<V3>(aos));
+        cr.evaluate(t, soa.view());
+        for (std::size_t i = 0; i < t.size(); i++) {
+            REQUIRE(aos[i] == cr.evaluate(t[i]));
+            REQUIRE(soa.get(i) == aos[i]);
+        }
+
+        // Unsorted parameters give the same results
+        std::shuffle(t.begin(), t.end(), rng);
+        cr.evaluate(t, soa.view());
+        for (std::size_t i = 0; i < t.size(); i += 7) REQUIRE(soa.get(i) == cr.evaluate(t[i]));
+    }
+
+    SECTION("arc length") {
+        // Straight line with uneven speed
+        const std::vector<V3> points = { { 0, 0, 0 }, { 10, 0, 0 } };
+        const std::vector<V3> tangents = { { 1, 0, 0 }, { 25, 0, 0 } };
+        esdm::CubicSpline<3, float> line = esdm::CubicSpline<3, float>::hermite(points, tangents);
+        line.buildArcLength(64);
+        REQUIRE(line.arcLength() == Approx(10));
+
+        std::vector<float> d(101);
+        for (std::size_t i = 0; i < d.size(); i++) d[i] = 0.1f * i;
+        std::vector<float> t(d.size());
+        line.paramAtDistance(d, t);
+        for (std::size_t i = 0; i < d.size(); i++) {
+            REQUIRE(t[i] == line.paramAtDistance(d[i]));
+            REQUIRE(line.evaluate(t[i])[0] == Approx(d[i]).margin(0.02));
+        }
+        REQUIRE(line.paramAtDistance(-1) == 0);
+        REQUIRE(line.paramAtDistance(20) == 1);
+
+        // Quarter circle approximated by a Bezier segment
+        const float k = 0.5522847f;
+        const std::vector<V3> arc = { { 1, 0, 0 }, { 1, k, 0 }, { k, 1, 0 }, { 0, 1, 0 } };
+        esdm::CubicSpline<3, float> quarter = esdm::CubicSpline<3, float>::bezier(arc);
+        quarter.buildArcLength();
+        REQUIRE(quarter.arcLength() == Approx(esdm::pi<float>() / 2).epsilon(1e-3));
+    }
+}
+
+TEST_CASE("noise", "[noise]") {
+    const esdm::NoiseTable table(1234);
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> coord(-50, 50);
+
+    auto check = [&]<std::size_t L>(std::integral_constant<std::size_t, L>) {
+        std::vector<esdm::Vec<L, float>> points(3001);
+        for (auto& p : points)
+            for (std::size_t i = 0; i < L; i++) p[i] = coord(rng);
+        esdm::VecSoA<L, float> soa{ std::span<const esdm::Vec<L, float>>(points) };
+        std::vector<float> out(points.size());
+        std::vector<float> out16(points.size());
+        std::vector<float> outAoS(points.size());
+
+        auto same = [&]<esdm::NoiseKind K>(std::integral_constant<esdm::NoiseKind, K>) {
+            esdm::noise<K>(table, soa.view(), std::span<float>(out));
+            esdm::noise<K, 16>(table, soa.view(), std::span<float>(out16));
+            esdm::noise<K>(table, std::span<const esdm::Vec<L, float>>(points), std::span<float>(outAoS));
+            // Equal up to how the compiler contracts multiply-adds in each path
+            for (std::size_t j = 0; j < points.size(); j++) {
+                const float n = esdm::noise<K>(table, points[j]);
+                REQUIRE(out[j] == Approx(n).margin(1e-4));
+                REQUIRE(out16[j] == Approx(n).margin(1e-4));
+                REQUIRE(outAoS[j] == Approx(n).margin(1e-4));
+                REQUIRE(std::abs(n) <= 1.05f);
+            }
+
+            esdm::fbm<K, 16>(table, soa.view(), std::span<float>(out), 4, 2.f, 0.5f);
+            for (std::size_t j = 0; j < points.size(); j += 13) REQUIRE(out[j] == Approx(esdm::fbm<K>(table, points[j], 4, 2.f, 0.5f)).margin(1e-4));
+
+            // Continuous
+            esdm::Vec<L, float> p = points[0];
+            const float a = esdm::noise<K>(table, p);
+            p[0] += 1e-3f;
+            REQUIRE(std::abs(esdm::noise<K>(table, p) - a) < 0.02f);
+        };
+        same(std::integral_constant<esdm::NoiseKind, esdm::NoiseKind::Perlin>());
+        same(std::integral_constant<esdm::NoiseKind, esdm::NoiseKind::Simplex>());
+        same(std::integral_constant<esdm::NoiseKind, esdm::NoiseKind::Value>());
+
+        // Gradient noise vanishes at lattice points
+        esdm::Vec<L, float> lattice;
+        for (std::size_t i = 0; i < L; i++) lattice[i] = float(i * 3 + 1);
+        REQUIRE(esdm::perlin(table, lattice) == 0);
+    };
+    check(std::integral_constant<std::size_t, 2>());
+    check(std::integral_constant<std::size_t, 3>());
+    check(std::integral_constant<std::size_t, 4>());
+
+    // Not constant and seed dependent
+    const esdm::NoiseTable other(99);
+    int differs = 0;
+    float lo = 1, hi = -1;
+    for (int i = 0; i < 1000; i++) {
+        const esdm::Vec3<float> p(coord(rng), coord(rng), coord(rng));
+        const float n = esdm::simplex(table, p);
+        differs += n != esdm::simplex(other, p);
+        lo = std::min(lo, n);
+        hi = std::max(hi, n);
+    }
+    REQUIRE(differs > 990);
+    REQUIRE(lo < -0.5f);
+    REQUIRE(hi > 0.5f);
+    REQUIRE(esdm::valueNoise(table, esdm::Vec2<float>(0.5f, 0.25f)) == esdm::valueNoise(esdm::NoiseTable(1234), esdm::Vec2<float>(0.5f, 0.25f)));
+}
+
+TEST_CASE("random numbers", "[random]") {
+    SECTION("philox") {
+        // Known answers from the Random123 distribution
+        const esdm::Philox zero(0);
+        REQUIRE(zero(0, 0) == esdm::Philox::Block{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 });
+        const esdm::Philox ones(~std::uint64_t(0));
+        REQUIRE(ones(~std::uint64_t(0), ~std::uint64_t(0)) == esdm::Philox::Block{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd });
+        const esdm::Philox pi(0x299f31d0a4093822);
+        REQUIRE(pi(0x85a308d3243f6a88, 0x0370734413198a2e) == esdm::Philox::Block{ 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 });
+
+        REQUIRE(zero(1) != zero(0));
+        REQUIRE(zero(0, 1) != zero(0));
+    }
+
+    SECTION("distributions") {
+        const esdm::Philox rng(7);
+        const std::size_t n = 20000;
+
+        esdm::Vec3<double> uniformSum, normalSum, normalSquares;
+        double hemisphereZ = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            const esdm::Vec3<float> u = esdm::sample(rng, esdm::Uniform<3, float>{ -2.f, 4.f }, i);
+            const esdm::Vec3<float> g = esdm::sample(rng, esdm::Normal<3, float>{ 1.f, 2.f }, i);
+            for (std::size_t c = 0; c < 3; c++) {
+                REQUIRE(u[c] >= -2.f);
+                REQUIRE(u[c] < 4.f);
+                uniformSum[c] += u[c];
+                normalSum[c] += g[c];
+                normalSquares[c] += (g[c] - 1.) * (g[c] - 1.);
+            }
+
+            REQUIRE(esdm::length(esdm::sample(rng, esdm::UnitSphere<float>(), i)) == Approx(1.f).margin(1e-5));
+            const esdm::Vec3<float> h = esdm::sample(rng, esdm::CosineHemisphere<float>(), i);
+            REQUIRE(esdm::length(h) == Approx(1.f).margin(1e-5));
+            REQUIRE(h[2] >= 0.f);
+            hemisphereZ += h[2];
+            REQUIRE(esdm::length(esdm::sample(rng, esdm::UnitDisk<float>(), i)) <= 1.f);
+        }
+        for (std::size_t c = 0; c < 3; c++) {
+            REQUIRE(uniformSum[c] / n == Approx(1.).margin(0.05));
+            REQUIRE(normalSum[c] / n == Approx(1.).margin(0.05));
+            REQUIRE(normalSquares[c] / n == Approx(4.).margin(0.15));
+        }
+        // E[cos] under a cosine weighted density is 2/3
+        REQUIRE(hemisphereZ / n == Approx(2. / 3.).margin(0.01));
+    }
+
+    SECTION("batch") {
+        const esdm::Philox rng(3);
+        const std::size_t n = 50001;
+        const esdm::UnitSphere<float> sphere;
+
+        esdm::ThreadPool single(1);
+        esdm::ThreadPool pool(4);
+        std::vector<esdm::Vec3<float>> a(n), b(n);
+        esdm::generate(single, rng, sphere, std::span<esdm::Vec3<float>>(a), 100, 5);
+        esdm::generate(pool, rng, sphere, std::span<esdm::Vec3<float>>(b), 100, 5);
+        for (std::size_t i = 0; i < n; i++) REQUIRE(a[i] == b[i]);
+        for (std::size_t i = 0; i < n; i += 97) REQUIRE(a[i] == esdm::sample(rng, sphere, 100 + i, 5));
+
+        // A later range continues the same sequence
+        std::vector<esdm::Vec3<float>> tail(n - 1000);
+        esdm::generate(pool, rng, sphere, std::span<esdm::Vec3<float>>(tail), 1100, 5);
+        for (std::size_t i = 0; i < tail.size(); i += 31) REQUIRE(tail[i] == a[1000 + i]);
+
+        esdm::VecSoA<2, double> soa;
+        soa.resize(n);
+        const esdm::Normal<2, double> normal;
+        esdm::generate(pool, rng, normal, soa.view());
+        for (std::size_t i = 0; i < n; i += 89) REQUIRE(soa.get(i) == esdm::sample(rng, normal, i));
+    }
+}
+
+
+TEST_CASE("3x3 decompositions", "[decomp]") {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> coord(-2.f, 2.f);
+    std::vector<esdm::Mat3<float>> mats(203);
+    for (std::size_t n = 0; n < mats.size(); n++) {
+        for (std::size_t i = 0; i < 3; i++)
+            for (std::size_t j = 0; j < 3; j++) mats[n][i][j] = coord(rng);
+        // Rank deficient
+        if (n % 5 == 0) mats[n][2] = mats[n][0] * 3.f;
+    }
+    mats[0] = esdm::Mat3<float>::ident();
+    mats[1] = esdm::Mat3<float>();
+    mats[2] = esdm::Mat3<float>(2.f, 0.f, 0.f, 0.f, -1.f, 0.f, 0.f, 0.f, 3.f);
+
+    const auto diag = [](const esdm::Vec3<float>& d) {
+        esdm::Mat3<float> m;
+        for (std::size_t i = 0; i < 3; i++) m[i][i] = d[i];
+        return m;
+    };
+    const auto near = [](const esdm::Mat3<float>& a, const esdm::Mat3<float>& b, float margin) {
+        for (std::size_t i = 0; i < 3; i++)
+            for (std::size_t j = 0; j < 3; j++) REQUIRE(a[i][j] == Approx(b[i][j]).margin(margin));
+    };
+    const auto rotation = [&](const esdm::Mat3<float>& r) {
+        near(esdm::transpose(r) * r, esdm::Mat3<float>::ident(), 1e-5f);
+        REQUIRE(esdm::dot(esdm::cross(r.getCol(0), r.getCol(1)), r.getCol(2)) == Approx(1.f).margin(1e-5));
+    };
+
+    SECTION("single") {
+        for (const esdm::Mat3<float>& a : mats) {
+            const esdm::Svd3<float> s = esdm::svd(a);
+            rotation(s.u);
+            rotation(s.v);
+            near(s.u * diag(s.sigma) * esdm::transpose(s.v), a, 1e-4f);
+            REQUIRE(s.sigma[0] >= std::abs(s.sigma[1]));
+            REQUIRE(s.sigma[1] >= std::abs(s.sigma[2]));
+
+            const esdm::Mat3<float> sym = esdm::transpose(a) * a;
+            const esdm::SymmetricEigen3<float> e = esdm::symmetricEigen(sym);
+            rotation(e.vectors);
+            near(e.vectors * diag(e.values) * esdm::transpose(e.vectors), sym, 1e-4f);
+            REQUIRE(e.values[0] >= e.values[1]);
+            REQUIRE(e.values[1] >= e.values[2]);
+            for (std::size_t i = 0; i < 3; i++) REQUIRE(e.values[i] == Approx(s.sigma[i] * s.sigma[i]).margin(1e-4));
+
+            const esdm::Polar3<float> p = esdm::polar(a);
+            rotation(p.rotation);
+            near(p.stretch, esdm::transpose(p.stretch), 1e-5f);
+            near(p.rotation * p.stretch, a, 1e-4f);
+        }
+
+        // Negative determinant leaves the sign on the smallest singular value
+        const esdm::Svd3<float> s = esdm::svd(mats[2]);
+        REQUIRE(s.sigma[0] == Approx(3.f));
+        REQUIRE(s.sigma[1] == Approx(2.f));
+        REQUIRE(s.sigma[2] == Approx(-1.f));
+
+        // Rotations come back unchanged
+        const esdm::Mat3<float> r = esdm::Mat3<float>(esdm::matrot(esdm::normalize(esdm::Vec3<float>(1.f, 2.f, 3.f)), 0.7f));
+        near(esdm::polar(r).rotation, r, 1e-5f);
+        near(esdm::polar(r * esdm::Mat3<float>::ident(2.f)).stretch, esdm::Mat3<float>::ident(2.f), 1e-5f);
+    }
+
+    SECTION("batch") {
+        std::vector<esdm::Svd3<float>> svds(mats.size());
+        esdm::svd(std::span<const esdm::Mat3<float>>(mats), std::span<esdm::Svd3<float>>(svds));
+        std::vector<esdm::Polar3<float>> polars(mats.size());
+        esdm::polar<16>(std::span<const esdm::Mat3<float>>(mats), std::span<esdm::Polar3<float>>(polars));
+        std::vector<esdm::Mat3<float>> syms(mats.size());
+        for (std::size_t n = 0; n < mats.size(); n++) syms[n] = esdm::transpose(mats[n]) * mats[n];
+        std::vector<esdm::SymmetricEigen3<float>> eigens(mats.size());
+        esdm::symmetricEigen(std::span<const esdm::Mat3<float>>(syms), std::span<esdm::SymmetricEigen3<float>>(eigens));
+
+        for (std::size_t n = 0; n < mats.size(); n++) {
+            const esdm::Svd3<float> s = esdm::svd(mats[n]);
+            for (std::size_t i = 0; i < 3; i++) REQUIRE(svds[n].sigma[i] == Approx(s.sigma[i]).margin(1e-5));
+            near(svds[n].u * diag(svds[n].sigma) * esdm::transpose(svds[n].v), mats[n], 1e-4f);
+            near(polars[n].rotation, esdm::polar(mats[n]).rotation, 1e-4f);
+            const esdm::SymmetricEigen3<float> e = esdm::symmetricEigen(syms[n]);
+            for (std::size_t i = 0; i < 3; i++) REQUIRE(eigens[n].values[i] == Approx(e.values[i]).margin(1e-4));
+        }
+    }
+}
+
+
+TEST_CASE("linear solvers", "[solve]") {
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<double> coord(-1., 1.);
+
+    const auto check = [&](auto size) {
+        constexpr std::size_t N = decltype(size)::value;
+        using M = esdm::Mat<N, N, double>;
+        using V = esdm::Vec<N, double>;
+
+        const auto random = [&] {
+            M a;
+            for (std::size_t i = 0; i < N; i++)
+                for (std::size_t j = 0; j < N; j++) a[i][j] = coord(rng);
+            return a;
+        };
+        const auto near = [](const V& a, const V& b, double margin) {
+            for (std::size_t i = 0; i < N; i++) REQUIRE(a[i] == Approx(b[i]).margin(margin));
+        };
+        // Backward error, a x - b against the size of x
+        const auto residual = [&](const M& a, const V& x, const V& b) {
+            double size = 1;
+            for (std::size_t i = 0; i < N; i++) size = std::max(size, std::abs(x[i]));
+            near(a * x, b, 1e-13 * size);
+        };
+        // P A = L U
+        const auto factors = [](const M& a, const esdm::LU<N, double>& f) {
+            for (std::size_t i = 0; i < N; i++)
+                for (std::size_t j = 0; j < N; j++) {
+                    double sum = 0;
+                    for (std::size_t k = 0; k <= std::min(i, j); k++) sum += (k == i ? 1. : f.lu[i][k]) * f.lu[k][j];
+                    REQUIRE(sum == Approx(a[f.perm[i]][j]).margin(1e-12));
+                }
+        };
+
+        for (int t = 0; t < 20; t++) {
+            // Diagonally dominant so the tolerances hold
+            M a = random();
+            for (std::size_t i = 0; i < N; i++) a[i][i] += double(N);
+            V x;
+            for (std::size_t i = 0; i < N; i++) x[i] = coord(rng);
+            const V b = a * x;
+
+            const esdm::LU<N, double> f = esdm::lu(a);
+            REQUIRE(!f.singular);
+            near(esdm::solve(f, b), x, 1e-9);
+            near(esdm::solve(a, b), x, 1e-9);
+            factors(a, f);
+
+            const esdm::QR<N, double> q = esdm::qr(a);
+            near(esdm::solve(q, b), x, 1e-9);
+            const M qtq = esdm::transpose(q.q) * q.q;
+            const M qr = q.q * q.r;
+            for (std::size_t i = 0; i < N; i++)
+                for (std::size_t j = 0; j < N; j++) {
+                    REQUIRE(qtq[i][j] == Approx(i == j ? 1. : 0.).margin(1e-12));
+                    REQUIRE(qr[i][j] == Approx(a[i][j]).margin(1e-12));
+                    if (i > j) REQUIRE(q.r[i][j] == 0.);
+                }
+
+            // Symmetric positive definite
+            const M spd = esdm::transpose(a) * a;
+            const V c = spd * x;
+            const esdm::Cholesky<N, double> ch = esdm::cholesky(spd);
+            REQUIRE(ch.positive);
+            near(esdm::solve(ch, c), x, 1e-8);
+            near(esdm::solveCholesky(spd, c), x, 1e-8);
+        }
+
+        // Plain random matrices need row swaps, half of them or more from the first column
+        int swapped = 0;
+        for (int t = 0; t < 50; t++) {
+            const M a = random();
+            V b;
+            for (std::size_t i = 0; i < N; i++) b[i] = coord(rng);
+
+            const esdm::LU<N, double> f = esdm::lu(a);
+            REQUIRE(!f.singular);
+            factors(a, f);
+            for (std::size_t i = 0; i < N; i++) {
+                if (f.perm[i] != i) {
+                    swapped++;
+                    break;
+                }
+            }
+            residual(a, esdm::solve(f, b), b);
+            residual(a, esdm::solve(a, b), b);
+            residual(a, esdm::solve(esdm::qr(a), b), b);
+        }
+        REQUIRE((swapped > 10) == (N > 1));
+
+        // Singular and indefinite
+        M s = random();
+        s[N - 1] = s[0];
+        REQUIRE(esdm::lu(s).singular == (N > 1));
+        REQUIRE(!esdm::cholesky(M::ident(-1.)).positive);
+
+        // Batches, with a partial last block and enough systems to thread
+        const std::size_t count = 5003;
+        std::vector<M> as(count);
+        std::vector<V> xs(count), bs(count), out(count);
+        for (std::size_t n = 0; n < count; n++) {
+            as[n] = random();
+            // Every third system is left without dominance so lanes pivot differently
+            if (n % 3 != 1)
+                for (std::size_t i = 0; i < N; i++) as[n][i][i] += double(N);
+            if (n % 3 == 0) as[n] = esdm::transpose(as[n]) * as[n];
+            for (std::size_t i = 0; i < N; i++) xs[n][i] = coord(rng);
+            bs[n] = as[n] * xs[n];
+        }
+        esdm::solve(std::span<const M>(as), std::span<const V>(bs), std::span<V>(out));
+        for (std::size_t n = 0; n < count; n++) REQUIRE(out[n] == esdm::solve(as[n], bs[n]));
+
+        esdm::VecSoA<N, double> soaB{ std::span<const V>(bs) };
+        esdm::VecSoA<N, double> soaX;
+        soaX.resize(count);
+        esdm::solve<4>(std::span<const M>(as), soaB.view(), soaX.view());
+        for (std::size_t n = 0; n < count; n += 7) {
+            REQUIRE(soaX.get(n) == out[n]);
+            residual(as[n], soaX.get(n), bs[n]);
+        }
+
+        std::vector<M> spds;
+        std::vector<V> spdB;
+        for (std::size_t n = 0; n < count; n += 3) {
+            spds.push_back(as[n]);
+            spdB.push_back(bs[n]);
+        }
+        std::vector<V> spdX(spds.size());
+        esdm::solveCholesky(std::span<const M>(spds), std::span<const V>(spdB), std::span<V>(spdX));
+        for (std::size_t n = 0; n < spds.size(); n++) near(spdX[n], xs[n * 3], 1e-8);
+    };
+    check(std::integral_constant<std::size_t, 1>());
+    check(std::integral_constant<std::size_t, 2>());
+    check(std::integral_constant<std::size_t, 3>());
+    check(std::integral_constant<std::size_t, 4>());
+    check(std::integral_constant<std::size_t, 6>());
+
+    // A zero leading pivot forces a row swap
+    const esdm::Mat3<double> a(0., 1., 2., 1., 0., 3., 4., -3., 8.);
+    const esdm::Vec3<double> x(1., -2., 3.);
+    const esdm::Vec3<double> b = a * x;
+    const esdm::LU<3, double> f = esdm::lu(a);
+    REQUIRE(!f.singular);
+    REQUIRE(f.perm[0] == 2);
+    REQUIRE(esdm::det(a) == Approx(-2.));
+    for (std::size_t i = 0; i < 3; i++) {
+        REQUIRE(esdm::solve(f, b)[i] == Approx(x[i]).margin(1e-12));
+        REQUIRE(esdm::solve(a, b)[i] == Approx(x[i]).margin(1e-12));
+    }
+    const std::vector<esdm::Mat3<double>> as(11, a);
+    const std::vector<esdm::Vec3<double>> bs(11, b);
+    std::vector<esdm::Vec3<double>> out(11);
+    esdm::solve<4>(std::span<const esdm::Mat3<double>>(as), std::span<const esdm::Vec3<double>>(bs),
+        std::span<esdm::Vec3<double>>(out));
+    for (const esdm::Vec3<double>& v : out) REQUIRE(v == esdm::solve(a, b));
+}
+
+
+TEST_CASE("determinant and inverse", "[matrix][det]") {
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<double> coord(-1., 1.);
+
+    REQUIRE(esdm::det(esdm::Mat2<int>(1, 2, 3, 4)) == -2);
+    REQUIRE(esdm::det(esdm::Mat3<int>(2, 0, 0, 0, 3, 0, 0, 0, 4)) == 24);
+    REQUIRE(esdm::det(esdm::Mat4<int>(esdm::Mat4<int>::ident(2))) == 16);
+    REQUIRE(esdm::adjugate(esdm::Mat2<int>(1, 2, 3, 4)) == esdm::Mat2<int>(4, -2, -3, 1));
+    static_assert(esdm::det(esdm::Mat3<int>(1, 2, 3, 4, 5, 6, 7, 8, 10)) == -3);
+
+    // Mirrored transforms have negative determinants
+    REQUIRE(esdm::det(esdm::mattrans(esdm::Vec3<float>(1.f, 2.f, 3.f))) == 1.f);
+    REQUIRE(esdm::det(esdm::Mat3<float>(-1.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f)) == -1.f);
+
+    const auto check = [&](auto size) {
+        constexpr std::size_t N = decltype(size)::value;
+        using M = esdm::Mat<N, N, double>;
+
+        for (int t = 0; t < 20; t++) {
+            M a;
+            for (std::size_t i = 0; i < N; i++)
+                for (std::size_t j = 0; j < N; j++) a[i][j] = coord(rng);
+            for (std::size_t i = 0; i < N; i++) a[i][i] += 2.;
+
+            const double d = esdm::det(a);
+            REQUIRE(d == Approx(esdm::detail::detGauss(a)).epsilon(1e-12));
+            const M adj = esdm::adjugate(a) * a;
+            const M inv = esdm::inverse(a) * a;
+            for (std::size_t i = 0; i < N; i++)
+                for (std::size_t j = 0; j < N; j++) {
+                    REQUIRE(adj[i][j] == Approx(i == j ? d : 0.).margin(1e-10));
+                    REQUIRE(inv[i][j] == Approx(i == j ? 1. : 0.).margin(1e-12));
+                }
+
+            // The adjugate survives singular matrices
+            if constexpr (N > 1) {
+                a[N - 1] = a[0];
+                REQUIRE(esdm::det(a) == Approx(0.).margin(1e-12));
+                const M sing = esdm::adjugate(a) * a;
+                for (std::size_t i = 0; i < N; i++)
+                    for (std::size_t j = 0; j < N; j++) REQUIRE(sing[i][j] == Approx(0.).margin(1e-10));
+            }
+        }
+    };
+    check(std::integral_constant<std::size_t, 1>());
+    check(std::integral_constant<std::size_t, 2>());
+    check(std::integral_constant<std::size_t, 3>());
+    check(std::integral_constant<std::size_t, 4>());
+    check(std::integral_constant<std::size_t, 5>());
+    check(std::integral_constant<std::size_t, 6>());
+
+    SECTION("batch") {
+        std::uniform_real_distribution<float> coordf(-1.f, 1.f);
+        std::vector<esdm::Mat4<float>> mats(1000);
+        for (esdm::Mat4<float>& m : mats) {
+            for (std::size_t i = 0; i < 4; i++)
+                for (std::size_t j = 0; j < 4; j++) m[i][j] = coordf(rng);
+            for (std::size_t i = 0; i < 4; i++) m[i][i] += 3.f;
+        }
+        esdm::VecSoA<16, float> soa;
+        soa.resize(mats.size());
+        for (std::size_t n = 0; n < mats.size(); n++)
+            for (std::size_t i = 0; i < 4; i++)
+                for (std::size_t j = 0; j < 4; j++) soa.component(i * 4 + j)[n] = mats[n][i][j];
+
+        std::vector<float> dets(mats.size()), soaDets(mats.size());
+        esdm::det(std::span<const esdm::Mat4<float>>(mats), std::span<float>(dets));
+        esdm::det<4>(soa.view(), std::span<float>(soaDets));
+        std::vector<esdm::Mat4<float>> invs(mats.size());
+        esdm::inverse(std::span<const esdm::Mat4<float>>(mats), std::span<esdm::Mat4<float>>(invs));
+        esdm::inverse<4>(soa.view(), soa.view());
+
+        for (std::size_t n = 0; n < mats.size(); n++) {
+            const float d = esdm::det(mats[n]);
+            REQUIRE(dets[n] == Approx(d).epsilon(1e-5));
+            REQUIRE(soaDets[n] == Approx(d).epsilon(1e-5));
+            const esdm::Mat4<float> inv = esdm::inverse(mats[n]);
+            for (std::size_t i = 0; i < 4; i++)
+                for (std::size_t j = 0; j < 4; j++) {
+                    REQUIRE(invs[n][i][j] == Approx(inv[i][j]).margin(1e-5));
+                    REQUIRE(soa.component(i * 4 + j)[n] == Approx(inv[i][j]).margin(1e-5));
+                }
+        }
+    }
+}
+
+
+TEST_CASE("matrix exponential and logarithm", "[matrix][matexp]") {
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<double> coord(-1., 1.);
+
+    const auto near = [](const auto& a, const auto& b, double margin) {
+        for (std::size_t i = 0; i < a.data.size(); i++)
+            for (std::size_t j = 0; j < a.data.size(); j++) REQUIRE(a[i][j] == Approx(b[i][j]).margin(margin));
+    };
+    const auto nearVec = [](const esdm::Vec3<double>& a, const esdm::Vec3<double>& b, double margin) {
+        for (std::size_t i = 0; i < 3; i++) REQUIRE(a[i] == Approx(b[i]).margin(margin));
+    };
+
+    SECTION("rotations") {
+        const esdm::Vec3<double> v(0.3, -1.2, 2.);
+        REQUIRE(esdm::skew(v) * esdm::Vec3<double>(1., 2., 3.) == esdm::cross(v, esdm::Vec3<double>(1., 2., 3.)));
+        REQUIRE(esdm::unskew(esdm::skew(v)) == v);
+
+        // Quarter turn about z takes x to y
+        nearVec(esdm::expRotation(esdm::Vec3<double>(0., 0., esdm::pi<double>() / 2)) * esdm::Vec3<double>(1., 0., 0.), { 0., 1., 0. }, 1e-15);
+        REQUIRE(esdm::expRotation(esdm::Vec3<double>()) == esdm::Mat3<double>::ident());
+
+        for (int t = 0; t < 200; t++) {
+            esdm::Vec3<double> w(coord(rng), coord(rng), coord(rng));
+            // Include tiny angles and angles up to and near pi
+            if (t % 4 == 0) w = w * 1e-9;
+            else w = esdm::normalize(w) * (t % 4 == 1 ? esdm::pi<double>() - 1e-7 : coord(rng) * 0.5 + 2.5);
+
+            const esdm::Mat3<double> r = esdm::expRotation(w);
+            near(esdm::transpose(r) * r, esdm::Mat3<double>::ident(), 1e-14);
+            REQUIRE(esdm::det(r) == Approx(1.));
+            nearVec(esdm::logRotation(r), w, 1e-7);
+            near(esdm::exp(esdm::skew(w)), r, 1e-13);
+            near(esdm::expSkew(esdm::logSkew(r)), r, 1e-13);
+        }
+
+        // Exactly a half turn
+        nearVec(esdm::abs(esdm::logRotation(esdm::Mat3<double>(-1., 0., 0., 0., -1., 0., 0., 0., 1.))), { 0., 0., esdm::pi<double>() }, 1e-15);
+
+        // Interpolation moves along the arc at constant speed
+        const esdm::Mat3<double> a = esdm::expRotation(esdm::Vec3<double>(0.2, 0.1, -0.4));
+        const esdm::Mat3<double> b = a * esdm::expRotation(esdm::Vec3<double>(0., 1.5, 0.));
+        near(esdm::slerp(a, b, 0.), a, 1e-15);
+        near(esdm::slerp(a, b, 1.), b, 1e-14);
+        near(esdm::slerp(a, b, 0.5), a * esdm::expRotation(esdm::Vec3<double>(0., 0.75, 0.)), 1e-14);
+    }
+
+    SECTION("general") {
+        REQUIRE(esdm::exp(esdm::Mat4<double>()) == esdm::Mat4<double>::ident());
+        const esdm::Mat2<double> d = esdm::exp(esdm::Mat2<double>(1., 0., 0., -2.));
+        REQUIRE(d[0][0] == Approx(std::exp(1.)));
+        REQUIRE(d[1][1] == Approx(std::exp(-2.)));
+
+        for (int t = 0; t < 50; t++) {
+            esdm::Mat4<double> a;
+            for (std::size_t i = 0; i < 4; i++)
+                for (std::size_t j = 0; j < 4; j++) a[i][j] = coord(rng) * (t % 2 ? 0.3 : 2.);
+            const esdm::Mat4<double> e = esdm::exp(a);
+            // exp(a) exp(-a) = I, log(exp(a)) = a while eigenvalues stay within the principal strip
+            near(e * esdm::exp(-a), esdm::Mat4<double>::ident(), 1e-10);
+            if (t % 2) near(esdm::log(e), a, 1e-10);
+        }
+
+        // Rigid transforms interpolate through the screw motion
+        const esdm::Mat4<double> a = esdm::mattrans(esdm::Vec3<double>(1., 2., 3.));
+        const esdm::Mat4<double> b = esdm::mattrans(esdm::Vec3<double>(3., 2., -1.));
+        near(esdm::interpolate(a, b, 0.25), esdm::mattrans(esdm::Vec3<double>(1.5, 2., 2.)), 1e-12);
+    }
+
+    SECTION("batch") {
+        std::vector<esdm::Vec3<double>> ws(2000);
+        for (esdm::Vec3<double>& w : ws) w = esdm::Vec3<double>(coord(rng), coord(rng), coord(rng)) * 2.;
+        std::vector<esdm::Mat3<double>> rs(ws.size());
+        std::vector<esdm::Vec3<double>> back(ws.size());
+        esdm::expRotation(std::span<const esdm::Vec3<double>>(ws), std::span<esdm::Mat3<double>>(rs));
+        esdm::logRotation(std::span<const esdm::Mat3<double>>(rs), std::span<esdm::Vec3<double>>(back));
+        std::vector<esdm::Mat3<double>> ks(ws.size()), es(ws.size()), ls(ws.size());
+        for (std::size_t i = 0; i < ws.size(); i++) ks[i] = esdm::skew(ws[i]) * 0.5;
+        esdm::exp(std::span<const esdm::Mat3<double>>(ks), std::span<esdm::Mat3<double>>(es));
+        esdm::log(std::span<const esdm::Mat3<double>>(es), std::span<esdm::Mat3<double>>(ls));
+        for (std::size_t i = 0; i < ws.size(); i += 7) {
+            REQUIRE(rs[i] == esdm::expRotation(ws[i]));
+            if (esdm::length(ws[i]) < esdm::pi<double>()) nearVec(back[i], ws[i], 1e-9);
+            near(ls[i], ks[i], 1e-10);
+        }
+    }
+}
+
+
+TEST_CASE("transform hierarchy", "[hierarchy]") {
+    std::mt19937 rng(41);
+    std::uniform_real_distribution<double> coord(-1., 1.);
+    esdm::ThreadPool pool(4);
+
+    const auto random = [&]() {
+        const esdm::Vec3<double> axis = esdm::normalize(esdm::Vec3<double>(coord(rng), coord(rng), coord(rng)));
+        return esdm::matrot(axis, coord(rng) * 3.) * esdm::mattrans(esdm::Vec3<double>(coord(rng), coord(rng), coord(rng)));
+    };
+
+    // Parents are added in random order through setParent, so the hierarchy
+    // must sort them itself
+    const std::size_t n = 20000;
+    esdm::Hierarchy<double> h;
+    std::vector<esdm::Mat4<double>> locals(n);
+    for (std::size_t i = 0; i < n; i++) {
+        locals[i] = random();
+        h.add(esdm::Hierarchy<double>::none, locals[i]);
+    }
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    std::shuffle(order.begin(), order.end(), rng);
+    for (std::size_t i = 1; i < n; i++) {
+        // Mostly deep chains with some wide levels
+        const std::size_t back = std::uniform_int_distribution<std::size_t>(1, i % 10 ? std::min<std::size_t>(i, 3) : i)(rng);
+        h.setParent(order[i], order[i - back]);
+    }
+
+    const auto check = [&]() {
+        std::vector<esdm::Mat4<double>> expect(n);
+        for (std::size_t i = 0; i < n; i++) {
+            const std::size_t node = order[i];
+            const std::size_t p = h.parent(node);
+            expect[node] = p == esdm::Hierarchy<double>::none ? locals[node] : locals[node] * expect[p];
+        }
+        for (std::size_t i = 0; i < n; i += 3) {
+            const esdm::Mat4<double> w = h.getWorld(i);
+            for (std::size_t r = 0; r < 4; r++)
+                for (std::size_t c = 0; c < 4; c++) REQUIRE(w[r][c] == Approx(expect[i][r][c]).margin(1e-9));
+        }
+    };
+
+    REQUIRE(h.update(pool) == n);
+    REQUIRE(h.levelCount() > 100);
+    check();
+    REQUIRE(h.update(pool) == 0);
+
+    // Only changed subtrees are recomputed
+    std::vector<std::size_t> subtree(n, 1);
+    for (std::size_t i = n; i-- > 1;) subtree[h.parent(order[i])] += subtree[order[i]];
+    const std::size_t node = order[n / 2];
+    locals[node] = random();
+    h.setLocal(node, locals[node]);
+    REQUIRE(h.update(pool) == subtree[node]);
+    check();
+
+    const esdm::Vec3<double> t(1., 2., 3.);
+    const esdm::Vec3<double> s(2., 0.5, 1.);
+    const esdm::Mat4<double> r = esdm::matrot(esdm::Vec3<double>(0., 0., 1.), 0.7);
+    esdm::Mat3<double> r3;
+    for (std::size_t i = 0; i < 3; i++)
+        for (std::size_t j = 0; j < 3; j++) r3[i][j] = r[i][j];
+    h.setLocal(order[0], t, r3, s);
+    esdm::Mat4<double> sm = esdm::Mat4<double>::ident();
+    for (std::size_t i = 0; i < 3; i++) sm[i][i] = s[i];
+    locals[order[0]] = sm * r * esdm::mattrans(t);
+    REQUIRE(h.update() == n);
+    check();
+
+    // Reparenting lays the nodes out again
+    h.setParent(order[n - 1], esdm::Hierarchy<double>::none);
+    h.update(pool);
+    check();
+}
+
+
+TEST_CASE("compressed encodings", "[codec]") {
+    std::mt19937 rng(42);
+    std::normal_distribution<float> gauss;
+
+    // Angle in degrees between two directions
+    const auto degrees = []<std::size_t L>(const esdm::Vec<L, float>& a, const esdm::Vec<L, float>& b) {
+        double dot = 0, la = 0, lb = 0;
+        for (std::size_t i = 0; i < L; i++) {
+            dot += (double)a[i] * b[i];
+            la += (double)a[i] * a[i];
+            lb += (double)b[i] * b[i];
+        }
+        return std::acos(std::min(std::abs(dot) / std::sqrt(la * lb), 1.)) * 180. / esdm::pi<double>();
+    };
+
+    SECTION("snorm and unorm") {
+        REQUIRE(esdm::packSnorm<std::int8_t>(1.f) == 127);
+        REQUIRE(esdm::packSnorm<std::int8_t>(-2.f) == -127);
+        REQUIRE(esdm::packSnorm<std::int8_t>(0.f) == 0);
+        REQUIRE(esdm::packSnorm<std::int16_t>(std::nanf("")) == -32767);
+        REQUIRE(esdm::unpackSnorm(std::int8_t(-128)) == -1.f);
+        REQUIRE(esdm::packUnorm<std::uint8_t>(0.5f) == 128);
+        REQUIRE(esdm::packUnorm<std::uint16_t>(3.f) == 65535);
+        REQUIRE(esdm::unpackUnorm<double>(std::uint8_t(255)) == 1.);
+
+        // Ends of the range at every width, the largest value of 32 and 64
+        // bit types is not exact in float or double
+        const auto bounds = []<typename T>(T) {
+            const auto snorm = []<typename I>(I) {
+                constexpr I hi = std::numeric_limits<I>::max();
+                REQUIRE(esdm::packSnorm<I>(T(1)) == hi);
+                REQUIRE(esdm::packSnorm<I>(T(-1)) == -hi);
+                REQUIRE(esdm::packSnorm<I>(T(0)) == 0);
+                REQUIRE(esdm::packSnorm<I>(T(2)) == hi);
+                REQUIRE(esdm::packSnorm<I>(T(-2)) == -hi);
+                REQUIRE(esdm::packSnorm<I>(T(0.5)) == I(hi / 2 + 1));
+                REQUIRE(esdm::unpackSnorm<T>(esdm::packSnorm<I>(T(1))) == T(1));
+                REQUIRE(esdm::unpackSnorm<T>(esdm::packSnorm<I>(T(-1))) == T(-1));
+            };
+            const auto unorm = []<typename I>(I) {
+                constexpr I hi = std::numeric_limits<I>::max();
+                REQUIRE(esdm::packUnorm<I>(T(1)) == hi);
+                REQUIRE(esdm::packUnorm<I>(T(0)) == 0);
+                REQUIRE(esdm::packUnorm<I>(T(-1)) == 0);
+                REQUIRE(esdm::packUnorm<I>(T(2)) == hi);
+                REQUIRE(esdm::unpackUnorm<T>(esdm::packUnorm<I>(T(1))) == T(1));
+            };
+            snorm(std::int8_t());
+            snorm(std::int16_t());
+            snorm(std::int32_t());
+            snorm(std::int64_t());
+            unorm(std::uint8_t());
+            unorm(std::uint16_t());
+            unorm(std::uint32_t());
+            unorm(std::uint64_t());
+        };
+        bounds(0.f);
+        bounds(0.);
+
+        const esdm::Vec3<std::int16_t> q = esdm::packSnorm<std::int16_t>(esdm::Vec3<float>(0.25f, -1.f, 0.f));
+        REQUIRE(q == esdm::Vec3<std::int16_t>(8192, -32767, 0));
+
+        std::uniform_real_distribution<float> unit(-1.2f, 1.2f);
+        std::vector<float> xs(5000);
+        for (float& x : xs) x = unit(rng);
+        std::vector<std::int8_t> s8(xs.size());
+        std::vector<std::uint16_t> u16(xs.size());
+        std::vector<float> back8(xs.size()), back16(xs.size());
+        esdm::packSnorm<std::int8_t>(std::span<const float>(xs), std::span<std::int8_t>(s8));
+        esdm::packUnorm<std::uint16_t>(std::span<const float>(xs), std::span<std::uint16_t>(u16));
+        esdm::unpackSnorm(std::span<const std::int8_t>(s8), std::span<float>(back8));
+        esdm::unpackUnorm(std::span<const std::uint16_t>(u16), std::span<float>(back16));
+        for (std::size_t i = 0; i < xs.size(); i++) {
+            REQUIRE(s8[i] == esdm::packSnorm<std::int8_t>(xs[i]));
+            REQUIRE(std::abs(back8[i] - std::clamp(xs[i], -1.f, 1.f)) <= 0.5f / 127.f + 1e-6f);
+            REQUIRE(std::abs(back16[i] - std::clamp(xs[i], 0.f, 1.f)) <= 0.5f / 65535.f + 1e-6f);
+        }
+
+        std::vector<esdm::Vec4<float>> vs(100);
+        for (esdm::Vec4<float>& v : vs) v = esdm::Vec4<float>(unit(rng), unit(rng), unit(rng), unit(rng));
+        std::vector<esdm::Vec4<std::uint8_t>> packed(vs.size());
+        std::vector<esdm::Vec4<float>> unpacked(vs.size());
+        esdm::packUnorm<std::uint8_t>(std::span<const esdm::Vec4<float>>(vs), std::span<esdm::Vec4<std::uint8_t>>(packed));
+        esdm::unpackUnorm(std::span<const esdm::Vec4<std::uint8_t>>(packed), std::span<esdm::Vec4<float>>(unpacked));
+        for (std::size_t i = 0; i < vs.size(); i++) {
+            REQUIRE(packed[i] == esdm::packUnorm<std::uint8_t>(vs[i]));
+            REQUIRE(unpacked[i] == esdm::unpackUnorm(packed[i]));
+        }
+    }
+
+    SECTION("octahedral") {
+        for (std::size_t axis = 0; axis < 3; axis++) {
+            for (float sign : { 1.f, -1.f }) {
+                esdm::Vec3<float> n;
+                n[axis] = sign;
+                REQUIRE(esdm::decodeOctahedral<16>(esdm::encodeOctahedral<16>(n)) == n);
+            }
+        }
+
+        const std::size_t count = 20000;
+        std::vector<esdm::Vec3<float>> ns(count);
+        for (esdm::Vec3<float>& n : ns) n = esdm::normalize(esdm::Vec3<float>(gauss(rng), gauss(rng), gauss(rng)));
+        const auto check = [&]<std::size_t Bits>(double bound) {
+            std::vector<std::uint32_t> codes(count);
+            std::vector<esdm::Vec3<float>> back(count);
+            esdm::encodeOctahedral<Bits>(std::span<const esdm::Vec3<float>>(ns), std::span<std::uint32_t>(codes));
+            esdm::decodeOctahedral<Bits>(std::span<const std::uint32_t>(codes), std::span<esdm::Vec3<float>>(back));
+            esdm::VecSoA<3, float> soa;
+            soa.resize(count);
+            esdm::decodeOctahedral<Bits>(std::span<const std::uint32_t>(codes), soa.view());
+            esdm::VecSoA<3, float> soaIn;
+            soaIn.resize(count);
+            for (std::size_t i = 0; i < count; i++)
+                for (std::size_t c = 0; c < 3; c++) soaIn.component(c)[i] = ns[i][c];
+            std::vector<std::uint32_t> soaCodes(count);
+            esdm::encodeOctahedral<Bits>(soaIn.view(), std::span<std::uint32_t>(soaCodes));
+            for (std::size_t i = 0; i < count; i++) {
+                REQUIRE(codes[i] == esdm::encodeOctahedral<Bits>(ns[i]));
+                REQUIRE(codes[i] < (std::uint64_t(1) << Bits));
+                REQUIRE(degrees(back[i], ns[i]) <= bound);
+                REQUIRE(esdm::length(back[i]) == Approx(1.f).margin(1e-6));
+                const esdm::Vec3<float> single = esdm::decodeOctahedral<Bits>(codes[i]);
+                for (std::size_t c = 0; c < 3; c++) {
+                    REQUIRE(back[i][c] == Approx(single[c]).margin(1e-6));
+                    REQUIRE(soa.component(c)[i] == back[i][c]);
+                }
+                REQUIRE(soaCodes[i] == codes[i]);
+            }
+        };
+        check.template operator()<16>(1.);
+        check.template operator()<24>(0.06);
+        check.template operator()<32>(0.004);
+    }
+
+    SECTION("smallest three") {
+        REQUIRE(esdm::decodeQuaternion<32>(esdm::encodeQuaternion<32>(esdm::Vec4<float>(0.f, 0.f, 0.f, 1.f))) == esdm::Vec4<float>(0.f, 0.f, 0.f, 1.f));
+        REQUIRE(esdm::decodeQuaternion<48>(esdm::encodeQuaternion<48>(esdm::Vec4<float>(0.f, -1.f, 0.f, 0.f))) == esdm::Vec4<float>(0.f, 1.f, 0.f, 0.f));
+
+        const std::size_t count = 20000;
+        std::vector<esdm::Vec4<float>> qs(count);
+        for (esdm::Vec4<float>& q : qs) q = esdm::normalize(esdm::Vec4<float>(gauss(rng), gauss(rng), gauss(rng), gauss(rng)));
+        const auto check = [&]<std::size_t Bits>(double bound) {
+            using Code = decltype(esdm::encodeQuaternion<Bits>(qs[0]));
+            static_assert(sizeof(Code) * 8 >= Bits);
+            std::vector<Code> codes(count);
+            std::vector<esdm::Vec4<float>> back(count);
+            esdm::encodeQuaternion<Bits>(std::span<const esdm::Vec4<float>>(qs), std::span<Code>(codes));
+            esdm::decodeQuaternion<Bits>(std::span<const Code>(codes), std::span<esdm::Vec4<float>>(back));
+            esdm::VecSoA<4, float> soa;
+            soa.resize(count);
+            esdm::decodeQuaternion<Bits>(std::span<const Code>(codes), soa.view());
+            std::vector<Code> again(count);
+            esdm::encodeQuaternion<Bits>(soa.view(), std::span<Code>(again));
+            for (std::size_t i = 0; i < count; i++) {
+                REQUIRE(again[i] == esdm::encodeQuaternion<Bits>(back[i]));
+                REQUIRE(codes[i] == esdm::encodeQuaternion<Bits>(qs[i]));
+                REQUIRE(std::uint64_t(codes[i]) < (std::uint64_t(1) << Bits));
+                // Rotation angle is twice the angle between the quaternions
+                REQUIRE(2. * degrees(back[i], qs[i]) <= bound);
+                const esdm::Vec4<float> single = esdm::decodeQuaternion<Bits>(codes[i]);
+                for (std::size_t c = 0; c < 4; c++) {
+                    REQUIRE(back[i][c] == Approx(single[c]).margin(1e-6));
+                    REQUIRE(soa.component(c)[i] == back[i][c]);
+                }
+            }
+        };
+        check.template operator()<32>(0.25);
+        check.template operator()<48>(0.008);
+    }
+}
+
+
+TEST_CASE("snapshot encoding", "[snapshot]") {
+    std::mt19937 rng(43);
+    std::uniform_real_distribution<float> coord(-1000.f, 1000.f);
+    std::uniform_real_distribution<float> move(-0.5f, 0.5f);
+
+    REQUIRE(esdm::detail::zigzag(0) == 0);
+    REQUIRE(esdm::detail::zigzag(-1) == 1);
+    REQUIRE(esdm::detail::zigzag(1) == 2);
+    for (std::int32_t d : { 0, 5, -5, 1 << 30, -(1 << 30), std::numeric_limits<std::int32_t>::min() })
+        REQUIRE(esdm::detail::unzigzag(esdm::detail::zigzag(d)) == d);
+
+    const esdm::SnapshotCodec<3, float> positions(esdm::Vec3<float>(-1024.f, -1024.f, -1024.f), esdm::Vec3<float>(1024.f, 1024.f, 1024.f), 20);
+    const esdm::SnapshotCodec<4, float> rotations(esdm::Vec4<float>(-1.f, -1.f, -1.f, -1.f), esdm::Vec4<float>(1.f, 1.f, 1.f, 1.f), 12);
+    REQUIRE(positions.quantize(esdm::Vec3<float>(-5000.f, 0.f, 5000.f)) == esdm::Vec3<std::uint32_t>(0, 512 * 1024, (1 << 20) - 1));
+
+    // Batches give the same codes as single vectors, NaN and values outside
+    // the bounds included, and 30 bit codes stay below the top code even
+    // though it is not exact in float
+    const esdm::SnapshotCodec<3, float> fine(esdm::Vec3<float>(-1.f, -1.f, -1.f), esdm::Vec3<float>(1.f, 1.f, 1.f), 30);
+    REQUIRE(fine.quantize(esdm::Vec3<float>(1.f, 2.f, -2.f)) == esdm::Vec3<std::uint32_t>((1 << 30) - 1, (1 << 30) - 1, 0));
+    std::vector<esdm::Vec3<float>> odd(300);
+    for (esdm::Vec3<float>& v : odd) v = esdm::Vec3<float>(coord(rng), coord(rng) * 0.002f, std::nanf(""));
+    std::vector<esdm::Vec3<std::uint32_t>> coarseCodes(odd.size()), fineCodes(odd.size());
+    positions.quantize(std::span<const esdm::Vec3<float>>(odd), std::span<esdm::Vec3<std::uint32_t>>(coarseCodes));
+    fine.quantize(std::span<const esdm::Vec3<float>>(odd), std::span<esdm::Vec3<std::uint32_t>>(fineCodes));
+    for (std::size_t i = 0; i < odd.size(); i++) {
+        REQUIRE(coarseCodes[i] == positions.quantize(odd[i]));
+        REQUIRE(fineCodes[i] == fine.quantize(odd[i]));
+        REQUIRE(fineCodes[i][2] == 0);
+    }
+
+    // Counts around the block size and lane count
+    for (std::size_t n : { 0, 1, 7, 8, 9, 255, 256, 257, 1000 }) {
+        std::vector<esdm::Vec3<float>> p0(n), p1(n);
+        std::vector<esdm::Vec4<float>> r0(n), r1(n);
+        for (std::size_t i = 0; i < n; i++) {
+            p0[i] = esdm::Vec3<float>(coord(rng), coord(rng), coord(rng));
+            p1[i] = i % 3 ? p0[i] + esdm::Vec3<float>(move(rng), move(rng), move(rng)) : p0[i];
+            r0[i] = esdm::normalize(esdm::Vec4<float>(move(rng), move(rng), move(rng), move(rng)));
+            r1[i] = esdm::normalize(r0[i] + esdm::Vec4<float>(move(rng), move(rng), move(rng), move(rng)) * 0.01f);
+        }
+
+        // Server side, a full snapshot and then a delta against it
+        std::vector<esdm::Vec3<std::uint32_t>> pc0(n), pc1(n);
+        std::vector<esdm::Vec4<std::uint32_t>> rc0(n), rc1(n);
+        esdm::SnapshotWriter full;
+        full.write(positions, std::span<const esdm::Vec3<float>>(p0), {}, std::span<esdm::Vec3<std::uint32_t>>(pc0));
+        full.write(rotations, std::span<const esdm::Vec4<float>>(r0), {}, std::span<esdm::Vec4<std::uint32_t>>(rc0));
+        esdm::SnapshotWriter delta;
+        delta.write(positions, std::span<const esdm::Vec3<float>>(p1), std::span<const esdm::Vec3<std::uint32_t>>(pc0), std::span<esdm::Vec3<std::uint32_t>>(pc1));
+        delta.write(rotations, std::span<const esdm::Vec4<float>>(r1), std::span<const esdm::Vec4<std::uint32_t>>(rc0), std::span<esdm::Vec4<std::uint32_t>>(rc1));
+        if (n >= 256) REQUIRE(delta.size() * 2 < full.size());
+
+        // Client side
+        std::vector<esdm::Vec3<std::uint32_t>> qc0(n), qc1(n);
+        std::vector<esdm::Vec4<std::uint32_t>> sc0(n), sc1(n);
+        std::vector<esdm::Vec3<float>> pv(n);
+        std::vector<esdm::Vec4<float>> rv(n);
+        esdm::SnapshotReader fullReader(full.data());
+        REQUIRE(fullReader.read(positions, {}, std::span<esdm::Vec3<std::uint32_t>>(qc0), std::span<esdm::Vec3<float>>(pv)));
+        REQUIRE(fullReader.read<4>({}, std::span<esdm::Vec4<std::uint32_t>>(sc0)));
+        REQUIRE(fullReader.remaining() == 0);
+        esdm::SnapshotReader deltaReader(delta.data());
+        REQUIRE(deltaReader.read(positions, std::span<const esdm::Vec3<std::uint32_t>>(qc0), std::span<esdm::Vec3<std::uint32_t>>(qc1), std::span<esdm::Vec3<float>>(pv)));
+        REQUIRE(deltaReader.read(rotations, std::span<const esdm::Vec4<std::uint32_t>>(sc0), std::span<esdm::Vec4<std::uint32_t>>(sc1), std::span<esdm::Vec4<float>>(rv)));
+        REQUIRE(deltaReader.remaining() == 0);
+
+        for (std::size_t i = 0; i < n; i++) {
+            REQUIRE(qc0[i] == pc0[i]);
+            REQUIRE(qc1[i] == pc1[i]);
+            REQUIRE(sc0[i] == rc0[i]);
+            REQUIRE(sc1[i] == rc1[i]);
+            for (std::size_t c = 0; c < 3; c++) REQUIRE(std::abs(pv[i][c] - p1[i][c]) <= positions.maxError()[c] * 1.2f);
+            for (std::size_t c = 0; c < 4; c++) REQUIRE(std::abs(rv[i][c] - r1[i][c]) <= rotations.maxError()[c] * 1.01f);
+        }
+
+        // Truncated snapshots are rejected
+        if (n > 0) {
+            esdm::SnapshotReader truncated(delta.data().first(delta.size() - 1));
+            REQUIRE(truncated.read<3>(std::span<const esdm::Vec3<std::uint32_t>>(qc0), std::span<esdm::Vec3<std::uint32_t>>(qc1)));
+            REQUIRE(!truncated.read<4>(std::span<const esdm::Vec4<std::uint32_t>>(sc0), std::span<esdm::Vec4<std::uint32_t>>(sc1)));
+        }
+    }
+
+    // Every width round trips
+    for (unsigned width = 0; width <= 32; width++) {
+        std::vector<esdm::Vec2<std::uint32_t>> codes(300), back(300);
+        std::uniform_int_distribution<std::uint32_t> bits(0, ~0u);
+        for (esdm::Vec2<std::uint32_t>& c : codes) {
+            // Zigzag change of at most width bits against a zero baseline
+            const std::uint32_t z = width == 32 ? bits(rng) : bits(rng) & ((1u << width) - 1);
+            c = esdm::Vec2<std::uint32_t>((std::uint32_t)esdm::detail::unzigzag(z), 0u);
+        }
+        esdm::SnapshotWriter w;
+        w.write<2>(codes, {});
+        esdm::SnapshotReader r(w.data());
+        REQUIRE(r.read<2>({}, back));
+        REQUIRE(r.remaining() == 0);
+        REQUIRE(codes == back);
+    }
+}
+
+
+TEST_CASE("bounding volumes", "[bounds]") {
+    const esdm::AABB3<float> a = { { 0.f, 0.f, 0.f }, { 2.f, 2.f, 2.f } };
+    const esdm::AABB3<float> b = { { 1.f, 1.f, 1.f }, { 3.f, 3.f, 3.f } };
+    const esdm::AABB3<float> c = { { 2.5f, 0.f, 0.f }, { 3.f, 1.f, 1.f } };
+
+    SECTION("boxes") {
+        REQUIRE(esdm::overlaps(a, b));
+        REQUIRE_FALSE(esdm::overlaps(a, c));
+        // Touching faces overlap
+        REQUIRE(esdm::overlaps(a, esdm::AABB3<float>{ { 2.f, 0.f, 0.f }, { 3.f, 1.f, 1.f } }));
+        REQUIRE(esdm::contains(a, esdm::Vec3<float>(2.f, 0.f, 1.f)));
+        REQUIRE_FALSE(esdm::contains(a, esdm::Vec3<float>(2.1f, 0.f, 1.f)));
+        REQUIRE(esdm::contains(esdm::merge(a, b), c));
+        REQUIRE_FALSE(esdm::contains(a, b));
+        REQUIRE(esdm::merge(a, esdm::Vec3<float>(-1.f, 1.f, 4.f)) == esdm::AABB3<float>{ { -1.f, 0.f, 0.f }, { 2.f, 2.f, 4.f } });
+        REQUIRE(esdm::center(b) == esdm::Vec3<float>(2.f, 2.f, 2.f));
+        REQUIRE(esdm::halfExtent(b) == esdm::Vec3<float>(1.f, 1.f, 1.f));
+    }
+
+    SECTION("transformed boxes bound every corner") {
+        const esdm::Mat4<float> m = esdm::Mat4<float>{
+            1.f, 0.f, 0.f, 0.f,
+            0.f, -2.f, 0.f, 0.f,
+            0.f, 0.f, 0.5f, 0.f,
+            0.f, 0.f, 0.f, 1.f
+        } * esdm::matrot(esdm::normalize(esdm::Vec3<float>(1.f, 2.f, 3.f)), 0.7f)
+            * esdm::mattrans(esdm::Vec3<float>(4.f, -1.f, 2.f));
+        const esdm::AABB3<float> t = esdm::transform(b, m);
+        esdm::AABB3<float> corners = { { esdm::inf<float>(), esdm::inf<float>(), esdm::inf<float>() }, { -esdm::inf<float>(), -esdm::inf<float>(), -esdm::inf<float>() } };
+        for (int i = 0; i < 8; i++) {
+            const esdm::Vec4<float> p(i & 1 ? b.max[0] : b.min[0], i & 2 ? b.max[1] : b.min[1], i & 4 ? b.max[2] : b.min[2], 1.f);
+            const esdm::Vec4<float> q = p * m;
+            corners = esdm::merge(corners, esdm::Vec3<float>(q[0], q[1], q[2]));
+        }
+        for (std::size_t i = 0; i < 3; i++) {
+            REQUIRE(t.min[i] == Approx(corners.min[i]).margin(1e-5));
+            REQUIRE(t.max[i] == Approx(corners.max[i]).margin(1e-5));
+        }
+    }
+
+    SECTION("spheres") {
+        const esdm::Sphere3<float> s = { { 0.f, 0.f, 0.f }, 1.f };
+        const esdm::Sphere3<float> u = { { 3.f, 0.f, 0.f }, 1.f };
+        REQUIRE_FALSE(esdm::overlaps(s, u));
+        REQUIRE(esdm::overlaps(s, esdm::Sphere3<float>{ { 2.f, 0.f, 0.f }, 1.f }));
+        REQUIRE(esdm::overlaps(s, a));
+        REQUIRE_FALSE(esdm::overlaps(s, esdm::AABB3<float>{ { 0.8f, 0.8f, 0.f }, { 2.f, 2.f, 2.f } }));
+        REQUIRE(esdm::overlaps(esdm::AABB3<float>{ { 0.5f, 0.5f, 0.f }, { 2.f, 2.f, 2.f } }, s));
+        REQUIRE(esdm::contains(s, esdm::Vec3<float>(0.f, 1.f, 0.f)));
+
+        const esdm::Sphere3<float> m = esdm::merge(s, u);
+        REQUIRE(m.center[0] == Approx(1.5f));
+        REQUIRE(m.radius == Approx(2.5f));
+        REQUIRE(esdm::contains(m, s));
+        REQUIRE(esdm::contains(m, u));
+        const esdm::Sphere3<float> inner = { { 0.2f, 0.f, 0.f }, 0.5f };
+        REQUIRE(esdm::merge(s, inner) == s);
+        REQUIRE(esdm::merge(inner, s) == s);
+        REQUIRE(esdm::merge(s, s) == s);
+
+        REQUIRE(esdm::aabb(u) == esdm::AABB3<float>{ { 2.f, -1.f, -1.f }, { 4.f, 1.f, 1.f } });
+
+        // Rotation and uniform scale keep the radius exact
+        const esdm::Mat4<float> r = esdm::Mat4<float>{
+            2.f, 0.f, 0.f, 0.f,
+            0.f, 2.f, 0.f, 0.f,
+            0.f, 0.f, 2.f, 0.f,
+            0.f, 0.f, 0.f, 1.f
+        } * esdm::matrot(esdm::normalize(esdm::Vec3<float>(1.f, 1.f, 0.f)), 1.1f)
+            * esdm::mattrans(esdm::Vec3<float>(1.f, 0.f, 0.f));
+        const esdm::Sphere3<float> t = esdm::transform(u, r);
+        REQUIRE(t.radius == Approx(2.f));
+        const esdm::Vec4<float> c = esdm::Vec4<float>(3.f, 0.f, 0.f, 1.f) * r;
+        for (std::size_t i = 0; i < 3; i++) REQUIRE(t.center[i] == Approx(c[i]));
+    }
+
+    SECTION("rays") {
+        const esdm::Ray3<float> r = { { -1.f, 1.f, 1.f }, { 1.f, 0.f, 0.f } };
+        REQUIRE(esdm::intersect(r, a) == 1.f);
+        REQUIRE(esdm::intersect(r, c) == 3.5f);
+        REQUIRE(esdm::intersect(r, c, 3.f) == esdm::inf<float>());
+        // Starting inside
+        REQUIRE(esdm::intersect(esdm::Ray3<float>{ { 1.f, 1.f, 1.f }, { 0.f, -1.f, 0.f } }, a) == 0.f);
+        // Parallel to a face it lies on
+        REQUIRE(esdm::intersect(esdm::Ray3<float>{ { -1.f, 2.f, 0.f }, { 1.f, 0.f, 0.f } }, a) == 1.f);
+        REQUIRE(esdm::intersect(esdm::Ray3<float>{ { 4.f, 2.f, 0.f }, { -1.f, -0.f, 0.f } }, a) == 2.f);
+        REQUIRE(esdm::intersect(esdm::Ray3<float>{ { 4.f, 2.5f, 0.f }, { -1.f, -0.f, 0.f } }, a) == esdm::inf<float>());
+        // Pointing away
+        REQUIRE(esdm::intersect(esdm::Ray3<float>{ { -1.f, 1.f, 1.f }, { -1.f, 0.f, 0.f } }, a) == esdm::inf<float>());
+        // Diagonal miss
+        REQUIRE(esdm::intersect(esdm::Ray3<float>{ { -1.f, 5.5f, 1.f }, { 1.f, -1.f, 0.f } }, a) == esdm::inf<float>());
+    }
+
+    SECTION("packets match single tests") {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> dist(-4.f, 4.f);
+        esdm::AABBPacket<8, 3, float> boxes;
+        esdm::SpherePacket<8, 3, float> spheres;
+        for (std::size_t i = 0; i < 8; i++) {
+            const esdm::Vec3<float> p(dist(rng), dist(rng), dist(rng));
+            const esdm::Vec3<float> q(dist(rng), dist(rng), dist(rng));
+            boxes.set(i, { esdm::min(p, q), esdm::max(p, q) });
+            spheres.set(i, { p, std::abs(dist(rng)) * 0.5f });
+        }
+        REQUIRE(boxes.get(3).min == esdm::min(boxes.get(3).min, boxes.get(3).max));
+
+        for (int n = 0; n < 50; n++) {
+            const esdm::Vec3<float> p(dist(rng), dist(rng), dist(rng));
+            const esdm::AABB3<float> box = { p, p + esdm::Vec3<float>(1.f, 1.f, 1.f) };
+            const esdm::Sphere3<float> s = { p, 1.f };
+            const esdm::Ray3<float> ray = { p * 2.f, esdm::Vec3<float>(dist(rng), dist(rng), 0.f) };
+            float t[8];
+            const std::uint32_t boxMask = esdm::overlaps(box, boxes);
+            const std::uint32_t sphereMask = esdm::overlaps(s, spheres);
+            const std::uint32_t mixedMask = esdm::overlaps(box, spheres);
+            const std::uint32_t rayMask = esdm::intersect(ray, boxes, t, 6.f);
+            for (std::size_t i = 0; i < 8; i++) {
+                REQUIRE(bool(boxMask >> i & 1) == esdm::overlaps(box, boxes.get(i)));
+                REQUIRE(bool(sphereMask >> i & 1) == esdm::overlaps(s, spheres.get(i)));
+                REQUIRE(bool(mixedMask >> i & 1) == esdm::overlaps(box, spheres.get(i)));
+                REQUIRE(bool(rayMask >> i & 1) == (t[i] != esdm::inf<float>()));
+                REQUIRE(t[i] == esdm::intersect(ray, boxes.get(i), 6.f));
+            }
+        }
+    }
+}
+
+TEST_CASE("sweep and prune broadphase", "[broadphase]") {
+    using Pair = esdm::SweepAndPrune<float>::Pair;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> coord(-20.f, 20.f);
+    std::uniform_real_distribution<float> size(0.1f, 2.f);
+    std::uniform_real_distribution<float> move(-0.1f, 0.1f);
+
+    const std::size_t n = 3000;
+    std::vector<esdm::AABB3<float>> boxes(n);
+    for (esdm::AABB3<float>& b : boxes) {
+        b.min = esdm::Vec3<float>(coord(rng), coord(rng), coord(rng));
+        b.max = b.min + esdm::Vec3<float>(size(rng), size(rng), size(rng));
+    }
+    // Touching faces count
+    boxes[1] = { boxes[0].max, boxes[0].max + esdm::Vec3<float>(1.f, 1.f, 1.f) };
+
+    auto bruteForce = [&] {
+        std::vector<Pair> out;
+        for (std::uint32_t i = 0; i < n; i++)
+            for (std::uint32_t j = i + 1; j < n; j++)
+                if (esdm::overlaps(boxes[i], boxes[j])) out.push_back({ i, j });
+        return out;
+    };
+    auto sorted = [](std::span<const Pair> pairs) {
+        std::vector<Pair> out(pairs.begin(), pairs.end());
+        std::sort(out.begin(), out.end(), [](const Pair& a, const Pair& b) {
+            return a.first != b.first ? a.first < b.first : a.second < b.second;
+        });
+        return out;
+    };
+
+    esdm::SweepAndPrune<float> sap;
+    REQUIRE_FALSE(sap.update(boxes));
+    REQUIRE(sap.size() == n);
+    const std::vector<Pair> expected = bruteForce();
+    REQUIRE(expected.size() > 100);
+    REQUIRE(sorted(sap.pairs()) == expected);
+    for (const Pair& p : sap.pairs()) REQUIRE(p.first < p.second);
+
+    SECTION("coherent motion stays incremental") {
+        for (int frame = 0; frame < 5; frame++) {
+            for (esdm::AABB3<float>& b : boxes) {
+                const esdm::Vec3<float> d(move(rng), move(rng), move(rng));
+                b = { b.min + d, b.max + d };
+            }
+            REQUIRE(sap.update(boxes));
+            REQUIRE(sap.moves() > 0);
+            REQUIRE(sorted(sap.pairs()) == bruteForce());
+        }
+    }
+
+    SECTION("large jumps fall back to a full sort") {
+        std::reverse(boxes.begin(), boxes.end());
+        REQUIRE_FALSE(sap.update(boxes));
+        REQUIRE(sorted(sap.pairs()) == bruteForce());
+    }
+
+    SECTION("any axis and thread count give the same pairs") {
+        esdm::ThreadPool pool(3);
+        for (std::size_t axis = 0; axis < 3; axis++) {
+            esdm::SweepAndPrune<float> other(pool, axis);
+            other.update(boxes);
+            REQUIRE(sorted(other.pairs()) == expected);
+        }
+        esdm::SweepAndPrune<float> single(pool);
+        single.update(boxes);
+        REQUIRE(std::vector<Pair>(single.pairs().begin(), single.pairs().end())
+            == std::vector<Pair>(sap.pairs().begin(), sap.pairs().end()));
+        sap.setAxis(2);
+        REQUIRE_FALSE(sap.update(boxes));
+        REQUIRE(sorted(sap.pairs()) == expected);
+    }
+
+    SECTION("empty") {
+        REQUIRE_FALSE(sap.update(std::span<const esdm::AABB3<float>>()));
+        REQUIRE(sap.pairs().empty());
+    }
+}
+
+TEST_CASE("gjk and epa", "[gjk]") {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> coord(-3.f, 3.f);
+    std::uniform_real_distribution<float> size(0.2f, 1.5f);
+
+    auto randomBox = [&] {
+        const esdm::Vec3<float> c(coord(rng), coord(rng), coord(rng));
+        const esdm::Vec3<float> h(size(rng), size(rng), size(rng));
+        return esdm::AABB3<float>{ c - h, c + h };
+    };
+    // Exact distance between boxes
+    auto boxDistance = [](const esdm::AABB3<float>& a, const esdm::AABB3<float>& b) {
+        float sq = 0.f;
+        for (std::size_t i = 0; i < 3; i++) {
+            const float gap = std::max({ 0.f, a.min[i] - b.max[i], b.min[i] - a.max[i] });
+            sq += gap * gap;
+        }
+        return std::sqrt(sq);
+    };
+    // Corners, edge midpoints and face centers, as a point set
+    auto boxPoints = [](const esdm::AABB3<float>& box) {
+        std::vector<esdm::Vec3<float>> out;
+        for (int x = 0; x < 3; x++)
+            for (int y = 0; y < 3; y++)
+                for (int z = 0; z < 3; z++)
+                    if (x != 1 || y != 1 || z != 1) {
+                        const int c[3] = { x, y, z };
+                        esdm::Vec3<float> p;
+                        for (std::size_t i = 0; i < 3; i++) p[i] = box.min[i] + (box.max[i] - box.min[i]) * 0.5f * (float)c[i];
+                        out.push_back(p);
+                    }
+        return out;
+    };
+
+    SECTION("support search") {
+        std::normal_distribution<float> normal;
+        for (std::size_t n : { 1, 7, 8, 9, 64, 65, 300 }) {
+            std::vector<esdm::Vec3<float>> points(n);
+            std::vector<float> x(n), y(n), z(n);
+            for (std::size_t i = 0; i < n; i++) {
+                points[i] = { normal(rng), normal(rng), normal(rng) };
+                x[i] = points[i][0];
+                y[i] = points[i][1];
+                z[i] = points[i][2];
+            }
+            const esdm::VecSoASpan<3, const float> soa({ x.data(), y.data(), z.data() }, n);
+            for (int k = 0; k < 20; k++) {
+                const esdm::Vec3<float> d(normal(rng), normal(rng), normal(rng));
+                std::size_t best = 0;
+                for (std::size_t i = 1; i < n; i++) if (esdm::dot(points[i], d) > esdm::dot(points[best], d)) best = i;
+                const std::size_t aos = esdm::supportIndex(std::span<const esdm::Vec3<float>>(points), d);
+                REQUIRE(esdm::dot(points[aos], d) == Approx(esdm::dot(points[best], d)).margin(1e-5));
+                REQUIRE(esdm::supportIndex(soa, d) == aos);
+            }
+        }
+        // Ties go to the first point
+        const std::vector<esdm::Vec3<float>> same(20, esdm::Vec3<float>(1.f, 0.f, 0.f));
+        REQUIRE(esdm::supportIndex(std::span<const esdm::Vec3<float>>(same), esdm::Vec3<float>(1.f, 0.f, 0.f)) == 0);
+
+        const esdm::AABB3<float> box = { { -1.f, -2.f, -3.f }, { 1.f, 2.f, 3.f } };
+        REQUIRE(esdm::support(box, esdm::Vec3<float>(1.f, -1.f, 1.f)) == esdm::Vec3<float>(1.f, -2.f, 3.f));
+        const esdm::Sphere3<float> s = { { 1.f, 0.f, 0.f }, 2.f };
+        REQUIRE(esdm::support(s, esdm::Vec3<float>(0.f, 5.f, 0.f))[1] == Approx(2.f));
+    }
+
+    SECTION("distance matches boxes") {
+        for (int k = 0; k < 300; k++) {
+            const esdm::AABB3<float> a = randomBox();
+            const esdm::AABB3<float> b = randomBox();
+            const float expected = boxDistance(a, b);
+            const esdm::GjkResult<float> r = esdm::gjkDistance(a, b);
+            REQUIRE(r.distance == Approx(expected).margin(1e-4));
+            // Touching boxes may go either way
+            if (expected > 1e-3f) {
+                REQUIRE_FALSE(r.overlap);
+                REQUIRE_FALSE(esdm::gjkOverlap(a, b));
+                REQUIRE(esdm::length(r.pointB - r.pointA) == Approx(expected).margin(1e-4));
+                const esdm::Vec3<float> e(1e-4f, 1e-4f, 1e-4f);
+                REQUIRE(esdm::contains(esdm::AABB3<float>{ a.min - e, a.max + e }, r.pointA));
+                REQUIRE(esdm::contains(esdm::AABB3<float>{ b.min - e, b.max + e }, r.pointB));
+            } else if (expected == 0.f && esdm::overlaps(esdm::AABB3<float>{ a.min + esdm::Vec3<float>(1e-3f, 1e-3f, 1e-3f), a.max - esdm::Vec3<float>(1e-3f, 1e-3f, 1e-3f) }, b)) {
+                REQUIRE(r.overlap);
+                REQUIRE(esdm::gjkOverlap(a, b));
+            }
+
+            // The same boxes as point sets, one of them placed by a transform
+            const std::vector<esdm::Vec3<float>> pa = boxPoints(a);
+            const esdm::Vec3<float> shift(0.5f, -0.25f, 1.f);
+            const std::vector<esdm::Vec3<float>> pb = boxPoints(esdm::AABB3<float>{ b.min - shift, b.max - shift });
+            const esdm::ConvexPoints<float> ha(pa);
+            const esdm::ConvexPoints<float> hb(pb);
+            const esdm::TransformedShape<esdm::ConvexPoints<float>> moved(hb, esdm::mattrans(shift));
+            REQUIRE(esdm::gjkDistance(ha, moved).distance == Approx(expected).margin(1e-4));
+        }
+    }
+
+    SECTION("spheres and rotated boxes") {
+        const esdm::Sphere3<float> a = { { 0.f, 0.f, 0.f }, 1.f };
+        const esdm::Sphere3<float> b = { { 3.f, 1.f, 0.f }, 1.f };
+        const esdm::GjkResult<float> r = esdm::gjkDistance(a, b);
+        REQUIRE(r.distance == Approx(std::sqrt(10.f) - 2.f).margin(1e-4));
+        REQUIRE(esdm::length(r.pointA) == Approx(1.f).margin(1e-4));
+
+        // A unit cube turned 45 degrees about z reaches sqrt(0.5) along x
+        const esdm::AABB3<float> cube = { { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } };
+        const esdm::TransformedShape<esdm::AABB3<float>> turned(cube,
+            esdm::matrot(esdm::Vec3<float>(0.f, 0.f, 1.f), 0.785398163f) * esdm::mattrans(esdm::Vec3<float>(2.f, 0.f, 0.f)));
+        REQUIRE(esdm::gjkDistance(esdm::Vec3<float>(0.f, 0.f, 0.f), turned).distance == Approx(2.f - std::sqrt(0.5f)).margin(1e-4));
+        REQUIRE(esdm::gjkOverlap(esdm::Vec3<float>(1.4f, 0.f, 0.f), turned));
+        REQUIRE_FALSE(esdm::gjkOverlap(esdm::Vec3<float>(1.25f, 0.f, 0.f), turned));
+    }
+
+    SECTION("penetration matches boxes") {
+        int overlapping = 0;
+        for (int k = 0; k < 300; k++) {
+            const esdm::AABB3<float> a = randomBox();
+            const esdm::AABB3<float> b = randomBox();
+            // Smallest push along an axis, from A towards B
+            float depth = esdm::inf<float>();
+            esdm::Vec3<float> normal;
+            for (std::size_t i = 0; i < 3; i++) {
+                const float up = a.max[i] - b.min[i];
+                const float down = b.max[i] - a.min[i];
+                if (up < depth) {
+                    depth = up;
+                    normal = esdm::Vec3<float>();
+                    normal[i] = 1.f;
+                }
+                if (down < depth) {
+                    depth = down;
+                    normal = esdm::Vec3<float>();
+                    normal[i] = -1.f;
+                }
+            }
+            const esdm::Contact<float> c = esdm::penetration(a, b);
+            if (depth > 1e-2f) {
+                overlapping++;
+                REQUIRE(c.overlap);
+                REQUIRE(c.depth == Approx(depth).margin(1e-4));
+                // Ties between axes may pick either
+                REQUIRE(esdm::dot(c.normal, normal) * depth == Approx(depth).margin(1e-4));
+                // Moving B out along the normal separates the boxes
+                const esdm::Vec3<float> push = c.normal * (c.depth + 1e-3f);
+                REQUIRE_FALSE(esdm::gjkOverlap(a, esdm::AABB3<float>{ b.min + push, b.max + push }));
+            } else if (depth < -1e-2f) {
+                REQUIRE_FALSE(c.overlap);
+                REQUIRE(c.depth == Approx(-boxDistance(a, b)).margin(1e-4));
+            }
+        }
+        REQUIRE(overlapping > 20);
+
+        const esdm::Contact<float> s = esdm::penetration(esdm::Sphere3<float>{ { 0.f, 0.f, 0.f }, 1.f }, esdm::Sphere3<float>{ { 1.5f, 0.f, 0.f }, 1.f });
+        REQUIRE(s.overlap);
+        REQUIRE(s.depth == Approx(0.5f).margin(1e-3));
+        REQUIRE(s.normal[0] == Approx(1.f).margin(1e-3));
+    }
+
+    SECTION("penetration of point sets") {
+        std::normal_distribution<float> normal;
+        std::uniform_int_distribution<int> count(4, 30);
+        int overlapping = 0;
+        for (int k = 0; k < 2000; k++) {
+            std::vector<esdm::Vec3<float>> pa(count(rng));
+            std::vector<esdm::Vec3<float>> pb(count(rng));
+            const esdm::Vec3<float> offset(normal(rng), normal(rng), normal(rng));
+            for (esdm::Vec3<float>& p : pa) p = esdm::Vec3<float>(normal(rng), normal(rng), normal(rng));
+            for (esdm::Vec3<float>& p : pb) p = esdm::Vec3<float>(normal(rng), normal(rng), normal(rng)) + offset;
+            const esdm::ConvexPoints<float> a(pa);
+            const esdm::ConvexPoints<float> b(pb);
+            const esdm::Contact<float> c = esdm::penetration(a, b);
+            if (!c.overlap || c.depth <= 0.f) continue;
+            overlapping++;
+
+            // The depth is the support of A - B along the normal
+            float support = -esdm::inf<float>();
+            for (const esdm::Vec3<float>& p : pa)
+                for (const esdm::Vec3<float>& q : pb) support = std::max(support, esdm::dot(p - q, c.normal));
+            REQUIRE(c.depth == Approx(support).margin(1e-4));
+
+            for (esdm::Vec3<float>& p : pb) p = p + c.normal * (c.depth + 1e-3f);
+            REQUIRE_FALSE(esdm::gjkOverlap(a, esdm::ConvexPoints<float>(pb)));
+        }
+        REQUIRE(overlapping > 1000);
+    }
+
+    SECTION("warm start") {
+        std::normal_distribution<float> normal;
+        std::vector<esdm::Vec3<float>> points(200);
+        for (esdm::Vec3<float>& p : points) p = esdm::normalize(esdm::Vec3<float>(normal(rng), normal(rng), normal(rng)));
+        const esdm::ConvexPoints<float> hull(points);
+        esdm::GjkCache<float> cache;
+        std::size_t cold = 0;
+        std::size_t warm = 0;
+        for (int frame = 0; frame < 50; frame++) {
+            const float x = 2.6f - 0.005f * (float)frame;
+            const esdm::TransformedShape<esdm::ConvexPoints<float>> other(hull, esdm::mattrans(esdm::Vec3<float>(x, 0.3f, 0.f)));
+            const esdm::GjkResult<float> a = esdm::gjkDistance(hull, other);
+            const esdm::GjkResult<float> b = esdm::gjkDistance(hull, other, cache);
+            REQUIRE(b.distance == Approx(a.distance).margin(1e-4));
+            cold += a.iterations;
+            warm += b.iterations;
+            REQUIRE(esdm::gjkOverlap(hull, other, cache) == a.overlap);
+            const esdm::Contact<float> c = esdm::penetration(hull, other, cache);
+            REQUIRE(c.depth == Approx(-a.distance).margin(1e-4));
+        }
+        REQUIRE(warm < cold);
+    }
+}
+
+TEST_CASE("convex hull", "[hull]") {
+    std::mt19937 rng(6);
+    std::normal_distribution<double> normal;
+
+    // Every point on or below every face, closed surface with V - E + F = 2
+    auto checkHull = []<typename T>(const esdm::QuickHull<T>& hull, const std::vector<esdm::Vec3<T>>& points, double tolerance) {
+        const auto faces = hull.faces();
+        REQUIRE(faces.size() == 2 * hull.vertices().size() - 4);
+        std::map<std::pair<std::uint32_t, std::uint32_t>, int> edges;
+        for (const auto& f : faces) {
+            for (std::size_t e = 0; e < 3; e++) edges[{ f[e], f[(e + 1) % 3] }]++;
+            const esdm::Vec3<T> n = esdm::normalize(esdm::cross(points[f[1]] - points[f[0]], points[f[2]] - points[f[0]]));
+            for (const auto& p : points) REQUIRE(esdm::dot(n, p - points[f[0]]) <= T(tolerance));
+        }
+        for (const auto& [e, count] : edges) {
+            REQUIRE(count == 1);
+            REQUIRE(edges.count({ e.second, e.first }) == 1);
+        }
+        for (std::size_t i = 0; i < hull.vertices().size(); i++) REQUIRE(hull.points()[i] == points[hull.vertices()[i]]);
+    };
+
+    SECTION("sphere") {
+        std::vector<esdm::Vec3<double>> points(2000);
+        for (esdm::Vec3<double>& p : points) p = esdm::normalize(esdm::Vec3<double>(normal(rng), normal(rng), normal(rng)));
+        for (esdm::HullMode mode : { esdm::HullMode::Fast, esdm::HullMode::Robust }) {
+            esdm::QuickHull<double> hull(esdm::ThreadPool::global(), mode);
+            REQUIRE(hull.build(points));
+            // Every point of a sphere is on the hull
+            REQUIRE(hull.vertices().size() == points.size());
+            checkHull(hull, points, 1e-12);
+        }
+    }
+
+    SECTION("cube and interior") {
+        std::uniform_real_distribution<float> inside(-0.99f, 0.99f);
+        std::vector<esdm::Vec3<float>> points;
+        for (int i = 0; i < 50000; i++) points.push_back({ inside(rng), inside(rng), inside(rng) });
+        for (int i = 0; i < 8; i++) points.push_back({ i & 1 ? 1.f : -1.f, i & 2 ? 1.f : -1.f, i & 4 ? 1.f : -1.f });
+        // Points on the faces and edges of the cube are coplanar with them
+        for (int i = 0; i < 200; i++) points.push_back({ 1.f, inside(rng), inside(rng) });
+        for (int i = 0; i < 200; i++) points.push_back({ inside(rng), -1.f, 1.f });
+        std::shuffle(points.begin(), points.end(), rng);
+
+        esdm::ThreadPool pool(4);
+        for (esdm::HullMode mode : { esdm::HullMode::Fast, esdm::HullMode::Robust }) {
+            esdm::QuickHull<float> hull(pool, mode);
+            REQUIRE(hull.build(points));
+            REQUIRE(hull.vertices().size() == 8);
+            REQUIRE(hull.faces().size() == 12);
+            for (const esdm::Vec3<float>& p : hull.points()) REQUIRE(esdm::dot(p, p) == 3.f);
+            checkHull(hull, points, 1e-6);
+
+            // Same hull from any thread count
+            esdm::ThreadPool one(1);
+            esdm::QuickHull<float> single(one, mode);
+            REQUIRE(single.build(points));
+            REQUIRE(std::equal(single.faces().begin(), single.faces().end(), hull.faces().begin(), hull.faces().end()));
+        }
+    }
+
+    SECTION("lattice") {
+        // Many exactly coplanar and collinear points
+        std::vector<esdm::Vec3<float>> points;
+        for (int x = 0; x < 12; x++) for (int y = 0; y < 7; y++) for (int z = 0; z < 5; z++)
+            points.push_back({ (float)x * 0.1f, (float)y * 0.3f, (float)z });
+        for (esdm::HullMode mode : { esdm::HullMode::Fast, esdm::HullMode::Robust }) {
+            esdm::QuickHull<float> hull(esdm::ThreadPool::global(), mode);
+            REQUIRE(hull.build(points));
+            checkHull(hull, points, 1e-5);
+            // Rebuilding reuses the buffers and gives the same hull
+            const std::vector<esdm::QuickHull<float>::Face> first(hull.faces().begin(), hull.faces().end());
+            REQUIRE(hull.build(points));
+            REQUIRE(std::equal(first.begin(), first.end(), hull.faces().begin(), hull.faces().end()));
+        }
+    }
+
+    SECTION("degenerate") {
+        esdm::QuickHull<float> hull;
+        std::vector<esdm::Vec3<float>> points = { { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f } };
+        REQUIRE_FALSE(hull.build(points));
+        for (int i = 0; i < 100; i++) points.push_back({ (float)(i % 10), (float)(i / 10), 0.f });
+        REQUIRE_FALSE(hull.build(points));
+        REQUIRE(hull.faces().empty());
+        points.push_back({ 0.f, 0.f, 1.f });
+        REQUIRE(hull.build(points));
+        REQUIRE(hull.vertices().size() == 5);
+    }
+
+    SECTION("gjk") {
+        std::vector<esdm::Vec3<float>> points(5000);
+        for (esdm::Vec3<float>& p : points) p = esdm::Vec3<float>((float)normal(rng), (float)normal(rng), (float)normal(rng));
+        esdm::QuickHull<float> hull;
+        REQUIRE(hull.build(points));
+        REQUIRE(hull.vertices().size() < points.size() / 10);
+        const esdm::ConvexPoints<float> full(points);
+        const esdm::ConvexPoints<float> reduced(hull.points());
+        for (int i = 0; i < 20; i++) {
+            const esdm::Vec3<float> d((float)normal(rng), (float)normal(rng), (float)normal(rng));
+            REQUIRE(esdm::dot(full.support(d), d) == Approx(esdm::dot(reduced.support(d), d)));
+        }
+    }
+}
+
+TEST_CASE("geometric predicates", "[predicates]") {
+    auto sign = [](auto x) { return (x > 0) - (x < 0); };
+
+    SECTION("orient2d near a line") {
+        // Points a few ulps off the line y = x, where the naive determinant
+        // gets the sign wrong, checked against exact integers in units of
+        // 2^-53
+        const double ulp = std::ldexp(1.0, -53);
+        const esdm::Vec2<double> b(12.0, 12.0);
+        const esdm::Vec2<double> c(24.0, 24.0);
+        std::size_t naiveWrong = 0;
+        for (int i = 0; i < 256; i++) {
+            for (int j = 0; j < 256; j++) {
+                const esdm::Vec2<double> a(0.5 + i * ulp, 0.5 + j * ulp);
+                auto whole = [](double v) { return (__int128)std::ldexp(v, 53); };
+                const __int128 exact = (whole(a[0]) - whole(c[0])) * (whole(b[1]) - whole(c[1]))
+                    - (whole(a[1]) - whole(c[1])) * (whole(b[0]) - whole(c[0]));
+                REQUIRE(sign(esdm::orient2d(a, b, c)) == sign(exact));
+                REQUIRE(sign(esdm::orient2d(b, c, a)) == sign(exact));
+                REQUIRE(sign(esdm::orient2d(b, a, c)) == -sign(exact));
+                const double naive = (a[0] - c[0]) * (b[1] - c[1]) - (a[1] - c[1]) * (b[0] - c[0]);
+                naiveWrong += sign(naive) != sign(exact);
+            }
+        }
+        REQUIRE(naiveWrong > 0);
+    }
+
+    std::mt19937 rng(7);
+
+    SECTION("orient3d near a plane") {
+        // Integer coordinates up to 2^30 keep the exact determinant in 128 bits
+        std::uniform_int_distribution<std::int64_t> coord(-(1 << 30), 1 << 30);
+        std::uniform_real_distribution<double> weight(-1.0, 2.0);
+        std::uniform_int_distribution<int> nudge(-1, 1);
+        for (int i = 0; i < 20000; i++) {
+            std::int64_t p[4][3];
+            for (int k = 0; k < 3; k++) for (int c = 0; c < 3; c++) p[k][c] = coord(rng) / 2;
+            const double s = weight(rng);
+            const double t = weight(rng);
+            for (int c = 0; c < 3; c++)
+                p[3][c] = (std::int64_t)std::llround((double)p[0][c] + s * (double)(p[1][c] - p[0][c]) + t * (double)(p[2][c] - p[0][c])) + nudge(rng);
+            __int128 e[3][3];
+            for (int k = 0; k < 3; k++) for (int c = 0; c < 3; c++) e[k][c] = p[k][c] - p[3][c];
+            const __int128 exact = e[0][2] * (e[1][0] * e[2][1] - e[2][0] * e[1][1])
+                + e[1][2] * (e[2][0] * e[0][1] - e[0][0] * e[2][1])
+                + e[2][2] * (e[0][0] * e[1][1] - e[1][0] * e[0][1]);
+            esdm::Vec3<double> v[4];
+            for (int k = 0; k < 4; k++) v[k] = esdm::Vec3<double>((double)p[k][0], (double)p[k][1], (double)p[k][2]);
+            REQUIRE(sign(esdm::orient3d(v[0], v[1], v[2], v[3])) == sign(exact));
+            REQUIRE(sign(esdm::orient3d(v[1], v[0], v[2], v[3])) == -sign(exact));
+        }
+        // Exactly coplanar
+        const esdm::Vec3<double> a(0.1, 0.2, 0.3);
+        REQUIRE(esdm::orient3d(a, a * 2.0, a * 4.0, esdm::Vec3<double>(1.0, -1.0, 0.5)) == 0.0);
+        REQUIRE(esdm::orient3d(esdm::Vec3<double>(0.0, 0.0, 0.0), esdm::Vec3<double>(1.0, 0.0, 0.0),
+            esdm::Vec3<double>(0.0, 1.0, 0.0), esdm::Vec3<double>(0.3, 0.7, -1e-300)) > 0.0);
+    }
+
+    SECTION("incircle near a circle") {
+        // Integer coordinates up to 2^27 keep the exact determinant in 128 bits
+        std::uniform_real_distribution<double> angle(0.0, 6.283185307179586);
+        std::uniform_int_distribution<int> nudge(-2, 2);
+        const double r = std::ldexp(1.0, 26);
+        for (int i = 0; i < 20000; i++) {
+            std::int64_t p[4][2];
+            for (int k = 0; k < 4; k++) {
+                const double t = angle(rng);
+                p[k][0] = std::llround(r * std::cos(t)) + (k == 3 ? nudge(rng) : 0);
+                p[k][1] = std::llround(r * std::sin(t));
+            }
+            __int128 e[3][2];
+            __int128 lift[3];
+            for (int k = 0; k < 3; k++) {
+                for (int c = 0; c < 2; c++) e[k][c] = p[k][c] - p[3][c];
+                lift[k] = e[k][0] * e[k][0] + e[k][1] * e[k][1];
+            }
+            const __int128 orient = (__int128)(p[0][0] - p[2][0]) * (p[1][1] - p[2][1]) - (__int128)(p[0][1] - p[2][1]) * (p[1][0] - p[2][0]);
+            const __int128 exact = lift[0] * (e[1][0] * e[2][1] - e[2][0] * e[1][1])
+                + lift[1] * (e[2][0] * e[0][1] - e[0][0] * e[2][1])
+                + lift[2] * (e[0][0] * e[1][1] - e[1][0] * e[0][1]);
+            esdm::Vec2<double> v[4];
+            for (int k = 0; k < 4; k++) v[k] = esdm::Vec2<double>((double)p[k][0], (double)p[k][1]);
+            REQUIRE(sign(esdm::orient2d(v[0], v[1], v[2])) == sign(orient));
+            REQUIRE(sign(esdm::incircle(v[0], v[1], v[2], v[3])) == sign(exact));
+        }
+    }
+
+    SECTION("float") {
+        // Small integers are exact in float, their products are not
+        std::uniform_int_distribution<int> coord(-(1 << 20), 1 << 20);
+        std::uniform_int_distribution<int> nudge(-1, 1);
+        for (int i = 0; i < 20000; i++) {
+            std::int64_t p[3][2];
+            for (int c = 0; c < 2; c++) {
+                p[0][c] = coord(rng);
+                p[1][c] = coord(rng);
+                p[2][c] = (p[0][c] + p[1][c]) / 2 + nudge(rng);
+            }
+            const std::int64_t exact = (p[0][0] - p[2][0]) * (p[1][1] - p[2][1]) - (p[0][1] - p[2][1]) * (p[1][0] - p[2][0]);
+            esdm::Vec2<float> v[3];
+            for (int k = 0; k < 3; k++) v[k] = esdm::Vec2<float>((float)p[k][0], (float)p[k][1]);
+            REQUIRE(sign(esdm::orient2d(v[0], v[1], v[2])) == sign(exact));
+        }
+    }
+}
+
+TEST_CASE("mesh normals and tangents", "[mesh]") {
+    // Closed torus grid, u around the tube and v around the axis
+    const std::size_t rings = 64;
+    const std::size_t segments = 48;
+    const float major = 2.f;
+    const float minor = 0.7f;
+    auto torus = [&](float u, float v) {
+        return esdm::Vec3<float>((major + minor * std::cos(u)) * std::cos(v), (major + minor * std::cos(u)) * std::sin(v), minor * std::sin(u));
+    };
+    auto torusNormal = [&](float u, float v) {
+        return esdm::Vec3<float>(std::cos(u) * std::cos(v), std::cos(u) * std::sin(v), std::sin(u));
+    };
+    const float tau = 6.2831853f;
+    std::vector<esdm::Vec3<float>> positions;
+    std::vector<esdm::Vec3<float>> expected;
+    for (std::size_t j = 0; j < rings; j++) {
+        for (std::size_t i = 0; i < segments; i++) {
+            const float u = tau * (float)i / (float)segments;
+            const float v = tau * (float)j / (float)rings;
+            positions.push_back(torus(u, v));
+            expected.push_back(torusNormal(u, v));
+        }
+    }
+    std::vector<std::uint32_t> indices;
+    auto grid = [&](std::size_t i, std::size_t j) { return (std::uint32_t)(j % rings * segments + i % segments); };
+    for (std::size_t j = 0; j < rings; j++) {
+        for (std::size_t i = 0; i < segments; i++) {
+            indices.insert(indices.end(), { grid(i, j), grid(i, j + 1), grid(i + 1, j + 1) });
+            indices.insert(indices.end(), { grid(i, j), grid(i + 1, j + 1), grid(i + 1, j) });
+        }
+    }
+    const std::size_t n = positions.size();
+
+    esdm::ThreadPool pool(4);
+    esdm::MeshTopology topology(pool);
+    topology.build(indices, n);
+    REQUIRE(topology.vertexCount() == n);
+    REQUIRE(topology.faceCount() == 2 * n);
+    for (std::size_t v = 0; v < n; v++) {
+        REQUIRE(topology.corners(v).size() == 6);
+        for (std::uint32_t c : topology.corners(v)) REQUIRE(indices[c] == v);
+    }
+
+    SECTION("face normals") {
+        std::vector<esdm::Vec3<float>> faces(indices.size() / 3);
+        esdm::faceNormals(std::span<const esdm::Vec3<float>>(positions), std::span<const std::uint32_t>(indices), std::span<esdm::Vec3<float>>(faces), pool);
+        for (std::size_t f = 0; f < faces.size(); f++) {
+            const esdm::Vec3<float>& p = positions[indices[3 * f]];
+            const esdm::Vec3<float> n = esdm::normalize(esdm::cross(positions[indices[3 * f + 1]] - p, positions[indices[3 * f + 2]] - p));
+            REQUIRE(esdm::dot(faces[f], n) == Approx(1.f));
+            // Outwards from the tube
+            REQUIRE(esdm::dot(faces[f], expected[indices[3 * f]]) > 0.9f);
+        }
+    }
+
+    SECTION("vertex normals") {
+        std::vector<esdm::Vec3<float>> faces(2 * n);
+        std::vector<esdm::Vec3<float>> normals(n);
+        for (esdm::NormalWeight weight : { esdm::NormalWeight::Area, esdm::NormalWeight::Angle }) {
+            esdm::vertexNormals(topology, std::span<const esdm::Vec3<float>>(positions), std::span<esdm::Vec3<float>>(faces), std::span<esdm::Vec3<float>>(normals), weight);
+            for (std::size_t v = 0; v < n; v++) {
+                REQUIRE(esdm::length(normals[v]) == Approx(1.f));
+                REQUIRE(esdm::dot(normals[v], expected[v]) > 0.998f);
+            }
+        }
+
+        // Same as scattering area weighted face normals, and the same bits
+        // for any thread count
+        std::mt19937 rng(8);
+        std::uniform_real_distribution<float> jitter(-0.02f, 0.02f);
+        for (esdm::Vec3<float>& p : positions) p = p + esdm::Vec3<float>(jitter(rng), jitter(rng), jitter(rng));
+        std::vector<esdm::Vec3<float>> scattered(n);
+        for (std::size_t f = 0; f < indices.size(); f += 3) {
+            const esdm::Vec3<float>& p = positions[indices[f]];
+            const esdm::Vec3<float> c = esdm::cross(positions[indices[f + 1]] - p, positions[indices[f + 2]] - p);
+            for (std::size_t k = 0; k < 3; k++) scattered[indices[f + k]] = scattered[indices[f + k]] + c;
+        }
+        esdm::vertexNormals(topology, std::span<const esdm::Vec3<float>>(positions), std::span<esdm::Vec3<float>>(faces), std::span<esdm::Vec3<float>>(normals));
+        for (std::size_t v = 0; v < n; v++) REQUIRE(esdm::dot(normals[v], esdm::normalize(scattered[v])) == Approx(1.f));
+
+        esdm::ThreadPool one(1);
+        esdm::MeshTopology single(one);
+        single.build(indices, n);
+        std::vector<esdm::Vec3<float>> serial(n);
+        esdm::vertexNormals(single, std::span<const esdm::Vec3<float>>(positions), std::span<esdm::Vec3<float>>(faces), std::span<esdm::Vec3<float>>(serial));
+        REQUIRE(serial == normals);
+    }
+
+    SECTION("tangents") {
+        // Texture coordinates following the torus parameters, away from the
+        // seams where they wrap
+        std::vector<esdm::Vec2<float>> uvs(n);
+        for (std::size_t j = 0; j < rings; j++)
+            for (std::size_t i = 0; i < segments; i++) uvs[j * segments + i] = esdm::Vec2<float>((float)i / (float)segments, (float)j / (float)rings * 3.f);
+        std::vector<esdm::Vec3<float>> faces(2 * n);
+        std::vector<esdm::Vec3<float>> normals(n);
+        esdm::vertexNormals(topology, std::span<const esdm::Vec3<float>>(positions), std::span<esdm::Vec3<float>>(faces), std::span<esdm::Vec3<float>>(normals), esdm::NormalWeight::Angle);
+        std::vector<esdm::Vec4<float>> tangents(n);
+        esdm::vertexTangents(topology, std::span<const esdm::Vec3<float>>(positions), std::span<const esdm::Vec2<float>>(uvs),
+            std::span<const esdm::Vec3<float>>(normals), std::span<esdm::Vec4<float>>(tangents));
+        for (std::size_t j = 1; j + 1 < rings; j++) {
+            for (std::size_t i = 1; i + 1 < segments; i++) {
+                const std::size_t v = j * segments + i;
+                const esdm::Vec3<float> t(tangents[v]);
+                REQUIRE(esdm::length(t) == Approx(1.f));
+                REQUIRE(esdm::dot(t, normals[v]) == Approx(0.f).margin(1e-5));
+                // Along the derivative in u and v
+                const float u = tau * (float)i / (float)segments;
+                const float w = tau * (float)j / (float)rings;
+                REQUIRE(esdm::dot(t, esdm::normalize(torus(u + 1e-3f, w) - torus(u - 1e-3f, w))) > 0.99f);
+                const esdm::Vec3<float> b = esdm::cross(normals[v], t) * tangents[v][3];
+                REQUIRE(esdm::dot(b, esdm::normalize(torus(u, w + 1e-3f) - torus(u, w - 1e-3f))) > 0.99f);
+            }
+        }
+
+        // Mirrored texture flips the handedness
+        for (esdm::Vec2<float>& uv : uvs) uv[1] = -uv[1];
+        std::vector<esdm::Vec4<float>> mirrored(n);
+        esdm::vertexTangents(topology, std::span<const esdm::Vec3<float>>(positions), std::span<const esdm::Vec2<float>>(uvs),
+            std::span<const esdm::Vec3<float>>(normals), std::span<esdm::Vec4<float>>(mirrored));
+        for (std::size_t j = 1; j + 1 < rings; j++) {
+            for (std::size_t i = 1; i + 1 < segments; i++) {
+                const std::size_t v = j * segments + i;
+                REQUIRE(esdm::dot(esdm::Vec3<float>(mirrored[v]), esdm::Vec3<float>(tangents[v])) == Approx(1.f));
+                REQUIRE(mirrored[v][3] == -tangents[v][3]);
+            }
+        }
+
+        // Without texture coordinates the tangent is still orthogonal
+        std::fill(uvs.begin(), uvs.end(), esdm::Vec2<float>());
+        esdm::vertexTangents(topology, std::span<const esdm::Vec3<float>>(positions), std::span<const esdm::Vec2<float>>(uvs),
+            std::span<const esdm::Vec3<float>>(normals), std::span<esdm::Vec4<float>>(tangents));
+        for (std::size_t v = 0; v < n; v++) {
+            REQUIRE(esdm::length(esdm::Vec3<float>(tangents[v])) == Approx(1.f));
+            REQUIRE(esdm::dot(esdm::Vec3<float>(tangents[v]), normals[v]) == Approx(0.f).margin(1e-5));
+        }
+    }
+}
+
+TEST_CASE("particle integration", "[integrate]") {
+    const esdm::Integrator methods[] = { esdm::Integrator::Euler, esdm::Integrator::SemiImplicitEuler, esdm::Integrator::Verlet, esdm::Integrator::RK4 };
+
+    SECTION("free fall") {
+        // Constant acceleration is exact for Verlet and RK4, the Euler
+        // methods are off by dt^2 n / 2 in opposite directions
+        const esdm::ParticleStep<double> step{ 0.01, { 0.0, 0.0, -9.81 } };
+        const std::size_t steps = 100;
+        for (esdm::Integrator method : methods) {
+            esdm::Particles<double> particles;
+            for (int i = 0; i < 1000; i++) particles.push_back({ (double)i, 0.0, 10.0 }, { 1.0, 2.0, 3.0 });
+            for (std::size_t s = 0; s < steps; s++) esdm::integrate(particles, method, step);
+            const double t = step.dt * (double)steps;
+            double z = 10.0 + 3.0 * t - 0.5 * 9.81 * t * t;
+            if (method == esdm::Integrator::Euler) z += 0.5 * 9.81 * step.dt * t;
+            if (method == esdm::Integrator::SemiImplicitEuler) z -= 0.5 * 9.81 * step.dt * t;
+            for (std::size_t i = 0; i < particles.size(); i++) {
+                const esdm::Vec3<double> p = particles.position.get(i);
+                REQUIRE(p[0] == Approx((double)i + t));
+                REQUIRE(p[1] == Approx(2.0 * t));
+                REQUIRE(p[2] == Approx(z));
+                REQUIRE(particles.velocity.get(i)[2] == Approx(3.0 - 9.81 * t));
+            }
+        }
+    }
+
+    SECTION("oscillator") {
+        // Springs to the origin through the field, after one period the
+        // particles should be back where they started
+        const double k = 4.0;
+        const double period = 2.0 * 3.14159265358979323846 / std::sqrt(k);
+        const std::size_t steps = 200;
+        auto spring = [k](std::size_t, std::size_t m, const double* const* x, const double* const*, double* const* a) {
+            for (std::size_t c = 0; c < 3; c++) for (std::size_t i = 0; i < m; i++) a[c][i] -= k * x[c][i];
+        };
+        double error[4];
+        for (std::size_t n = 0; n < 4; n++) {
+            esdm::Particles<double> particles;
+            for (int i = 0; i < 300; i++) particles.push_back({ 1.0, (double)i * 0.01, 0.0 }, { 0.0, 0.0, 2.0 });
+            const esdm::ParticleStep<double> step{ period / (double)steps, {} };
+            for (std::size_t s = 0; s < steps; s++) esdm::integrate(particles, methods[n], step, spring);
+            error[n] = 0;
+            for (std::size_t i = 0; i < particles.size(); i++)
+                error[n] = std::max(error[n], esdm::length(particles.position.get(i) - esdm::Vec3<double>(1.0, (double)i * 0.01, 0.0)));
+        }
+        REQUIRE(error[3] < 1e-7);
+        REQUIRE(error[2] < 2e-3);
+        REQUIRE(error[1] < 0.1);
+        REQUIRE(error[0] > error[1]);
+    }
+
+    SECTION("damping, forces and kinematic particles") {
+        esdm::Particles<float> particles;
+        particles.push_back({ 0.f, 0.f, 0.f }, { 4.f, 0.f, 0.f });
+        particles.push_back({ 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f }, 0.5f);
+        particles.push_back({ 5.f, 5.f, 5.f }, { 0.f, 0.f, 0.f }, 0.f);
+        particles.push_back({ 5.f, 5.f, 5.f }, { 1.f, 0.f, 0.f }, 0.f);
+        particles.force.set(1, { 2.f, 0.f, 0.f });
+        particles.force.set(2, { 2.f, 0.f, 0.f });
+        const esdm::ParticleStep<float> step{ 0.01f, { 0.f, -1.f, 0.f }, 0.5f };
+        for (int s = 0; s < 100; s++) esdm::integrate(particles, esdm::Integrator::RK4, step);
+        // v' = -damping v - 1 in y, v' = f / m - damping v in x
+        REQUIRE(particles.velocity.get(0)[0] == Approx(4.f * std::exp(-0.5f)));
+        REQUIRE(particles.velocity.get(0)[1] == Approx(-2.f * (1.f - std::exp(-0.5f))));
+        REQUIRE(particles.velocity.get(1)[0] == Approx(2.f * (1.f - std::exp(-0.5f))));
+        REQUIRE(particles.position.get(2) == esdm::Vec3<float>(5.f, 5.f, 5.f));
+        REQUIRE(particles.position.get(3)[0] == Approx(6.f));
+        REQUIRE(particles.velocity.get(3) == esdm::Vec3<float>(1.f, 0.f, 0.f));
+    }
+
+    SECTION("constraints") {
+        std::mt19937 rng(9);
+        std::uniform_real_distribution<float> coord(-2.f, 2.f);
+        esdm::Particles<float> particles;
+        for (int i = 0; i < 50000; i++) particles.push_back({ coord(rng), coord(rng), coord(rng) }, { coord(rng), coord(rng), coord(rng) });
+        const esdm::Particles<float> before = particles;
+
+        const esdm::AABB3<float> box{ { -1.f, -1.f, -1.f }, { 1.f, 1.f, 1.f } };
+        esdm::constrainBox(particles, box, 0.5f);
+        for (std::size_t i = 0; i < particles.size(); i++) {
+            const esdm::Vec3<float> p = before.position.get(i);
+            const esdm::Vec3<float> v = before.velocity.get(i);
+            for (std::size_t c = 0; c < 3; c++) {
+                REQUIRE(particles.position.get(i)[c] == std::min(std::max(p[c], -1.f), 1.f));
+                const bool leaving = (p[c] < -1.f && v[c] < 0.f) || (p[c] > 1.f && v[c] > 0.f);
+                REQUIRE(particles.velocity.get(i)[c] == (leaving ? -0.5f * v[c] : v[c]));
+            }
+        }
+
+        particles = before;
+        const esdm::Vec3<float> normal = esdm::normalize(esdm::Vec3<float>(1.f, 2.f, 2.f));
+        esdm::constrainPlane(particles, normal, 0.5f, 1.f);
+        for (std::size_t i = 0; i < particles.size(); i++) {
+            const esdm::Vec3<float> p = before.position.get(i);
+            const esdm::Vec3<float> v = before.velocity.get(i);
+            const float d = esdm::dot(normal, p) - 0.5f;
+            const esdm::Vec3<float> q = particles.position.get(i);
+            const esdm::Vec3<float> w = particles.velocity.get(i);
+            if (d >= 0.f) {
+                REQUIRE(q == p);
+                REQUIRE(w == v);
+            } else {
+                REQUIRE(esdm::dot(normal, q) == Approx(0.5f).margin(1e-5));
+                // Elastic, the speed stays and the normal part points out
+                REQUIRE(esdm::length(w) == Approx(esdm::length(v)));
+                REQUIRE(esdm::dot(normal, w) == Approx(std::abs(esdm::dot(normal, v))).margin(1e-5));
+            }
+        }
+    }
+
+    SECTION("threads") {
+        std::mt19937 rng(10);
+        std::uniform_real_distribution<float> coord(-2.f, 2.f);
+        esdm::Particles<float> particles;
+        for (int i = 0; i < 100000; i++) particles.push_back({ coord(rng), coord(rng), coord(rng) }, { coord(rng), coord(rng), coord(rng) });
+        esdm::Particles<float> other = particles;
+        esdm::ThreadPool one(1);
+        esdm::ThreadPool four(4);
+        const esdm::ParticleStep<float> step{ 1.f / 60.f, { 0.f, -9.8f, 0.f }, 0.1f };
+        for (esdm::Integrator method : methods) {
+            esdm::integrate(particles, method, step, one);
+            esdm::integrate(other, method, step, four);
+        }
+        for (std::size_t c = 0; c < 3; c++) {
+            REQUIRE(std::equal(particles.position.component(c).begin(), particles.position.component(c).end(), other.position.component(c).begin()));
+            REQUIRE(std::equal(particles.velocity.component(c).begin(), particles.velocity.component(c).end(), other.velocity.component(c).begin()));
+        }
+    }
 }
\ No newline at end of file